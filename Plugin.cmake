@@ -64,25 +64,37 @@ set(PKG_INFO_URL https://opencpn.org/OpenCPN/plugins/radarPI.html)
 
 set(SRC
   include/ControlsDialog.h
+  include/FrameScheduler.h
   include/GuardZone.h
   include/GuardZoneBogey.h
+  include/GuardZoneMask.h
   include/Kalman.h
   include/Matrix.h
   include/MessageBox.h
+  include/NetworkInterfaces.h
   include/OptionsDialog.h
+  include/PacketTrace.h
+  include/PolarHistory.h
   include/RadarCanvas.h
   include/RadarControl.h
   include/RadarControlItem.h
+  include/RadarControlJournal.h
   include/RadarDraw.h
+  include/RadarDrawCore.h
   include/RadarDrawShader.h
   include/RadarDrawVertex.h
   include/RadarFactory.h
   include/RadarInfo.h
+  include/RadarLifecycle.h
   include/RadarLocationInfo.h
   include/RadarMarpa.h
   include/RadarPanel.h
+  include/RadarPlayback.h
+  include/RadarPolarImage.h
   include/RadarReceive.h
+  include/RadarRecorder.h
   include/RadarType.h
+  include/ScanCorrelator.h
   include/SelectDialog.h
   include/SoftwareControlSet.h
   include/TextureFont.h
@@ -93,6 +105,7 @@ set(SRC
   include/radar_pi.h
   include/shaderutil.h
   include/socketutil.h
+  include/spokeutil.h
 
   # Source files that are repeatedly included to get a 
   # different effect every time
@@ -105,11 +118,13 @@ set(SRC
   include/emulator/EmulatorControlSet.h
   include/emulator/EmulatorControlsDialog.h
   include/emulator/EmulatorReceive.h
+  include/emulator/EmulatorScene.h
   include/emulator/emulatortype.h
   include/garminhd/GarminHDControl.h
   include/garminhd/GarminHDControlSet.h
   include/garminhd/GarminHDControlsDialog.h
   include/garminhd/GarminHDReceive.h
+  include/garminhd/GarminHDUnpack.h
   include/garminhd/garminhdtype.h
   include/garminxhd/GarminxHDControl.h
   include/garminxhd/GarminxHDControlSet.h
@@ -137,25 +152,38 @@ set(SRC
   include/raymarine/RME120type.h
   include/raymarine/RMQuantumtype.h
   include/raymarine/RaymarineCommon.h
+  include/raymarine/RaymarineDecode.h
   include/raymarine/RaymarineLocate.h
   include/raymarine/RMQuantumControlsDialog.h
   include/raymarine/RMQuantumControl.h
   include/raymarine/RMQuantumControlSet.h
 
   src/ControlsDialog.cpp
+  src/FrameScheduler.cpp
   src/GuardZone.cpp
   src/GuardZoneBogey.cpp
+  src/GuardZoneMask.cpp
   src/Kalman.cpp
   src/MessageBox.cpp
+  src/NetworkInterfaces.cpp
   src/OptionsDialog.cpp
+  src/PacketTrace.cpp
+  src/PolarHistory.cpp
   src/RadarCanvas.cpp
+  src/RadarControlJournal.cpp
   src/RadarDraw.cpp
+  src/RadarDrawCore.cpp
   src/RadarDrawShader.cpp
   src/RadarDrawVertex.cpp
   src/RadarFactory.cpp
   src/RadarInfo.cpp
+  src/RadarLifecycle.cpp
   src/RadarMarpa.cpp
   src/RadarPanel.cpp
+  src/RadarPlayback.cpp
+  src/RadarPolarImage.cpp
+  src/RadarRecorder.cpp
+  src/ScanCorrelator.cpp
   src/SelectDialog.cpp
   src/TextureFont.cpp
   src/TrailBuffer.cpp
@@ -164,13 +192,16 @@ set(SRC
   src/radar_pi.cpp
   src/shaderutil.cpp
   src/socketutil.cpp
+  src/spokeutil.cpp
 
   src/emulator/EmulatorControl.cpp
   src/emulator/EmulatorControlsDialog.cpp
   src/emulator/EmulatorReceive.cpp
+  src/emulator/EmulatorScene.cpp
   src/garminhd/GarminHDControl.cpp
   src/garminhd/GarminHDControlsDialog.cpp
   src/garminhd/GarminHDReceive.cpp
+  src/garminhd/GarminHDUnpack.cpp
   src/garminxhd/GarminxHDControl.cpp
   src/garminxhd/GarminxHDControlsDialog.cpp
   src/garminxhd/GarminxHDReceive.cpp
@@ -181,6 +212,7 @@ set(SRC
   src/raymarine/RME120Control.cpp
   src/raymarine/RMQuantumControl.cpp
   src/raymarine/RME120ControlsDialog.cpp
+  src/raymarine/RaymarineDecode.cpp
   src/raymarine/RaymarineReceive.cpp
   src/raymarine/RaymarineLocate.cpp
   src/raymarine/RMQuantumControlsDialog.cpp
@@ -176,6 +176,7 @@ public:
         m_inner_range = 0;
         m_start_bearing = 0;
         m_end_bearing = 0;
+        m_polygon = 0;
         m_arpa_box = 0;
         m_alarm = 0;
         CLEAR_STRUCT(m_bearing_buttons);
@@ -195,6 +196,8 @@ public:
         m_timed_run_button = 0;
         m_interference_rejection_button = 0;
         m_threshold_button = 0;
+        m_cfar_button = 0;
+        m_scan_correlation_button = 0;
         m_target_separation_button = 0;
         m_noise_rejection_button = 0;
         m_target_boost_button = 0;
@@ -367,6 +370,7 @@ protected:
     wxTextCtrl* m_inner_range;
     wxTextCtrl* m_start_bearing;
     wxTextCtrl* m_end_bearing;
+    wxTextCtrl* m_polygon;
     wxCheckBox* m_arpa_box;
     wxCheckBox* m_alarm;
 
@@ -397,6 +401,8 @@ protected:
     // Advanced controls
     RadarControlButton* m_noise_rejection_button;
     RadarControlButton* m_threshold_button;
+    RadarControlButton* m_cfar_button;
+    RadarControlButton* m_scan_correlation_button;
     RadarControlButton* m_target_separation_button;
     RadarControlButton* m_target_boost_button;
     RadarControlButton* m_target_expansion_button;
@@ -524,6 +530,7 @@ public:
     void OnOuter_Range_Value(wxCommandEvent& event);
     void OnStart_Bearing_Value(wxCommandEvent& event);
     void OnEnd_Bearing_Value(wxCommandEvent& event);
+    void OnPolygon_Value(wxCommandEvent& event);
     void OnARPAClick(wxCommandEvent& event);
     void OnAlarmClick(wxCommandEvent& event);
 };
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _FRAMESCHEDULER_H_
+#define _FRAMESCHEDULER_H_
+
+#include "radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define FRAME_SECTORS (64) // Resolution of the damage tracking, sectors per rotation
+#define FRAME_ALL_SECTORS (~(uint64_t)0)
+
+// A radar can be drawn on its own PPI window and on each chart canvas
+#define FRAME_TARGET_PPI (0)
+#define FRAME_TARGET_CANVAS(c) (1 + (c))
+#define FRAME_TARGETS (1 + MAX_CHART_CANVAS)
+
+#define FRAME_BUDGET_PERCENT (50) // Max share of the GUI thread that is spent drawing
+#define FRAME_IDLE_MILLIS (1000) // Redraw a PPI window at least this often
+#define FRAME_REQUEST_TIMEOUT (1000) // Request again if a Refresh() was not painted
+
+/*
+ * Decides when a radar window or chart canvas needs to be redrawn.
+ *
+ * The receive threads mark the sectors of the rotation where new spokes have
+ * arrived. Each chart canvas knows which sectors of the radar it can see, so a
+ * canvas is only refreshed when data it shows has changed since it was last
+ * painted, and no more often than the refresh rate and the time spent
+ * drawing allow.
+ */
+class FrameScheduler {
+public:
+    FrameScheduler();
+
+    // Called on the receive threads
+    void MarkSpoke(int radar, SpokeBearing angle, SpokeBearing bearing,
+        int spokes);
+    void MarkAll(int radar);
+
+    // Called on the GUI thread
+    void SetVisibleSectors(int radar, int target, uint64_t sectors);
+    void Presented(int radar, int target);
+    bool IsDue(int radar, int target, int interval_millis, bool keep_alive);
+    void Requested(int radar, int target);
+
+    // The sectors of a radar image centered at 'center' with 'radius' pixels,
+    // rotated 'rotation' degrees clockwise, that fall within a viewport of
+    // width x height pixels.
+    static uint64_t GetVisibleSectors(wxPoint center, double radius,
+        double rotation, int width, int height);
+
+private:
+    struct Target {
+        uint64_t damage; // Sectors changed since the last paint
+        uint64_t visible; // Sectors that are on screen
+        wxLongLong presented; // When the target was last painted
+        wxLongLong requested; // When a Refresh() was last asked for, or 0
+    };
+
+    wxCriticalSection m_exclusive;
+    Target m_target[RADARS][FRAME_TARGETS];
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _FRAMESCHEDULER_H_ */
@@ -36,6 +36,10 @@
 
 namespace RadarPlugin {
 
+#define GUARD_ZONE_MAX_VERTICES (64)
+// Max polygon intervals per spoke; a ray crosses each edge at most once
+#define GUARD_ZONE_MAX_INTERVALS (GUARD_ZONE_MAX_VERTICES / 2)
+
 class GuardZone {
 public:
     GuardZoneType m_type;
@@ -48,9 +52,21 @@ public:
     time_t m_show_time;
     wxLongLong m_arpa_update_time[SPOKES_MAX];
 
+    // Polygon zones: vertices in meters, x = range * cos(bearing) and
+    // y = range * sin(bearing) with the bearing relative to the bow.
+    // Only changed on the GUI thread; the receive thread reads it through
+    // GetPolygonIntervals under m_polygon_lock.
+    vector<Point> m_polygon;
+    wxCriticalSection m_polygon_lock;
+
+    // Incremented on every change that affects which samples are in the
+    // zone, so GuardZoneMask knows when to recompute its table.
+    volatile int m_version;
+
     void ResetBogeys()
     {
         m_bogey_count = -1;
+        m_tripped_count = -1;
         m_running_count = 0;
         m_last_in_guard_zone = false;
         m_last_angle = 0;
@@ -59,34 +75,40 @@ public:
     void SetType(GuardZoneType type)
     {
         m_type = type;
-        if (m_type > (GuardZoneType)1)
-            m_type = (GuardZoneType)0;
+        if (m_type > GZ_POLYGON)
+            m_type = GZ_ARC;
+        m_version++;
         ResetBogeys();
     };
     void SetStartBearing(SpokeBearing start_bearing)
     {
         m_start_bearing = start_bearing;
+        m_version++;
         ResetBogeys();
     };
     void SetEndBearing(SpokeBearing end_bearing)
     {
         m_end_bearing = end_bearing;
+        m_version++;
         ResetBogeys();
     };
     void SetInnerRange(int inner_range)
     {
         m_inner_range = inner_range;
+        m_version++;
         ResetBogeys();
     };
     void SetOuterRange(int outer_range)
     {
         m_outer_range = outer_range;
+        m_version++;
         ResetBogeys();
     };
     void SetArpaOn(int arpa) { m_arpa_on = arpa; };
     void SetAlarmOn(int alarm)
     {
         m_alarm_on = alarm;
+        m_version++;
         if (m_alarm_on) {
             m_pi->m_guard_bogey_confirmed = false;
         } else {
@@ -95,23 +117,47 @@ public:
     };
 
     /*
-     * Check if data is in this GuardZone, if so update bogeyCount
+     * Update bogeyCount with the hits GuardZoneMask counted in this zone
+     * for one spoke. 'in_zone' says whether the spoke crosses the zone.
      */
-    void ProcessSpoke(
-        SpokeBearing angle, uint8_t* data, uint8_t* hist, size_t len);
+    void ProcessSpoke(SpokeBearing angle, bool in_zone, size_t hits);
+
+    // Polygon zones are stored in the config as "bearing:range ..." pairs,
+    // with bearings in degrees relative to the bow and ranges in meters
+    // (or in 'meters_per_unit' when edited in the guard zone dialog).
+    // Returns the number of vertices skipped because they are invalid or
+    // beyond GUARD_ZONE_MAX_VERTICES.
+    size_t SetPolygon(const wxString& spec, double meters_per_unit = 1.);
+    wxString GetPolygonString(double meters_per_unit = 1.);
+
+    // Compute where a ray at 'angle' degrees off the bow is inside the
+    // polygon, as at most 'max' intervals [begin[i]..end[i]> in meters.
+    size_t GetPolygonIntervals(
+        double angle, double* begin, double* end, size_t max);
+
+    // Set by GuardZoneMask when every spoke crosses the zone, the sweep
+    // then ends when the spokes wrap around as for a circle.
+    bool m_covers_all_spokes;
 
     // Find targets inside the zone
     void SearchTargets();
 
     int GetBogeyCount()
     {
-        if (m_bogey_count > -1) {
+        // A zone that tripped in the current sweep already has at least
+        // this many bogeys, don't wait for the sweep to end.
+        int bogeys = m_tripped_count > m_bogey_count ? m_tripped_count
+                                                     : m_bogey_count;
+        if (bogeys > -1) {
             LOG_GUARD(wxT("%s reporting bogey_count=%d"), m_log_name.c_str(),
-                m_bogey_count);
+                bogeys);
         }
-        return m_bogey_count;
+        return bogeys;
     };
 
+    // True when the running count passed the trip count in this sweep
+    bool IsTripped() { return m_tripped_count >= 0; };
+
     GuardZone(radar_pi* pi, RadarInfo* ri, int zone);
 
     ~GuardZone() { LOG_VERBOSE(wxT("%s destroyed"), m_log_name.c_str()); }
@@ -125,6 +171,8 @@ private:
     SpokeBearing m_last_angle;
     int m_bogey_count; // complete cycle
     int m_running_count; // current swipe
+    volatile int m_tripped_count; // running count when the alarm tripped in
+                                  // the current swipe, or -1
 
     void UpdateSettings();
 };
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _GUARDZONEMASK_H_
+#define _GUARDZONEMASK_H_
+
+#include "radar_pi.h"
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+/*
+ * Precomputed guard zone coverage of every spoke.
+ *
+ * For each spoke the ranges covered by the active (alarmed) guard zones are
+ * split into non-overlapping runs, each with the set of zones it belongs to.
+ * A spoke is then counted in a single pass over its runs, however many zones
+ * overlap, and the per-spoke arc and polygon tests are replaced by a table
+ * lookup. The table is rebuilt on the receive thread when a zone changes
+ * (see GuardZone::m_version), an alarm is switched, or the range changes.
+ */
+class GuardZoneMask {
+public:
+    GuardZoneMask(radar_pi* pi, RadarInfo* ri);
+
+    // Count the returns above threshold_blue in each active zone and pass
+    // the hits on to the zones.
+    void ProcessSpoke(SpokeBearing angle, const SpokeRuns& runs);
+
+private:
+    struct Run {
+        uint16_t begin; // First sample of the run
+        uint16_t end; // One beyond the last sample
+        uint8_t zones; // Bit z set when zone z covers the run
+    };
+
+    bool NeedsUpdate();
+    void Update();
+    void AddZoneIntervals(size_t z, SpokeBearing angle, vector<Run>& runs);
+
+    radar_pi* m_pi;
+    RadarInfo* m_ri;
+
+    int m_version[GUARD_ZONES];
+    double m_pixels_per_meter;
+    int m_spokes;
+    size_t m_spoke_len_max;
+
+    vector<size_t> m_first_run; // Runs of spoke s are [m_first_run[s]..m_first_run[s + 1]>
+    vector<Run> m_runs;
+    vector<uint8_t> m_in_zone; // Zones crossed by each spoke
+    uint8_t m_active; // Zones that are processed at all
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _GUARDZONEMASK_H_ */
@@ -0,0 +1,263 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _NETWORK_INTERFACES_H_
+#define _NETWORK_INTERFACES_H_
+
+#include <deque>
+#include <vector>
+
+#include "pi_common.h"
+#include "socketutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+class radar_pi;
+
+#define NETWORK_INTERFACES_POLL (60) // Seconds between re-reads without netlink
+
+//
+// The IPv4 interfaces that can receive radar multicast, shared by all
+// locators.
+//
+// Instead of each of them reading the interface list and rebuilding all of
+// its sockets every minute, they ask for the list and its generation, which
+// only changes when an interface comes or goes or gets a different address.
+// On Linux a netlink socket tells us when that happens; elsewhere the list is
+// read again at most every NETWORK_INTERFACES_POLL seconds.
+//
+// Safe to use from any thread.
+//
+class NetworkInterfaces {
+public:
+    NetworkInterfaces(radar_pi* pi);
+    ~NetworkInterfaces();
+
+    // Returns the generation of the list copied to 'interfaces'.
+    int GetInterfaces(vector<NetworkAddress>* interfaces);
+
+private:
+    void CheckForChanges();
+    void ReadInterfaces();
+
+    radar_pi* m_pi;
+
+    wxCriticalSection m_exclusive; // protects the following
+    vector<NetworkAddress> m_interfaces;
+    int m_generation; // 0 = not read yet
+    SOCKET m_netlink; // INVALID_SOCKET when not available
+    time_t m_next_read; // Without netlink
+};
+
+#define MULTICAST_QUEUE_MAX (256) // Datagrams waiting for a subscriber
+
+class MulticastDispatcher;
+
+// Where a datagram handed out by MulticastSubscriber::Receive() came from
+struct MulticastSource {
+    NetworkAddress interface_address;
+    NetworkAddress group;
+    NetworkAddress from; // Address and port of the sender
+};
+
+//
+// One thread's share of the multicast sockets of the MulticastDispatcher.
+//
+// Join() subscribes to a group on an interface. The datagrams that the
+// dispatcher reads for it wait here until Receive() takes them. The socket
+// returned by GetWakeSocket() becomes readable when that queue stops being
+// empty, so the thread can select() on it next to its other sockets.
+//
+// Owned and used by a single thread, the dispatcher is taken from
+// radar_pi::m_multicast_dispatcher.
+//
+class MulticastSubscriber {
+public:
+    MulticastSubscriber(radar_pi* pi);
+    ~MulticastSubscriber();
+
+    // Returns false and appends the reason to 'error' when the group cannot
+    // be received on that interface.
+    bool Join(const NetworkAddress& interface_address,
+        const NetworkAddress& group, wxString& error);
+    // Stop receiving the group on one interface, or on all when
+    // 'interface_address' is null. Drops the datagrams still queued for it.
+    void Leave(const NetworkAddress& group,
+        const NetworkAddress& interface_address = NetworkAddress());
+    void LeaveAll();
+    bool IsJoined(const NetworkAddress& group);
+    // The shared socket of a joined group, to send from its port. Only the
+    // dispatcher reads from it.
+    SOCKET GetSocket(const NetworkAddress& group);
+
+    SOCKET GetWakeSocket() { return m_wake_receive; }
+
+    // Copies the oldest queued datagram to 'data', truncated to 'size', and
+    // returns its length, or returns -1 when nothing is queued.
+    int Receive(uint8_t* data, size_t size, MulticastSource* source);
+
+private:
+    friend class MulticastDispatcher;
+
+    struct Packet {
+        MulticastSource source;
+        vector<uint8_t> data;
+    };
+    struct Membership {
+        NetworkAddress interface_address;
+        NetworkAddress group;
+    };
+
+    // Called by the dispatcher thread
+    void Deliver(const MulticastSource& source, const uint8_t* data,
+        size_t len);
+
+    radar_pi* m_pi;
+    MulticastDispatcher* m_dispatcher; // Of m_joined, 0 when none
+    vector<Membership> m_joined;
+
+    SOCKET m_wake_receive; // Readable when m_queue is not empty
+    SOCKET m_wake_send;
+
+    wxCriticalSection m_exclusive; // protects the following
+    deque<Packet> m_queue;
+    size_t m_dropped; // Since the last log line
+};
+
+//
+// Receives multicast for all locators and radar receivers.
+//
+// There is one socket per (interface, group), opened when the first
+// subscriber joins and closed when the last one leaves. This thread reads
+// each datagram once and queues a copy for every subscriber of its socket,
+// so radars and locators that listen to the same group share the socket,
+// and a receiver restarting does not close it under the others.
+//
+class MulticastDispatcher : public wxThread {
+public:
+    MulticastDispatcher(radar_pi* pi);
+    ~MulticastDispatcher();
+
+    void Shutdown(void);
+
+protected:
+    void* Entry(void);
+
+private:
+    friend class MulticastSubscriber;
+
+    struct Membership {
+        NetworkAddress interface_address;
+        NetworkAddress group;
+        SOCKET socket;
+        vector<MulticastSubscriber*> subscribers;
+    };
+
+    // Called by the subscriber threads
+    bool Join(MulticastSubscriber* subscriber,
+        const NetworkAddress& interface_address, const NetworkAddress& group,
+        wxString& error);
+    void Leave(MulticastSubscriber* subscriber,
+        const NetworkAddress& interface_address, const NetworkAddress& group);
+    SOCKET GetSocket(
+        const NetworkAddress& interface_address, const NetworkAddress& group);
+    void Wake();
+
+    radar_pi* m_pi;
+    volatile bool m_shutdown;
+
+    SOCKET m_wake_receive; // Interrupts select() when m_memberships changed
+    SOCKET m_wake_send;
+
+    wxCriticalSection m_exclusive; // protects the following
+    vector<Membership> m_memberships;
+    vector<SOCKET> m_closing; // Left by all, closed by the dispatcher thread
+};
+
+//
+// Subscription to one or more multicast groups on every interface.
+//
+// Update() follows the NetworkInterfaces list: when it changed it joins the
+// groups on interfaces that are new and leaves them on interfaces that are
+// gone, but stays joined on all other interfaces, so these do not miss any
+// packets. Groups that could not be joined are tried again every
+// NETWORK_INTERFACES_POLL seconds, also when the list did not change.
+//
+// Owned and used by a single thread, the interface list is taken from
+// radar_pi::m_network_interfaces.
+//
+class MulticastGroups {
+public:
+    MulticastGroups(radar_pi* pi);
+    ~MulticastGroups() { Close(); }
+
+    void AddGroup(const NetworkAddress& group) { m_groups.push_back(group); }
+
+    // Returns true if the memberships were rebuilt, because the interface
+    // list changed or failed joins were retried. Appends the reason for each
+    // group that still could not be joined to 'errors', if given, one per
+    // line.
+    bool Update(wxString* errors = 0);
+    // Leave all groups, the next Update() joins them again
+    void Close();
+
+    size_t GetCount() { return m_entries.size(); }
+    const NetworkAddress& GetInterface(size_t i)
+    {
+        return m_entries[i].interface_address;
+    }
+
+    SOCKET GetWakeSocket() { return m_subscriber.GetWakeSocket(); }
+    int Receive(uint8_t* data, size_t size, MulticastSource* source)
+    {
+        return m_subscriber.Receive(data, size, source);
+    }
+
+private:
+    struct Entry {
+        NetworkAddress interface_address;
+        NetworkAddress group;
+        bool joined;
+    };
+
+    radar_pi* m_pi;
+    MulticastSubscriber m_subscriber;
+    vector<NetworkAddress> m_groups;
+    vector<Entry> m_entries; // For each interface, one per group
+    int m_generation; // Of the interface list in m_entries, 0 = none
+    size_t m_failed; // Entries that are not joined
+    time_t m_next_retry; // When to join these again
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _NETWORK_INTERFACES_H_ */
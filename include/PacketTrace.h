@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _PACKETTRACE_H_
+#define _PACKETTRACE_H_
+
+#include <atomic>
+
+#include "radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define TRACE_RING_SIZE (1024 * 1024) // Bytes buffered per thread, power of 2
+#define TRACE_FLUSH_MILLIS (100) // How often the buffers are written out
+#define TRACE_LABEL_MAX (255) // Longer labels are cut off
+#define TRACE_SNAPLEN (65535) // Longer packets are cut off
+#define TRACE_LINKTYPE (147) // LINKTYPE_USER0
+#define TRACE_EXTENSION wxT("pcap")
+
+// The file is a standard pcap file with link type USER0. The data of each
+// packet is a length byte, the label and then the packet itself.
+// src/PacketTrace-dump.cpp shows it as hex.
+
+#pragma pack(push, 1)
+
+struct PcapFileHeader {
+    uint32_t magic; // 0xa1b2c3d4
+    uint16_t version_major; // 2
+    uint16_t version_minor; // 4
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct PcapRecordHeader {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+#pragma pack(pop)
+
+/*
+ * A buffer written by a single thread and read by the trace thread.
+ * The producer only moves m_head and the consumer only moves m_tail, so
+ * neither side ever waits for the other. When the buffer is full the packet
+ * is dropped and counted.
+ */
+struct PacketTraceRing {
+    PacketTraceRing()
+    {
+        m_head = 0;
+        m_tail = 0;
+        m_dropped = 0;
+    }
+
+    bool Put(const PcapRecordHeader& header, const uint8_t* label,
+        size_t label_len, const uint8_t* data, size_t len);
+    size_t Write(FILE* file);
+
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+    std::atomic<uint32_t> m_dropped;
+    uint8_t m_data[TRACE_RING_SIZE];
+
+private:
+    void Copy(size_t pos, const void* src, size_t len);
+};
+
+/*
+ * Collects raw packets from any thread and writes them to a pcap file on its
+ * own thread, so that tracing a busy radar does not slow down the receive
+ * threads. The file is created when the first packet arrives.
+ */
+class PacketTrace : public wxThread {
+public:
+    PacketTrace(radar_pi* pi, const wxString& filename);
+    ~PacketTrace();
+
+    // Called on any thread
+    void Add(const wxString& what, const void* data, size_t len);
+
+    void Shutdown(void) { m_shutdown = true; }
+
+protected:
+    void* Entry(void);
+
+private:
+    PacketTraceRing* GetRing();
+    bool Flush();
+
+    radar_pi* m_pi;
+    wxString m_filename;
+    uint32_t m_id;
+    FILE* m_file;
+    volatile bool m_shutdown;
+
+    wxCriticalSection m_exclusive; // Protects m_rings
+    vector<PacketTraceRing*> m_rings;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _PACKETTRACE_H_ */
@@ -0,0 +1,210 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _POLAR_HISTORY_H_
+#define _POLAR_HISTORY_H_
+
+#include "pi_common.h"
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define HISTORY_ALIGNMENT (64) // Rows start on a cache line boundary
+#define HISTORY_WRAP_ROWS                                                      \
+    (64) // Rows duplicated on both sides of the 0 / m_spokes seam
+#define HISTORY_WORD_BITS (64)
+
+// The flags kept per sample, each stored in its own bit plane.
+enum HistoryPlane {
+    HISTORY_ABOVE_THRESHOLD, // Return was above threshold_red
+    HISTORY_UNCLAIMED, // Not yet claimed by an ARPA target this sweep
+    HISTORY_DOPPLER, // Approaching doppler return
+    HISTORY_PLANES
+};
+#define HISTORY_BIT(plane) (1 << (plane))
+
+static inline int HistoryPopCount(uint64_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the lowest set bit, w must not be zero.
+static inline int HistoryFirstSet(uint64_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    return HistoryPopCount((w & (~w + 1)) - 1);
+#endif
+}
+
+// Set bits [r_begin..r_end> in the plane starting at 'words', r_end must be
+// greater than r_begin.
+static inline void HistorySetBits(uint64_t* words, size_t r_begin, size_t r_end)
+{
+    size_t first = r_begin / HISTORY_WORD_BITS;
+    size_t last = (r_end - 1) / HISTORY_WORD_BITS;
+    uint64_t first_mask = ~(uint64_t)0 << (r_begin % HISTORY_WORD_BITS);
+    uint64_t last_mask = ~(uint64_t)0
+        >> (HISTORY_WORD_BITS - 1 - (r_end - 1) % HISTORY_WORD_BITS);
+
+    if (first == last) {
+        words[first] |= first_mask & last_mask;
+        return;
+    }
+    words[first] |= first_mask;
+    for (size_t w = first + 1; w < last; w++) {
+        words[w] = ~(uint64_t)0;
+    }
+    words[last] |= last_mask;
+}
+
+/*
+ * The history of the last revolution as used by ARPA and the guard zones.
+ *
+ * Every sample has three flags (see HistoryPlane). Each flag is stored in a
+ * bit plane, one bit per sample packed into 64-bit words along the range
+ * axis. The planes of a spoke are stored next to each other in one row, and
+ * every row starts on a cache line. All rows are in one contiguous buffer.
+ *
+ * The first and last HISTORY_WRAP_ROWS spokes are duplicated on the other
+ * side of the buffer, so code that walks across angles can use angle - k or
+ * angle + k directly without applying MOD_SPOKES, even at the 0 / m_spokes
+ * seam. Only the owner of the history may modify a row, and only through the
+ * methods below so the duplicated rows stay in step.
+ *
+ * The time and position at which a spoke was received are kept in separate
+ * arrays so that scanning the times does not pull in the sample data.
+ *
+ * Clear() does not touch the rows, it starts a new generation (epoch). Each
+ * row remembers the epoch in which it was last written, and a row from an
+ * older epoch reads as empty until the next spoke for it is stored. So a
+ * range change costs the same however many spokes the radar has.
+ */
+class PolarHistory {
+public:
+    PolarHistory(size_t spokes, size_t spoke_len_max);
+    ~PolarHistory();
+
+    // Forget all spokes, in constant time.
+    void Clear();
+
+    // Return the flags of a sample as a combination of HISTORY_BIT() values.
+    // 'angle' may be up to HISTORY_WRAP_ROWS spokes outside [0..m_spokes>,
+    // 'r' must be in [0..spoke_len_max>.
+    int Bits(int angle, int r) const
+    {
+        const uint64_t* row = Row(angle) + (r / HISTORY_WORD_BITS);
+        int shift = r % HISTORY_WORD_BITS;
+
+        return (int)((row[0] >> shift) & 1)
+            | (int)(((row[m_words] >> shift) & 1) << HISTORY_UNCLAIMED)
+            | (int)(((row[2 * m_words] >> shift) & 1) << HISTORY_DOPPLER);
+    }
+
+    // Return the first r in [r_begin..r_end> that is above threshold (and
+    // doppler, if requested), or r_end if there is none.
+    int FindNext(int angle, int r_begin, int r_end, bool doppler) const;
+
+    // Store a new spoke received at 'time' when the radar was at 'pos',
+    // returns the number of approaching doppler samples.
+    int SetLine(SpokeBearing bearing, const SpokeRuns& runs, int threshold,
+        wxLongLong time, const GeoPosition& pos);
+
+    // Clear the planes in 'planes' for samples [r_begin..r_end> of 'angle'.
+    void ClearBits(int angle, int r_begin, int r_end, int planes);
+
+    int ModSpokes(int angle) const
+    {
+        angle %= m_spokes;
+        return angle < 0 ? angle + m_spokes : angle;
+    }
+
+    // The time a spoke was received and the radar position at that time,
+    // 'bearing' in [0..m_spokes>. Both are zero when the spoke has not been
+    // received since the last Clear().
+    wxLongLong GetTime(SpokeBearing bearing) const
+    {
+        return IsCurrent(bearing + HISTORY_WRAP_ROWS) ? m_time[bearing]
+                                                      : wxLongLong(0);
+    }
+    GeoPosition GetPos(SpokeBearing bearing) const
+    {
+        if (IsCurrent(bearing + HISTORY_WRAP_ROWS)) {
+            return m_pos[bearing];
+        }
+        GeoPosition none = { 0., 0. };
+        return none;
+    }
+
+private:
+    bool IsCurrent(unsigned row) const { return m_row_epoch[row] == m_epoch; }
+    const uint64_t* Row(int angle) const
+    {
+        unsigned row = (unsigned)(angle + HISTORY_WRAP_ROWS);
+
+        if (row >= m_rows) {
+            row = (unsigned)(ModSpokes(angle) + HISTORY_WRAP_ROWS);
+        }
+        if (!IsCurrent(row)) {
+            return m_zero_row;
+        }
+        return m_data + (size_t)row * m_stride;
+    }
+    uint64_t* RowForWrite(int row) { return m_data + (size_t)row * m_stride; }
+    int MirrorRow(SpokeBearing bearing) const;
+
+    int m_spokes;
+    size_t m_spoke_len_max;
+    size_t m_words; // Words per plane per spoke
+    size_t m_stride; // Words per row, HISTORY_PLANES * m_words rounded up to
+                     // HISTORY_ALIGNMENT
+    unsigned m_rows; // m_spokes + 2 * HISTORY_WRAP_ROWS
+    uint64_t* m_data;
+    uint64_t* m_zero_row; // What a row from an older epoch reads as
+
+    uint32_t m_epoch; // Incremented by Clear()
+    uint32_t* m_row_epoch; // Epoch in which each row was written, [m_rows]
+    wxLongLong* m_time; // Time each spoke was received, [0..m_spokes>
+    GeoPosition* m_pos; // Radar position at that time, [0..m_spokes>
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif
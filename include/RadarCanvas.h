@@ -87,6 +87,8 @@ private:
     wxSize m_zoom_size;
     wxPoint m_mouse_down;
     unsigned int m_cursor_texture;
+    GLGeometry m_range_ring_geometry;
+    GLGeometry m_vrm_geometry[BEARING_LINES];
 
     wxLongLong m_last_mousewheel_zoom_in;
     wxLongLong m_last_mousewheel_zoom_out;
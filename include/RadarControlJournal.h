@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADAR_CONTROL_JOURNAL_H_
+#define _RADAR_CONTROL_JOURNAL_H_
+
+#include "RadarControlItem.h"
+#include "radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define CONTROL_JOURNAL_RESEND (1) // Seconds before an unchanged value is sent again
+
+/*
+ * The control values reported by the radar, on their way from the receive
+ * thread to the RadarControlItems.
+ *
+ * Radars repeat their settings in every status packet, and some in every
+ * spoke packet. Instead of calling Update() on each item for each packet,
+ * which takes a lock per item, the receive thread notes the values with
+ * Set() and ends each packet with Commit(). Commit() takes one lock, and
+ * only when a value differs from what it sent before or has not been sent
+ * for CONTROL_JOURNAL_RESEND seconds. The latter lets the radar overrule a
+ * value the user changed in the UI but the radar did not accept.
+ *
+ * The main thread calls Apply() when it is about to show the controls. Of
+ * the values committed since the previous call only the latest per control
+ * is applied, so the items, and the buttons that show them, only change
+ * as often as the UI is refreshed and only for controls that changed.
+ *
+ * Set() and Commit() may only be called from one (receive) thread.
+ */
+class RadarControlJournal {
+public:
+    RadarControlJournal();
+
+    void Set(ControlType ct, int value, RadarControlState state = RCS_MANUAL)
+    {
+        if (!m_pending_set[ct]) {
+            m_pending_set[ct] = true;
+            m_pending_list[m_pending_count++] = ct;
+        }
+        m_pending[ct].value = value;
+        m_pending[ct].state = state;
+    }
+    void Commit();
+
+    void Apply(RadarInfo* ri);
+
+private:
+    struct Entry {
+        int value;
+        RadarControlState state;
+    };
+
+    // Receive thread only
+    Entry m_pending[CT_MAX]; // Set since the last Commit()
+    bool m_pending_set[CT_MAX];
+    ControlType m_pending_list[CT_MAX];
+    int m_pending_count;
+    Entry m_sent[CT_MAX]; // Last committed
+    time_t m_sent_time[CT_MAX]; // When, 0 = never
+
+    wxCriticalSection m_exclusive; // protects the following
+    Entry m_shared[CT_MAX]; // Committed but not yet applied
+    bool m_shared_set[CT_MAX];
+    volatile bool m_shared_any; // Lets Apply() skip the lock when idle
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_CONTROL_JOURNAL_H_ */
@@ -33,6 +33,7 @@
 #define _RADAR_DRAW_H_
 
 #include "radar_pi.h"
+#include "spokeutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -46,9 +47,29 @@ public:
     virtual void DrawRadarPanelImage(double panel_scale, double panel_rotate)
         = 0;
     virtual void ProcessRadarSpoke(int transparency, SpokeBearing angle,
-        uint8_t* data, size_t len, GeoPosition spoke_pos)
+        const SpokeRuns& runs, GeoPosition spoke_pos)
         = 0;
 
+    // Forget all spokes processed so far. This must not depend on the number
+    // of spokes, as it runs on every range change.
+    virtual void ClearSpokes() { }
+
+    // Draw methods that show a shared RadarPolarImage return true, and are
+    // told which image to show before each draw instead of being passed the
+    // spokes through ProcessRadarSpoke.
+    virtual bool UsesPolarImage() { return false; }
+    virtual void SetPolarImage(RadarPolarImage* image, int reader) { }
+
+    // The level of detail to draw, see RadarPolarImage::GetLevelForScale.
+    // Level n has 2^n times fewer samples along each axis.
+    virtual void SetLevel(int level) { }
+
+    // Draw methods that do not use the fixed function matrices return true,
+    // and are given the column-major transform from samples to clip space
+    // before each draw instead.
+    virtual bool UsesOwnTransform() { return false; }
+    virtual void SetTransform(const GLfloat* transform) { }
+
     virtual ~RadarDraw() = 0;
 
     static void GetDrawingMethods(wxArrayString& methods);
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADARDRAWCORE_H_
+#define _RADARDRAWCORE_H_
+
+#include "RadarDrawShader.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define CORE_UNIFORM_BINDING (0) // Binding point of the RadarTransform block
+
+/*
+ * Draw the radar picture in the same way as RadarDrawShader, but only with
+ * calls that exist in an OpenGL 3.3 core or OpenGL ES 3 context: the quad is
+ * a static vertex buffer in a vertex array object, the transform and alpha
+ * are passed in a uniform block and no glBegin() or glPushAttrib() is used.
+ *
+ * Nor are the fixed function matrices read back, the caller computes the
+ * transform on the CPU and hands it over with SetTransform().
+ */
+class RadarDrawCore : public RadarDrawShader {
+public:
+    RadarDrawCore(RadarInfo* ri)
+        : RadarDrawShader(ri, false)
+    {
+        m_method = 3;
+        m_texture_format = GL_RED;
+        m_vao = 0;
+        m_vbo = 0;
+        m_ubo = 0;
+        CLEAR_STRUCT(m_transform);
+    }
+
+    ~RadarDrawCore();
+
+    bool Init(size_t spokes, size_t spoke_len_max);
+
+    bool UsesOwnTransform() { return true; }
+    void SetTransform(const GLfloat* transform)
+    {
+        memcpy(m_transform, transform, sizeof(m_transform));
+    }
+
+private:
+    GLuint m_vao; // Vertex array with the quad in m_vbo
+    GLuint m_vbo; // Position and polar coordinate of the four corners
+    GLuint m_ubo; // RadarTransform uniform block
+    GLfloat m_transform[16]; // From SetTransform()
+
+    void ResetCore();
+    void Draw(int transparency);
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARDRAWCORE_H_ */
@@ -36,22 +36,46 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
-#define SHADER_COLOR_CHANNELS (4) // RGB + Alpha
+#define SHADER_PALETTE_SIZE (64) // >= BLOB_COLOURS, power of 2
+#define SHADER_TIMING_FRAMES (100) // Report GPU time once per this many draws
 
+/*
+ * Draw the radar picture with a fragment shader that converts the polar
+ * RadarPolarImage to screen coordinates. The image holds BlobColour indices;
+ * the shader looks up the colour in a small palette texture and applies the
+ * transparency of the panel or overlay, so the same image serves both.
+ * The texture holds the level of the image that matches the scale on screen.
+ *
+ * With 'lookup' set the shader does not compute length() and atan() for
+ * every fragment, but reads radius and angle from a texture that is
+ * computed once for one quadrant; the other quadrants follow by symmetry.
+ *
+ * When the ShaderTiming setting is on, the GPU time of each draw is measured
+ * with timer queries and reported every SHADER_TIMING_FRAMES draws.
+ */
 class RadarDrawShader : public RadarDraw {
 public:
-    RadarDrawShader(RadarInfo* ri)
+    RadarDrawShader(RadarInfo* ri, bool lookup)
     {
         m_ri = ri;
-        m_start_line = -1; // No spokes received since last draw
-        m_lines = 0;
+        m_use_lookup = lookup;
+        m_method = lookup ? 2 : 1;
+        m_texture_format = GL_LUMINANCE;
+        m_image = 0;
+        m_reader = 0;
+        m_level = 0;
+        m_texture_level = -1;
         m_texture = 0;
+        m_palette = 0;
+        m_lookup = 0;
+        m_query[0] = 0;
+        m_query[1] = 0;
+        m_query_frames = 0;
+        m_query_measured = 0;
+        m_query_nanos = 0;
         m_fragment = 0;
         m_vertex = 0;
         m_program = 0;
-        m_format = GL_RGBA;
-        m_channels = SHADER_COLOR_CHANNELS;
-        m_data = 0;
         m_spokes = 0;
         m_spoke_len_max = 0;
     }
@@ -61,30 +85,48 @@ public:
     bool Init(size_t spokes, size_t spoke_len_max);
     void DrawRadarOverlayImage(double radar_scale, double panel_rotate);
     void DrawRadarPanelImage(double panel_scale, double panel_rotate);
-    void ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data,
-        size_t len, GeoPosition spoke_pos);
+    void ProcessRadarSpoke(int transparency, SpokeBearing angle,
+        const SpokeRuns& runs, GeoPosition spoke_pos);
+
+    bool UsesPolarImage() { return true; }
+    void SetPolarImage(RadarPolarImage* image, int reader);
+    void SetLevel(int level) { m_level = level; }
 
-private:
+protected:
     RadarInfo* m_ri;
+    bool m_use_lookup;
+    int m_method; // Index in GetDrawingMethods(), for logging
+    GLenum m_texture_format; // Format of m_texture: GL_LUMINANCE or GL_RED
+
+    RadarPolarImage* m_image; // The image shown, owned by RadarInfo
+    int m_reader; // Which reader of m_image we are
+    int m_level; // Level of m_image to draw
+    int m_texture_level; // Level that m_texture holds, -1 = none yet
 
-    wxCriticalSection m_exclusive; // protects the following data structures
-    unsigned char*
-        m_data; // [SHADER_COLOR_CHANNELS * m_spokes * m_spoke_len_max];
     size_t m_spokes;
     size_t m_spoke_len_max;
 
-    int m_start_line; // First line received since last draw, or -1
-    int m_lines; // # of lines received since last draw
-
-    int m_format;
-    int m_channels;
-
-    GLuint m_texture;
+    GLuint m_texture; // BlobColour rank per sample
+    GLuint m_palette; // RGBA per BlobColour
+    GLuint m_lookup; // Radius and angle of each point in one quadrant
     GLuint m_fragment;
     GLuint m_vertex;
     GLuint m_program;
 
+    GLuint m_query[2]; // Timer queries, alternating so we never wait for one
+    int m_query_frames;
+    int m_query_measured;
+    GLuint64 m_query_nanos;
+
     void Reset();
+    void CreateTextures();
+    void AllocateTexture();
+    void CreateLookupTexture();
+    void BeginTiming();
+    void EndTiming();
+    void UploadChangedLines();
+    void UploadPalette();
+    virtual void Draw(int transparency);
 };
 
 PLUGIN_END_NAMESPACE
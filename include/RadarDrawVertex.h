@@ -51,13 +51,20 @@ public:
         m_oom = false;
         m_spokes = 0;
         m_spoke_len_max = 0;
+        m_level = 0;
+        m_epoch = 0;
     }
 
     bool Init(size_t spokes, size_t spoke_len_max);
     void DrawRadarOverlayImage(double radar_scale, double panel_rotate);
     void DrawRadarPanelImage(double panel_scale, double panel_rotate);
-    void ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data,
-        size_t len, GeoPosition spoke_pos);
+    void ProcessRadarSpoke(int transparency, SpokeBearing angle,
+        const SpokeRuns& runs, GeoPosition spoke_pos);
+    void ClearSpokes();
+
+    // Spokes processed from now on are built with 2^level samples per blob
+    // step, so a zoomed out picture needs fewer triangles.
+    void SetLevel(int level) { m_level = level; }
 
     ~RadarDrawVertex()
     {
@@ -70,6 +77,7 @@ private:
     RadarInfo* m_ri;
     size_t m_spokes;
     size_t m_spoke_len_max;
+    volatile int m_level;
 
     static const int VERTEX_PER_TRIANGLE = 3;
     static const int VERTEX_PER_QUAD = 2 * VERTEX_PER_TRIANGLE;
@@ -89,15 +97,19 @@ private:
         size_t count;
         size_t allocated;
         GeoPosition spoke_pos;
+        unsigned int epoch; // Value of m_epoch when the line was built
     };
 
     void SetBlob(VertexLine* line, int angle_begin, int angle_end, int r1,
         int r2, GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha);
+    void SetBlob(VertexLine* line, SpokeBearing angle, int r1, int r2,
+        BlobColour colour, GLubyte alpha);
 
     void Reset();
     wxCriticalSection m_exclusive; // protects the following
     VertexLine* m_vertices;
     unsigned int m_count;
+    unsigned int m_epoch; // Lines from an older epoch are not drawn
     bool m_oom;
 };
 
@@ -34,8 +34,12 @@
 
 #include "ControlsDialog.h"
 #include "RadarControlItem.h"
+#include "RadarControlJournal.h"
+#include "RadarLifecycle.h"
+#include "RadarPolarImage.h"
 #include "RadarReceive.h"
 #include "radar_pi.h"
+#include "spokeutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -43,6 +47,9 @@ class RadarDraw;
 class RadarCanvas;
 class RadarPanel;
 class GuardZoneBogey;
+class GuardZoneMask;
+class PolarHistory;
+class ScanCorrelator;
 class RadarInfo;
 class TrailBuffer;
 
@@ -50,6 +57,9 @@ struct DrawInfo {
     RadarDraw* draw;
     int drawing_method;
     bool color_option;
+    GLGeometry guard_zone[GUARD_ZONES]; // Cached per GL context, the panel
+    GLGeometry no_transmit; // ones are released by ~RadarCanvas, the overlay
+                            // ones by radar_pi::DeInit
 };
 
 #define SECONDS_TO_REVOLUTIONS(x) ((x)*2 / 5)
@@ -67,7 +77,20 @@ enum {
 
 #define COURSE_SAMPLES (16)
 
-class RadarInfo {
+// The clutter filter (CT_CFAR) windows cover about the same distance at every
+// range, within the sample limits.
+#define CFAR_WINDOW_METERS (100)
+#define CFAR_WINDOW_MIN (4)
+#define CFAR_WINDOW_MAX (32)
+#define CFAR_GUARD_METERS (25)
+#define CFAR_GUARD_MAX (16)
+
+// Scan correlation (CT_SCAN_CORRELATION) passes returns seen in this many of
+// the last revolutions.
+#define SCAN_CORRELATION_HITS (3)
+#define SCAN_CORRELATION_REVOLUTIONS (4)
+
+class RadarInfo : public RadarLifecycleHost {
     friend class TrailBuffer;
 
 public:
@@ -152,6 +175,8 @@ public:
     RadarControlItem m_doppler;
     RadarControlItem m_autotrack_doppler;
     RadarControlItem m_threshold;
+    RadarControlItem m_cfar; // CT_CFAR, software clutter filter
+    RadarControlItem m_scan_correlation; // CT_SCAN_CORRELATION, SCAN_CORRELATION_*
     RadarControlItem m_tune_fine; // Following added for Raymarine E120
     RadarControlItem m_tune_coarse;
     RadarControlItem
@@ -182,47 +207,36 @@ public:
     RadarLocationInfo
         m_radar_location_info; // Navico and Raymarine specific stuff (multicast
                                // addresses + serial nr)
+    bool m_discovery_changed; // One of the three above changed since saved
     RadarControl* m_control;
     RadarReceive* m_receive;
+    RadarControlJournal m_control_journal; // Control values from m_receive
     ControlsDialog* m_control_dialog;
     RadarPanel* m_radar_panel;
     RadarCanvas* m_radar_canvas;
 
     /* Abstractions of our own. Some filled by RadarReceive. */
 
-    time_t m_radar_timeout; // When we consider the radar no longer valid
-    time_t m_data_timeout; // When we consider the data to be obsolete (radar no
-                           // longer sending data)
-    time_t m_stayalive_timeout; // When we will send another stayalive ping
-#define STAYALIVE_TIMEOUT (5) // Send data every 5 seconds to ping radar
-#define DATA_TIMEOUT (5)
+    RadarLifecycle m_lifecycle; // Loss of data and presence, stayalive, timed transmit
 
     bool m_status_text_hide;
 
     int m_refresh_millis;
 
     GuardZone* m_guard_zone[GUARD_ZONES];
+    GuardZoneMask* m_guard_zone_mask;
     double m_ebl[ORIENTATION_NUMBER][BEARING_LINES];
     double m_vrm[BEARING_LINES];
     receive_statistics m_statistics;
 
-    struct line_history {
-        uint8_t* line;
-        wxLongLong time;
-        GeoPosition pos;
-    };
-
-    line_history* m_history;
+    PolarHistory* m_history;
+    ScanCorrelator* m_correlator;
 
     int m_old_range;
     int m_dir_lat;
     int m_dir_lon;
     TrailBuffer* m_trails;
 
-    // Timed Transmit
-    time_t m_idle_standby; // When we will change to standby
-    time_t m_idle_transmit; // When we will change to transmit
-
     /* Methods */
 
     RadarInfo(radar_pi* pi, int radar);
@@ -236,20 +250,26 @@ public:
     void SetAutoRangeMeters(int meters);
     bool SetControlValue(ControlType controlType, RadarControlItem& item,
         RadarControlButton* button);
+    // The item that holds a control the radar reports, or 0
+    RadarControlItem* GetControlItem(ControlType controlType);
     void ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing,
         uint8_t* data, size_t len, int range_meters, wxLongLong time);
+    // Same, for decoders that produce the spoke as runs.
+    void ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing,
+        const SpokeRuns& runs, int range_meters, wxLongLong time);
     void RefreshDisplay();
-    void RenderGuardZone();
+    void RenderGuardZone(DrawInfo* di);
+    void ReleasePanelGeometry(bool context_current);
+    void ReleaseOverlayGeometry(bool context_current);
     void ResetRadarImage();
     void ShiftImageLonToCenter();
     void ShiftImageLatToCenter();
-    void RenderRadarImage1(
-        wxPoint center, double scale, double rotation, bool overlay);
+    void RenderRadarImage1(wxPoint center, double scale, double rotation,
+        bool overlay, wxSize viewport);
     void ShowRadarWindow(bool show);
     void ShowControlDialog(bool show, bool reparent);
     void Shutdown();
     void CalculateRotationSpeed(SpokeBearing angle);
-    void UpdateTransmitState();
     void RequestRadarState(RadarState state);
     int GetDrawTime()
     {
@@ -265,17 +285,9 @@ public:
     }
     bool IsPaneShown();
 
-    void resetTimeout(time_t now)
-    {
-        wxCriticalSectionLocker lock(m_exclusive);
-
-        m_radar_timeout = now + WATCHDOG_TIMEOUT;
-    };
-
     void UpdateControlState(bool all);
     void ComputeColourMap();
     void ComputeTargetTrails();
-    void CheckTimedTransmit();
     void SetTimedNextStateTimer(int ms);
     wxString GetRangeText();
     wxString GetDisplayRangeStr(int meters, bool unit);
@@ -315,6 +327,20 @@ public:
     bool GetRadarPosition(GeoPosition* pos);
     bool GetRadarPosition(ExtendedPosition* radar_pos);
 
+    // While a recording plays, the position and heading it was made with
+    // replace those from OpenCPN for this radar only.
+    void SetPlaybackNavigation(GeoPosition pos, double heading);
+    void ClearPlaybackNavigation();
+    double GetHeadingTrue();
+    HeadingSource GetHeadingSource();
+
+    // The clock that the spoke times are on. Live this is the wall clock;
+    // while a recording plays it is the recorded clock, started at 'start'
+    // on the wall clock and running 'speed' times as fast.
+    void SetPlaybackClock(wxLongLong start, double speed);
+    void ClearPlaybackClock();
+    wxLongLong GetRadarTime();
+
     wxString GetCanvasTextTopLeft();
     wxString GetCanvasTextBottomLeft();
     wxString GetCanvasTextCenter();
@@ -327,6 +353,23 @@ public:
     void SetRadarInterfaceAddress(NetworkAddress& ifaddr, NetworkAddress& addr);
     NetworkAddress GetRadarAddress();
     NetworkAddress GetRadarInterfaceAddress();
+    bool TakeDiscoveryChanged();
+
+    // RadarLifecycleHost
+    LifecycleState GetLifecycleState();
+    void OnDataLost();
+    void OnPresenceLost();
+    void SendStayAlive();
+    void RequestTransmit(bool transmit);
+    bool IsBootTransmitPending();
+    void ClearBootTransmit();
+    TimedTransmitMode GetTimedTransmitMode();
+    int GetTimedRunSeconds();
+    int GetTimedIdleSeconds();
+    bool HoldTransmit();
+    void RenewTimedTransmit();
+    void SetCountdown(int seconds);
+    void WakeLifecycle();
 
     GeoPosition m_mouse_pos;
     double m_mouse_ebl[ORIENTATION_NUMBER];
@@ -340,6 +383,12 @@ public:
     // Speedup PolarToCartesian lookup (angle,radius) -> (x, y)
     PolarToCartesianLookup* m_polar_lookup;
 
+    // The picture for draw methods that use a RadarPolarImage. When the panel
+    // and the overlay show the same data (stabilized orientation and trails on
+    // the overlay) both read the panel image and the overlay image is idle.
+    RadarPolarImage* m_polar_image[POLAR_IMAGE_READERS];
+    volatile bool m_polar_image_shared;
+
     void AdjustRange(int adjustment, int current_range_meters);
     int GetNearestRange(int range_meters, int units);
 
@@ -355,8 +404,11 @@ public:
 
 private:
     void ResetSpokes();
-    void RenderRadarImage2(
-        DrawInfo* di, double radar_scale, double panel_rotate);
+    void ProcessSpokeRuns(SpokeBearing angle, SpokeBearing bearing,
+        int range_meters, wxLongLong time);
+    void RenderRadarImage2(DrawInfo* di, wxPoint center, double radar_scale,
+        double panel_rotate, const double* clip);
+    void BuildGuardZoneGeometry(GuardZone* zone, GLGeometry* geometry);
     wxString FormatDistance(double distance);
     wxString FormatAngle(double angle);
 
@@ -377,6 +429,21 @@ private:
     int m_previous_orientation;
 
     GeoPosition m_radar_position;
+    bool m_playback_navigation; // The following replace m_radar_position and the heading
+    GeoPosition m_playback_position;
+    double m_playback_heading;
+    wxLongLong m_playback_clock_start; // 0 when live
+    double m_playback_clock_speed;
+
+    RadarRecorder* m_recorder; // Records the spokes when record_directory is set
+
+    // The spoke being processed, only used on the receive thread. Consumers
+    // that can iterate the runs do so, the samples are kept for the trails.
+    SpokeRuns m_spoke_runs;
+    uint8_t m_spoke_samples[SPOKE_LEN_MAX];
+    SpokeCfar m_cfar_detector;
+    SpokeRuns m_persistent_runs; // What m_correlator passes of m_spoke_runs
+    bool m_correlating; // Whether m_correlator saw the previous spoke
 };
 
 PLUGIN_END_NAMESPACE
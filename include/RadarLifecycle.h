@@ -0,0 +1,235 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADAR_LIFECYCLE_H_
+#define _RADAR_LIFECYCLE_H_
+
+#include <atomic>
+
+#include "pi_common.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define DEADLINE_WHEEL_SLOTS (64) // Must be a power of two
+#define DEADLINE_WHEEL_TICK_MS (100)
+
+/*
+ * A hashed timer wheel of a fixed number of one-shot timers, each known by
+ * a small integer id.
+ *
+ * A timer lives in the slot of the tick its deadline falls in, so arming and
+ * cancelling are O(1), and Expire() only visits the slots for the ticks that
+ * passed since it was last called. Deadlines further away than one turn of
+ * the wheel simply stay in their slot until their turn comes round.
+ *
+ * Times are milliseconds on any monotonic clock. Main thread only.
+ */
+class DeadlineWheel {
+public:
+    DeadlineWheel(int timers);
+    ~DeadlineWheel();
+
+    void Arm(int id, wxLongLong deadline);
+    void Cancel(int id);
+    bool IsArmed(int id) { return m_timer[id].slot >= 0; }
+    wxLongLong GetDeadline(int id) { return m_timer[id].deadline; }
+
+    // Returns an expired timer, which is no longer armed, or -1 if none is
+    // left. Call until it returns -1.
+    int Expire(wxLongLong now);
+    // Returns false if no timer is armed.
+    bool GetNextDeadline(wxLongLong* deadline);
+
+private:
+    struct Timer {
+        wxLongLong deadline;
+        int slot; // -1 = not armed
+        int prev;
+        int next;
+    };
+
+    int SlotOf(wxLongLong tick)
+    {
+        return (int)(tick.GetLo() & (DEADLINE_WHEEL_SLOTS - 1));
+    }
+
+    int m_timers;
+    Timer* m_timer;
+    int m_head[DEADLINE_WHEEL_SLOTS];
+    wxLongLong m_tick; // Tick that Expire() has visited up to
+    int m_armed;
+};
+
+// Returns milliseconds since some fixed point, not affected by clock changes.
+extern wxLongLong GetMonotonicMillis();
+
+enum LifecycleTimer {
+    LT_DATA, // No spokes for LIFECYCLE_DATA_TIMEOUT
+    LT_PRESENCE, // No packets at all for LIFECYCLE_PRESENCE_TIMEOUT
+    LT_STAYALIVE, // Time to ping the radar
+    LT_BOOT, // Waiting for standby to honour 'transmit at boot'
+    LT_TIMED_TRANSMIT, // Timed transmit changes state
+    LT_COUNTDOWN, // Timed transmit countdown ticks down a second
+    LT_TIMERS
+};
+
+// The radar state as far as the lifecycle is concerned
+enum LifecycleState {
+    LS_OFF,
+    LS_STANDBY,
+    LS_TRANSMIT,
+    LS_BUSY // Warming up, spinning up or down, etc.
+};
+
+enum TimedTransmitMode { TTM_OFF, TTM_SOFTWARE, TTM_HARDWARE };
+
+#define LIFECYCLE_DATA_TIMEOUT (5000)
+#define LIFECYCLE_PRESENCE_TIMEOUT (10000)
+#define LIFECYCLE_STAYALIVE (5000) // Ping the radar this often
+#define LIFECYCLE_TIMED_TRANSMIT_START (10000) // First change after enabling
+#define LIFECYCLE_RETRY (1000) // Look again at a deadline we could not honour
+
+/*
+ * What the lifecycle needs to know about, and do to, a radar. Implemented by
+ * RadarInfo, and by a fake in the tests.
+ */
+class RadarLifecycleHost {
+public:
+    virtual ~RadarLifecycleHost() { }
+
+    virtual LifecycleState GetLifecycleState() = 0;
+    virtual void OnDataLost() = 0; // Radar is now in standby
+    virtual void OnPresenceLost() = 0; // Radar is now off
+    virtual void SendStayAlive() = 0;
+    virtual void RequestTransmit(bool transmit) = 0;
+
+    virtual bool IsBootTransmitPending() = 0;
+    virtual void ClearBootTransmit() = 0;
+
+    virtual TimedTransmitMode GetTimedTransmitMode() = 0;
+    virtual int GetTimedRunSeconds() = 0;
+    virtual int GetTimedIdleSeconds() = 0;
+    virtual bool HoldTransmit() = 0; // Targets that must not be lost
+    virtual void RenewTimedTransmit() = 0; // Hardware timed transmit only
+    virtual void SetCountdown(int seconds) = 0; // Software timed transmit only
+
+    // Called from a receive thread; have the main thread call Wake() soon.
+    virtual void WakeLifecycle() = 0;
+};
+
+/*
+ * The lifecycle of one radar: losing data and presence, stay-alive pings,
+ * 'transmit at boot' and software timed transmit.
+ *
+ * Nothing is polled. Each of these has a timer in the DeadlineWheel that is
+ * armed for the moment something needs to happen. The receive threads only
+ * note when they last saw a packet with DataReceived() and ReportReceived();
+ * when LT_DATA or LT_PRESENCE fires and newer packets were seen the timer is
+ * simply armed again for the new deadline. Only when a radar comes back
+ * after its timer was allowed to lapse does the receive thread need to wake
+ * the main thread, through WakeLifecycle().
+ *
+ * All methods except DataReceived(), ReportReceived() and Detected() are
+ * for the main thread only, which also owns the wheel. They take the
+ * current time so that the tests can run them on a fake clock.
+ */
+class RadarLifecycle {
+public:
+    RadarLifecycle(
+        RadarLifecycleHost* host, DeadlineWheel* wheel, int first_timer);
+    ~RadarLifecycle();
+
+    // Receive thread events
+    void DataReceived(wxLongLong now);
+    void DataReceived() { DataReceived(GetMonotonicMillis()); }
+    void ReportReceived(wxLongLong now);
+    void ReportReceived() { ReportReceived(GetMonotonicMillis()); }
+    void Detected(); // Transmit socket (re)opened
+
+    // Main thread events
+    void Wake(wxLongLong now);
+    void OnTimer(LifecycleTimer timer, wxLongLong now);
+    void CommandSent(wxLongLong now); // Transmit or standby was sent
+    void TimedTransmitChanged(wxLongLong now);
+
+    bool IsTimedTransmitRunning() { return m_timed_transmit != TT_NONE; }
+
+private:
+    enum TimedTransmit {
+        TT_NONE,
+        TT_UNTIL_STANDBY, // Transmit, go to standby at m_timed_deadline
+        TT_UNTIL_TRANSMIT // Standby, start transmitting at m_timed_deadline
+    };
+
+    void Arm(LifecycleTimer timer, wxLongLong deadline)
+    {
+        m_wheel->Arm(m_first_timer + timer, deadline);
+    }
+    void Cancel(LifecycleTimer timer)
+    {
+        m_wheel->Cancel(m_first_timer + timer);
+    }
+    bool IsArmed(LifecycleTimer timer)
+    {
+        return m_wheel->IsArmed(m_first_timer + timer);
+    }
+
+    void CheckData(wxLongLong now);
+    void CheckPresence(wxLongLong now);
+    void CheckBoot(wxLongLong now);
+    void CheckTimedTransmit(wxLongLong now);
+    void UpdateCountdown(wxLongLong now);
+
+    RadarLifecycleHost* m_host;
+    DeadlineWheel* m_wheel;
+    int m_first_timer;
+
+    // Written by the receive thread. All of these are sequentially consistent
+    // atomics: a 64 bit time can tear on 32 bit CPUs, and the handshake in
+    // CheckData() and CheckPresence() needs the store of the flag to be
+    // ordered before the load of the time.
+    std::atomic<int64_t> m_data_time;
+    std::atomic<int64_t> m_report_time;
+    std::atomic<bool> m_detected;
+
+    // Set by the receive thread when it wakes us, cleared by the main thread
+    // when it lets the corresponding timer lapse.
+    std::atomic<bool> m_data_armed;
+    std::atomic<bool> m_presence_armed;
+
+    TimedTransmit m_timed_transmit;
+    wxLongLong m_timed_deadline;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_LIFECYCLE_H_ */
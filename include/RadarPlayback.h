@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADARPLAYBACK_H_
+#define _RADARPLAYBACK_H_
+
+#include "RadarReceive.h"
+#include "RadarRecorder.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define PLAYBACK_MAX_SLEEP (100) // Millis, so that Shutdown() is seen quickly
+
+/*
+ * Plays a recording made by RadarRecorder instead of receiving from the
+ * radar, at the original pace times 'playback_speed'. The spokes go through
+ * the normal ProcessRadarSpoke path, so trails, ARPA, guard zones and all
+ * drawing work as they did live. The recorded position and heading replace
+ * those from OpenCPN for this radar, so targets, trails and the overlay
+ * end up where they were; they are also shown in the info status.
+ *
+ * At the end the recording starts again from the beginning.
+ */
+class RadarPlayback : public RadarReceive {
+public:
+    RadarPlayback(radar_pi* pi, RadarInfo* ri, const wxString& filename)
+        : RadarReceive(pi, ri)
+    {
+        m_filename = filename;
+        m_shutdown = false;
+        m_recorded_time = 0;
+        m_recorded_pos.lat = 0.;
+        m_recorded_pos.lon = 0.;
+        m_recorded_heading = 0.;
+    }
+
+    void* Entry(void);
+    void Shutdown(void) { m_shutdown = true; }
+    wxString GetInfoStatus();
+
+private:
+    bool Sleep(wxLongLong millis);
+
+    wxString m_filename;
+    RadarRecording m_recording;
+    volatile bool m_shutdown;
+
+    wxCriticalSection m_lock; // Protects the following
+    wxLongLong m_recorded_time;
+    GeoPosition m_recorded_pos;
+    double m_recorded_heading;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARPLAYBACK_H_ */
@@ -0,0 +1,138 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADAR_POLAR_IMAGE_H_
+#define _RADAR_POLAR_IMAGE_H_
+
+#include "radar_pi.h"
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// The draw methods that read a RadarPolarImage, each with its own record of
+// which spokes it has not uploaded yet.
+enum PolarImageReader { POLAR_IMAGE_PANEL, POLAR_IMAGE_OVERLAY, POLAR_IMAGE_READERS };
+
+#define POLAR_IMAGE_LEVELS (4) // Full resolution and three halvings
+
+/*
+ * The radar picture as one byte per sample, [m_spokes][m_spoke_len_max].
+ *
+ * A spoke is colour mapped and stored once, however many draw methods show
+ * it. The readers (the PPI panel and the chart overlay) each upload the
+ * spokes that changed since their previous frame and apply the colours and
+ * their own transparency on the GPU.
+ *
+ * The image also keeps lower resolution levels, each half the spokes and
+ * half the samples of the one above, for when the radar covers only a few
+ * hundred pixels on screen. These are updated with every spoke by taking
+ * the maximum of each 2 x 2 block, so a small target does not vanish when
+ * zoomed out.
+ *
+ * For this the bytes are not BlobColour values but their rank: the more
+ * important a colour, the higher its rank. See PolarImageRank().
+ *
+ * Clear() only starts a new epoch. A line written in an older epoch is
+ * zeroed when it is next written or handed to a reader, so the receive
+ * thread does not wait for the whole image to be wiped on a range change.
+ */
+class RadarPolarImage {
+public:
+    RadarPolarImage(RadarInfo* ri, size_t spokes, size_t spoke_len_max);
+    ~RadarPolarImage();
+
+    void Clear(); // Constant time, see above
+    void ProcessRadarSpoke(SpokeBearing angle, const SpokeRuns& runs);
+
+    // Return the lines of 'level' that changed since the previous call for
+    // 'reader' as [*start_line..*start_line + *lines> (modulo the number of
+    // spokes in the level), and forget them. Returns false when nothing
+    // changed. Lines left over from before a Clear() are zeroed first, so
+    // GetLine() returns what the reader should show. Call with m_exclusive
+    // locked.
+    bool GetChangedLines(int reader, int level, int* start_line, int* lines);
+
+    // Make the next GetChangedLines for 'reader' return the whole image
+    void SetAllChanged(int reader);
+
+    const uint8_t* GetLine(int level, int angle) const
+    {
+        return m_level[level].data + (size_t)angle * m_level[level].spoke_len;
+    }
+    size_t GetSpokes(int level) const { return m_level[level].spokes; }
+    size_t GetSpokeLen(int level) const { return m_level[level].spoke_len; }
+
+    // The level to draw when one sample of the full image covers
+    // 'pixels_per_sample' pixels on screen.
+    static int GetLevelForScale(double pixels_per_sample);
+
+    size_t m_spokes;
+    size_t m_spoke_len_max;
+
+    wxCriticalSection m_exclusive; // protects the data and the change records
+
+private:
+    struct Level {
+        size_t spokes;
+        size_t spoke_len;
+        uint8_t* data;
+        uint32_t* epoch; // Epoch in which each line was written, [spokes]
+    };
+
+    void MarkChanged(SpokeBearing angle);
+    const uint8_t* CurrentLine(int level, size_t line);
+    void UpdateLevel(int level, size_t line);
+
+    RadarInfo* m_ri;
+    Level m_level[POLAR_IMAGE_LEVELS];
+    uint32_t m_epoch; // Incremented by Clear()
+
+    int m_start_line[POLAR_IMAGE_READERS]; // First line changed since last upload, or -1
+    int m_lines[POLAR_IMAGE_READERS]; // # of lines changed since last upload
+};
+
+/*
+ * The rank of a BlobColour, and the colour of a rank. Echoes rank above
+ * trails and recent trails above old ones, so BLOB_HISTORY_0..31 are
+ * reversed and the other colours keep their value.
+ */
+inline int PolarImageRank(int colour_or_rank)
+{
+    if (colour_or_rank >= BLOB_HISTORY_0 && colour_or_rank <= BLOB_HISTORY_MAX) {
+        return BLOB_HISTORY_0 + BLOB_HISTORY_MAX - colour_or_rank;
+    }
+    return colour_or_rank;
+}
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADAR_POLAR_IMAGE_H_ */
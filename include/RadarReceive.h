@@ -36,6 +36,8 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
+#define DISCOVERY_CACHE_PERIOD (60) // Seconds to wait on the cached interface
+
 //
 // The base class for a specific implementation of a thread
 // that receives data from a radar.
@@ -49,6 +51,7 @@ public:
         Create(1024 * 1024); // Stack size, be liberal
         m_pi = pi; // This allows you to access the main plugin stuff
         m_ri = ri; // and this the per-radar stuff
+        m_cache_until = 0;
     }
 
     virtual ~RadarReceive() { }
@@ -78,8 +81,23 @@ public:
     virtual SOCKET GetCommSocket() { return INVALID_SOCKET; }
 
 protected:
+    /*
+     * When the config contains the interface and addresses where the radar was
+     * seen last time the receive thread listens there straight away, and keeps
+     * doing so for DISCOVERY_CACHE_PERIOD instead of moving on to the next
+     * network card while the radar is still booting. The locator keeps looking
+     * on all cards in the meantime and replaces stale addresses when it hears
+     * the radar somewhere else.
+     */
+    void StartDiscoveryCache(bool cached)
+    {
+        m_cache_until = cached ? time(0) + DISCOVERY_CACHE_PERIOD : 0;
+    }
+    bool UsingDiscoveryCache() { return time(0) < m_cache_until; }
+
     radar_pi* m_pi;
     RadarInfo* m_ri;
+    time_t m_cache_until;
 };
 
 PLUGIN_END_NAMESPACE
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RADARRECORDER_H_
+#define _RADARRECORDER_H_
+
+#include "radar_pi.h"
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+/*
+ * A recording is a file with a RecordingHeader followed by one record per
+ * spoke, as it came from the decoder: before main bang, threshold, trails
+ * and colours. Each record is a RecordedSpoke followed by its runs, every
+ * run stored as the gap since the end of the previous run and the length
+ * minus one (both as LEB128 varints) and the value.
+ *
+ * Spokes do not depend on each other, so playback can start at any spoke.
+ * When the recording is closed the file offset of the first spoke of every
+ * revolution is appended as an index with a RecordingTrailer, so playback
+ * can seek to any revolution at once. A recording that was not closed is
+ * indexed by scanning it when it is opened.
+ */
+
+#define RECORDING_MAGIC "RADARREC"
+#define RECORDING_INDEX_MAGIC "RADARIDX"
+#define RECORDING_VERSION (1)
+#define RECORDING_EXTENSION wxT("radarrec")
+#define RECORDING_BUFFER_SIZE (256 * 1024) // stdio buffer, written about once a minute
+
+#pragma pack(push, 1)
+
+struct RecordingHeader {
+    char magic[8]; // RECORDING_MAGIC
+    uint32_t version; // RECORDING_VERSION
+    uint32_t spokes; // Spokes per revolution
+    uint32_t spoke_len_max; // Samples per spoke
+    uint32_t reserved;
+};
+
+struct RecordedSpoke {
+    uint16_t size; // Bytes in this record, including this header
+    uint16_t angle;
+    uint16_t bearing;
+    uint16_t len; // Samples in the spoke
+    int32_t range_meters;
+    int64_t time; // Millis since the epoch, UTC
+    int32_t lat; // Radar position in 1e-7 degrees
+    int32_t lon;
+    uint16_t heading; // True heading in 1/100 degrees
+    uint16_t runs; // Number of runs that follow
+};
+
+struct RecordingIndex {
+    uint64_t offset; // Of the first spoke of a revolution
+    int64_t time; // Of that spoke
+};
+
+struct RecordingTrailer {
+    char magic[8]; // RECORDING_INDEX_MAGIC
+    uint64_t index_offset; // Of the first RecordingIndex
+    uint64_t revolutions; // Number of RecordingIndex entries
+};
+
+#pragma pack(pop)
+
+// Largest record: a run takes at most 3 bytes per sample it covers, or 5
+// when it covers at least 128.
+#define RECORDING_MAX_RECORD (sizeof(RecordedSpoke) + 4 * SPOKE_LEN_MAX)
+
+/*
+ * Writes the spokes of one radar to a recording. AddSpoke() is called on the
+ * receive thread and costs an encode into a stack buffer and a buffered
+ * fwrite.
+ */
+class RadarRecorder {
+public:
+    RadarRecorder(RadarInfo* ri);
+    ~RadarRecorder();
+
+    bool Open(const wxString& filename, size_t spokes, size_t spoke_len_max);
+    void AddSpoke(SpokeBearing angle, SpokeBearing bearing,
+        const SpokeRuns& runs, int range_meters, wxLongLong time,
+        const GeoPosition& pos, double heading);
+
+    wxString GetFileName() { return m_filename; }
+
+private:
+    void Close();
+
+    RadarInfo* m_ri;
+    wxString m_filename;
+    FILE* m_file;
+    uint64_t m_offset; // Where the next spoke goes
+    int m_previous_angle;
+    vector<RecordingIndex> m_index;
+};
+
+/*
+ * A recording mapped into memory for playback.
+ */
+class RadarRecording {
+public:
+    RadarRecording();
+    ~RadarRecording();
+
+    bool Open(const wxString& filename);
+
+    size_t GetSpokes() { return m_header.spokes; }
+    size_t GetSpokeLen() { return m_header.spoke_len_max; }
+    size_t GetRevolutions() { return m_index.size(); }
+    wxLongLong GetStartTime();
+
+    // Continue at the first spoke of revolution 'revolution'.
+    void SeekRevolution(size_t revolution);
+    // Continue at the revolution that contains 'time'.
+    void Seek(wxLongLong time);
+
+    // Decode the next spoke, returns false at the end of the recording.
+    bool NextSpoke(RecordedSpoke* spoke, SpokeRuns* runs);
+
+private:
+    void Close();
+    bool ReadIndex();
+    void BuildIndex();
+    size_t DecodeSpoke(size_t offset, RecordedSpoke* spoke, SpokeRuns* runs);
+
+    RecordingHeader m_header;
+    const uint8_t* m_data;
+    size_t m_size; // Of the mapped file
+    size_t m_end; // End of the spoke records
+    size_t m_offset; // Next spoke to decode
+    vector<RecordingIndex> m_index;
+#ifdef __WXMSW__
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_fd;
+#endif
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RADARRECORDER_H_ */
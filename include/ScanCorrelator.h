@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _SCAN_CORRELATOR_H_
+#define _SCAN_CORRELATOR_H_
+
+#include "PolarHistory.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SCAN_CORRELATOR_REVOLUTIONS_MAX (8)
+
+/*
+ * Scan-to-scan correlation: passes on only the returns that were also seen
+ * in at least 'hits' of the last 'revolutions' revolutions, this one
+ * included. Sea clutter comes and goes from one revolution to the next,
+ * while ships, buoys and land stay.
+ *
+ * For every sample it remembers whether there was a return in each of the
+ * previous revolutions, as bit planes along the range axis like
+ * PolarHistory, so 64 samples are counted with a few 64-bit operations.
+ * The earlier revolutions are widened by one sample on either side, so that
+ * a target that moves a little along the spoke is still recognised.
+ *
+ * Spokes are kept by bearing, so turning the boat does not break up the
+ * correlation. While the boat turns a bearing can be written twice in one
+ * revolution of the radar; the second write is merged into the first one
+ * instead of taking the place of another revolution, and is compared with
+ * one earlier revolution fewer. Clear() takes constant time, as in
+ * PolarHistory.
+ *
+ * Only used on the receive thread.
+ */
+class ScanCorrelator {
+public:
+    ScanCorrelator(size_t spokes, size_t spoke_len_max, int revolutions,
+        int hits);
+    ~ScanCorrelator();
+
+    // Forget all earlier revolutions, in constant time.
+    void Clear();
+
+    // Remember the returns in 'runs' as the latest revolution of 'bearing',
+    // and set 'persistent' to those of them that were seen often enough.
+    // 'angle' is the spoke relative to the radar, a new revolution starts
+    // when it wraps around.
+    void Correlate(SpokeBearing angle, SpokeBearing bearing,
+        const SpokeRuns& runs, SpokeRuns* persistent);
+
+private:
+    uint64_t* Plane(SpokeBearing bearing, int plane)
+    {
+        return m_data + ((size_t)bearing * m_planes + plane) * m_words;
+    }
+
+    int m_spokes;
+    size_t m_spoke_len_max;
+    size_t m_words; // Words per plane
+    int m_planes; // Earlier revolutions kept per spoke, revolutions - 1
+    int m_hits; // Needed in the earlier revolutions, hits - 1
+    uint64_t* m_data; // [m_spokes][m_planes][m_words]
+    uint8_t* m_oldest; // Plane of each spoke with its oldest revolution
+    uint32_t m_epoch; // Incremented by Clear()
+    uint32_t* m_spoke_epoch; // Epoch in which each spoke was last written
+    SpokeBearing m_last_angle;
+    uint32_t m_revolution; // Incremented when the angle wraps around
+    uint32_t* m_spoke_revolution; // Revolution in which each spoke was last written
+    vector<uint64_t> m_current; // This revolution, [m_words]
+    vector<uint64_t> m_persistent; // Samples that pass, [m_words]
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _SCAN_CORRELATOR_H_ */
@@ -173,6 +173,23 @@
         _("Off"), _("On")                                                      \
     }
 #endif
+// CT_SCAN_CORRELATION is a combination of these
+#define SCAN_CORRELATION_DISPLAY (1)
+#define SCAN_CORRELATION_GUARD (2)
+#define SCAN_CORRELATION_ARPA (4)
+#ifndef SCAN_CORRELATION_NAMES
+#define SCAN_CORRELATION_NAMES                                                 \
+    {                                                                          \
+        _("Off"), _("Display"), _("Guard zones"), _("Display + guard zones"),  \
+            _("ARPA"), _("Display + ARPA"), _("Guard zones + ARPA"), _("All")  \
+    }
+#endif
+#ifndef CFAR_NAMES
+#define CFAR_NAMES                                                             \
+    {                                                                          \
+        _("Off"), _("Low"), _("Medium"), _("High")                             \
+    }
+#endif
 
 HAVE_CONTROL(CT_ANTENNA_FORWARD, CTD_AUTO_NO, CTD_DEF_ZERO, -500, +500,
     CTD_STEP_1, CTD_NUMERIC)
@@ -188,6 +205,10 @@ HAVE_CONTROL(CT_OVERLAY_CANVAS, CTD_AUTO_NO, CTD_DEF_ZERO, CTD_MIN_ZERO, 1,
     CTD_STEP_1, OFF_ON_NAMES)
 HAVE_CONTROL(CT_REFRESHRATE, CTD_AUTO_NO, 1, 1, 5, CTD_STEP_1, CTD_NUMERIC)
 HAVE_CONTROL(CT_THRESHOLD, CTD_AUTO_NO, 0, 0, 100, 10, CTD_PERCENTAGE)
+HAVE_CONTROL(CT_CFAR, CTD_AUTO_NO, CTD_DEF_ZERO, CTD_MIN_ZERO, 3, CTD_STEP_1,
+    CFAR_NAMES)
+HAVE_CONTROL(CT_SCAN_CORRELATION, CTD_AUTO_NO, CTD_DEF_ZERO, CTD_MIN_ZERO, 7,
+    CTD_STEP_1, SCAN_CORRELATION_NAMES)
 HAVE_CONTROL(CT_TRANSPARENCY, CTD_AUTO_NO, 5, MIN_OVERLAY_TRANSPARENCY,
     MAX_OVERLAY_TRANSPARENCY, CTD_STEP_1, CTD_PERCENTAGE)
 HAVE_CONTROL(CT_TARGET_TRAILS, CTD_AUTO_NO, CTD_DEF_OFF, CTD_MIN_ZERO, 6,
@@ -28,6 +28,8 @@
 
 #include "pi_common.h"
 
+#include <vector>
+
 PLUGIN_BEGIN_NAMESPACE
 
 /* support ascii plus degree symbol for now pack font in a single texture 16x8
@@ -46,30 +48,59 @@ struct TexGlyphInfo {
     float advance;
 };
 
+/*
+ * The rendered glyphs of one font, shared by every TextureFont that uses the
+ * same face, size, weight, style and blur. Building an atlas draws all glyphs
+ * through a wxMemoryDC, so this is done once per font instead of once per
+ * window. The atlas is plain memory; each GL context uploads its own texture.
+ */
+struct TextureFontAtlas {
+    TexGlyphInfo tgi[MAX_GLYPH];
+    int tex_w, tex_h;
+    unsigned char* alpha; // tex_w * tex_h intensities
+};
+
 class TextureFont {
 public:
     TextureFont()
     {
         m_texobj = 0;
         m_blur = false;
+        m_luminance = false;
+        m_atlas = 0;
+        m_tgi = 0;
     }
 
+    // Cheap when the font did not change since the last call
     void Build(wxFont& font, bool blur = false, bool luminance = false);
     void Delete();
 
     void GetTextExtent(const wxString& string, int* width, int* height);
     void RenderString(const wxString& string, int x = 0, int y = 0);
 
+    // Free the glyph atlases shared by all fonts; no TextureFont may be in use
+    static void FreeAtlases();
+
 private:
-    void RenderGlyph(wchar_t c);
+    float RenderGlyph(wchar_t c);
+    void FlushQuads();
+
+    static TextureFontAtlas* GetAtlas(
+        const wxString& key, wxFont& font, bool blur);
 
     wxFont m_font;
+    wxString m_key;
     bool m_blur;
+    bool m_luminance;
 
-    TexGlyphInfo m_tgi[MAX_GLYPH];
+    TextureFontAtlas* m_atlas;
+    const TexGlyphInfo* m_tgi;
 
     unsigned int m_texobj;
     int tex_w, tex_h;
+
+    // Glyph quads of the string being rendered, drawn in one call
+    vector<float> m_quads; // s, t, x, y per vertex
 };
 
 PLUGIN_END_NAMESPACE
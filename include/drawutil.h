@@ -34,13 +34,12 @@
 
 #include "pi_common.h"
 
+#include <vector>
+
 PLUGIN_BEGIN_NAMESPACE
 
 extern void DrawArc(float cx, float cy, float r, float start_angle,
     float arc_angle, int num_segments);
-extern void DrawOutlineArc(
-    double r1, double r2, double a1, double a2, bool stippled);
-extern void DrawFilledArc(double r1, double r2, double a1, double a2);
 extern void CheckOpenGLError(const wxString& after);
 
 typedef struct {
@@ -53,68 +52,159 @@ typedef struct {
     int16_t y;
 } PointInt;
 
-// Allocated arrays are not two dimensional, so we make
-// up a macro that makes it look that way. Note the 'stride'
-// which is the length of the 2nd dimension, not the 1st.
-#define M_XY_STRIDE m_spoke_len
-#define M_XY(x, y) m_xy[x * M_XY_STRIDE + y]
-#define M_XYI(x, y) m_xyi[x * M_XY_STRIDE + y]
+/*
+ * The direction of a spoke as 1.15 fixed point cosine and sine, so that
+ * POLAR_LOOKUP_ONE is 1.0.
+ */
+#define POLAR_LOOKUP_SHIFT (15)
+#define POLAR_LOOKUP_ONE (1 << POLAR_LOOKUP_SHIFT)
+
+typedef struct {
+    int32_t cosine;
+    int32_t sine;
+} SpokeDirection;
 
+/*
+ * Converts (spoke, radius) to cartesian coordinates.
+ *
+ * Only the direction of each spoke is stored, not a point for every sample.
+ * When the number of spokes is a multiple of eight only the first octant
+ * is kept and the other seven are derived by swapping and negating, so the
+ * table is a few kilobytes instead of tens of megabytes.
+ *
+ * Callers that walk along a spoke should fetch the direction once with
+ * GetDirection() and then call GetPointInt(direction, radius).
+ */
 class PolarToCartesianLookup {
 private:
     size_t m_spokes;
-    size_t m_spoke_len;
-    Point* m_xy;
-    PointInt* m_xyi;
+    size_t m_octant; // spokes per octant, or 0 if the full circle is stored
+    SpokeDirection* m_direction;
 
 public:
-    PolarToCartesianLookup(size_t spokes, size_t spoke_len)
-    {
-        m_spokes = spokes;
-        m_spoke_len = spoke_len + 1;
+    PolarToCartesianLookup(size_t spokes);
+    ~PolarToCartesianLookup();
 
-        m_xy = (Point*)malloc(sizeof(Point) * m_spokes * m_spoke_len);
-        m_xyi = (PointInt*)malloc(sizeof(PointInt) * m_spokes * m_spoke_len);
+    SpokeDirection GetDirection(size_t angle)
+    {
+        angle = (angle + m_spokes) % m_spokes;
+        if (!m_octant) {
+            return m_direction[angle];
+        }
 
-        if (!m_xy || !m_xyi) {
-            wxLogError(wxT("Out Of Memory, fatal!"));
-            wxAbort();
+        size_t quarter = 2 * m_octant;
+        size_t quadrant = angle / quarter;
+        size_t r = angle % quarter;
+        SpokeDirection d;
+
+        if (r <= m_octant) {
+            d = m_direction[r];
+        } else {
+            // Mirror in the 45 degree diagonal
+            d.cosine = m_direction[quarter - r].sine;
+            d.sine = m_direction[quarter - r].cosine;
         }
 
-        for (size_t arc = 0; arc < m_spokes; arc++) {
-            float sine = sinf((float)arc * PI * 2 / m_spokes);
-            float cosine = cosf((float)arc * PI * 2 / m_spokes);
-            for (size_t radius = 0; radius < m_spoke_len; radius++) {
-                float x = (float)radius * cosine;
-                float y = (float)radius * sine;
-                M_XY(arc, radius).x = x;
-                M_XY(arc, radius).y = y;
-                M_XYI(arc, radius).x = (int16_t)x;
-                M_XYI(arc, radius).y = (int16_t)y;
-            }
+        SpokeDirection ret;
+        switch (quadrant) {
+        case 0:
+            ret = d;
+            break;
+        case 1:
+            ret.cosine = -d.sine;
+            ret.sine = d.cosine;
+            break;
+        case 2:
+            ret.cosine = -d.cosine;
+            ret.sine = -d.sine;
+            break;
+        default:
+            ret.cosine = d.sine;
+            ret.sine = -d.cosine;
+            break;
         }
+        return ret;
     }
 
-    ~PolarToCartesianLookup()
+    static PointInt GetPointInt(SpokeDirection d, size_t radius)
     {
-        free(m_xy);
-        free(m_xyi);
+        PointInt p;
+        // Division instead of a shift so that it truncates towards zero,
+        // like the float to int conversion it replaces.
+        p.x = (int16_t)((int32_t)radius * d.cosine / POLAR_LOOKUP_ONE);
+        p.y = (int16_t)((int32_t)radius * d.sine / POLAR_LOOKUP_ONE);
+        return p;
     }
 
-    // We trust that the optimizer will inline this
     Point GetPoint(size_t angle, size_t radius)
     {
-        return M_XY((angle + m_spokes) % m_spokes, radius);
+        SpokeDirection d = GetDirection(angle);
+        Point p;
+        p.x = (float)radius * d.cosine * (1.f / POLAR_LOOKUP_ONE);
+        p.y = (float)radius * d.sine * (1.f / POLAR_LOOKUP_ONE);
+        return p;
     }
+
     PointInt GetPointInt(size_t angle, size_t radius)
     {
-        return M_XYI((angle + m_spokes) % m_spokes, radius);
-    };
+        return GetPointInt(GetDirection(angle), radius);
+    }
 };
 
 extern void DrawRoundRect(
     float x, float y, float width, float height, float radius = 0.0);
 
+/*
+ * Static 2D geometry (filled arcs and lines) that is built once and then
+ * drawn with a single glDrawArrays call per primitive type, instead of being
+ * regenerated in immediate mode on every frame.
+ *
+ * The owner passes the values the geometry depends on to IsCurrent(). When
+ * these differ from the last build the geometry is emptied and IsCurrent()
+ * returns false; the owner then adds the shapes again. The vertices are
+ * uploaded to a VBO on the first Draw after a change, or drawn from client
+ * memory when the driver has no buffer objects.
+ *
+ * A VBO belongs to one GL context, so keep one GLGeometry per context and
+ * Release() it where that context is torn down; the destructor does not
+ * touch GL, as no context need be current there. Whether buffer objects
+ * are supported is also decided per context.
+ */
+class GLGeometry {
+public:
+    GLGeometry();
+    ~GLGeometry();
+
+    bool IsCurrent(const double* key, size_t n);
+
+    // Arcs between ranges r1 and r2 from angle a1 to a2 (degrees), in the
+    // same way as the old immediate mode DrawFilledArc and DrawOutlineArc.
+    void AddFilledArc(double r1, double r2, double a1, double a2);
+    void AddOutlineArc(double r1, double r2, double a1, double a2);
+    void AddArc(float cx, float cy, float r, float start_angle,
+        float arc_angle, int num_segments);
+    void AddLine(float x1, float y1, float x2, float y2);
+
+    // Draw the filled triangles or the lines, in the current colour
+    void DrawFilled();
+    void DrawOutline();
+
+    // Forget the shapes and the VBO. The VBO is only deleted when the context
+    // it was created in is current, otherwise it goes away with the context.
+    void Release(bool context_current);
+
+private:
+    void Upload();
+    void DrawArrays(GLenum mode, size_t first, size_t count);
+
+    vector<double> m_key;
+    vector<float> m_fill; // x, y pairs forming GL_TRIANGLES
+    vector<float> m_lines; // x, y pairs forming GL_LINES
+    GLuint m_vbo;
+    bool m_uploaded;
+    int m_buffers_supported; // In the context of m_vbo, -1 until known
+};
+
 PLUGIN_END_NAMESPACE
 
 #endif
@@ -32,13 +32,15 @@
 #ifndef _EMULATORRECEIVE_H_
 #define _EMULATORRECEIVE_H_
 
+#include "EmulatorScene.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
 //
-// An intermediary class that implements the common parts of any Emulator radar.
+// Generates spokes from an EmulatorScene at the rate of a real radar, so the
+// rest of the plugin can be exercised and profiled without hardware.
 //
 
 class EmulatorReceive : public RadarReceive {
@@ -47,8 +49,10 @@ public:
         : RadarReceive(pi, ri)
     {
         m_shutdown = false;
-        m_next_spoke = 0;
-        m_next_rotation = 0;
+        m_spokes_done = 0;
+        m_start = 0;
+        m_scene_start = 0;
+        m_origin_set = false;
         m_receive_socket = GetLocalhostServerTCPSocket();
         m_send_socket = GetLocalhostSendTCPSocket(m_receive_socket);
         LOG_RECEIVE(wxT("%s receive thread created"), m_ri->m_name.c_str());
@@ -65,12 +69,18 @@ public:
     wxString GetInfoStatus();
 
 private:
-    void EmulateFakeBuffer(void);
+    void LoadScene(void);
+    void EmulateSpokes(void);
+    ScenePoint GetOwnPosition(double seconds);
 
     volatile bool m_shutdown;
 
-    int m_next_spoke; // emulator next spoke
-    int m_next_rotation; // slowly rotate emulator
+    EmulatorScene m_scene;
+    wxLongLong m_scene_start; // When the scene started moving
+    wxLongLong m_start; // When transmit started
+    uint64_t m_spokes_done; // Spokes generated since m_start
+    GeoPosition m_origin; // Where the scene coordinates start
+    bool m_origin_set;
 
     SOCKET m_receive_socket; // Where we listen for message from m_send_socket
     SOCKET m_send_socket; // A message to this socket will interrupt select()
@@ -0,0 +1,137 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _EMULATORSCENE_H_
+#define _EMULATORSCENE_H_
+
+#include "radar_pi.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SCENE_DEFAULT_RPM (24)
+#define SCENE_DEFAULT_BEAM (2.0) // Horizontal beam width in degrees
+#define SCENE_DEFAULT_TARGET_SIZE (20.0) // meters
+#define SCENE_DEFAULT_COAST_DEPTH (200.0) // meters of land that return echoes
+#define SCENE_MAX_RPM (120)
+#define SCENE_KNOTS_TO_MPS(k) ((k) * (double)METERS_PER_NM / 3600.)
+
+/*
+ * A scene for the emulator, read from a text file. Every line holds one
+ * item, '#' starts a comment. Bearings and courses are in degrees true,
+ * distances in meters from where the ship is when the emulator starts,
+ * speeds in knots.
+ *
+ *   spokes <n>                      spokes per rotation, default the radar's
+ *   spoke_len <n>                   samples per spoke, default the radar's
+ *   rpm <n>                         rotations per minute, default 24
+ *   beam <degrees>                  horizontal beam width, default 2
+ *   seed <n>                        start of the clutter noise
+ *   ownship <heading> <speed>       used when OpenCPN has no heading or fix
+ *   target <bearing> <distance> <course> <speed> [<size> [<strength>]]
+ *   rain <bearing> <distance> <radius> <strength> [<course> <speed>]
+ *   sea <range> <strength>
+ *   coast <depth> <bearing>:<distance> <bearing>:<distance> ...
+ *
+ * A coast is a closed polygon of land; everything behind its first 'depth'
+ * meters is in its shadow.
+ */
+
+struct ScenePoint {
+    double x; // meters east
+    double y; // meters north
+};
+
+struct SceneTarget {
+    ScenePoint start;
+    ScenePoint velocity; // m/s
+    double size;
+    uint8_t strength;
+};
+
+struct SceneRain {
+    ScenePoint start;
+    ScenePoint velocity; // m/s
+    double radius;
+    uint8_t strength;
+};
+
+struct SceneCoast {
+    vector<ScenePoint> polygon;
+    double depth;
+};
+
+class EmulatorScene {
+public:
+    EmulatorScene();
+
+    bool Load(const wxString& filename);
+    bool Parse(const wxString& text, const wxString& name);
+    void LoadDefault();
+
+    // Limit the geometry to what the radar can show
+    void SetGeometry(size_t spokes, size_t spoke_len);
+
+    // Fill 'data' with 'len' samples covering 'range' meters, for a spoke at
+    // 'bearing' degrees true seen from 'pos', 'seconds' after the start.
+    void Render(uint8_t* data, size_t len, double bearing, ScenePoint pos,
+        double range, double seconds);
+
+    ScenePoint GetOwnShipPosition(double seconds);
+
+    wxString m_name;
+    size_t m_spokes;
+    size_t m_spoke_len;
+    double m_rpm;
+    double m_beam; // degrees
+
+    bool m_own_ship;
+    double m_own_heading;
+    double m_own_speed; // m/s
+
+    double m_sea_range;
+    uint8_t m_sea_strength;
+
+    vector<SceneTarget> m_targets;
+    vector<SceneRain> m_rain;
+    vector<SceneCoast> m_coast;
+
+private:
+    void Clear();
+    bool ParseLine(const wxString& line);
+    uint32_t Random();
+
+    uint32_t m_random;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _EMULATORSCENE_H_ */
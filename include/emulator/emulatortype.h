@@ -20,8 +20,8 @@ PLUGIN_END_NAMESPACE
     }
 
 // Emulator has 1440 spokes of exactly 768 bytes each, to emulate Garmin
-#define EMULATOR_SPOKES 1440
-#define EMULATOR_MAX_SPOKE_LEN 768
+#define EMULATOR_SPOKES 2048
+#define EMULATOR_MAX_SPOKE_LEN 1024
 
 #if SPOKES_MAX < EMULATOR_SPOKES
 #undef SPOKES_MAX
@@ -32,8 +32,10 @@
 #ifndef _GARMIN_HD_RECEIVE_H_
 #define _GARMIN_HD_RECEIVE_H_
 
+#include "NetworkInterfaces.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
+#include "spokeutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -48,6 +50,7 @@ public:
     GarminHDReceive(radar_pi* pi, RadarInfo* ri, NetworkAddress reportAddr,
         NetworkAddress dataAddr)
         : RadarReceive(pi, ri)
+        , m_multicast(pi)
     {
         m_report_addr = reportAddr;
         m_next_spoke = -1;
@@ -83,19 +86,21 @@ private:
     bool ProcessReport(const uint8_t* data, size_t len);
 
     bool IsValidGarminAddress(struct ifaddrs* nif);
-    SOCKET PickNextEthernetCard();
-    SOCKET GetNewReportSocket();
+    bool PickNextEthernetCard();
+    bool JoinReportGroup();
 
     wxString m_ip;
 
     SOCKET m_receive_socket; // Where we listen for message from m_send_socket
     SOCKET m_send_socket; // A message to this socket will interrupt select()
                           // and allow immediate shutdown
+    MulticastSubscriber m_multicast; // Report group, carries the spokes too
 
     struct ifaddrs* m_interface_array;
     struct ifaddrs* m_interface;
 
     int m_next_spoke;
+    SpokeRuns m_runs; // Spoke unpacked by ProcessFrame
     int m_radar_status;
     bool m_first_receive;
 
@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _GARMIN_HD_UNPACK_H_
+#define _GARMIN_HD_UNPACK_H_
+
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+/*
+ * Convert one Garmin HD spoke of 'bytes' bytes into 'runs'. The HD has one
+ * bit per sample, least significant bit first, so the spoke is 8 * bytes
+ * samples long; a set bit becomes a sample of 255.
+ *
+ * The bits are read 64 at a time and the runs of set bits are found with
+ * bit scans, so an empty stretch of 64 samples costs one test and a target
+ * a few instructions, instead of a branch per sample.
+ */
+extern void GarminHDUnpackSpoke(
+    const uint8_t* src, size_t bytes, SpokeRuns* runs);
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _GARMIN_HD_UNPACK_H_ */
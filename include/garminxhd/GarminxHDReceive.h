@@ -32,6 +32,7 @@
 #ifndef _GARMIN_XH_RECEIVE_H_
 #define _GARMIN_XH_RECEIVE_H_
 
+#include "NetworkInterfaces.h"
 #include "RadarReceive.h"
 #include "socketutil.h"
 
@@ -46,6 +47,7 @@ public:
     GarminxHDReceive(radar_pi* pi, RadarInfo* ri, NetworkAddress reportAddr,
         NetworkAddress dataAddr)
         : RadarReceive(pi, ri)
+        , m_multicast(pi)
     {
         m_data_addr = dataAddr;
         m_report_addr = reportAddr;
@@ -84,15 +86,16 @@ private:
     bool ProcessReport(const uint8_t* data, size_t len);
 
     bool IsValidGarminAddress(struct ifaddrs* nif);
-    SOCKET PickNextEthernetCard();
-    SOCKET GetNewReportSocket();
-    SOCKET GetNewDataSocket();
+    bool PickNextEthernetCard();
+    bool JoinReportGroup();
+    bool JoinDataGroup();
 
     wxString m_ip;
 
     SOCKET m_receive_socket; // Where we listen for message from m_send_socket
     SOCKET m_send_socket; // A message to this socket will interrupt select()
                           // and allow immediate shutdown
+    MulticastSubscriber m_multicast; // Report and data groups
 
     struct ifaddrs* m_interface_array;
     struct ifaddrs* m_interface;
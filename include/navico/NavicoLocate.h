@@ -35,6 +35,7 @@
 #include <map>
 
 #include "NavicoCommon.h"
+#include "NetworkInterfaces.h"
 #include "radar_pi.h"
 #include "socketutil.h"
 
@@ -54,15 +55,13 @@ class NavicoLocate : public wxThread {
 public:
     NavicoLocate(radar_pi* pi)
         : wxThread(wxTHREAD_JOINABLE)
+        , m_groups(pi)
     {
         Create(64 * 1024); // Stack size
         m_pi = pi; // This allows you to access the main plugin stuff
         m_shutdown = false;
         m_is_shutdown = true;
 
-        m_interface_addr = 0;
-        m_socket = 0;
-        m_interface_count = 0;
         m_report_count = 0;
         m_errors.Clear();
 
@@ -99,22 +98,14 @@ private:
     bool DetectedRadar(const NetworkAddress& radar_address);
     void WakeRadar();
 
-    void UpdateEthernetCards();
-    void CleanupCards();
+    bool UpdateEthernetCards();
     void FoundNavicoLocationInfo(const NetworkAddress& addr,
         const NetworkAddress& interface_addr, const RadarLocationInfo& info);
 
-    void ClearErrors(void);
-    void AddError(wxString& error);
-
     radar_pi* m_pi;
     volatile bool m_shutdown;
 
-    // Three arrays, all created on each call to UpdateEthernetCards.
-    // One entry for each ethernet card.
-    NetworkAddress* m_interface_addr;
-    SOCKET* m_socket;
-    size_t m_interface_count;
+    MulticastGroups m_groups; // The report group on each ethernet card
     size_t m_report_count;
 
     wxString m_errors;
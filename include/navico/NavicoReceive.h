@@ -33,6 +33,7 @@
 #define _NAVICORECEIVE_H_
 
 #include "NavicoCommon.h"
+#include "NetworkInterfaces.h"
 #include "RadarReceive.h"
 #include "navico/NavicoLocate.h"
 #include "socketutil.h"
@@ -53,7 +54,7 @@ PLUGIN_BEGIN_NAMESPACE
 #define SCALE_DECIDEGREES_TO_DEGREES(n) (((int)n) / 10)
 #define SCALE_DEGREES_TO_DECIDEGREES(n) (((int)n) * 10)
 
-extern SOCKET g_HaloInfoSocket;
+extern bool g_HaloInfoJoined;
 
 //
 // An intermediary class that implements the common parts of any Navico radar.
@@ -64,6 +65,7 @@ public:
     NavicoReceive(radar_pi* pi, RadarInfo* ri, NetworkAddress reportAddr,
         NetworkAddress dataAddr, NetworkAddress sendAddr)
         : RadarReceive(pi, ri)
+        , m_multicast(pi)
     {
         m_info.serialNr = wxT(" ");
         m_info.spoke_data_addr = dataAddr;
@@ -74,6 +76,7 @@ public:
         m_shutdown_time_requested = 0;
         m_is_shutdown = false;
         m_first_receive = true;
+        m_sea_reported = RCS_MANUAL;
         m_interface_addr = m_ri->GetRadarInterfaceAddress();
         m_halo_received_info = wxGetUTCTimeMillis();
         m_halo_sent_heading = m_halo_received_info;
@@ -112,6 +115,8 @@ public:
         m_ri->SetRadarLocationInfo(
             m_info); //  in case the initial value from constuctor are used,
                      //  write these to radar_pi
+        StartDiscoveryCache(
+            !m_interface_addr.IsNull() && !m_info.spoke_data_addr.IsNull());
     };
 
     ~NavicoReceive() {};
@@ -130,14 +135,14 @@ public:
     volatile bool m_is_shutdown;
 
 private:
-    SOCKET GetNewDataSocket();
-    SOCKET GetNewInfoSocket();
-    SOCKET GetNewReportSocket();
-    SOCKET PickNextEthernetCard();
+    bool JoinDataGroup();
+    bool JoinInfoGroup();
+    bool JoinReportGroup();
+    bool PickNextEthernetCard();
     bool ProcessReport(const uint8_t* data, size_t len);
     void DetectedRadar(NetworkAddress& radar_address);
     void ProcessFrame(const uint8_t* data, size_t len);
-    void ReleaseInfoSocket();
+    void LeaveInfoGroup();
     void SendHeadingPacket();
     void SendMysteryPacket();
     void SetRadarType(RadarType t);
@@ -145,6 +150,7 @@ private:
     SOCKET m_receive_socket; // Where we listen for message from m_send_socket
     SOCKET m_send_socket; // A message to this socket will interrupt select()
                           // and allow immediate shutdown
+    MulticastSubscriber m_multicast; // Report, data and halo info groups
 
     struct ifaddrs* m_interface_array;
     struct ifaddrs* m_interface;
@@ -152,6 +158,7 @@ private:
     uint8_t m_next_scan;
     char m_radar_status;
     bool m_first_receive;
+    RadarControlState m_sea_reported; // Sea clutter mode of the last 02C4
 
     wxLongLong m_halo_received_info; // When some mfd sent info
     wxLongLong m_halo_sent_heading; // When we send it, every 100 ms
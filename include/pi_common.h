@@ -82,6 +82,7 @@ extern "C" {
 #include <wx/clrpicker.h>
 #include <wx/datetime.h>
 #include <wx/fileconf.h>
+#include <wx/filename.h>
 #include <wx/glcanvas.h>
 #include <wx/mstream.h>
 #include <wx/sckaddr.h>
@@ -166,6 +167,9 @@ using namespace std;
 
 #define DEGREES_PER_ROTATION (360) // Classical math
 
+typedef int SpokeBearing; // A value from 0 -- LINES_PER_ROTATION indicating a
+                          // bearing (? = North, +ve = clockwise)
+
 struct GeoPosition {
     double lat;
     double lon;
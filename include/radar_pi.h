@@ -38,7 +38,9 @@
 #include <algorithm>
 #include <vector>
 
+#include "NetworkInterfaces.h"
 #include "RadarControlItem.h"
+#include "RadarLifecycle.h"
 #include "RadarLocationInfo.h"
 #include "config.h"
 #include "drawutil.h"
@@ -76,8 +78,12 @@ class RadarReceive;
 class RadarControl;
 class radar_pi;
 class GuardZoneBogey;
+class RadarPolarImage;
+class RadarRecorder;
 class RadarArpa;
 class GPSKalmanFilter;
+class FrameScheduler;
+class PacketTrace;
 class RaymarineLocate;
 class NavicoLocate;
 
@@ -97,9 +103,6 @@ static const int SECONDS_PER_TIMED_RUN_SETTING = 60;
 
 #define OPENGL_ROTATION (-90.0) // Difference between 'up' and OpenGL 'up'...
 
-typedef int SpokeBearing; // A value from 0 -- LINES_PER_ROTATION indicating a
-                          // bearing (? = North, +ve = clockwise)
-
 typedef int AngleDegrees; // An angle relative to North or HeadUp. Generally
                           // [0..359> or [-180,180]
 
@@ -208,13 +211,15 @@ enum {
 // Arranged from low to high priority:
 enum HeadingSource {
     HEADING_NONE,
+    HEADING_EMULATOR, // The emulator scene's own ship, anything else wins
     HEADING_FIX_COG,
     HEADING_FIX_HDM,
     HEADING_FIX_HDT,
     HEADING_NMEA_HDM,
     HEADING_NMEA_HDT,
     HEADING_RADAR_HDM,
-    HEADING_RADAR_HDT
+    HEADING_RADAR_HDT,
+    HEADING_PLAYBACK // Only per radar, see RadarInfo::GetHeadingSource()
 };
 
 enum ToolbarIconColor {
@@ -266,7 +271,7 @@ struct receive_statistics {
     int missing_spokes;
 };
 
-typedef enum GuardZoneType { GZ_ARC, GZ_CIRCLE } GuardZoneType;
+typedef enum GuardZoneType { GZ_ARC, GZ_CIRCLE, GZ_POLYGON } GuardZoneType;
 
 typedef enum RadarType {
 #define DEFINE_RADAR(t, n, s, l, a, b, c, d) t,
@@ -422,6 +427,7 @@ static const bool HasBitCount2[8] = {
 #define DEFAULT_OVERLAY_TRANSPARENCY (5)
 #define MIN_OVERLAY_TRANSPARENCY (0)
 #define MAX_OVERLAY_TRANSPARENCY (90)
+#define RADAR_PANEL_TRANSPARENCY (4) // The PPI window is nearly opaque
 #define MIN_AGE (4)
 #define MAX_AGE (12)
 
@@ -446,6 +452,8 @@ struct PersistentSettings {
     int verbose; // Loglevel 0..4.
     int guard_zone_threshold; // How many blobs must be sent by radar before we
                               // fire alarm
+    int guard_zone_trip_count; // Hits within one sweep that raise the alarm
+                               // at once, 0 = use guard_zone_threshold
     int guard_zone_render_style; // 0 = Shading, 1 = Outline, 2 = Shading +
                                  // Outline
     int guard_zone_timeout; // How long before we warn again when bogeys are
@@ -462,6 +470,15 @@ struct PersistentSettings {
     int menu_auto_hide; // 0 = none, 1 = 10s, 2 = 30s
     int drawing_method; // VertexBuffer, Shader, etc.
     bool developer_mode; // Readonly from config, allows head up mode
+    bool shader_timing; // Readonly from config, log GPU time of shader drawing
+    wxString emulator_scene; // Readonly from config, scene file for the
+                             // emulator, built in scene when empty
+    wxString record_directory; // Readonly from config, record the spokes of
+                               // every radar to a new file here
+    wxString playback_file[RADARS]; // Readonly from config, play this
+                                    // recording instead of the radar
+    double playback_speed; // Readonly from config, 1 = as recorded
+    int playback_start; // Readonly from config, seconds into the recording
     bool show; // whether to show any radar (overlay or window)
     bool show_radar[RADARS]; // whether to show radar window
     bool dock_radar[RADARS]; // whether to dock radar window
@@ -584,6 +601,9 @@ public:
 
     void NotifyRadarWindowViz();
     void NotifyControlDialog();
+    void NotifyGuardZoneTripped();
+    void NotifyLifecycle();
+    void ScheduleDeadlines();
 
     void OnControlDialogClose(RadarInfo* ri);
     void SetDisplayMode(DisplayModeType mode);
@@ -603,6 +623,7 @@ public:
 
     bool LoadConfig();
     bool SaveConfig();
+    void SaveDiscoveryCache();
 
     long GetRangeMeters();
     long GetOptimalRangeMeters();
@@ -611,6 +632,7 @@ public:
     RadarLocationInfo& GetRadarLocationInfo(size_t r);
 
     void SetRadarHeading(double heading = nan(""), bool isTrue = false);
+    void SetEmulatorHeading(double heading);
     double GetHeadingTrue()
     {
         wxCriticalSectionLocker lock(m_exclusive);
@@ -647,6 +669,7 @@ public:
     wxLongLong GetBootMillis() { return m_boot_time; }
     bool IsOpenGLEnabled() { return m_opengl_mode == OPENGL_ON; }
     wxGLContext* GetChartOpenGLContext();
+    bool SetChartOpenGLContextCurrent();
 
     bool HaveOverlay()
     {
@@ -675,6 +698,9 @@ public:
                                     // plugin is disabled
     NavicoLocate* m_navico_locator;
     RaymarineLocate* m_raymarine_locator;
+    DeadlineWheel m_deadlines; // Timers of all m_radar[]->m_lifecycle
+    NetworkInterfaces m_network_interfaces; // Shared by the locators
+    MulticastDispatcher* m_multicast_dispatcher; // For locators and receivers
 
     MessageBox* m_pMessageBox;
     wxWindow* m_parent_window;
@@ -701,7 +727,11 @@ private:
     void UpdateCOGAvg(double cog);
     void OnTimerNotify(wxTimerEvent& event);
     void TimedControlUpdate();
+    void ApplyControlJournals();
     void TimedUpdate(wxTimerEvent& event);
+    void OnGuardZoneTripped(wxCommandEvent& event);
+    void OnLifecycleWake(wxCommandEvent& event);
+    void OnDeadlineTimer(wxTimerEvent& event);
     void ScheduleWindowRefresh();
     void SetOpenGLMode(OpenGLMode mode);
     int GetArpaTargetCount(void);
@@ -723,6 +753,8 @@ public:
                                      // this canvas
     bool m_render_busy;
     int m_draw_time_overlay_ms[MAX_CHART_CANVAS];
+    FrameScheduler* m_frame_scheduler;
+    PacketTrace* m_trace; // Only when VerboseLog is set
 
     bool m_bpos_set;
     time_t m_bpos_timestamp;
@@ -763,6 +795,8 @@ public:
     bool m_old_data_seen;
     volatile bool m_notify_radar_window_viz;
     volatile bool m_notify_control_dialog;
+    volatile bool m_notify_guard_zone_tripped; // Event queued, not yet handled
+    volatile bool m_notify_lifecycle; // Event queued, not yet handled
     wxLongLong m_notify_time_ms;
 
 #define HEADING_TIMEOUT (5)
@@ -809,7 +843,9 @@ private:
     bool m_opencpn_gl_context_broken;
 
     wxTimer* m_timer;
+    int m_frame_period; // Millis between timer ticks, 0 = not running
     wxTimer* m_update_timer;
+    wxTimer* m_deadline_timer; // Runs out at the next m_deadlines deadline
 
     DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _RAYMARINE_DECODE_H_
+#define _RAYMARINE_DECODE_H_
+
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define RAYMARINE_ESCAPE (0x5c) // 0x5c n v: n samples of value v
+
+/*
+ * Decoders for the spoke data of the E120 and Quantum radars.
+ *
+ * The data starts with a run length encoded part in which 0x5c n v stands
+ * for n samples of value v and any other byte for itself, and may be
+ * followed by bytes that are stored as is. The HD and Quantum radars send
+ * one 8 bit sample per byte. The older E120 radars send two 4 bit samples
+ * per byte, low nibble first, and a run of n such bytes means 2n samples.
+ *
+ * Both decoders append to 'runs' starting at sample *sample, advance
+ * *sample past what they decoded and return the number of bytes of 'src'
+ * they used. They stop when the spoke is full. The escapes are found 16
+ * bytes at a time, and each stretch of equal bytes between them becomes a
+ * single run instead of one run per byte.
+ */
+extern unsigned int RaymarineDecodeEncoded(const uint8_t* src,
+    unsigned int len, bool nibbles, SpokeRuns* runs, unsigned int* sample);
+extern unsigned int RaymarineDecodeRaw(const uint8_t* src, unsigned int len,
+    bool nibbles, SpokeRuns* runs, unsigned int* sample);
+
+PLUGIN_END_NAMESPACE
+
+#endif /* _RAYMARINE_DECODE_H_ */
@@ -36,6 +36,7 @@
 
 #include <map>
 
+#include "NetworkInterfaces.h"
 #include "radar_pi.h"
 #include "socketutil.h"
 
@@ -56,15 +57,16 @@ class RaymarineLocate : public wxThread {
 public:
     RaymarineLocate(radar_pi* pi)
         : wxThread(wxTHREAD_JOINABLE)
+        , m_groups(pi)
     {
         Create(64 * 1024); // Stack size
         m_pi = pi; // This allows you to access the main plugin stuff
         m_shutdown = false;
         m_is_shutdown = true;
 
-        m_interface_addr = 0;
-        m_socket = 0;
-        m_interface_count = 0;
+        // Raymarine E120 radars and compatible report their addresses here
+        m_groups.AddGroup(NetworkAddress(224, 0, 0, 1, 5800));
+        m_groups.AddGroup(NetworkAddress(232, 1, 1, 1, 5800)); // Quantum WiFi
         m_report_count = 0;
         SetPriority(wxPRIORITY_MAX);
         // LOG_INFO(wxT("RaymarineLocate thread created, prio= %i"),
@@ -97,19 +99,13 @@ private:
         size_t len);
     bool DetectedRadar(const NetworkAddress& radar_address);
 
-    void UpdateEthernetCards();
-    void CleanupCards();
     void FoundRaymarineLocationInfo(const NetworkAddress& addr,
         const NetworkAddress& interface_addr, const RadarLocationInfo& info);
 
     radar_pi* m_pi;
     volatile bool m_shutdown;
 
-    // Three arrays, all created on each call to UpdateEthernetCards.
-    // One entry for each ethernet card.
-    NetworkAddress* m_interface_addr;
-    SOCKET* m_socket;
-    size_t m_interface_count;
+    MulticastGroups m_groups; // Both report groups on each ethernet card
     size_t m_report_count;
 
     wxCriticalSection m_exclusive;
@@ -34,10 +34,12 @@
 #ifndef _RAYMARINERECEIVE_H_
 #define _RAYMARINERECEIVE_H_
 
+#include "NetworkInterfaces.h"
 #include "RadarFactory.h"
 #include "RadarReceive.h"
 #include "raymarine/RaymarineLocate.h"
 #include "socketutil.h"
+#include "spokeutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -50,6 +52,7 @@ public:
     RaymarineReceive(radar_pi* pi, RadarInfo* ri, NetworkAddress reportAddr,
         NetworkAddress dataAddr, NetworkAddress sendAddr)
         : RadarReceive(pi, ri)
+        , m_multicast(pi)
     {
         m_info.serialNr = wxT(" ");
         m_info.spoke_data_addr = dataAddr;
@@ -59,6 +62,7 @@ public:
         m_range_meters = 0;
         m_target_expansion = false;
         m_comm_socket = INVALID_SOCKET;
+        m_comm_multicast = false;
         // However radar is leading for range_units, will be overwritten with
         // value from the radar
         m_shutdown_time_requested = 0;
@@ -99,6 +103,8 @@ public:
         m_ri->SetRadarLocationInfo(
             m_info); //  in case the initial values from constuctor are used,
                      //  write these to radar_pi
+        StartDiscoveryCache(
+            !m_interface_addr.IsNull() && !m_info.report_addr.IsNull());
 
         m_range_meters = 1; // this will be considered an invalid value.
         m_previous_angle = 0;
@@ -123,11 +129,16 @@ private:
 
     SOCKET PickNextEthernetCard();
     SOCKET GetNewReportSocket();
+    void CloseCommSocket();
+    void ReceivedFromRadar(const uint8_t* data, size_t len,
+        const NetworkAddress& radar_address, bool* detected);
 
     SOCKET m_receive_socket; // Where we listen for message from m_send_socket
     SOCKET m_send_socket; // A message to this socket will interrupt select()
                           // and allow immediate shutdown
     SOCKET m_comm_socket; // Radar communication socket
+    bool m_comm_multicast; // m_comm_socket is the dispatcher's report socket
+    MulticastSubscriber m_multicast; // The report group
 
     struct ifaddrs* m_interface_array;
     struct ifaddrs* m_interface;
@@ -135,6 +146,7 @@ private:
     int m_next_spoke;
     bool m_first_receive;
     SpokeBearing m_previous_angle;
+    SpokeRuns m_runs; // Spoke decoded from the run length encoded formats
 
     wxCriticalSection m_lock; // Protects m_status
     wxString m_status; // Userfriendly string
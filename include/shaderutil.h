@@ -27,6 +27,12 @@ struct attrib_info {
 
 extern GLboolean ShadersSupported(void);
 
+// Only valid after ShadersSupported()
+extern GLboolean TimerQueriesSupported(void);
+// GL 3.3 or GLES 3 (*es set) with the functions RadarDrawCore needs.
+// Only valid after ShadersSupported()
+extern GLboolean CoreProfileSupported(bool* es);
+
 extern bool CompileShaderText(
     GLuint* shader, GLenum shaderType, const char* text);
 
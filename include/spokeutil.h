@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#ifndef _SPOKEUTIL_H_
+#define _SPOKEUTIL_H_
+
+#include "pi_common.h"
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPOKE_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SPOKE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Vectorized helper that works on one spoke of 8 bit samples. It uses SSE2
+// or NEON when the compiler targets it and falls back to plain C otherwise.
+
+// Zero each sample in data[0..len> that is below threshold[i].
+extern void RemoveBelowEach(
+    uint8_t* data, const uint8_t* threshold, size_t len);
+
+// A run of equal samples [begin..end> that are not zero.
+struct SpokeRun {
+    uint16_t begin;
+    uint16_t end;
+    uint8_t value;
+};
+
+/*
+ * One spoke as the runs of equal samples that are not zero, in increasing
+ * order; all samples between the runs are zero. Open water spokes are mostly
+ * empty, so iterating the runs instead of the samples skips most of the work.
+ *
+ * Decoders whose wire format is run length encoded build it directly with
+ * Add(), the others convert their samples with SetSamples().
+ */
+class SpokeRuns {
+public:
+    SpokeRuns() { m_len = 0; }
+
+    // Start an empty spoke of 'len' samples.
+    void Clear(size_t len)
+    {
+        m_runs.clear();
+        m_len = len;
+    }
+
+    // Append 'length' samples of 'value' starting at 'begin', which must not
+    // be before the end of the previous run. Samples beyond the length of the
+    // spoke are dropped.
+    void Add(size_t begin, size_t length, uint8_t value)
+    {
+        if (value == 0 || begin >= m_len) {
+            return;
+        }
+        size_t end = wxMin(begin + length, m_len);
+        if (!m_runs.empty() && m_runs.back().end == begin
+            && m_runs.back().value == value) {
+            m_runs.back().end = (uint16_t)end;
+            return;
+        }
+        if (end > begin) {
+            SpokeRun run = { (uint16_t)begin, (uint16_t)end, value };
+            m_runs.push_back(run);
+        }
+    }
+
+    size_t GetLen() const { return m_len; }
+    size_t GetCount() const { return m_runs.size(); }
+    const SpokeRun& operator[](size_t i) const { return m_runs[i]; }
+
+    void SetSamples(const uint8_t* data, size_t len);
+    // Write all GetLen() samples, including the zeros between the runs.
+    void GetSamples(uint8_t* data) const;
+
+    // Zero the samples [0..radius>, e.g. the main bang.
+    void ClearBelow(size_t radius);
+    // Zero the samples that are below 'threshold'.
+    void RemoveBelow(uint8_t threshold);
+    // Set the last sample of the spoke to 'value'.
+    void SetLast(uint8_t value);
+    // Return the number of samples in [begin..end> that are >= threshold.
+    size_t CountAbove(size_t begin, size_t end, uint8_t threshold) const;
+
+private:
+    vector<SpokeRun> m_runs;
+    size_t m_len;
+};
+
+/*
+ * Cell averaging CFAR (constant false alarm rate) detector for one spoke.
+ *
+ * A sample is kept only when it is at least 'scale' times the mean of the
+ * 'window' samples before or after it, whichever mean is greater. The
+ * 'guard' samples right next to it are left out of both windows, so that a
+ * target does not raise its own threshold. Taking the greater of the two
+ * keeps the edge of a clutter patch from passing as a target.
+ *
+ * Sea clutter raises the threshold of everything in and around it, while a
+ * target in open water keeps a threshold of zero.
+ */
+class SpokeCfar {
+public:
+    SpokeCfar() { Configure(16, 2, 32); }
+
+    // 'scale' is in 1/16ths, so 32 means twice the mean.
+    void Configure(size_t window, size_t guard, unsigned scale);
+    // Zero the samples in data[0..len> that do not stand out.
+    void Apply(uint8_t* data, size_t len);
+
+private:
+    size_t m_window;
+    size_t m_guard;
+    uint32_t m_multiplier; // scale / 16 / window in 1/65536ths
+    vector<uint32_t> m_sum; // m_sum[i] = data[0] + ... + data[i - 1]
+    vector<uint8_t> m_threshold;
+};
+
+PLUGIN_END_NAMESPACE
+
+#endif
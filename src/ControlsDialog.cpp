@@ -119,7 +119,7 @@ const string ControlTypeNames[CT_MAX] = {
 #undef CONTROL_TYPE
 };
 
-wxString guard_zone_names[2];
+wxString guard_zone_names[3];
 
 void RadarControlButton::AdjustValue(int adjustment) {
   int oldValue = m_item->GetValue();
@@ -388,6 +388,7 @@ bool ControlsDialog::Create(wxWindow* parent, radar_pi* ppi, RadarInfo* ri, wxWi
   /*guard_zone_names[0] = _("Off");*/
   guard_zone_names[0] = _("Arc");
   guard_zone_names[1] = _("Circle");
+  guard_zone_names[2] = _("Polygon");
 
   if (!wxDialog::Create(parent, id, caption, pos, wxDefaultSize, wstyle)) {
     return false;
@@ -483,6 +484,7 @@ void ControlsDialog::ShowGuardZone(int zone) {
 
   bearing = MOD_DEGREES_180(m_guard_zone->m_end_bearing);
   m_end_bearing->SetValue(wxString::Format(wxT("%d"), bearing));
+  m_polygon->ChangeValue(m_guard_zone->GetPolygonString(conversionFactor));
   m_alarm->SetValue(m_guard_zone->m_alarm_on ? 1 : 0);
   m_arpa_box->SetValue(m_guard_zone->m_arpa_on ? 1 : 0);
   m_guard_zone->m_show_time = time(0);
@@ -500,12 +502,21 @@ void ControlsDialog::SetGuardZoneVisibility() {
     m_end_bearing->Disable();
     m_inner_range->Enable();
     m_outer_range->Enable();
+    m_polygon->Disable();
+
+  } else if (zoneType == GZ_POLYGON) {
+    m_start_bearing->Disable();
+    m_end_bearing->Disable();
+    m_inner_range->Disable();
+    m_outer_range->Disable();
+    m_polygon->Enable();
 
   } else {
     m_start_bearing->Enable();
     m_end_bearing->Enable();
     m_inner_range->Enable();
     m_outer_range->Enable();
+    m_polygon->Disable();
   }
   m_guard_sizer->Layout();
 }
@@ -701,6 +712,17 @@ void ControlsDialog::CreateControls() {
     m_advanced_sizer->Add(m_threshold_button, 0, wxALL, BORDER);
   }
 
+  if (m_ctrl[CT_CFAR].type) {
+    m_cfar_button = new RadarControlButton(this, ID_CONTROL_BUTTON, _("Clutter filter"), m_ctrl[CT_CFAR], &m_ri->m_cfar);
+    m_advanced_sizer->Add(m_cfar_button, 0, wxALL, BORDER);
+  }
+
+  if (m_ctrl[CT_SCAN_CORRELATION].type) {
+    m_scan_correlation_button = new RadarControlButton(this, ID_CONTROL_BUTTON, _("Scan correlation"), m_ctrl[CT_SCAN_CORRELATION],
+                                                       &m_ri->m_scan_correlation);
+    m_advanced_sizer->Add(m_scan_correlation_button, 0, wxALL, BORDER);
+  }
+
   // The TARGET EXPANSION button
   if (m_ctrl[CT_TARGET_EXPANSION].type) {
     m_target_expansion_button = new RadarControlButton(this, ID_CONTROL_BUTTON, _("Target expansion"), m_ctrl[CT_TARGET_EXPANSION],
@@ -970,6 +992,14 @@ void ControlsDialog::CreateControls() {
   m_guard_sizer->Add(m_end_bearing, 1, wxALIGN_CENTER_HORIZONTAL | wxALL, BORDER);
   m_end_bearing->Connect(wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler(ControlsDialog::OnEnd_Bearing_Value), NULL, this);
 
+  // Polygon vertices as "bearing:range ..." pairs, range in the range units
+  wxStaticText* pPolygon = new wxStaticText(this, wxID_ANY, _("Polygon (bearing:range ...)"), wxDefaultPosition, wxDefaultSize, 0);
+  m_guard_sizer->Add(pPolygon, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, 0);
+
+  m_polygon = new wxTextCtrl(this, wxID_ANY);
+  m_guard_sizer->Add(m_polygon, 1, wxEXPAND | wxALL, BORDER);
+  m_polygon->Connect(wxEVT_COMMAND_TEXT_UPDATED, wxCommandEventHandler(ControlsDialog::OnPolygon_Value), NULL, this);
+
   // checkbox for ARPA
   m_arpa_box = new wxCheckBox(this, wxID_ANY, _("ARPA On"), wxDefaultPosition, wxDefaultSize, wxALIGN_LEFT | wxST_NO_AUTORESIZE);
   m_guard_sizer->Add(m_arpa_box, 0, wxALIGN_CENTER_HORIZONTAL | wxALL, 5);
@@ -1598,7 +1628,7 @@ void ControlsDialog::OnTransmitButtonClick(wxCommandEvent& event) {
 
   // If we already have a running timer, then turn timed_idle_mode off
   if (m_ri->m_next_state_change.GetValue() > 1 &&
-      (m_ri->m_timed_idle_hardware || m_ri->m_idle_transmit > 0 || m_ri->m_idle_standby > 0)) {
+      (m_ri->m_timed_idle_hardware || m_ri->m_lifecycle.IsTimedTransmitRunning())) {
     m_timed_idle_button->SetState(RCS_OFF);
   }
   if (state == RADAR_STANDBY || state == RADAR_STOPPING || state == RADAR_SPINNING_DOWN) {
@@ -1613,7 +1643,7 @@ void ControlsDialog::OnClearTrailsButtonClick(wxCommandEvent& event) { m_ri->Cle
 void ControlsDialog::OnOrientationButtonClick(wxCommandEvent& event) {
   int value = m_ri->m_orientation.GetValue() + 1;
 
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (m_ri->GetHeadingSource() == HEADING_NONE) {
     value = ORIENTATION_HEAD_UP;
   } else {  // There is a heading
     if (value == ORIENTATION_NUMBER) {
@@ -1781,7 +1811,7 @@ bool ControlsDialog::UpdateSizersButtonsShown() {
     }
   }
 
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (m_ri->GetHeadingSource() == HEADING_NONE) {
     m_orientation_button->Disable();
   } else {
     m_orientation_button->Enable();
@@ -1872,6 +1902,12 @@ void ControlsDialog::DisableRadarControls() {
   if (m_threshold_button) {
     m_threshold_button->Disable();
   }
+  if (m_cfar_button) {
+    m_cfar_button->Disable();
+  }
+  if (m_scan_correlation_button) {
+    m_scan_correlation_button->Disable();
+  }
   if (m_target_separation_button) {
     m_target_separation_button->Disable();
   }
@@ -1982,6 +2018,12 @@ void ControlsDialog::EnableRadarControls() {
   if (m_threshold_button) {
     m_threshold_button->Enable();
   }
+  if (m_cfar_button) {
+    m_cfar_button->Enable();
+  }
+  if (m_scan_correlation_button) {
+    m_scan_correlation_button->Enable();
+  }
   if (m_target_separation_button) {
     m_target_separation_button->Enable();
   }
@@ -2093,6 +2135,12 @@ void ControlsDialog::LimitRadarControls() {
   if (m_threshold_button) {
     m_threshold_button->Disable();
   }
+  if (m_cfar_button) {
+    m_cfar_button->Disable();
+  }
+  if (m_scan_correlation_button) {
+    m_scan_correlation_button->Disable();
+  }
   if (m_target_separation_button) {
     m_target_separation_button->Disable();
   }
@@ -2504,6 +2552,15 @@ void ControlsDialog::OnEnd_Bearing_Value(wxCommandEvent& event) {
   m_guard_zone->SetEndBearing(t);
 }
 
+void ControlsDialog::OnPolygon_Value(wxCommandEvent& event) {
+  int conversionFactor = RangeUnitsToMeters[m_pi->m_settings.range_units];
+
+  m_guard_zone->m_show_time = time(0);
+
+  // Vertices that are still being typed are skipped until they are complete
+  m_guard_zone->SetPolygon(m_polygon->GetValue(), conversionFactor);
+}
+
 void ControlsDialog::OnARPAClick(wxCommandEvent& event) {
   int arpa = m_arpa_box->GetValue();
   m_guard_zone->SetArpaOn(arpa);
@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "FrameScheduler.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SECTOR_OF(spoke, spokes) ((size_t)(spoke) * FRAME_SECTORS / (spokes) % FRAME_SECTORS)
+
+FrameScheduler::FrameScheduler() {
+  for (int r = 0; r < RADARS; r++) {
+    for (int t = 0; t < FRAME_TARGETS; t++) {
+      m_target[r][t].damage = FRAME_ALL_SECTORS;
+      m_target[r][t].visible = FRAME_ALL_SECTORS;
+      m_target[r][t].presented = 0;
+      m_target[r][t].requested = 0;
+    }
+  }
+}
+
+void FrameScheduler::MarkSpoke(int radar, SpokeBearing angle, SpokeBearing bearing, int spokes) {
+  if (spokes <= 0) {
+    return;
+  }
+  uint64_t angle_bit = (uint64_t)1 << SECTOR_OF(angle, spokes);
+  uint64_t bearing_bit = (uint64_t)1 << SECTOR_OF(bearing, spokes);
+
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  // The PPI is always marked with both, as it shows either depending on its orientation.
+  m_target[radar][FRAME_TARGET_PPI].damage |= angle_bit | bearing_bit;
+  // The overlay image is always stabilized
+  for (int c = 0; c < MAX_CHART_CANVAS; c++) {
+    m_target[radar][FRAME_TARGET_CANVAS(c)].damage |= bearing_bit;
+  }
+}
+
+void FrameScheduler::MarkAll(int radar) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (int t = 0; t < FRAME_TARGETS; t++) {
+    m_target[radar][t].damage = FRAME_ALL_SECTORS;
+  }
+}
+
+void FrameScheduler::SetVisibleSectors(int radar, int target, uint64_t sectors) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_target[radar][target].visible = sectors;
+}
+
+void FrameScheduler::Presented(int radar, int target) {
+  wxCriticalSectionLocker lock(m_exclusive);
+  Target &t = m_target[radar][target];
+
+  // A paint draws the whole image, so everything that changed is now up to date,
+  // also what was off screen.
+  t.damage = 0;
+  t.presented = wxGetUTCTimeMillis();
+  t.requested = 0;
+}
+
+bool FrameScheduler::IsDue(int radar, int target, int interval_millis, bool keep_alive) {
+  wxLongLong now = wxGetUTCTimeMillis();
+  wxCriticalSectionLocker lock(m_exclusive);
+  Target &t = m_target[radar][target];
+
+  if (t.requested != 0 && now - t.requested < FRAME_REQUEST_TIMEOUT) {
+    return false;  // Still waiting for the previous request to be painted
+  }
+  if ((t.damage & t.visible) == 0) {
+    return keep_alive && now - t.presented >= FRAME_IDLE_MILLIS;
+  }
+  return now - t.presented >= interval_millis;
+}
+
+void FrameScheduler::Requested(int radar, int target) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_target[radar][target].requested = wxGetUTCTimeMillis();
+}
+
+uint64_t FrameScheduler::GetVisibleSectors(wxPoint center, double radius, double rotation, int width, int height) {
+  if (center.x - radius >= 0 && center.x + radius < width && center.y - radius >= 0 && center.y + radius < height) {
+    return FRAME_ALL_SECTORS;  // The whole image is on screen
+  }
+
+  uint64_t sectors = 0;
+  double sector_degrees = 360.0 / FRAME_SECTORS;
+
+  for (int s = 0; s < FRAME_SECTORS; s++) {
+    // Compute the bounding box of the wedge of sector s. Screen angles are clockwise from 'up'.
+    double a1 = rotation + s * sector_degrees;
+    double a2 = a1 + sector_degrees;
+    double x_min = center.x, x_max = center.x, y_min = center.y, y_max = center.y;
+
+    // The two ends of the arc, plus any of the four extremes of the circle that lie on it.
+    double corners[6];
+    int n = 0;
+    corners[n++] = a1;
+    corners[n++] = a2;
+    for (double a = ceil(a1 / 90.) * 90.; a < a2; a += 90.) {
+      corners[n++] = a;
+    }
+    for (int i = 0; i < n; i++) {
+      double x = center.x + radius * sin(deg2rad(corners[i]));
+      double y = center.y - radius * cos(deg2rad(corners[i]));
+      x_min = wxMin(x_min, x);
+      x_max = wxMax(x_max, x);
+      y_min = wxMin(y_min, y);
+      y_max = wxMax(y_max, y);
+    }
+
+    if (x_max >= 0 && x_min < width && y_max >= 0 && y_min < height) {
+      sectors |= (uint64_t)1 << s;
+    }
+  }
+  return sectors;
+}
+
+PLUGIN_END_NAMESPACE
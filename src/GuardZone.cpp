@@ -29,12 +29,13 @@
  */
 #include "GuardZone.h"
 
+#include "PolarHistory.h"
 #include "RadarMarpa.h"
 #include "radar_pi.h"
 
-PLUGIN_BEGIN_NAMESPACE
+#include <wx/tokenzr.h>
 
-#undef TEST_GUARD_ZONE_LOCATION
+PLUGIN_BEGIN_NAMESPACE
 
 GuardZone::GuardZone(radar_pi* pi, RadarInfo* ri, int zone) {
   m_pi = pi;
@@ -48,74 +49,39 @@ GuardZone::GuardZone(radar_pi* pi, RadarInfo* ri, int zone) {
   m_arpa_on = 0;
   m_alarm_on = 0;
   m_show_time = 0;
+  m_version = 0;
+  m_covers_all_spokes = false;
   CLEAR_STRUCT(m_arpa_update_time);
   ResetBogeys();
 }
 
-void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, uint8_t* hist, size_t len) {
-  size_t range_start = m_inner_range * m_ri->m_pixels_per_meter;  // Convert from meters to [0..spoke_len_max>
-  size_t range_end = m_outer_range * m_ri->m_pixels_per_meter;    // Convert from meters to [0..spoke_len_max>
-  bool in_guard_zone = false;
-  AngleDegrees degAngle = SCALE_SPOKES_TO_DEGREES(angle);
-
-  switch (m_type) {
-    case GZ_ARC:
-      if ((degAngle >= m_start_bearing && degAngle < m_end_bearing) ||
-          (m_start_bearing >= m_end_bearing && (degAngle >= m_start_bearing || degAngle < m_end_bearing))) {
-        if (range_start < len) {
-          if (range_end > len) {
-            range_end = len;
-          }
-          for (size_t r = range_start; r <= range_end; r++) {
-            if (data[r] >= m_pi->m_settings.threshold_blue) {
-              m_running_count++;
-            }
-#ifdef TEST_GUARD_ZONE_LOCATION
-            // Zap guard zone computation location to green so this is visible on screen
-            else {
-              data[r] = m_pi->m_settings.threshold_green;
-            }
-#endif
-          }
-        }
-        in_guard_zone = true;
-      }
-      break;
-
-    case GZ_CIRCLE:
-      if (range_start < len) {
-        if (range_end > len) {
-          range_end = len;
-        }
+void GuardZone::ProcessSpoke(SpokeBearing angle, bool in_guard_zone, size_t hits) {
+  m_running_count += (int)hits;
 
-        for (size_t r = range_start; r <= range_end; r++) {
-          if (data[r] >= m_pi->m_settings.threshold_blue) {
-            m_running_count++;
-          }
-#ifdef TEST_GUARD_ZONE_LOCATION
-          // Zap guard zone computation location to green so this is visible on screen
-          else {
-            data[r] = m_pi->m_settings.threshold_green;
-          }
-#endif
-        }
-        if (angle > m_last_angle) {
-          in_guard_zone = true;
-        }
-      }
-      break;
+  if (m_tripped_count < 0 && hits > 0) {
+    int trip_count = m_pi->m_settings.guard_zone_trip_count;
+    if (trip_count <= 0) {
+      trip_count = m_pi->m_settings.guard_zone_threshold;
+    }
+    if (m_running_count > trip_count) {
+      m_tripped_count = m_running_count;
+      LOG_GUARD(wxT("%s tripped at angle=%d running_count=%d"), m_log_name.c_str(), angle, m_running_count);
+      m_pi->NotifyGuardZoneTripped();
+    }
+  }
 
-    default:
-      in_guard_zone = false;
-      break;
+  if (m_type == GZ_CIRCLE || m_covers_all_spokes) {
+    // The sweep through the zone ends when the spokes wrap around
+    in_guard_zone = in_guard_zone && angle > m_last_angle;
   }
 
   if (m_last_in_guard_zone && !in_guard_zone) {
     // last bearing that could add to m_running_count, so store as bogey_count;
     m_bogey_count = m_running_count;
+    m_tripped_count = -1;
     m_running_count = 0;
-    LOG_GUARD(wxT("%s angle=%d last_angle=%d guardzone=%d..%d (%d - %d) bogey_count=%d"), m_log_name.c_str(), angle, m_last_angle,
-              range_start, range_end, m_inner_range, m_outer_range, m_bogey_count);
+    LOG_GUARD(wxT("%s angle=%d last_angle=%d guardzone=%d - %d bogey_count=%d"), m_log_name.c_str(), angle, m_last_angle,
+              m_inner_range, m_outer_range, m_bogey_count);
 
     // When debugging with a static ship it is hard to find moving targets, so move
     // the guard zone instead. This slowly rotates the guard zone.
@@ -124,6 +90,7 @@ void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, uint8_t* hist, s
       m_end_bearing += m_pi->m_settings.guard_zone_debug_inc;
       m_start_bearing %= DEGREES_PER_ROTATION;
       m_end_bearing %= DEGREES_PER_ROTATION;
+      m_version++;
     }
   }
 
@@ -131,6 +98,108 @@ void GuardZone::ProcessSpoke(SpokeBearing angle, uint8_t* data, uint8_t* hist, s
   m_last_angle = angle;
 }
 
+size_t GuardZone::SetPolygon(const wxString &spec, double meters_per_unit) {
+  wxStringTokenizer tokens(spec, wxT(" ;"), wxTOKEN_STRTOK);
+  vector<Point> polygon;
+  size_t skipped = 0;
+
+  while (tokens.HasMoreTokens()) {
+    wxString token = tokens.GetNextToken();
+    double bearing, range;
+
+    if (!token.BeforeFirst(':').ToDouble(&bearing) || !token.AfterFirst(':').ToDouble(&range) || range < 0. ||
+        polygon.size() >= GUARD_ZONE_MAX_VERTICES) {
+      skipped++;
+      continue;
+    }
+    range *= meters_per_unit;
+    Point p;
+    p.x = range * cos(deg2rad(bearing));
+    p.y = range * sin(deg2rad(bearing));
+    polygon.push_back(p);
+  }
+  LOG_VERBOSE(wxT("%s polygon with %u vertices, %u skipped"), m_log_name.c_str(), (unsigned)polygon.size(), (unsigned)skipped);
+
+  {
+    wxCriticalSectionLocker lock(m_polygon_lock);
+    m_polygon.swap(polygon);
+  }
+  m_version++;
+  ResetBogeys();
+  return skipped;
+}
+
+wxString GuardZone::GetPolygonString(double meters_per_unit) {
+  wxString spec;
+
+  for (size_t i = 0; i < m_polygon.size(); i++) {
+    double bearing = rad2deg(atan2(m_polygon[i].y, m_polygon[i].x));
+    double range = sqrt(m_polygon[i].x * m_polygon[i].x + m_polygon[i].y * m_polygon[i].y) / meters_per_unit;
+
+    if (bearing < 0.) {
+      bearing += 360.;
+    }
+    if (i > 0) {
+      spec << wxT(" ");
+    }
+    if (meters_per_unit == 1.) {
+      spec << wxString::Format(wxT("%.1f:%.0f"), bearing, range);
+    } else {
+      spec << wxString::Format(wxT("%.1f:%.3f"), bearing, range);
+    }
+  }
+  return spec;
+}
+
+/*
+ * Rotate the polygon so the ray at 'angle' becomes the positive x axis. Every edge
+ * that crosses the x axis then gives one boundary at x, and the origin is inside
+ * when an odd number of boundaries lie ahead of it (even-odd rule).
+ */
+size_t GuardZone::GetPolygonIntervals(double angle, double *begin, double *end, size_t max) {
+  wxCriticalSectionLocker lock(m_polygon_lock);
+  double crossing[GUARD_ZONE_MAX_VERTICES];  // SetPolygon keeps at most this many edges
+  size_t crossings = 0;
+  size_t n = m_polygon.size();
+  size_t intervals = 0;
+
+  if (n < 3 || max == 0) {
+    return 0;
+  }
+
+  double c = cos(deg2rad(angle));
+  double s = sin(deg2rad(angle));
+
+  for (size_t i = 0; i < n; i++) {
+    const Point &p = m_polygon[i];
+    const Point &q = m_polygon[(i + 1) % n];
+    double py = p.y * c - p.x * s;
+    double qy = q.y * c - q.x * s;
+
+    if ((py > 0.) != (qy > 0.)) {
+      double px = p.x * c + p.y * s;
+      double qx = q.x * c + q.y * s;
+      double x = px + (qx - px) * py / (py - qy);
+
+      if (x > 0.) {
+        crossing[crossings++] = x;
+      }
+    }
+  }
+  std::sort(crossing, crossing + crossings);
+
+  size_t i = 0;
+  if (crossings & 1) {
+    begin[intervals] = 0.;
+    end[intervals++] = crossing[i++];
+  }
+  for (; i + 1 < crossings && intervals < max; i += 2) {
+    begin[intervals] = crossing[i];
+    end[intervals++] = crossing[i + 1];
+  }
+  return intervals;
+}
+
 // Search guard zone for ARPA targets
 void GuardZone::SearchTargets() {
   ExtendedPosition own_pos;
@@ -143,8 +212,8 @@ void GuardZone::SearchTargets() {
   }
   if (!m_pi->m_settings.show                        // No radar shown
     || !m_ri->GetRadarPosition(&own_pos.pos)        // No position
-    || m_pi->GetHeadingSource() == HEADING_NONE     // No heading 
-    || (m_pi->GetHeadingSource() == HEADING_FIX_HDM && m_pi->m_var_source == VARIATION_SOURCE_NONE)) {
+    || m_ri->GetHeadingSource() == HEADING_NONE     // No heading 
+    || (m_ri->GetHeadingSource() == HEADING_FIX_HDM && m_pi->m_var_source == VARIATION_SOURCE_NONE)) {
     return;
   }
   if (m_pi->m_radar[0] == 0 && m_pi->m_radar[1] == 0) {
@@ -163,9 +232,14 @@ void GuardZone::SearchTargets() {
   }
   size_t range_start = m_inner_range * m_ri->m_pixels_per_meter;  // Convert from meters to 0..511
   size_t range_end = m_outer_range * m_ri->m_pixels_per_meter;    // Convert from meters to 0..511
+  if (m_type == GZ_POLYGON) {
+    // The polygon limits the range per spoke, see below
+    range_start = 1;
+    range_end = m_ri->m_spoke_len_max;
+  }
   if (range_start < 1) range_start = 1;
   if (range_start >= range_end) return;
-  int hdt = SCALE_DEGREES_TO_SPOKES(m_pi->GetHeadingTrue());
+  int hdt = SCALE_DEGREES_TO_SPOKES(m_ri->GetHeadingTrue());
   while (hdt >= m_ri->m_spokes) {
     hdt -= m_ri->m_spokes;
   }
@@ -179,7 +253,7 @@ void GuardZone::SearchTargets() {
   if (start_bearing > end_bearing) {
     end_bearing += m_ri->m_spokes;
   }
-  if (m_type == GZ_CIRCLE) {
+  if (m_type == GZ_CIRCLE || m_type == GZ_POLYGON) {
     start_bearing = 0;
     end_bearing = m_ri->m_spokes;
   }
@@ -192,9 +266,9 @@ void GuardZone::SearchTargets() {
     // loop with +2 increments as target must be larger than 2 pixels in width
     for (int angleIter = start_bearing; angleIter < end_bearing; angleIter += 2) {
       SpokeBearing angle = MOD_SPOKES(angleIter);
-      wxLongLong time1 = m_ri->m_history[angle].time;
+      wxLongLong time1 = m_ri->m_history->GetTime(angle);
       // time2 must be timed later than the pass 2 in refresh, otherwise target may be found multiple times
-      wxLongLong time2 = m_ri->m_history[MOD_SPOKES(angle + 3 * SCAN_MARGIN)].time;
+      wxLongLong time2 = m_ri->m_history->GetTime(MOD_SPOKES(angle + 3 * SCAN_MARGIN));
 
       // check if target has been refreshed since last time
       // and if the beam has passed the target location with SCAN_MARGIN spokes
@@ -202,18 +276,38 @@ void GuardZone::SearchTargets() {
            time2 >= time1)) {  // the beam sould have passed our "angle" AND a
                                // point SCANMARGIN further set new refresh time
         m_arpa_update_time[angle] = time1;
-        for (int rrr = (int)range_start; rrr < (int)range_end; rrr++) {
-          if (m_ri->m_arpa->GetTargetCount() >= MAX_NUMBER_OF_TARGETS - 1) {
-            LOG_INFO(wxT("No more scanning for ARPA targets in loop, maximum number of targets reached"));
-            return;
+
+        double begin[GUARD_ZONE_MAX_INTERVALS];
+        double end[GUARD_ZONE_MAX_INTERVALS];
+        size_t intervals = 1;
+        begin[0] = range_start;
+        end[0] = range_end;
+        if (m_type == GZ_POLYGON) {
+          intervals = GetPolygonIntervals(SCALE_SPOKES_TO_DEGREES(MOD_SPOKES(angle + m_ri->m_spokes - hdt)), begin, end,
+                                          GUARD_ZONE_MAX_INTERVALS);
+        }
+        for (size_t i = 0; i < intervals; i++) {
+          int r_begin = (int)range_start;
+          int r_end = (int)range_end;
+          if (m_type == GZ_POLYGON) {
+            r_begin = wxMax(r_begin, (int)(begin[i] * m_ri->m_pixels_per_meter));
+            r_end = wxMin(r_end, (int)(end[i] * m_ri->m_pixels_per_meter));
           }
-          if (m_ri->m_arpa->MultiPix(angle, rrr, 0)) {
-            // pixel found that does not belong to a known target
-            Polar pol;
-            pol.angle = angle;
-            pol.r = rrr;
-            int target_i = m_ri->m_arpa->AcquireNewARPATarget(pol, 0, 0);
-            if (target_i == -1) break;
+          // Skip straight to the next sample above threshold, most of a spoke is empty
+          for (int rrr = m_ri->m_history->FindNext(angle, r_begin, r_end, false); rrr < r_end;
+               rrr = m_ri->m_history->FindNext(angle, rrr + 1, r_end, false)) {
+            if (m_ri->m_arpa->GetTargetCount() >= MAX_NUMBER_OF_TARGETS - 1) {
+              LOG_INFO(wxT("No more scanning for ARPA targets in loop, maximum number of targets reached"));
+              return;
+            }
+            if (m_ri->m_arpa->MultiPix(angle, rrr, 0)) {
+              // pixel found that does not belong to a known target
+              Polar pol;
+              pol.angle = angle;
+              pol.r = rrr;
+              int target_i = m_ri->m_arpa->AcquireNewARPATarget(pol, 0, 0);
+              if (target_i == -1) break;
+            }
           }
         }
       }
@@ -0,0 +1,223 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "GuardZoneMask.h"
+#include "GuardZone.h"
+#include "RadarInfo.h"
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+GuardZoneMask::GuardZoneMask(radar_pi *pi, RadarInfo *ri) {
+  m_pi = pi;
+  m_ri = ri;
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    m_version[z] = -1;
+  }
+  m_pixels_per_meter = 0.;
+  m_spokes = 0;
+  m_spoke_len_max = 0;
+  m_active = 0;
+}
+
+bool GuardZoneMask::NeedsUpdate() {
+  if (m_pixels_per_meter != m_ri->m_pixels_per_meter || m_spokes != m_ri->m_spokes || m_spoke_len_max != m_ri->m_spoke_len_max) {
+    return true;
+  }
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    if (m_version[z] != m_ri->m_guard_zone[z]->m_version) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Append the [begin..end> sample intervals where zone 'z' crosses spoke 'angle'.
+ */
+void GuardZoneMask::AddZoneIntervals(size_t z, SpokeBearing angle, vector<Run> &runs) {
+  GuardZone *zone = m_ri->m_guard_zone[z];
+  Run run;
+
+  run.zones = (uint8_t)(1 << z);
+
+  if (zone->m_type == GZ_POLYGON) {
+    double begin[GUARD_ZONE_MAX_INTERVALS];
+    double end[GUARD_ZONE_MAX_INTERVALS];
+    size_t n = zone->GetPolygonIntervals(SCALE_SPOKES_TO_DEGREES(angle), begin, end, GUARD_ZONE_MAX_INTERVALS);
+
+    for (size_t i = 0; i < n; i++) {
+      size_t r_begin = (size_t)(begin[i] * m_pixels_per_meter);
+      size_t r_end = (size_t)(end[i] * m_pixels_per_meter) + 1;
+
+      if (r_end > m_spoke_len_max) {
+        r_end = m_spoke_len_max;
+      }
+      if (r_begin < r_end) {
+        run.begin = (uint16_t)r_begin;
+        run.end = (uint16_t)r_end;
+        runs.push_back(run);
+      }
+    }
+    return;
+  }
+
+  if (zone->m_type == GZ_ARC) {
+    AngleDegrees degAngle = SCALE_SPOKES_TO_DEGREES(angle);
+    AngleDegrees start = zone->m_start_bearing;
+    AngleDegrees end = zone->m_end_bearing;
+
+    if (!((degAngle >= start && degAngle < end) || (start >= end && (degAngle >= start || degAngle < end)))) {
+      return;
+    }
+  }
+
+  // The outer range is inclusive, as it always has been
+  size_t r_begin = (size_t)(zone->m_inner_range * m_pixels_per_meter);
+  size_t r_end = (size_t)(zone->m_outer_range * m_pixels_per_meter) + 1;
+
+  if (r_end > m_spoke_len_max) {
+    r_end = m_spoke_len_max;
+  }
+  run.begin = (uint16_t)wxMin(r_begin, m_spoke_len_max);
+  run.end = (uint16_t)wxMax(r_begin, r_end);
+  // An empty run still marks the spoke as crossing the zone
+  runs.push_back(run);
+}
+
+void GuardZoneMask::Update() {
+  vector<Run> intervals;
+  vector<uint16_t> edges;
+
+  m_pixels_per_meter = m_ri->m_pixels_per_meter;
+  m_spokes = m_ri->m_spokes;
+  m_spoke_len_max = m_ri->m_spoke_len_max;
+  m_active = 0;
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    m_version[z] = m_ri->m_guard_zone[z]->m_version;
+    if (m_ri->m_guard_zone[z]->m_alarm_on) {
+      m_active |= (uint8_t)(1 << z);
+    }
+  }
+
+  m_first_run.assign(m_spokes + 1, 0);
+  m_in_zone.assign(m_spokes, 0);
+  m_runs.clear();
+
+  if (!m_active || m_pixels_per_meter <= 0.) {
+    return;
+  }
+
+  uint8_t all_spokes = m_active;
+
+  for (int angle = 0; angle < m_spokes; angle++) {
+    intervals.clear();
+    edges.clear();
+    m_first_run[angle] = m_runs.size();
+
+    for (size_t z = 0; z < GUARD_ZONES; z++) {
+      if (m_active & (1 << z)) {
+        AddZoneIntervals(z, angle, intervals);
+      }
+    }
+
+    for (size_t i = 0; i < intervals.size(); i++) {
+      m_in_zone[angle] |= intervals[i].zones;
+      edges.push_back(intervals[i].begin);
+      edges.push_back(intervals[i].end);
+    }
+    all_spokes &= m_in_zone[angle];
+
+    // Split the spoke at every interval edge and find the zones covering each piece.
+    // Neighbouring pieces that belong to the same zones are merged into one run.
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    for (size_t e = 0; e + 1 < edges.size(); e++) {
+      Run run;
+      run.begin = edges[e];
+      run.end = edges[e + 1];
+      run.zones = 0;
+      for (size_t i = 0; i < intervals.size(); i++) {
+        if (intervals[i].begin <= run.begin && intervals[i].end >= run.end) {
+          run.zones |= intervals[i].zones;
+        }
+      }
+      if (!run.zones) {
+        continue;
+      }
+      if (m_runs.size() > m_first_run[angle] && m_runs.back().end == run.begin && m_runs.back().zones == run.zones) {
+        m_runs.back().end = run.end;
+      } else {
+        m_runs.push_back(run);
+      }
+    }
+  }
+  m_first_run[m_spokes] = m_runs.size();
+
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    m_ri->m_guard_zone[z]->m_covers_all_spokes = (all_spokes & (1 << z)) != 0;
+  }
+
+  LOG_GUARD(wxT("%s guard zone mask: %u runs for %d spokes"), m_ri->m_name.c_str(), (unsigned)m_runs.size(), m_spokes);
+}
+
+void GuardZoneMask::ProcessSpoke(SpokeBearing angle, const SpokeRuns &runs) {
+  if (NeedsUpdate()) {
+    Update();
+  }
+  if (!m_active || (int)angle >= m_spokes) {
+    return;
+  }
+
+  size_t hits[GUARD_ZONES] = {0};
+  uint8_t threshold = (uint8_t)m_pi->m_settings.threshold_blue;
+
+  for (size_t i = m_first_run[angle]; i < m_first_run[angle + 1]; i++) {
+    const Run &run = m_runs[i];
+    size_t n = runs.CountAbove(run.begin, run.end, threshold);
+    if (n) {
+      for (size_t z = 0; z < GUARD_ZONES; z++) {
+        if (run.zones & (1 << z)) {
+          hits[z] += n;
+        }
+      }
+    }
+  }
+
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    if (m_active & (1 << z)) {
+      m_ri->m_guard_zone[z]->ProcessSpoke(angle, (m_in_zone[angle] & (1 << z)) != 0, hits[z]);
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,541 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "NetworkInterfaces.h"
+
+#include "radar_pi.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+NetworkInterfaces::NetworkInterfaces(radar_pi *pi) {
+  m_pi = pi;
+  m_generation = 0;
+  m_next_read = 0;
+  m_netlink = INVALID_SOCKET;
+
+#ifdef __linux__
+  // Subscribe to link and IPv4 address changes. We do not parse the
+  // messages, any message is a reason to read the list again.
+  SOCKET s = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (s != INVALID_SOCKET) {
+    struct sockaddr_nl sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+    if (!::bind(s, (struct sockaddr *)&sa, sizeof(sa)) && fcntl(s, F_SETFL, O_NONBLOCK) != -1) {
+      m_netlink = s;
+      return;
+    }
+    closesocket(s);
+  }
+  LOG_INFO(wxT("Cannot watch network interfaces via netlink, polling instead"));
+#endif
+}
+
+NetworkInterfaces::~NetworkInterfaces() {
+  if (m_netlink != INVALID_SOCKET) {
+    closesocket(m_netlink);
+  }
+}
+
+int NetworkInterfaces::GetInterfaces(vector<NetworkAddress> *interfaces) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  CheckForChanges();
+  *interfaces = m_interfaces;
+  return m_generation;
+}
+
+void NetworkInterfaces::CheckForChanges() {
+  bool read = m_generation == 0;
+
+  if (m_netlink != INVALID_SOCKET) {
+    char buf[4096];
+
+    for (;;) {
+      int r = recv(m_netlink, buf, sizeof(buf), 0);
+      if (r > 0) {
+        read = true;
+      } else if (r < 0 && errno == ENOBUFS) {
+        read = true;  // Missed some messages, so certainly look
+      } else {
+        break;
+      }
+    }
+  } else if (time(0) >= m_next_read) {
+    read = true;
+  }
+
+  if (read) {
+    ReadInterfaces();
+  }
+}
+
+void NetworkInterfaces::ReadInterfaces() {
+  struct ifaddrs *addr_list;
+  struct ifaddrs *addr;
+  vector<NetworkAddress> interfaces;
+
+  m_next_read = time(0) + NETWORK_INTERFACES_POLL;
+
+  if (!getifaddrs(&addr_list)) {
+    for (addr = addr_list; addr; addr = addr->ifa_next) {
+      if (VALID_IPV4_ADDRESS(addr)) {
+        NetworkAddress a;
+
+        a.addr = ((struct sockaddr_in *)addr->ifa_addr)->sin_addr;
+        interfaces.push_back(a);
+      }
+    }
+    freeifaddrs(addr_list);
+  } else {
+    wxLogError(wxT("No ethernet cards found"));
+  }
+
+  if (m_generation == 0 || interfaces != m_interfaces) {
+    m_interfaces = interfaces;
+    m_generation++;
+    LOG_VERBOSE(wxT("Found %d ethernet cards"), (int)m_interfaces.size());
+  }
+}
+
+MulticastSubscriber::MulticastSubscriber(radar_pi *pi) {
+  m_pi = pi;
+  m_dispatcher = 0;
+  m_dropped = 0;
+  m_wake_receive = GetLocalhostServerTCPSocket();
+  m_wake_send = GetLocalhostSendTCPSocket(m_wake_receive);
+}
+
+MulticastSubscriber::~MulticastSubscriber() {
+  LeaveAll();
+  if (m_wake_send != INVALID_SOCKET) {
+    closesocket(m_wake_send);
+  }
+  if (m_wake_receive != INVALID_SOCKET) {
+    closesocket(m_wake_receive);
+  }
+}
+
+bool MulticastSubscriber::Join(const NetworkAddress &interface_address, const NetworkAddress &group, wxString &error) {
+  for (size_t i = 0; i < m_joined.size(); i++) {
+    if (m_joined[i].interface_address == interface_address && m_joined[i].group == group) {
+      return true;
+    }
+  }
+
+  MulticastDispatcher *dispatcher = m_dispatcher ? m_dispatcher : m_pi->m_multicast_dispatcher;
+  if (!dispatcher || m_wake_send == INVALID_SOCKET) {
+    error << _("Multicast dispatcher is not running");
+    return false;
+  }
+  if (!dispatcher->Join(this, interface_address, group, error)) {
+    return false;
+  }
+
+  Membership m;
+
+  m.interface_address = interface_address;
+  m.group = group;
+  m_joined.push_back(m);
+  m_dispatcher = dispatcher;
+  return true;
+}
+
+void MulticastSubscriber::Leave(const NetworkAddress &group, const NetworkAddress &interface_address) {
+  for (size_t i = 0; i < m_joined.size();) {
+    if (m_joined[i].group == group && (interface_address.IsNull() || m_joined[i].interface_address == interface_address)) {
+      m_dispatcher->Leave(this, m_joined[i].interface_address, group);
+      m_joined.erase(m_joined.begin() + i);
+    } else {
+      i++;
+    }
+  }
+
+  // The dispatcher no longer delivers these, drop what it already did as closing a socket would
+  wxCriticalSectionLocker lock(m_exclusive);
+  for (deque<Packet>::iterator p = m_queue.begin(); p != m_queue.end();) {
+    if (p->source.group == group && (interface_address.IsNull() || p->source.interface_address == interface_address)) {
+      p = m_queue.erase(p);
+    } else {
+      p++;
+    }
+  }
+}
+
+void MulticastSubscriber::LeaveAll() {
+  for (size_t i = 0; i < m_joined.size(); i++) {
+    m_dispatcher->Leave(this, m_joined[i].interface_address, m_joined[i].group);
+  }
+  m_joined.clear();
+
+  wxCriticalSectionLocker lock(m_exclusive);
+  m_queue.clear();
+}
+
+bool MulticastSubscriber::IsJoined(const NetworkAddress &group) {
+  for (size_t i = 0; i < m_joined.size(); i++) {
+    if (m_joined[i].group == group) {
+      return true;
+    }
+  }
+  return false;
+}
+
+SOCKET MulticastSubscriber::GetSocket(const NetworkAddress &group) {
+  for (size_t i = 0; i < m_joined.size(); i++) {
+    if (m_joined[i].group == group) {
+      return m_dispatcher->GetSocket(m_joined[i].interface_address, group);
+    }
+  }
+  return INVALID_SOCKET;
+}
+
+int MulticastSubscriber::Receive(uint8_t *data, size_t size, MulticastSource *source) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (m_queue.empty()) {
+    // Take the wake up away, Deliver() sends a new one with the next datagram
+    char buf[16];
+    while (socketReady(m_wake_receive, 0) && recv(m_wake_receive, buf, sizeof(buf), 0) > 0) {
+    }
+    if (m_dropped) {
+      LOG_INFO(wxT("Dropped %u multicast datagrams, the receiver could not keep up"), (unsigned int)m_dropped);
+      m_dropped = 0;
+    }
+    return -1;
+  }
+
+  Packet &p = m_queue.front();
+  size_t len = wxMin(p.data.size(), size);
+
+  if (len > 0) {
+    memcpy(data, &p.data[0], len);
+  }
+  if (source) {
+    *source = p.source;
+  }
+  m_queue.pop_front();
+  return (int)len;
+}
+
+void MulticastSubscriber::Deliver(const MulticastSource &source, const uint8_t *data, size_t len) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (m_queue.size() >= MULTICAST_QUEUE_MAX) {
+    m_queue.pop_front();
+    m_dropped++;
+  }
+  m_queue.push_back(Packet());
+
+  Packet &p = m_queue.back();
+  p.source = source;
+  p.data.assign(data, data + len);
+
+  if (m_queue.size() == 1) {
+    send(m_wake_send, "!", 1, MSG_DONTROUTE);
+  }
+}
+
+MulticastDispatcher::MulticastDispatcher(radar_pi *pi) : wxThread(wxTHREAD_JOINABLE) {
+  Create(64 * 1024);  // Stack size
+  m_pi = pi;
+  m_shutdown = false;
+  m_wake_receive = GetLocalhostServerTCPSocket();
+  m_wake_send = GetLocalhostSendTCPSocket(m_wake_receive);
+  SetPriority(wxPRIORITY_MAX);  // It feeds the locators and the receive threads
+}
+
+MulticastDispatcher::~MulticastDispatcher() {
+  for (size_t i = 0; i < m_memberships.size(); i++) {
+    closesocket(m_memberships[i].socket);
+  }
+  for (size_t i = 0; i < m_closing.size(); i++) {
+    closesocket(m_closing[i]);
+  }
+  if (m_wake_send != INVALID_SOCKET) {
+    closesocket(m_wake_send);
+  }
+  if (m_wake_receive != INVALID_SOCKET) {
+    closesocket(m_wake_receive);
+  }
+}
+
+void MulticastDispatcher::Shutdown(void) {
+  m_shutdown = true;
+  Wake();
+}
+
+void MulticastDispatcher::Wake() {
+  if (m_wake_send != INVALID_SOCKET) {
+    send(m_wake_send, "!", 1, MSG_DONTROUTE);
+  }
+}
+
+bool MulticastDispatcher::Join(MulticastSubscriber *subscriber, const NetworkAddress &interface_address,
+                               const NetworkAddress &group, wxString &error) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t i = 0; i < m_memberships.size(); i++) {
+    if (m_memberships[i].interface_address == interface_address && m_memberships[i].group == group) {
+      m_memberships[i].subscribers.push_back(subscriber);
+      return true;
+    }
+  }
+
+  SOCKET socket = startUDPMulticastReceiveSocket(interface_address, group, error);
+  if (socket == INVALID_SOCKET) {
+    return false;
+  }
+
+  Membership m;
+
+  m.interface_address = interface_address;
+  m.group = group;
+  m.socket = socket;
+  m.subscribers.push_back(subscriber);
+  m_memberships.push_back(m);
+  LOG_VERBOSE(wxT("Receiving %s on interface %s"), group.FormatNetworkAddressPort(), interface_address.FormatNetworkAddress());
+  Wake();  // Add it to the select()
+  return true;
+}
+
+void MulticastDispatcher::Leave(MulticastSubscriber *subscriber, const NetworkAddress &interface_address,
+                                const NetworkAddress &group) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t i = 0; i < m_memberships.size(); i++) {
+    Membership &m = m_memberships[i];
+
+    if (m.interface_address == interface_address && m.group == group) {
+      for (size_t j = 0; j < m.subscribers.size(); j++) {
+        if (m.subscribers[j] == subscriber) {
+          m.subscribers.erase(m.subscribers.begin() + j);
+          break;
+        }
+      }
+      if (m.subscribers.empty()) {
+        // Entry() may be reading it right now, so it closes the socket itself
+        LOG_VERBOSE(wxT("No longer receiving %s on interface %s"), group.FormatNetworkAddressPort(),
+                    interface_address.FormatNetworkAddress());
+        m_closing.push_back(m.socket);
+        m_memberships.erase(m_memberships.begin() + i);
+        Wake();
+      }
+      return;
+    }
+  }
+}
+
+SOCKET MulticastDispatcher::GetSocket(const NetworkAddress &interface_address, const NetworkAddress &group) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  for (size_t i = 0; i < m_memberships.size(); i++) {
+    if (m_memberships[i].interface_address == interface_address && m_memberships[i].group == group) {
+      return m_memberships[i].socket;
+    }
+  }
+  return INVALID_SOCKET;
+}
+
+/*
+ * Entry
+ *
+ * Called by wxThread when the new thread is running.
+ * It should remain running until Shutdown is called.
+ */
+void *MulticastDispatcher::Entry(void) {
+  union {
+    sockaddr_storage addr;
+    sockaddr_in ipv4;
+  } rx_addr;
+  socklen_t rx_len;
+
+  vector<uint8_t> data(65536);  // Largest UDP datagram
+  vector<SOCKET> sockets;
+
+  LOG_VERBOSE(wxT("MulticastDispatcher thread starting"));
+
+  while (!m_shutdown) {
+    struct timeval tv = {1, 0};
+    fd_set fdin;
+    FD_ZERO(&fdin);
+
+    int maxFd = INVALID_SOCKET;
+    if (m_wake_receive != INVALID_SOCKET) {
+      FD_SET(m_wake_receive, &fdin);
+      maxFd = MAX(m_wake_receive, maxFd);
+    }
+
+    {
+      wxCriticalSectionLocker lock(m_exclusive);
+
+      for (size_t i = 0; i < m_closing.size(); i++) {
+        closesocket(m_closing[i]);
+      }
+      m_closing.clear();
+
+      sockets.clear();
+      for (size_t i = 0; i < m_memberships.size(); i++) {
+        SOCKET sock = m_memberships[i].socket;
+        sockets.push_back(sock);
+        FD_SET(sock, &fdin);
+        maxFd = MAX(sock, maxFd);
+      }
+    }
+
+    int r = select(maxFd + 1, &fdin, 0, 0, &tv);
+    if (r <= 0) {
+      continue;
+    }
+
+    if (m_wake_receive != INVALID_SOCKET && FD_ISSET(m_wake_receive, &fdin)) {
+      char buf[16];
+      recv(m_wake_receive, buf, sizeof(buf), 0);
+    }
+
+    // Only this thread closes sockets, so all of these are still open
+    for (size_t i = 0; i < sockets.size(); i++) {
+      if (!FD_ISSET(sockets[i], &fdin)) {
+        continue;
+      }
+      rx_len = sizeof(rx_addr);
+      r = recvfrom(sockets[i], (char *)&data[0], (int)data.size(), 0, (struct sockaddr *)&rx_addr, &rx_len);
+      if (r < 0) {
+        continue;
+      }
+
+      wxCriticalSectionLocker lock(m_exclusive);
+      for (size_t j = 0; j < m_memberships.size(); j++) {
+        Membership &m = m_memberships[j];
+
+        if (m.socket == sockets[i]) {
+          MulticastSource source;
+
+          source.interface_address = m.interface_address;
+          source.group = m.group;
+          source.from.addr = rx_addr.ipv4.sin_addr;
+          source.from.port = rx_addr.ipv4.sin_port;
+          for (size_t k = 0; k < m.subscribers.size(); k++) {
+            m.subscribers[k]->Deliver(source, &data[0], (size_t)r);
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  LOG_VERBOSE(wxT("MulticastDispatcher thread stopping"));
+  return 0;
+}
+
+MulticastGroups::MulticastGroups(radar_pi *pi) : m_subscriber(pi) {
+  m_pi = pi;
+  m_generation = 0;
+  m_failed = 0;
+  m_next_retry = 0;
+}
+
+bool MulticastGroups::Update(wxString *errors) {
+  vector<NetworkAddress> interfaces;
+  int generation = m_pi->m_network_interfaces.GetInterfaces(&interfaces);
+
+  time_t now = time(0);
+
+  if (generation == m_generation && (!m_failed || now < m_next_retry)) {
+    return false;
+  }
+
+  vector<Entry> entries;
+  size_t failed = 0;
+  for (size_t i = 0; i < interfaces.size(); i++) {
+    for (size_t g = 0; g < m_groups.size(); g++) {
+      Entry e;
+
+      e.interface_address = interfaces[i];
+      e.group = m_groups[g];
+      e.joined = false;
+
+      // Stay joined where we already are
+      for (size_t j = 0; j < m_entries.size(); j++) {
+        if (m_entries[j].joined && m_entries[j].interface_address == e.interface_address && m_entries[j].group == e.group) {
+          e.joined = true;
+          m_entries[j].joined = false;
+          break;
+        }
+      }
+
+      if (!e.joined) {
+        wxString error = wxString::Format(wxT("Cannot scan interface %s: "), e.interface_address.FormatNetworkAddress());
+        e.joined = m_subscriber.Join(e.interface_address, e.group, error);
+        if (!e.joined) {
+          failed++;
+          wxLogError(error);
+          if (errors) {
+            *errors << wxT("\n") << error;
+          }
+        } else {
+          LOG_VERBOSE(wxT("Scanning interface %s for radars on %s"), e.interface_address.FormatNetworkAddress(),
+                      e.group.FormatNetworkAddressPort());
+        }
+      }
+      entries.push_back(e);
+    }
+  }
+
+  Close();  // Whatever is left belongs to interfaces that went away
+  m_entries = entries;
+  m_generation = generation;
+  m_failed = failed;
+  m_next_retry = now + NETWORK_INTERFACES_POLL;
+  return true;
+}
+
+void MulticastGroups::Close() {
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    if (m_entries[i].joined) {
+      m_subscriber.Leave(m_entries[i].group, m_entries[i].interface_address);
+    }
+  }
+  m_entries.clear();
+  m_generation = 0;
+  m_failed = 0;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,194 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Shows a packet trace written by PacketTrace as hex, one packet at a time.
+ * This is a standalone tool that does not need wxWidgets, build it with
+ *
+ *   c++ -o PacketTrace-dump src/PacketTrace-dump.cpp
+ *
+ * and run it as
+ *
+ *   PacketTrace-dump [-f <label substring>] [-n] radar_pi-YYYYMMDD-HHMMSS.pcap
+ *
+ * where -f only shows packets whose label contains the text and -n only
+ * shows the label lines.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#define PCAP_MAGIC (0xa1b2c3d4)
+#define PCAP_MAGIC_SWAPPED (0xd4c3b2a1)
+#define PCAP_LINKTYPE_USER0 (147)
+
+static uint32_t Swap32(uint32_t v, bool swap) {
+  if (!swap) {
+    return v;
+  }
+  return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+static bool Read32(FILE *f, uint32_t *v, bool swap) {
+  if (fread(v, sizeof(*v), 1, f) != 1) {
+    return false;
+  }
+  *v = Swap32(*v, swap);
+  return true;
+}
+
+static void DumpHex(const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i += 16) {
+    printf(" %5u   ", (unsigned)i);
+    for (size_t j = i; j < i + 16; j++) {
+      if (j % 16 == 8) {
+        printf("  ");
+      }
+      if (j < size) {
+        printf(" %02X", data[j]);
+      } else {
+        printf("   ");
+      }
+    }
+    printf("   ");
+    for (size_t j = i; j < i + 16 && j < size; j++) {
+      putchar((data[j] >= 0x20 && data[j] < 0x7f) ? data[j] : '.');
+    }
+    putchar('\n');
+  }
+}
+
+static int Usage(const char *name) {
+  fprintf(stderr, "Usage: %s [-f <label substring>] [-n] <trace.pcap>\n", name);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  const char *filter = 0;
+  const char *filename = 0;
+  bool headers_only = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "-n") == 0) {
+      headers_only = true;
+    } else if (argv[i][0] == '-' || filename) {
+      return Usage(argv[0]);
+    } else {
+      filename = argv[i];
+    }
+  }
+  if (!filename) {
+    return Usage(argv[0]);
+  }
+
+  FILE *f = fopen(filename, "rb");
+  if (!f) {
+    perror(filename);
+    return 1;
+  }
+
+  uint32_t magic, v, snaplen, linktype;
+  if (fread(&magic, sizeof(magic), 1, f) != 1 || (magic != PCAP_MAGIC && magic != PCAP_MAGIC_SWAPPED)) {
+    fprintf(stderr, "%s: not a pcap file\n", filename);
+    return 1;
+  }
+  bool swap = magic == PCAP_MAGIC_SWAPPED;
+  // version, thiszone, sigfigs
+  if (!Read32(f, &v, swap) || !Read32(f, &v, swap) || !Read32(f, &v, swap) || !Read32(f, &snaplen, swap) ||
+      !Read32(f, &linktype, swap)) {
+    fprintf(stderr, "%s: truncated header\n", filename);
+    return 1;
+  }
+  if (linktype != PCAP_LINKTYPE_USER0) {
+    fprintf(stderr, "%s: link type %u is not a radar_pi packet trace\n", filename, linktype);
+    return 1;
+  }
+
+  std::vector<uint8_t> packet;
+  size_t count = 0;
+  size_t shown = 0;
+
+  for (;;) {
+    uint32_t ts_sec, ts_usec, incl_len, orig_len;
+
+    if (!Read32(f, &ts_sec, swap) || !Read32(f, &ts_usec, swap) || !Read32(f, &incl_len, swap) ||
+        !Read32(f, &orig_len, swap)) {
+      break;
+    }
+    packet.resize(incl_len);
+    if (incl_len > 0 && fread(&packet[0], 1, incl_len, f) != incl_len) {
+      fprintf(stderr, "%s: truncated packet %u\n", filename, (unsigned)count);
+      break;
+    }
+    count++;
+    if (incl_len < 1 || packet[0] + 1u > incl_len) {
+      fprintf(stderr, "%s: packet %u has no label\n", filename, (unsigned)count);
+      continue;
+    }
+
+    std::string label((const char *)&packet[1], packet[0]);
+    const uint8_t *data = &packet[1 + packet[0]];
+    size_t len = incl_len - 1 - packet[0];
+    size_t orig_data_len = orig_len - 1 - packet[0];
+
+    if (filter && label.find(filter) == std::string::npos) {
+      continue;
+    }
+    shown++;
+
+    time_t t = (time_t)ts_sec;
+    struct tm *tm = gmtime(&t);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", tm);
+
+    printf("%s.%06u %s %u bytes", when, ts_usec, label.c_str(), (unsigned)orig_data_len);
+    if (len < orig_data_len) {
+      printf(" (%u captured)", (unsigned)len);
+    }
+    printf(":\n");
+    if (!headers_only) {
+      DumpHex(data, len);
+    }
+  }
+  fclose(f);
+
+  fprintf(stderr, "%u packets, %u shown\n", (unsigned)count, (unsigned)shown);
+  return 0;
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+
+#include "PacketTrace.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Each thread remembers its ring, and for which trace it was made
+static std::atomic<uint32_t> s_trace_id(0);
+static thread_local PacketTraceRing *t_ring = 0;
+static thread_local uint32_t t_trace_id = 0;
+
+void PacketTraceRing::Copy(size_t pos, const void *src, size_t len) {
+  size_t offset = pos & (TRACE_RING_SIZE - 1);
+  size_t first = wxMin(len, TRACE_RING_SIZE - offset);
+
+  memcpy(m_data + offset, src, first);
+  memcpy(m_data, (const uint8_t *)src + first, len - first);
+}
+
+bool PacketTraceRing::Put(const PcapRecordHeader &header, const uint8_t *label, size_t label_len, const uint8_t *data,
+                          size_t len) {
+  size_t head = m_head.load(std::memory_order_relaxed);
+  size_t tail = m_tail.load(std::memory_order_acquire);
+  size_t need = sizeof(header) + 1 + label_len + len;
+
+  if (need > TRACE_RING_SIZE - (head - tail)) {
+    m_dropped++;
+    return false;
+  }
+
+  uint8_t label_byte = (uint8_t)label_len;
+  Copy(head, &header, sizeof(header));
+  head += sizeof(header);
+  Copy(head, &label_byte, 1);
+  head += 1;
+  Copy(head, label, label_len);
+  head += label_len;
+  Copy(head, data, len);
+  head += len;
+
+  m_head.store(head, std::memory_order_release);
+  return true;
+}
+
+size_t PacketTraceRing::Write(FILE *file) {
+  size_t head = m_head.load(std::memory_order_acquire);
+  size_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t len = head - tail;
+
+  if (len > 0) {
+    if (file) {
+      size_t offset = tail & (TRACE_RING_SIZE - 1);
+      size_t first = wxMin(len, TRACE_RING_SIZE - offset);
+
+      fwrite(m_data + offset, 1, first, file);
+      fwrite(m_data, 1, len - first, file);
+    }
+    m_tail.store(head, std::memory_order_release);
+  }
+  return len;
+}
+
+PacketTrace::PacketTrace(radar_pi *pi, const wxString &filename) : wxThread(wxTHREAD_JOINABLE) {
+  Create(64 * 1024);  // Stack size
+  m_pi = pi;
+  m_filename = filename;
+  m_id = ++s_trace_id;
+  m_file = 0;
+  m_shutdown = false;
+}
+
+PacketTrace::~PacketTrace() {
+  for (size_t i = 0; i < m_rings.size(); i++) {
+    delete m_rings[i];
+  }
+  m_rings.clear();
+}
+
+PacketTraceRing *PacketTrace::GetRing() {
+  if (t_trace_id != m_id) {
+    PacketTraceRing *ring = new PacketTraceRing;
+
+    {
+      wxCriticalSectionLocker lock(m_exclusive);
+      m_rings.push_back(ring);
+    }
+    t_ring = ring;
+    t_trace_id = m_id;
+  }
+  return t_ring;
+}
+
+void PacketTrace::Add(const wxString &what, const void *data, size_t len) {
+  wxLongLong now = wxGetUTCTimeUSec();
+  wxScopedCharBuffer label = what.ToUTF8();
+  size_t label_len = wxMin(label.length(), (size_t)TRACE_LABEL_MAX);
+  size_t incl_len = wxMin(len, (size_t)TRACE_SNAPLEN);
+  PcapRecordHeader header;
+
+  header.ts_sec = (uint32_t)(now / 1000000).GetValue();
+  header.ts_usec = (uint32_t)(now % 1000000).GetValue();
+  header.incl_len = (uint32_t)(1 + label_len + incl_len);
+  header.orig_len = (uint32_t)(1 + label_len + len);
+
+  GetRing()->Put(header, (const uint8_t *)label.data(), label_len, (const uint8_t *)data, incl_len);
+}
+
+bool PacketTrace::Flush() {
+  vector<PacketTraceRing *> rings;
+
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+    rings = m_rings;
+  }
+
+  size_t written = 0;
+  for (size_t i = 0; i < rings.size(); i++) {
+    if (!m_file && !m_filename.IsEmpty() && rings[i]->m_head.load(std::memory_order_acquire) != rings[i]->m_tail.load()) {
+      PcapFileHeader header;
+
+      m_file = wxFopen(m_filename, wxT("wb"));
+      if (!m_file) {
+        wxLogError(wxT("radar_pi: cannot create packet trace %s"), m_filename.c_str());
+        m_filename = wxT("");  // Do not try again, discard the packets
+      } else {
+        header.magic = 0xa1b2c3d4;
+        header.version_major = 2;
+        header.version_minor = 4;
+        header.thiszone = 0;
+        header.sigfigs = 0;
+        header.snaplen = TRACE_SNAPLEN;
+        header.linktype = TRACE_LINKTYPE;
+        fwrite(&header, sizeof(header), 1, m_file);
+        LOG_INFO(wxT("radar_pi: tracing packets to %s"), m_filename.c_str());
+      }
+    }
+    written += rings[i]->Write(m_file);
+
+    uint32_t dropped = rings[i]->m_dropped.exchange(0);
+    if (dropped > 0) {
+      LOG_INFO(wxT("radar_pi: packet trace buffer full, dropped %u packets"), dropped);
+    }
+  }
+  if (m_file && written > 0) {
+    fflush(m_file);
+  }
+  return written > 0;
+}
+
+void *PacketTrace::Entry(void) {
+  LOG_VERBOSE(wxT("PacketTrace thread starting"));
+
+  while (!m_shutdown) {
+    Flush();
+    wxMilliSleep(TRACE_FLUSH_MILLIS);
+  }
+  Flush();
+
+  if (m_file) {
+    fclose(m_file);
+    m_file = 0;
+  }
+  LOG_VERBOSE(wxT("PacketTrace thread stopped"));
+  return 0;
+}
+
+PLUGIN_END_NAMESPACE
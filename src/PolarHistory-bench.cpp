@@ -0,0 +1,150 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Measures what a range change costs the receive thread: clearing the ARPA
+ * history of a 4096 spoke radar with an epoch bump, against wiping all rows
+ * as PolarHistory::Clear() used to. Also checks that cleared rows read as
+ * empty until they are written again. Build it against the plugin headers
+ * and wxWidgets, like Kalman-test.cpp, for instance
+ *
+ *   c++ -O2 -Iinclude `wx-config --cxxflags` -o PolarHistory-bench \
+ *     src/PolarHistory-bench.cpp src/PolarHistory.cpp src/spokeutil.cpp `wx-config --libs`
+ */
+
+#include "PolarHistory.h"
+
+#include <chrono>
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define BENCH_SPOKES (4096)
+#define BENCH_SPOKE_LEN (1024)
+#define BENCH_RESETS (1000)
+
+static double NanosSince(std::chrono::steady_clock::time_point start, int n) {
+  std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+  return d.count() / n;
+}
+
+// Store a revolution of spokes with a target every 64 samples
+static void FillHistory(PolarHistory *history, const SpokeRuns &runs, GeoPosition pos) {
+  for (int b = 0; b < BENCH_SPOKES; b++) {
+    history->SetLine(b, runs, 100, wxLongLong(1000 + b), pos);
+  }
+}
+
+int main() {
+  int ret = 0;
+  PolarHistory *history = new PolarHistory(BENCH_SPOKES, BENCH_SPOKE_LEN);
+  SpokeRuns runs;
+  GeoPosition pos = {52.0, 4.0};
+
+  runs.Clear(BENCH_SPOKE_LEN);
+  for (size_t r = 0; r + 8 <= BENCH_SPOKE_LEN; r += 64) {
+    runs.Add(r, 8, 200);
+  }
+
+  FillHistory(history, runs, pos);
+  if (history->FindNext(17, 0, BENCH_SPOKE_LEN, false) != 0 || history->GetTime(17) != 1017) {
+    cout << "ERROR: spoke not stored\n";
+    ret = 1;
+  }
+
+  history->Clear();
+  for (int b = -HISTORY_WRAP_ROWS; b < BENCH_SPOKES + HISTORY_WRAP_ROWS; b++) {
+    if (history->FindNext(b, 0, BENCH_SPOKE_LEN, false) != BENCH_SPOKE_LEN || history->Bits(b, 0) != 0) {
+      cout << "ERROR: spoke " << b << " not empty after Clear()\n";
+      ret = 1;
+      break;
+    }
+  }
+  if (history->GetTime(17) != 0 || history->GetPos(17).lat != 0.) {
+    cout << "ERROR: time or position not reset by Clear()\n";
+    ret = 1;
+  }
+  history->ClearBits(3, 0, BENCH_SPOKE_LEN, HISTORY_BIT(HISTORY_UNCLAIMED));
+  history->SetLine(3, runs, 100, wxLongLong(5), pos);
+  if (history->FindNext(3, 0, BENCH_SPOKE_LEN, false) != 0 || history->FindNext(4, 0, BENCH_SPOKE_LEN, false) != BENCH_SPOKE_LEN) {
+    cout << "ERROR: only the spoke written since Clear() should be visible\n";
+    ret = 1;
+  }
+  if (history->FindNext(BENCH_SPOKES + 3, 0, BENCH_SPOKE_LEN, false) != 0) {
+    cout << "ERROR: duplicated row at the seam not current\n";
+    ret = 1;
+  }
+
+  // The old Clear() wiped the rows, times and positions. Its buffers had the
+  // same size as the current ones, so wipe a copy of that size.
+  size_t words = (BENCH_SPOKE_LEN + HISTORY_WORD_BITS - 1) / HISTORY_WORD_BITS;
+  size_t stride = (HISTORY_PLANES * words + 7) / 8 * 8;
+  size_t bytes = (BENCH_SPOKES + 2 * HISTORY_WRAP_ROWS) * stride * sizeof(uint64_t) +
+                 BENCH_SPOKES * (sizeof(wxLongLong) + sizeof(GeoPosition));
+  uint8_t *old_buffer = (uint8_t *)malloc(bytes);
+  memset(old_buffer, 1, bytes);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_RESETS; i++) {
+    memset(old_buffer, i, bytes);
+  }
+  double wipe_ns = NanosSince(start, BENCH_RESETS);
+  if (old_buffer[bytes - 1] != (uint8_t)(BENCH_RESETS - 1)) {  // Keep the compiler from dropping the memsets
+    ret = 1;
+  }
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_RESETS; i++) {
+    history->Clear();
+  }
+  double epoch_ns = NanosSince(start, BENCH_RESETS);
+
+  // The cost that moved: the first revolution after a reset
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; i++) {
+    history->Clear();
+    FillHistory(history, runs, pos);
+  }
+  double refill_ns = NanosSince(start, 10);
+
+  cout << "History of " << BENCH_SPOKES << " x " << BENCH_SPOKE_LEN << " samples, " << bytes / 1024 << " KiB\n";
+  cout << "Reset by wiping:     " << wipe_ns / 1000. << " us\n";
+  cout << "Reset by new epoch:  " << epoch_ns / 1000. << " us\n";
+  cout << "Storing a revolution after reset: " << refill_ns / 1000. << " us\n";
+
+  free(old_buffer);
+  delete history;
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+int main() { return RadarPlugin::main(); }
@@ -0,0 +1,227 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "PolarHistory.h"
+
+#ifdef __WXMSW__
+#include <malloc.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+static void *AlignedCalloc(size_t size) {
+  void *p;
+#ifdef __WXMSW__
+  p = _aligned_malloc(size, HISTORY_ALIGNMENT);
+#else
+  if (posix_memalign(&p, HISTORY_ALIGNMENT, size) != 0) {
+    p = 0;
+  }
+#endif
+  if (p) {
+    memset(p, 0, size);
+  }
+  return p;
+}
+
+static void AlignedFree(void *p) {
+#ifdef __WXMSW__
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+PolarHistory::PolarHistory(size_t spokes, size_t spoke_len_max) {
+  const size_t words_per_line = HISTORY_ALIGNMENT / sizeof(uint64_t);
+
+  m_spokes = (int)spokes;
+  m_spoke_len_max = spoke_len_max;
+  m_words = (spoke_len_max + HISTORY_WORD_BITS - 1) / HISTORY_WORD_BITS;
+  m_stride = (HISTORY_PLANES * m_words + words_per_line - 1) / words_per_line * words_per_line;
+  m_rows = (unsigned)(spokes + 2 * HISTORY_WRAP_ROWS);
+  m_data = (uint64_t *)AlignedCalloc(m_rows * m_stride * sizeof(uint64_t));
+  m_zero_row = (uint64_t *)AlignedCalloc(m_stride * sizeof(uint64_t));
+  m_epoch = 1;  // and every row was written in epoch 0, so reads as empty
+  m_row_epoch = (uint32_t *)calloc(sizeof(uint32_t), m_rows);
+  m_time = (wxLongLong *)calloc(sizeof(wxLongLong), spokes);
+  m_pos = (GeoPosition *)calloc(sizeof(GeoPosition), spokes);
+
+  if (!m_data || !m_zero_row || !m_row_epoch || !m_time || !m_pos) {
+    wxLogError(wxT("Out Of Memory, fatal!"));
+    wxAbort();
+  }
+}
+
+PolarHistory::~PolarHistory() {
+  AlignedFree(m_data);
+  AlignedFree(m_zero_row);
+  free(m_row_epoch);
+  free(m_time);
+  free(m_pos);
+}
+
+void PolarHistory::Clear() {
+  m_epoch++;
+  if (m_epoch == 0) {
+    // Once every 2^32 clears a row written long ago would look current again
+    memset(m_row_epoch, 0, m_rows * sizeof(uint32_t));
+    m_epoch = 1;
+  }
+}
+
+/*
+ * Return the physical row that duplicates 'bearing' on the other side of
+ * the seam, or -1 if the bearing is not near the seam.
+ */
+int PolarHistory::MirrorRow(SpokeBearing bearing) const {
+  if (bearing < HISTORY_WRAP_ROWS) {
+    return bearing + m_spokes + HISTORY_WRAP_ROWS;
+  }
+  if (bearing >= m_spokes - HISTORY_WRAP_ROWS) {
+    return bearing - m_spokes + HISTORY_WRAP_ROWS;
+  }
+  return -1;
+}
+
+int PolarHistory::SetLine(SpokeBearing bearing, const SpokeRuns &runs, int threshold, wxLongLong time,
+                          const GeoPosition &pos) {
+  uint64_t *above = RowForWrite(bearing + HISTORY_WRAP_ROWS);
+  uint64_t *unclaimed = above + m_words;
+  uint64_t *doppler = above + 2 * m_words;
+  int doppler_count = 0;
+
+  memset(above, 0, HISTORY_PLANES * m_words * sizeof(uint64_t));
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    const SpokeRun &run = runs[i];
+    size_t end = wxMin((size_t)run.end, m_spoke_len_max);
+
+    if (run.begin >= end) {
+      break;
+    }
+    if (run.value == UINT8_MAX) {  // approaching doppler target
+      HistorySetBits(doppler, run.begin, end);
+      doppler_count += (int)(end - run.begin);
+    } else if (run.value < threshold) {
+      continue;
+    }
+    HistorySetBits(above, run.begin, end);
+  }
+  memcpy(unclaimed, above, m_words * sizeof(uint64_t));
+  m_time[bearing] = time;
+  m_pos[bearing] = pos;
+  m_row_epoch[bearing + HISTORY_WRAP_ROWS] = m_epoch;
+
+  int mirror = MirrorRow(bearing);
+  if (mirror >= 0) {
+    memcpy(RowForWrite(mirror), above, m_stride * sizeof(uint64_t));
+    m_row_epoch[mirror] = m_epoch;
+  }
+  return doppler_count;
+}
+
+void PolarHistory::ClearBits(int angle, int r_begin, int r_end, int planes) {
+  if (r_begin < 0) {
+    r_begin = 0;
+  }
+  if (r_end > (int)m_spoke_len_max) {
+    r_end = (int)m_spoke_len_max;
+  }
+  if (r_begin >= r_end) {
+    return;
+  }
+
+  SpokeBearing bearing = ModSpokes(angle);
+  if (!IsCurrent(bearing + HISTORY_WRAP_ROWS)) {
+    return;  // Reads as empty already
+  }
+  int mirror = MirrorRow(bearing);
+  size_t first = r_begin / HISTORY_WORD_BITS;
+  size_t last = (r_end - 1) / HISTORY_WORD_BITS;
+  uint64_t first_mask = ~(uint64_t)0 << (r_begin % HISTORY_WORD_BITS);
+  uint64_t last_mask = ~(uint64_t)0 >> (HISTORY_WORD_BITS - 1 - (r_end - 1) % HISTORY_WORD_BITS);
+
+  for (int plane = 0; plane < HISTORY_PLANES; plane++) {
+    if (!(planes & HISTORY_BIT(plane))) {
+      continue;
+    }
+    uint64_t *p = RowForWrite(bearing + HISTORY_WRAP_ROWS) + plane * m_words;
+    uint64_t *m = mirror >= 0 ? RowForWrite(mirror) + plane * m_words : 0;
+    for (size_t w = first; w <= last; w++) {
+      uint64_t mask = ~(uint64_t)0;
+      if (w == first) {
+        mask &= first_mask;
+      }
+      if (w == last) {
+        mask &= last_mask;
+      }
+      p[w] &= ~mask;
+      if (m) {
+        m[w] = p[w];
+      }
+    }
+  }
+}
+
+int PolarHistory::FindNext(int angle, int r_begin, int r_end, bool doppler) const {
+  if (r_begin < 0) {
+    r_begin = 0;
+  }
+  if (r_end > (int)m_spoke_len_max) {
+    r_end = (int)m_spoke_len_max;
+  }
+  if (r_begin >= r_end) {
+    return r_end;
+  }
+
+  const uint64_t *above = Row(angle);
+  const uint64_t *dop = above + 2 * m_words;
+  size_t w = r_begin / HISTORY_WORD_BITS;
+  size_t last = (r_end - 1) / HISTORY_WORD_BITS;
+  uint64_t bits = above[w] & (~(uint64_t)0 << (r_begin % HISTORY_WORD_BITS));
+
+  for (;;) {
+    if (doppler) {
+      bits &= dop[w];
+    }
+    if (bits) {
+      int r = (int)(w * HISTORY_WORD_BITS) + HistoryFirstSet(bits);
+      return r < r_end ? r : r_end;
+    }
+    if (++w > last) {
+      return r_end;
+    }
+    bits = above[w];
+  }
+}
+
+PLUGIN_END_NAMESPACE
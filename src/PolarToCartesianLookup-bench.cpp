@@ -0,0 +1,192 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+/*
+ * Measures what the trail update pays for PolarToCartesianLookup keeping
+ * only the direction of each spoke: a revolution of 2048 spokes of 1024
+ * samples is swept into a 2048 x 2048 grid like
+ * TrailBuffer::UpdateTrueTrails, with the old table of a point per sample,
+ * with one direction per spoke, and with a full lookup per point. Also
+ * checks the octant folding against cos() and sin() for every spoke, and
+ * counts the points that moved from where the old table put them. Build it
+ * against the plugin headers and wxWidgets, like Kalman-test.cpp, for
+ * instance
+ *
+ *   c++ -O2 -Iinclude `wx-config --cxxflags` -o PolarToCartesianLookup-bench \
+ *     src/PolarToCartesianLookup-bench.cpp src/drawutil.cpp src/shaderutil.cpp \
+ *     `wx-config --libs --gl-libs` -lGL
+ */
+
+#include "drawutil.h"
+
+#include <chrono>
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define BENCH_SPOKES (2048)
+#define BENCH_SPOKE_LEN (1024)
+#define BENCH_GRID (2048)
+#define BENCH_REVOLUTIONS (20)
+
+static double NanosSince(std::chrono::steady_clock::time_point start, int n) {
+  std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+  return d.count() / n;
+}
+
+// The table the lookup used to keep, an int point for every sample of every spoke
+static PointInt *MakeOldTable() {
+  PointInt *table = (PointInt *)malloc(sizeof(PointInt) * BENCH_SPOKES * BENCH_SPOKE_LEN);
+
+  for (size_t arc = 0; arc < BENCH_SPOKES; arc++) {
+    float sine = sinf((float)arc * PI * 2 / BENCH_SPOKES);
+    float cosine = cosf((float)arc * PI * 2 / BENCH_SPOKES);
+    for (size_t radius = 0; radius < BENCH_SPOKE_LEN; radius++) {
+      table[arc * BENCH_SPOKE_LEN + radius].x = (int16_t)((float)radius * cosine);
+      table[arc * BENCH_SPOKE_LEN + radius].y = (int16_t)((float)radius * sine);
+    }
+  }
+  return table;
+}
+
+// Age every cell a spoke passes over, as the trail update does
+static inline void Touch(uint8_t *grid, PointInt point) {
+  uint8_t *trail = &grid[(point.x + BENCH_GRID / 2) * BENCH_GRID + point.y + BENCH_GRID / 2];
+  if (*trail < 255) {
+    (*trail)++;
+  }
+}
+
+static int CheckDirections(size_t spokes) {
+  PolarToCartesianLookup lookup(spokes);
+
+  for (size_t arc = 0; arc < spokes; arc++) {
+    SpokeDirection d = lookup.GetDirection(arc);
+    double angle = (double)arc * PI * 2 / spokes;
+    if (abs(d.cosine - (int32_t)round(cos(angle) * POLAR_LOOKUP_ONE)) > 1 ||
+        abs(d.sine - (int32_t)round(sin(angle) * POLAR_LOOKUP_ONE)) > 1) {
+      cout << "ERROR: spoke " << arc << " of " << spokes << " points in the wrong direction\n";
+      return 1;
+    }
+  }
+  SpokeDirection wrapped = lookup.GetDirection(spokes + 3);
+  SpokeDirection direct = lookup.GetDirection(3);
+  if (wrapped.cosine != direct.cosine || wrapped.sine != direct.sine) {
+    cout << "ERROR: spoke " << spokes + 3 << " of " << spokes << " does not wrap\n";
+    return 1;
+  }
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= CheckDirections(BENCH_SPOKES);
+  ret |= CheckDirections(250);  // Quantum, not a multiple of eight
+
+  PolarToCartesianLookup lookup(BENCH_SPOKES);
+  PointInt *old_table = MakeOldTable();
+  uint8_t *grid = (uint8_t *)calloc(BENCH_GRID, BENCH_GRID);
+  if (!old_table || !grid) {
+    cout << "ERROR: out of memory\n";
+    return 1;
+  }
+
+  size_t moved = 0;
+  for (size_t arc = 0; arc < BENCH_SPOKES; arc++) {
+    SpokeDirection direction = lookup.GetDirection(arc);
+    for (size_t radius = 0; radius < BENCH_SPOKE_LEN; radius++) {
+      PointInt p = PolarToCartesianLookup::GetPointInt(direction, radius);
+      PointInt q = old_table[arc * BENCH_SPOKE_LEN + radius];
+      if (p.x != q.x || p.y != q.y) {
+        moved++;
+        if (abs(p.x - q.x) > 1 || abs(p.y - q.y) > 1) {
+          cout << "ERROR: spoke " << arc << " sample " << radius << " moved more than a pixel\n";
+          ret = 1;
+        }
+      }
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < BENCH_REVOLUTIONS; rev++) {
+    for (size_t arc = 0; arc < BENCH_SPOKES; arc++) {
+      const PointInt *spoke = &old_table[arc * BENCH_SPOKE_LEN];
+      for (size_t radius = 0; radius < BENCH_SPOKE_LEN; radius++) {
+        Touch(grid, spoke[radius]);
+      }
+    }
+  }
+  double table_ns = NanosSince(start, BENCH_REVOLUTIONS * BENCH_SPOKES * BENCH_SPOKE_LEN);
+
+  start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < BENCH_REVOLUTIONS; rev++) {
+    for (size_t arc = 0; arc < BENCH_SPOKES; arc++) {
+      SpokeDirection direction = lookup.GetDirection(arc);
+      for (size_t radius = 0; radius < BENCH_SPOKE_LEN; radius++) {
+        Touch(grid, PolarToCartesianLookup::GetPointInt(direction, radius));
+      }
+    }
+  }
+  double direction_ns = NanosSince(start, BENCH_REVOLUTIONS * BENCH_SPOKES * BENCH_SPOKE_LEN);
+
+  start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < BENCH_REVOLUTIONS; rev++) {
+    for (size_t arc = 0; arc < BENCH_SPOKES; arc++) {
+      for (size_t radius = 0; radius < BENCH_SPOKE_LEN; radius++) {
+        Touch(grid, lookup.GetPointInt(arc, radius));
+      }
+    }
+  }
+  double lookup_ns = NanosSince(start, BENCH_REVOLUTIONS * BENCH_SPOKES * BENCH_SPOKE_LEN);
+
+  size_t sum = 0;
+  for (size_t i = 0; i < BENCH_GRID * BENCH_GRID; i++) {
+    sum += grid[i];  // Keep the compiler from dropping the sweeps
+  }
+
+  cout << "Sweep of " << BENCH_SPOKES << " x " << BENCH_SPOKE_LEN << " samples into " << BENCH_GRID << " x " << BENCH_GRID
+       << " trails (" << sum % 10 << ")\n";
+  cout << "Point per sample:    " << table_ns << " ns per sample, "
+       << sizeof(PointInt) * BENCH_SPOKES * BENCH_SPOKE_LEN / 1024 << " KiB of int points\n";
+  cout << "Direction per spoke: " << direction_ns << " ns per sample\n";
+  cout << "Lookup per point:    " << lookup_ns << " ns per sample\n";
+  cout << "Moved by a pixel:    " << moved * 100. / (BENCH_SPOKES * BENCH_SPOKE_LEN) << "% of the points\n";
+
+  free(grid);
+  free(old_table);
+  cout << (ret ? "FAILED\n" : "OK\n");
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
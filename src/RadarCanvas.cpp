@@ -30,6 +30,7 @@
  */
 
 #include "RadarCanvas.h"
+#include "FrameScheduler.h"
 
 #include "RadarInfo.h"
 #include "TextureFont.h"
@@ -69,12 +70,21 @@ RadarCanvas::RadarCanvas(radar_pi *pi, RadarInfo *ri, wxWindow *parent, wxSize s
 
 RadarCanvas::~RadarCanvas() {
   LOG_VERBOSE(wxT("%s destroy OpenGL canvas"), m_ri->m_name.c_str());
-  delete m_context;
-  delete m_zero_context;
+  // Free the GL objects of our context while it is still current
+  bool current = SetCurrent(*m_context);
+  m_ri->ReleasePanelGeometry(current);
+  m_range_ring_geometry.Release(current);
+  for (int i = 0; i < BEARING_LINES; i++) {
+    m_vrm_geometry[i].Release(current);
+  }
   if (m_cursor_texture) {
-    glDeleteTextures(1, &m_cursor_texture);
+    if (current) {
+      glDeleteTextures(1, &m_cursor_texture);
+    }
     m_cursor_texture = 0;
   }
+  delete m_context;
+  delete m_zero_context;
 }
 
 void RadarCanvas::OnSize(wxSizeEvent &evt) {
@@ -251,7 +261,7 @@ void RadarCanvas::RenderRangeRingsAndHeading(const wxSize &clientSize, float r)
   glPushMatrix();
   glPushAttrib(GL_ALL_ATTRIB_BITS);
   double heading = 180.;
-  if (m_pi->GetHeadingSource() != HEADING_NONE) {
+  if (m_ri->GetHeadingSource() != HEADING_NONE) {
     switch (m_ri->GetOrientation()) {
       case ORIENTATION_HEAD_UP:
         heading += 0.;
@@ -259,14 +269,14 @@ void RadarCanvas::RenderRangeRingsAndHeading(const wxSize &clientSize, float r)
         break;
       case ORIENTATION_STABILIZED_UP:
         heading += m_ri->m_course;
-        m_ri->m_predictor = m_pi->GetHeadingTrue() - m_ri->m_course;
+        m_ri->m_predictor = m_ri->GetHeadingTrue() - m_ri->m_course;
         break;
       case ORIENTATION_NORTH_UP:
-        m_ri->m_predictor = m_pi->GetHeadingTrue();
+        m_ri->m_predictor = m_ri->GetHeadingTrue();
         break;
       case ORIENTATION_COG_UP:
         heading += m_pi->GetCOG();
-        m_ri->m_predictor = m_pi->GetHeadingTrue() - heading - 180.;
+        m_ri->m_predictor = m_ri->GetHeadingTrue() - heading - 180.;
         break;
     }
   } else {
@@ -311,8 +321,15 @@ void RadarCanvas::RenderRangeRingsAndHeading(const wxSize &clientSize, float r)
   int px;
   int py;
 
+  const double key[] = {center_x, center_y, r, (double)rings};
+  if (!m_range_ring_geometry.IsCurrent(key, ARRAY_SIZE(key))) {
+    for (int i = 1; i <= rings; i++) {
+      m_range_ring_geometry.AddArc(center_x, center_y, r * i / (double)rings, 0.0, 2.0 * (float)PI, 360);
+    }
+  }
+  m_range_ring_geometry.DrawOutline();
+
   for (int i = 1; i <= rings; i++) {
-    DrawArc(center_x, center_y, r * i / (double)rings, 0.0, 2.0 * (float)PI, 360);
     if (meters != 0) {
       wxString s = m_ri->GetDisplayRangeStr(meters * i / rings, false);
       if (s.length() > 0) {
@@ -321,7 +338,7 @@ void RadarCanvas::RenderRangeRingsAndHeading(const wxSize &clientSize, float r)
     }
   }
 
-  // if (m_pi->GetHeadingSource() != HEADING_NONE) {
+  // if (m_ri->GetHeadingSource() != HEADING_NONE) {
 
   x = sinf((float)deg2rad(m_ri->m_predictor));
   y = -cosf((float)deg2rad(m_ri->m_predictor));
@@ -345,7 +362,7 @@ void RadarCanvas::RenderRangeRingsAndHeading(const wxSize &clientSize, float r)
     y = cosf(deg2rad(i - heading)) * (r * 1.00 - 1);
 
     wxString s;
-    if (i % 90 == 0 && (m_pi->GetHeadingSource() != HEADING_NONE)) {
+    if (i % 90 == 0 && (m_ri->GetHeadingSource() != HEADING_NONE)) {
       static char nesw[4] = {'N', 'E', 'S', 'W'};
       s = wxString::Format(wxT("%c"), nesw[i / 90]);
     } else {
@@ -457,7 +474,7 @@ void RadarCanvas::RenderCursor(const wxSize &clientSize, float radius, const Geo
   distance = local_distance(pos, cursor) * 1852.;
   bearing = local_bearing(pos, cursor);
   if (m_ri->GetOrientation() != ORIENTATION_NORTH_UP) {
-    bearing -= m_pi->GetHeadingTrue();
+    bearing -= m_ri->GetHeadingTrue();
   }
   RenderCursor(clientSize, radius, distance, bearing);
 }
@@ -521,7 +538,11 @@ void RadarCanvas::Render_EBL_VRM(const wxSize &clientSize, float radius) {
         glVertex2f(x, y);
         glEnd();
       }
-      DrawArc(center_x, center_y, scale, 0.f, 2.f * (float)PI, 360);
+      const double key[] = {center_x, center_y, scale};
+      if (!m_vrm_geometry[b].IsCurrent(key, ARRAY_SIZE(key))) {
+        m_vrm_geometry[b].AddArc(center_x, center_y, scale, 0.f, 2.f * (float)PI, 360);
+      }
+      m_vrm_geometry[b].DrawOutline();
     }
   }
   glPopMatrix();
@@ -616,7 +637,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
   PlugIn_ViewPort vp;
   GeoPosition pos;
 
-  if (m_pi->GetHeadingSource() != HEADING_NONE && m_ri->GetRadarPosition(&pos) && m_ri->m_target_on_ppi.GetValue() > 0) {
+  if (m_ri->GetHeadingSource() != HEADING_NONE && m_ri->GetRadarPosition(&pos) && m_ri->m_target_on_ppi.GetValue() > 0) {
     // LAYER 2 - AIS AND ARPA TARGETS
 
     ResetGLViewPort(clientSize);
@@ -633,7 +654,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
     switch (m_ri->GetOrientation()) {
       case ORIENTATION_HEAD_UP:
       case ORIENTATION_STABILIZED_UP:
-        vp.rotation = deg2rad(-m_pi->GetHeadingTrue());
+        vp.rotation = deg2rad(-m_ri->GetHeadingTrue());
         break;
       case ORIENTATION_NORTH_UP:
         vp.rotation = 0.;
@@ -684,7 +705,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
   }
   glMatrixMode(GL_MODELVIEW);  // Reset matrick stack target back to GL_MODELVIEW
 
-  m_ri->RenderRadarImage1(wxPoint(0, 0), m_ri->m_panel_zoom / m_ri->m_range.GetValue(), 0.0, false);
+  m_ri->RenderRadarImage1(wxPoint(0, 0), m_ri->m_panel_zoom / m_ri->m_range.GetValue(), 0.0, false, clientSize);
 
   // LAYER 5 - TEXTS & CURSOR
   ResetGLViewPort(clientSize);
@@ -704,6 +725,7 @@ void RadarCanvas::Render(wxPaintEvent &evt) {
   // Also it seems much more logical to call SwapBuffers() *before* going back to the OpenCPN
   // context.
   SwapBuffers();
+  m_pi->m_frame_scheduler->Presented(m_ri->m_radar, FRAME_TARGET_PPI);
 
   // Restore the OpenGL context, so that AIS rollover doesn't break.
   // Apparently this is executed in a timer on Windows and Linux in such
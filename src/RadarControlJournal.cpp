@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarControlJournal.h"
+
+#include "RadarInfo.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+RadarControlJournal::RadarControlJournal() {
+  for (int i = 0; i < CT_MAX; i++) {
+    m_pending_set[i] = false;
+    m_sent_time[i] = 0;
+    m_shared_set[i] = false;
+  }
+  m_pending_count = 0;
+  m_shared_any = false;
+}
+
+void RadarControlJournal::Commit() {
+  if (m_pending_count == 0) {
+    return;
+  }
+
+  time_t now = time(0);
+  bool send = false;
+  for (int i = 0; i < m_pending_count && !send; i++) {
+    ControlType ct = m_pending_list[i];
+    send = m_sent_time[ct] == 0 || now >= m_sent_time[ct] + CONTROL_JOURNAL_RESEND ||
+           m_pending[ct].value != m_sent[ct].value || m_pending[ct].state != m_sent[ct].state;
+  }
+
+  if (send) {
+    wxCriticalSectionLocker lock(m_exclusive);
+
+    for (int i = 0; i < m_pending_count; i++) {
+      ControlType ct = m_pending_list[i];
+      m_shared[ct] = m_pending[ct];
+      m_shared_set[ct] = true;
+      m_sent[ct] = m_pending[ct];
+      m_sent_time[ct] = now;
+    }
+    m_shared_any = true;
+  }
+
+  for (int i = 0; i < m_pending_count; i++) {
+    m_pending_set[m_pending_list[i]] = false;
+  }
+  m_pending_count = 0;
+}
+
+void RadarControlJournal::Apply(RadarInfo *ri) {
+  Entry entry[CT_MAX];
+  ControlType list[CT_MAX];
+  int count = 0;
+
+  if (!m_shared_any) {
+    return;
+  }
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+
+    for (int i = 0; i < CT_MAX; i++) {
+      if (m_shared_set[i]) {
+        m_shared_set[i] = false;
+        entry[count] = m_shared[i];
+        list[count++] = (ControlType)i;
+      }
+    }
+    m_shared_any = false;
+  }
+
+  // Update() only marks the item modified, and so redraws its button, when
+  // the value differs from what the button shows.
+  for (int i = 0; i < count; i++) {
+    if (list[i] == CT_RANGE) {
+      ri->m_range.Update(entry[i].value);  // Keeps the auto range state
+      continue;
+    }
+    RadarControlItem *item = ri->GetControlItem(list[i]);
+    if (item) {
+      item->Update(entry[i].value, entry[i].state);
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
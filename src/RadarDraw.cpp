@@ -31,6 +31,7 @@
 
 #include "RadarDraw.h"
 
+#include "RadarDrawCore.h"
 #include "RadarDrawShader.h"
 #include "RadarDrawVertex.h"
 
@@ -42,7 +43,11 @@ RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method) {
     case 0:
       return new RadarDrawVertex(ri);
     case 1:
-      return new RadarDrawShader(ri);
+      return new RadarDrawShader(ri, false);
+    case 2:
+      return new RadarDrawShader(ri, true);
+    case 3:
+      return new RadarDrawCore(ri);
     default:
       wxLogError(wxT("unsupported draw method %d"), draw_method);
   }
@@ -52,7 +57,7 @@ RadarDraw* RadarDraw::make_Draw(RadarInfo* ri, int draw_method) {
 RadarDraw::~RadarDraw() {}
 
 void RadarDraw::GetDrawingMethods(wxArrayString& methods) {
-  wxString m[] = {_("Vertex Array"), _("Shader")};
+  wxString m[] = {_("Vertex Array"), _("Shader"), _("Shader with lookup"), _("OpenGL 3.3 core")};
 
   methods = wxArrayString(ARRAY_SIZE(m), m);
 }
@@ -0,0 +1,222 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarDrawCore.h"
+
+#include "RadarInfo.h"
+#include "RadarPolarImage.h"
+#include "shaderutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// The #version line is prepended at run time, it differs between GL and GLES.
+static const char *VertexShaderCoreText =
+    "layout(std140) uniform RadarTransform { \n"
+    "   mat4 transform; \n"
+    "   vec4 colour_scale; \n"
+    "}; \n"
+    "layout(location = 0) in vec2 position; \n"
+    "layout(location = 1) in vec2 polar; \n"
+    "out vec2 xy; \n"
+    "void main() \n"
+    "{ \n"
+    "   xy = polar; \n"
+    "   gl_Position = transform * vec4(position, 0.0, 1.0); \n"
+    "} \n";
+
+// Same as FragmentShaderColorText in RadarDrawShader.cpp
+static const char *FragmentShaderCoreText =
+    "layout(std140) uniform RadarTransform { \n"
+    "   mat4 transform; \n"
+    "   vec4 colour_scale; \n"
+    "}; \n"
+    "uniform sampler2D tex2d; \n"
+    "uniform sampler2D palette; \n"
+    "in vec2 xy; \n"
+    "out vec4 frag_colour; \n"
+    "void main() \n"
+    "{ \n"
+    "   float d = length(xy);\n"
+    "   if (d >= 1.0) \n"
+    "      discard; \n"
+    "   float a = atan(xy.y, xy.x) / 6.28318; \n"
+    "   float index = texture(tex2d, vec2(d, a)).r * 255.0; \n"
+    "   vec4 colour = texture(palette, vec2((index + 0.5) / 64.0, 0.5)); \n"
+    "   frag_colour = vec4(colour.rgb, colour.a * colour_scale.x); \n"
+    "} \n";
+
+static const char *VersionCore = "#version 330 core\n";
+static const char *VersionES = "#version 300 es\nprecision highp float;\n";
+
+bool RadarDrawCore::Init(size_t spokes, size_t spoke_len_max) {
+  bool es = false;
+
+  m_spokes = spokes;
+  m_spoke_len_max = spoke_len_max;
+
+  if (!CompileShader && !ShadersSupported()) {
+    wxLogError(wxT("the OpenGL system of this computer does not support shader m_programs"));
+    return false;
+  }
+  if (!CoreProfileSupported(&es)) {
+    wxLogError(wxT("the OpenGL system of this computer does not support OpenGL 3.3 or OpenGL ES 3"));
+    return false;
+  }
+
+  ResetCore();
+  Reset();
+
+  wxString vertex = wxString::FromAscii(es ? VersionES : VersionCore) + wxString::FromAscii(VertexShaderCoreText);
+  wxString fragment = wxString::FromAscii(es ? VersionES : VersionCore) + wxString::FromAscii(FragmentShaderCoreText);
+
+  if (!CompileShaderText(&m_vertex, GL_VERTEX_SHADER, vertex.mb_str()) ||
+      !CompileShaderText(&m_fragment, GL_FRAGMENT_SHADER, fragment.mb_str())) {
+    wxLogError(wxT("the OpenGL system of this computer failed to compile shader programs"));
+    return false;
+  }
+
+  m_program = LinkShaders(m_vertex, m_fragment);
+  if (m_program == 0) {
+    wxLogError(wxT("GPU oriented OpenGL failed to link shader program"));
+    return false;
+  }
+
+  GLuint block = GetUniformBlockIndex(m_program, "RadarTransform");
+  if (block == GL_INVALID_INDEX) {
+    wxLogError(wxT("GPU oriented OpenGL shader program has no RadarTransform block"));
+    return false;
+  }
+  UniformBlockBinding(m_program, block, CORE_UNIFORM_BINDING);
+
+  // The samplers never change, so set them once
+  UseProgram(m_program);
+  Uniform1i(GetUniformLocation(m_program, "tex2d"), 0);
+  Uniform1i(GetUniformLocation(m_program, "palette"), 1);
+  UseProgram(0);
+
+  CreateTextures();
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // We tell the GPU to draw a square from (-512,-512) to (+512,+512).
+  // The shader morphs this into a circle.
+  GLfloat fullscale = m_spoke_len_max;
+  GLfloat quad[4][4] = {{-fullscale, -fullscale, -1, -1},
+                        {fullscale, -fullscale, 1, -1},
+                        {-fullscale, fullscale, -1, 1},
+                        {fullscale, fullscale, 1, 1}};
+
+  GenVertexArrays(1, &m_vao);
+  BindVertexArray(m_vao);
+  GenBuffers(1, &m_vbo);
+  BindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  BufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+  VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(quad[0]), (const GLvoid *)0);
+  EnableVertexAttribArray(0);
+  VertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(quad[0]), (const GLvoid *)(2 * sizeof(GLfloat)));
+  EnableVertexAttribArray(1);
+  BindVertexArray(0);
+  BindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // mat4 transform + vec4 colour_scale, std140 layout
+  GenBuffers(1, &m_ubo);
+  BindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+  BufferData(GL_UNIFORM_BUFFER, 20 * sizeof(GLfloat), 0, GL_STREAM_DRAW);
+  BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+  if (m_ri->m_pi->m_settings.shader_timing && TimerQueriesSupported()) {
+    GenQueries(2, m_query);
+  }
+
+  return true;
+}
+
+void RadarDrawCore::ResetCore() {
+  if (m_vao) {
+    DeleteVertexArrays(1, &m_vao);
+    m_vao = 0;
+  }
+  if (m_vbo) {
+    DeleteBuffers(1, &m_vbo);
+    m_vbo = 0;
+  }
+  if (m_ubo) {
+    DeleteBuffers(1, &m_ubo);
+    m_ubo = 0;
+  }
+}
+
+RadarDrawCore::~RadarDrawCore() { ResetCore(); }
+
+void RadarDrawCore::Draw(int transparency) {
+  if (!m_program || !m_texture || !m_image || !m_vao) {
+    return;
+  }
+
+  GLfloat block[20];
+
+  memcpy(block, m_transform, sizeof(m_transform));
+  block[16] = (GLfloat)(MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
+  block[17] = 0;
+  block[18] = 0;
+  block[19] = 0;
+
+  BeginTiming();
+
+  UseProgram(m_program);
+  BindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+  BufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), block);
+  BindBufferBase(GL_UNIFORM_BUFFER, CORE_UNIFORM_BINDING, m_ubo);
+
+  ActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, m_palette);
+  UploadPalette();
+  ActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  UploadChangedLines();
+
+  BindVertexArray(m_vao);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  // Leave the state as we found it, there is no glPopAttrib() to do it for us
+  BindVertexArray(0);
+  ActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  ActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  BindBufferBase(GL_UNIFORM_BUFFER, CORE_UNIFORM_BINDING, 0);
+  BindBuffer(GL_UNIFORM_BUFFER, 0);
+  UseProgram(0);
+
+  EndTiming();
+}
+
+PLUGIN_END_NAMESPACE
@@ -32,6 +32,7 @@
 #include "RadarDrawShader.h"
 
 #include "RadarInfo.h"
+#include "RadarPolarImage.h"
 #include "drawutil.h"
 #include "shaderutil.h"
 
@@ -60,22 +61,48 @@ static const char *FragmentShaderText =
     "} \n";
 #endif
 
+// The texture holds a BlobColour rank per sample, the palette the colour
+// for each rank. Ranks are looked up with GL_NEAREST, interpolating them
+// would mix unrelated colours.
 static const char *FragmentShaderColorText =
     "uniform sampler2D tex2d; \n"
+    "uniform sampler2D palette; \n"
+    "uniform float alpha; \n"
     "void main() \n"
     "{ \n"
     "   float d = length(gl_TexCoord[0].xy);\n"
     "   if (d >= 1.0) \n"
     "      discard; \n"
     "   float a = atan(gl_TexCoord[0].y, gl_TexCoord[0].x) / 6.28318; \n"
-    "   gl_FragColor = texture2D(tex2d, vec2(d, a)); \n"
+    "   float index = texture2D(tex2d, vec2(d, a)).x * 255.0; \n"
+    "   vec4 colour = texture2D(palette, vec2((index + 0.5) / 64.0, 0.5)); \n"
+    "   gl_FragColor = vec4(colour.rgb, colour.a * alpha); \n"
     "} \n";
 
-bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
-  wxCriticalSectionLocker lock(m_exclusive);
+// Same, but radius and angle come from the lookup texture for the quadrant
+// x >= 0, y >= 0. Both are stored as 16 bits in two channels: radius in
+// r and g (1.0 = outside the circle), angle / 90 degrees in b and a.
+static const char *FragmentShaderLookupText =
+    "uniform sampler2D tex2d; \n"
+    "uniform sampler2D palette; \n"
+    "uniform sampler2D lookup; \n"
+    "uniform float alpha; \n"
+    "void main() \n"
+    "{ \n"
+    "   vec2 p = gl_TexCoord[0].xy; \n"
+    "   vec4 l = texture2D(lookup, abs(p)); \n"
+    "   const vec2 unpack = vec2(65280.0, 255.0) / 65535.0; \n"
+    "   float d = dot(l.rg, unpack); \n"
+    "   if (d >= 1.0) \n"
+    "      discard; \n"
+    "   float q = dot(l.ba, unpack) * 0.25; \n"
+    "   float a = p.y >= 0.0 ? (p.x >= 0.0 ? q : 0.5 - q) : (p.x < 0.0 ? 0.5 + q : 1.0 - q); \n"
+    "   float index = texture2D(tex2d, vec2(d, a)).x * 255.0; \n"
+    "   vec4 colour = texture2D(palette, vec2((index + 0.5) / 64.0, 0.5)); \n"
+    "   gl_FragColor = vec4(colour.rgb, colour.a * alpha); \n"
+    "} \n";
 
-  m_format = GL_RGBA;
-  m_channels = SHADER_COLOR_CHANNELS;
+bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
   m_spokes = spokes;
   m_spoke_len_max = spoke_len_max;
 
@@ -87,7 +114,7 @@ bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
   Reset();
 
   if (!CompileShaderText(&m_vertex, GL_VERTEX_SHADER, VertexShaderText) ||
-      !CompileShaderText(&m_fragment, GL_FRAGMENT_SHADER, FragmentShaderColorText)) {
+      !CompileShaderText(&m_fragment, GL_FRAGMENT_SHADER, m_use_lookup ? FragmentShaderLookupText : FragmentShaderColorText)) {
     wxLogError(wxT("the OpenGL system of this computer failed to compile shader programs"));
     return false;
   }
@@ -98,30 +125,71 @@ bool RadarDrawShader::Init(size_t spokes, size_t spoke_len_max) {
     return false;
   }
 
+  CreateTextures();
+  if (m_use_lookup) {
+    CreateLookupTexture();
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (m_ri->m_pi->m_settings.shader_timing && TimerQueriesSupported()) {
+    GenQueries(2, m_query);
+  }
+
+  return true;
+}
+
+void RadarDrawShader::CreateTextures() {
+  // The size of m_texture is set when we know which level to draw
   glGenTextures(1, &m_texture);
   glBindTexture(GL_TEXTURE_2D, m_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  m_texture_level = -1;
+
+  glGenTextures(1, &m_palette);
+  glBindTexture(GL_TEXTURE_2D, m_palette);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SHADER_PALETTE_SIZE, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
 
-  if (m_data) {
-    free(m_data);
+// One texel per sample along the axes. The texture is sampled with GL_NEAREST;
+// interpolating would mix the two bytes of each value.
+void RadarDrawShader::CreateLookupTexture() {
+  size_t size = m_spoke_len_max;
+  GLubyte *lookup = (GLubyte *)malloc(size * size * 4);
+  if (!lookup) {
+    wxLogError(wxT("Out Of Memory, fatal!"));
+    wxAbort();
   }
-  m_data = (unsigned char *)calloc(SHADER_COLOR_CHANNELS, m_spoke_len_max * m_spokes);
-  // Tell the GPU the size of the texture:
-  glTexImage2D(/* target          = */ GL_TEXTURE_2D,
-               /* level           = */ 0,
-               /* internal_format = */ m_format,
-               /* width           = */ m_spoke_len_max,
-               /* heigth          = */ m_spokes,
-               /* border          = */ 0,
-               /* format          = */ m_format,
-               /* type            = */ GL_UNSIGNED_BYTE,
-               /* data            = */ m_data);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  m_start_line = -1;
-  m_lines = 0;
+  for (size_t y = 0; y < size; y++) {
+    for (size_t x = 0; x < size; x++) {
+      // The centre of texel (x, y) in the [0, 1] quadrant
+      double px = (x + 0.5) / size;
+      double py = (y + 0.5) / size;
+      double d = sqrt(px * px + py * py);
+      double q = atan2(py, px) / (PI / 2);
+      uint16_t d16 = (d >= 1.0) ? 65535 : (uint16_t)(d * 65535);
+      uint16_t q16 = (uint16_t)(q * 65535 + 0.5);
+      GLubyte *t = lookup + (y * size + x) * 4;
+
+      t[0] = d16 >> 8;
+      t[1] = d16 & 0xff;
+      t[2] = q16 >> 8;
+      t[3] = q16 & 0xff;
+    }
+  }
 
-  return true;
+  glGenTextures(1, &m_lookup);
+  glBindTexture(GL_TEXTURE_2D, m_lookup);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, lookup);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  free(lookup);
 }
 
 void RadarDrawShader::Reset() {
@@ -141,74 +209,181 @@ void RadarDrawShader::Reset() {
     glDeleteTextures(1, &m_texture);
     m_texture = 0;
   }
+  if (m_palette) {
+    glDeleteTextures(1, &m_palette);
+    m_palette = 0;
+  }
+  if (m_lookup) {
+    glDeleteTextures(1, &m_lookup);
+    m_lookup = 0;
+  }
+  if (m_query[0]) {
+    DeleteQueries(2, m_query);
+    m_query[0] = 0;
+    m_query[1] = 0;
+  }
+}
 
-  if (m_data) {
-    free(m_data);
-    m_data = 0;
+RadarDrawShader::~RadarDrawShader() { Reset(); }
+
+void RadarDrawShader::SetPolarImage(RadarPolarImage *image, int reader) {
+  if (image != m_image || reader != m_reader) {
+    // A different image, so the texture has to be uploaded completely
+    wxCriticalSectionLocker lock(image->m_exclusive);
+
+    image->SetAllChanged(reader);
+    m_image = image;
+    m_reader = reader;
   }
 }
 
-RadarDrawShader::~RadarDrawShader() {
-  wxCriticalSectionLocker lock(m_exclusive);
+// Size m_texture for m_level. Called with m_texture bound.
+void RadarDrawShader::AllocateTexture() {
+  wxCriticalSectionLocker lock(m_image->m_exclusive);
 
-  Reset();
+  // Tell the GPU the size of the texture, the data follows from the polar image
+  glTexImage2D(/* target          = */ GL_TEXTURE_2D,
+               /* level           = */ 0,
+               /* internal_format = */ (GLint)(m_texture_format == GL_RED ? GL_R8 : m_texture_format),
+               /* width           = */ m_image->GetSpokeLen(m_level),
+               /* heigth          = */ m_image->GetSpokes(m_level),
+               /* border          = */ 0,
+               /* format          = */ m_texture_format,
+               /* type            = */ GL_UNSIGNED_BYTE,
+               /* data            = */ 0);
+  m_image->SetAllChanged(m_reader);
+  m_texture_level = m_level;
 }
 
-void RadarDrawShader::DrawRadarOverlayImage(double radar_scale, double panel_rotate) {
-  wxCriticalSectionLocker lock(m_exclusive);
+void RadarDrawShader::UploadChangedLines() {
+  int start_line, lines;
 
-  if (!m_program || !m_texture || !m_data) {
+  if (m_texture_level != m_level) {
+    AllocateTexture();
+  }
+
+  wxCriticalSectionLocker lock(m_image->m_exclusive);
+
+  if (!m_image->GetChangedLines(m_reader, m_level, &start_line, &lines)) {
+    return;
+  }
+
+  int spokes = (int)m_image->GetSpokes(m_level);
+  int spoke_len = (int)m_image->GetSpokeLen(m_level);
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  // Since the last time we have received data from [start_line, start_line + lines>
+  // so we only need to update the texture for those data lines.
+  if (start_line + lines > spokes) {
+    int end_line = (start_line + lines) % spokes;
+    // if the new data partly wraps past the end of the texture
+    // tell it the two parts separately
+    // First remap [0, end_line>
+    glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
+                    /* level =    */ 0,
+                    /* x-offset = */ 0,
+                    /* y-offset = */ 0,
+                    /* width =    */ spoke_len,
+                    /* height =   */ end_line,
+                    /* format =   */ m_texture_format,
+                    /* type =     */ GL_UNSIGNED_BYTE,
+                    /* pixels =   */ m_image->GetLine(m_level, 0));
+    lines = spokes - start_line;
+  }
+  // And then remap [start_line, start_line + lines>
+  glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
+                  /* level =    */ 0,
+                  /* x-offset = */ 0,
+                  /* y-offset = */ start_line,
+                  /* width =    */ spoke_len,
+                  /* height =   */ lines,
+                  /* format =   */ m_texture_format,
+                  /* type =     */ GL_UNSIGNED_BYTE,
+                  /* pixels =   */ m_image->GetLine(m_level, start_line));
+}
+
+// The colours can change at any time (day/night, settings) and the palette is tiny,
+// so it is simply uploaded on every draw. It is indexed by the rank of the colour.
+void RadarDrawShader::UploadPalette() {
+  GLubyte palette[SHADER_PALETTE_SIZE][4];
+
+  CLEAR_STRUCT(palette);
+  for (int i = BLOB_NONE + 1; i < BLOB_COLOURS && i < SHADER_PALETTE_SIZE; i++) {
+    const PixelColour &colour = m_ri->m_colour_map_rgb[PolarImageRank(i)];
+    palette[i][0] = colour.Red();
+    palette[i][1] = colour.Green();
+    palette[i][2] = colour.Blue();
+    palette[i][3] = 255;
+  }
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SHADER_PALETTE_SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, palette);
+}
+
+// Start timing this draw. The result of the query started two draws ago is
+// collected first, so that we never stall waiting for the GPU.
+void RadarDrawShader::BeginTiming() {
+  if (!m_query[0]) {
     return;
   }
+  GLuint query = m_query[m_query_frames % 2];
+  if (m_query_frames >= 2) {
+    GLint available = 0;
+    GLuint64 nanos = 0;
+
+    GetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GetQueryObjectui64v(query, GL_QUERY_RESULT, &nanos);
+      m_query_nanos += nanos;
+      m_query_measured++;
+    }
+    if (m_query_measured == SHADER_TIMING_FRAMES) {
+      wxArrayString methods;
+      RadarDraw::GetDrawingMethods(methods);
+      LOG_INFO(wxT("%s %s: GPU time %.3f ms per draw for %d x %d"), m_ri->m_name.c_str(),
+               methods[m_method].c_str(), m_query_nanos / 1.0e6 / SHADER_TIMING_FRAMES, (int)m_spokes,
+               (int)m_spoke_len_max);
+      m_query_nanos = 0;
+      m_query_measured = 0;
+    }
+  }
+  BeginQuery(GL_TIME_ELAPSED, query);
+}
 
+void RadarDrawShader::EndTiming() {
+  if (!m_query[0]) {
+    return;
+  }
+  EndQuery(GL_TIME_ELAPSED);
+  m_query_frames++;
+}
+
+void RadarDrawShader::Draw(int transparency) {
+  if (!m_program || !m_texture || !m_image) {
+    return;
+  }
+
+  BeginTiming();
   glPushAttrib(GL_TEXTURE_BIT);
 
   UseProgram(m_program);
 
+  if (m_lookup) {
+    ActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, m_lookup);
+  }
+  ActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, m_palette);
+  UploadPalette();
+  ActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, m_texture);
+  UploadChangedLines();
 
-  if (m_start_line > -1) {
-    // Since the last time we have received data from [m_start_line, m_end_line>
-    // so we only need to update the texture for those data lines.
-    if (m_start_line + m_lines > (int)m_spokes) {
-      int end_line = (m_start_line + m_lines) % m_spokes;
-      // if the new data partly wraps past the end of the texture
-      // tell it the two parts separately
-      // First remap [0, m_end_line>
-      glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
-                      /* level =    */ 0,
-                      /* x-offset = */ 0,
-                      /* y-offset = */ 0,
-                      /* width =    */ m_spoke_len_max,
-                      /* height =   */ end_line,
-                      /* format =   */ m_format,
-                      /* type =     */ GL_UNSIGNED_BYTE,
-                      /* pixels =   */ m_data);
-      // And then remap [m_start_line, m_spokes>
-      glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
-                      /* level =    */ 0,
-                      /* x-offset = */ 0,
-                      /* y-offset = */ m_start_line,
-                      /* width =    */ m_spoke_len_max,
-                      /* height =   */ m_spokes - m_start_line,
-                      /* format =   */ m_format,
-                      /* type =     */ GL_UNSIGNED_BYTE,
-                      /* pixels =   */ m_data + m_start_line * m_spoke_len_max * m_channels);
-    } else {
-      // Map [m_start_line, m_end_line>
-      glTexSubImage2D(/* target =   */ GL_TEXTURE_2D,
-                      /* level =    */ 0,
-                      /* x-offset = */ 0,
-                      /* y-offset = */ m_start_line,
-                      /* width =    */ m_spoke_len_max,
-                      /* height =   */ m_lines,
-                      /* format =   */ m_format,
-                      /* type =     */ GL_UNSIGNED_BYTE,
-                      /* pixels =   */ m_data + m_start_line * m_spoke_len_max * m_channels);
-    }
-    m_start_line = -1;
-    m_lines = 0;
+  GLfloat alpha = (GLfloat)(MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
+  Uniform1i(GetUniformLocation(m_program, "tex2d"), 0);
+  Uniform1i(GetUniformLocation(m_program, "palette"), 1);
+  if (m_lookup) {
+    Uniform1i(GetUniformLocation(m_program, "lookup"), 2);
   }
+  Uniform1fv(GetUniformLocation(m_program, "alpha"), 1, &alpha);
 
   // We tell the GPU to draw a square from (-512,-512) to (+512,+512).
   // The shader morphs this into a circle.
@@ -226,49 +401,16 @@ void RadarDrawShader::DrawRadarOverlayImage(double radar_scale, double panel_rot
 
   UseProgram(0);
   glPopAttrib();
+  EndTiming();
 }
 
-void RadarDrawShader::DrawRadarPanelImage(double panel_scale, double panel_rotate) { DrawRadarOverlayImage(1., 0.); }
+void RadarDrawShader::DrawRadarOverlayImage(double radar_scale, double panel_rotate) {
+  Draw(m_ri->m_pi->m_settings.overlay_transparency.GetValue());
+}
 
-void RadarDrawShader::ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t *data, size_t len, GeoPosition spoke_pos) {
-  GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
-  wxCriticalSectionLocker lock(m_exclusive);
+void RadarDrawShader::DrawRadarPanelImage(double panel_scale, double panel_rotate) { Draw(RADAR_PANEL_TRANSPARENCY); }
 
-  if (m_start_line == -1) {
-    m_start_line = angle;  // Note that this only runs once after each draw,
-  }
-  if (m_lines < (int)m_spokes) {
-    m_lines++;
-  }
-
-  if (m_channels == SHADER_COLOR_CHANNELS) {
-    unsigned char *d = m_data + (angle * m_spoke_len_max) * m_channels;
-    for (size_t r = 0; r < len; r++) {
-      GLubyte strength = data[r];
-      BlobColour colour = m_ri->m_colour_map[strength];
-      d[0] = m_ri->m_colour_map_rgb[colour].Red();
-      d[1] = m_ri->m_colour_map_rgb[colour].Green();
-      d[2] = m_ri->m_colour_map_rgb[colour].Blue();
-      d[3] = colour != BLOB_NONE ? alpha : 0;
-      d += m_channels;
-    }
-    for (size_t r = len; r < m_spoke_len_max; r++) {
-      *d++ = 0;
-      *d++ = 0;
-      *d++ = 0;
-      *d++ = 0;
-    }
-  } else {
-    unsigned char *d = m_data + (angle * m_spoke_len_max);
-    for (size_t r = 0; r < len; r++) {
-      GLubyte strength = data[r];
-      BlobColour colour = m_ri->m_colour_map[strength];
-      *d++ = (m_ri->m_colour_map_rgb[colour].Red() * alpha) >> 8;
-    }
-    for (size_t r = len; r < m_spoke_len_max; r++) {
-      *d++ = 0;
-    }
-  }
-}
+// The spokes are stored in the RadarPolarImage by RadarInfo
+void RadarDrawShader::ProcessRadarSpoke(int transparency, SpokeBearing angle, const SpokeRuns &runs, GeoPosition spoke_pos) {}
 
 PLUGIN_END_NAMESPACE
@@ -71,6 +71,13 @@ void RadarDrawVertex::Reset() {
   }
 }
 
+void RadarDrawVertex::ClearSpokes() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  // Keep the lines and their memory, they are rebuilt as the spokes come in
+  m_epoch++;
+}
+
 #define ADD_VERTEX_POINT(angle, radius, r, g, b, a)                         \
   {                                                                         \
     line->points[count].xy = m_ri->m_polar_lookup->GetPoint(angle, radius); \
@@ -118,12 +125,11 @@ void RadarDrawVertex::SetBlob(VertexLine* line, int angle_begin, int angle_end,
   line->count = count;
 }
 
-void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, uint8_t* data, size_t len, GeoPosition spoke_pos) {
+void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, const SpokeRuns& runs, GeoPosition spoke_pos) {
   GLubyte alpha = 255 * (MAX_OVERLAY_TRANSPARENCY - transparency) / MAX_OVERLAY_TRANSPARENCY;
   BlobColour previous_colour = BLOB_NONE;
-  GLubyte strength = 0;
+  size_t len = runs.GetLen();
   time_t now = time(0);
-  uint8_t red, green, blue;
   wxCriticalSectionLocker lock(m_exclusive);
   int r_begin = 0;
   int r_end = 0;
@@ -149,40 +155,77 @@ void RadarDrawVertex::ProcessRadarSpoke(int transparency, SpokeBearing angle, ui
     }
   }
   line->count = 0;
+  line->epoch = m_epoch;
   line->timeout = now + m_ri->m_pi->m_settings.max_age;
   line->spoke_pos = spoke_pos;
-  for (size_t radius = 0; radius < len; radius++) {
-    strength = data[radius];
-    BlobColour actual_colour = m_ri->m_colour_map[strength];
-
-    if (actual_colour == previous_colour) {
-      // continue with same color, just register it
-      r_end++;
-    } else if (previous_colour == BLOB_NONE && actual_colour != BLOB_NONE) {
-      // blob starts, no display, just register
-      r_begin = radius;
-      r_end = r_begin + 1;
-      previous_colour = actual_colour;  // new color
-    } else if (previous_colour != BLOB_NONE && (previous_colour != actual_colour)) {
-      red = m_ri->m_colour_map_rgb[previous_colour].Red();
-      green = m_ri->m_colour_map_rgb[previous_colour].Green();
-      blue = m_ri->m_colour_map_rgb[previous_colour].Blue();
-      SetBlob(line, angle, angle + 1, r_begin, r_end, red, green, blue, alpha);
-      previous_colour = actual_colour;
-      if (actual_colour != BLOB_NONE) {  // change of color, start new blob
-        r_begin = radius;
-        r_end = r_begin + 1;
+
+  // When zoomed out, blobs cover whole steps of 'step' samples. Where two runs
+  // share a step the most important colour gets it, as RadarPolarImage does
+  // for its lower levels. A finished blob is only drawn once the next one is
+  // known not to continue it.
+  int step = 1 << m_level;
+  BlobColour done_colour = BLOB_NONE;
+  int done_begin = 0;
+  int done_end = 0;
+
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    const SpokeRun& run = runs[i];
+    BlobColour actual_colour = m_ri->m_colour_map[run.value];
+    int begin = run.begin & ~(step - 1);
+    int end = (run.end + step - 1) & ~(step - 1);
+
+    if (actual_colour == BLOB_NONE) {
+      continue;
+    }
+    if (previous_colour != BLOB_NONE && begin <= r_end) {
+      if (actual_colour == previous_colour) {
+        // continue with same color, just register it
+        r_end = wxMax(r_end, end);
+        continue;
       }
+      if (begin < r_end) {
+        // Both want the last step of the previous blob
+        if (PolarImageRank(actual_colour) > PolarImageRank(previous_colour)) {
+          r_end = begin;
+        } else if (end <= r_end) {
+          continue;
+        } else {
+          begin = r_end;
+        }
+      }
+    }
+    if (previous_colour != BLOB_NONE && r_end > r_begin) {
+      if (done_colour != BLOB_NONE) {
+        SetBlob(line, angle, done_begin, done_end, done_colour, alpha);
+      }
+      done_colour = previous_colour;
+      done_begin = r_begin;
+      done_end = r_end;
+    }
+    if (actual_colour == done_colour && begin == done_end) {
+      // The previous blob lost its last step, continue the one before it
+      r_begin = done_begin;
+      done_colour = BLOB_NONE;
+    } else {
+      r_begin = begin;
     }
+    previous_colour = actual_colour;  // new color
+    r_end = end;
+  }
+  if (done_colour != BLOB_NONE) {
+    SetBlob(line, angle, done_begin, done_end, done_colour, alpha);
   }
   if (previous_colour != BLOB_NONE) {  // Draw final blob
-    red = m_ri->m_colour_map_rgb[previous_colour].Red();
-    green = m_ri->m_colour_map_rgb[previous_colour].Green();
-    blue = m_ri->m_colour_map_rgb[previous_colour].Blue();
-    SetBlob(line, angle, angle + 1, r_begin, r_end, red, green, blue, alpha);
+    SetBlob(line, angle, r_begin, wxMin(r_end, (int)len), previous_colour, alpha);
   }
 }
 
+void RadarDrawVertex::SetBlob(VertexLine* line, SpokeBearing angle, int r1, int r2, BlobColour colour, GLubyte alpha) {
+  const PixelColour& rgb = m_ri->m_colour_map_rgb[colour];
+
+  SetBlob(line, angle, angle + 1, r1, r2, rgb.Red(), rgb.Green(), rgb.Blue(), alpha);
+}
+
 void RadarDrawVertex::DrawRadarOverlayImage(double radar_scale, double panel_rotate) {
   wxPoint boat_center;
   GeoPosition posi;
@@ -205,7 +248,7 @@ void RadarDrawVertex::DrawRadarOverlayImage(double radar_scale, double panel_rot
     glScaled(radar_scale, radar_scale, 1.);
     for (size_t i = 0; i < m_spokes; i++) {
       VertexLine* line = &m_vertices[i];
-      if (!line->count || TIMED_OUT(now, line->timeout)) {
+      if (!line->count || line->epoch != m_epoch || TIMED_OUT(now, line->timeout)) {
         continue;
       }
       if ((line->spoke_pos.lat != prev_pos.lat || line->spoke_pos.lon != prev_pos.lon)) {
@@ -245,7 +288,7 @@ void RadarDrawVertex::DrawRadarPanelImage(double panel_scale, double panel_rotat
     glScaled(panel_scale, panel_scale, 1.);
     for (size_t i = 0; i < m_spokes; i++) {
       VertexLine* line = &m_vertices[i];
-      if (!line->count || TIMED_OUT(now, line->timeout)) {
+      if (!line->count || line->epoch != m_epoch || TIMED_OUT(now, line->timeout)) {
         continue;
       }
       line_pos = line->spoke_pos;
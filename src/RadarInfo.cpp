@@ -32,14 +32,20 @@
 #include "RadarInfo.h"
 
 #include "ControlsDialog.h"
+#include "FrameScheduler.h"
 #include "GuardZone.h"
+#include "GuardZoneMask.h"
 #include "MessageBox.h"
+#include "PolarHistory.h"
 #include "RadarCanvas.h"
 #include "RadarDraw.h"
 #include "RadarFactory.h"
 #include "RadarMarpa.h"
 #include "RadarPanel.h"
+#include "RadarPlayback.h"
 #include "RadarReceive.h"
+#include "RadarRecorder.h"
+#include "ScanCorrelator.h"
 #include "TrailBuffer.h"
 #include "drawutil.h"
 
@@ -53,7 +59,7 @@ bool g_first_render = true;
  * Called when the config is not yet known, so this should not start any
  * computations based on those yet.
  */
-RadarInfo::RadarInfo(radar_pi *pi, int radar) {
+RadarInfo::RadarInfo(radar_pi *pi, int radar) : m_lifecycle(this, &pi->m_deadlines, radar * LT_TIMERS) {
   m_pi = pi;
   m_radar = radar;
   m_arpa = 0;
@@ -67,16 +73,21 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   m_pixels_per_meter = 0.;
   m_previous_auto_range_meters = 0;
   m_previous_orientation = ORIENTATION_HEAD_UP;
-  m_stayalive_timeout = 0;
-  m_radar_timeout = 0;
-  m_data_timeout = 0;
+  m_playback_navigation = false;
+  m_playback_heading = 0.;
+  m_playback_clock_start = 0;
+  m_playback_clock_speed = 1.;
   m_history = 0;
+  m_correlator = 0;
+  m_correlating = false;
   m_polar_lookup = 0;
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    m_polar_image[i] = 0;
+  }
+  m_polar_image_shared = false;
   m_spokes = 0;
   m_spoke_len_max = 0;
   m_trails = 0;
-  m_idle_standby = 0;
-  m_idle_transmit = 0;
   m_doppler_count = 0;
   m_showManualValueInAuto = false;
   m_timed_idle_hardware = false;
@@ -87,6 +98,7 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   m_radar_location_info = RadarLocationInfo(empty_info);
   m_radar_interface_address = NetworkAddress();
   m_radar_address = NetworkAddress();
+  m_discovery_changed = false;
   m_last_rotation_time = 0;
   m_last_angle = 0;
   m_no_transmit_zones = 0;
@@ -103,6 +115,7 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   }
   m_control = 0;
   m_receive = 0;
+  m_recorder = 0;
   m_draw_panel.draw = 0;
   m_draw_overlay.draw = 0;
   m_draw_time_ms = 1000;  // Assume really bad draw time until we actually measure it to prevent fast redraw at start
@@ -130,6 +143,8 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   m_quantum2type = false;
   m_min_contour_length = 6;
   m_threshold.Update(0);
+  m_cfar.Update(0);
+  m_scan_correlation.Update(0);
   m_main_bang_size.Update(0);
   m_antenna_forward.Update(0);
   m_antenna_starboard.Update(0);
@@ -142,6 +157,7 @@ RadarInfo::RadarInfo(radar_pi *pi, int radar) {
   for (size_t z = 0; z < GUARD_ZONES; z++) {
     m_guard_zone[z] = new GuardZone(m_pi, this, z);
   }
+  m_guard_zone_mask = new GuardZoneMask(m_pi, this);
 }
 
 void RadarInfo::Shutdown() {
@@ -158,6 +174,10 @@ void RadarInfo::Shutdown() {
       m_receive = 0;
     }
   }
+  if (m_recorder) {
+    delete m_recorder;
+    m_recorder = 0;
+  }
   if (m_control_dialog) {
     delete m_control_dialog;
     m_control_dialog = 0;
@@ -204,19 +224,29 @@ RadarInfo::~RadarInfo() {
       m_guard_zone[z] = 0;
     }
   }
+  if (m_guard_zone_mask) {
+    delete m_guard_zone_mask;
+    m_guard_zone_mask = 0;
+  }
 
   if (m_history) {
-    for (size_t i = 0; i < m_spokes; i++) {
-      if (m_history[i].line) {
-        free(m_history[i].line);
-      }
-    }
-    free(m_history);
+    delete m_history;
+    m_history = 0;
+  }
+  if (m_correlator) {
+    delete m_correlator;
+    m_correlator = 0;
   }
   if (m_polar_lookup) {
     delete m_polar_lookup;
     m_polar_lookup = 0;
   }
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    if (m_polar_image[i]) {
+      delete m_polar_image[i];
+      m_polar_image[i] = 0;
+    }
+  }
 }
 
 /**
@@ -231,11 +261,18 @@ bool RadarInfo::Init() {
   m_name = RadarTypeName[m_radar_type];
   m_spokes = RadarSpokes[m_radar_type];
   m_spoke_len_max = RadarSpokeLenMax[m_radar_type];
-  m_history = (line_history *)calloc(sizeof(line_history), m_spokes);
-  for (size_t i = 0; i < m_spokes; i++) {
-    m_history[i].line = (uint8_t *)calloc(sizeof(uint8_t), m_spoke_len_max);
+  if (!m_history) {
+    m_history = new PolarHistory(m_spokes, m_spoke_len_max);
+  }
+  if (!m_correlator) {
+    m_correlator = new ScanCorrelator(m_spokes, m_spoke_len_max, SCAN_CORRELATION_REVOLUTIONS, SCAN_CORRELATION_HITS);
+  }
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    if (!m_polar_image[i]) {
+      m_polar_image[i] = new RadarPolarImage(this, m_spokes, m_spoke_len_max);
+    }
   }
-  m_polar_lookup = new PolarToCartesianLookup(m_spokes, m_spoke_len_max);
+  m_polar_lookup = new PolarToCartesianLookup(m_spokes);
   ComputeColourMap();
   if (!m_control) {
     m_control = RadarFactory::MakeRadarControl(m_radar_type, m_pi, this);
@@ -271,7 +308,21 @@ bool RadarInfo::Init() {
   UpdateControlState(true);
   if (!m_receive) {
     LOG_RECEIVE(wxT("%s starting receive thread"), m_name.c_str());
-    m_receive = RadarFactory::MakeRadarReceive(m_radar_type, m_pi, this);
+    if (!M_SETTINGS.playback_file[m_radar].IsEmpty()) {
+      m_receive = new RadarPlayback(m_pi, this, M_SETTINGS.playback_file[m_radar]);
+    } else {
+      m_receive = RadarFactory::MakeRadarReceive(m_radar_type, m_pi, this);
+      if (!m_recorder && !M_SETTINGS.record_directory.IsEmpty()) {
+        wxString name = m_name + wxDateTime::Now().Format(wxT("-%Y%m%d-%H%M%S"));
+        wxFileName file(M_SETTINGS.record_directory, name, RECORDING_EXTENSION);
+
+        m_recorder = new RadarRecorder(this);
+        if (!m_recorder->Open(file.GetFullPath(), m_spokes, m_spoke_len_max)) {
+          delete m_recorder;
+          m_recorder = 0;
+        }
+      }
+    }
     if (!m_receive) {
       LOG_INFO(wxT("%s unable to start receive thread."), m_name.c_str());
     } else {
@@ -332,7 +383,7 @@ void RadarInfo::DetectedRadar(NetworkAddress &interfaceAddress, NetworkAddress &
       LOG_TRANSMIT(wxT("radar_pi %s: Created transmit socket"), m_name.c_str());
     }
   }
-  m_stayalive_timeout = 0;  // Allow immediate restart of any TxOn or TxOff command
+  m_lifecycle.Detected();  // Allow immediate restart of any TxOn or TxOff command
   m_pi->NotifyControlDialog();
 }
 
@@ -399,27 +450,21 @@ void RadarInfo::ComputeColourMap() {
 }
 
 void RadarInfo::ResetSpokes() {
-  uint8_t zap[SPOKE_LEN_MAX];
-  GeoPosition pos;
-  GetRadarPosition(&pos);
   LOG_VERBOSE(wxT("reset spokes"));
 
-  CLEAR_STRUCT(zap);
-  for (size_t i = 0; i < m_spokes; i++) {
-    memset(m_history[i].line, 0, m_spoke_len_max);
-    m_history[i].time = 0;
-    m_history[i].pos.lat = 0.;
-    m_history[i].pos.lon = 0.;
-  }
-
+  // None of these touch the spokes themselves, they start a new epoch so
+  // that the old spokes are ignored until they are overwritten.
+  m_history->Clear();
+  m_correlator->Clear();
   if (m_draw_panel.draw) {
-    for (size_t r = 0; r < m_spokes; r++) {
-      m_draw_panel.draw->ProcessRadarSpoke(0, r, zap, m_spoke_len_max, pos);
-    }
+    m_draw_panel.draw->ClearSpokes();
   }
   if (m_draw_overlay.draw) {
-    for (size_t r = 0; r < m_spokes; r++) {
-      m_draw_overlay.draw->ProcessRadarSpoke(0, r, zap, m_spoke_len_max, pos);
+    m_draw_overlay.draw->ClearSpokes();
+  }
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    if (m_polar_image[i]) {
+      m_polar_image[i]->Clear();
     }
   }
 
@@ -427,6 +472,7 @@ void RadarInfo::ResetSpokes() {
     // Zap them anyway just to be sure
     m_guard_zone[z]->ResetBogeys();
   }
+  m_pi->m_frame_scheduler->MarkAll(m_radar);
 }
 
 void RadarInfo::CalculateRotationSpeed(SpokeBearing angle) {
@@ -459,29 +505,45 @@ void RadarInfo::CalculateRotationSpeed(SpokeBearing angle) {
  */
 void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint8_t *data, size_t len, int range_meters,
                                   wxLongLong time_rec) {
+  m_spoke_runs.SetSamples(data, wxMin(len, (size_t)SPOKE_LEN_MAX));
+  ProcessSpokeRuns(angle, bearing, range_meters, time_rec);
+}
+
+void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, const SpokeRuns &runs, int range_meters,
+                                  wxLongLong time_rec) {
+  if (runs.GetLen() > SPOKE_LEN_MAX) {
+    return;
+  }
+  m_spoke_runs = runs;
+  ProcessSpokeRuns(angle, bearing, range_meters, time_rec);
+}
+
+// Process the spoke in m_spoke_runs
+void RadarInfo::ProcessSpokeRuns(SpokeBearing angle, SpokeBearing bearing, int range_meters, wxLongLong time_rec) {
   int orientation;
-  int i;
+  size_t len = m_spoke_runs.GetLen();
+  uint8_t *data = m_spoke_samples;
 
   SampleCourse(angle);            // Calculate course as the moving average of m_hdt over one revolution
   CalculateRotationSpeed(angle);  // Find out how fast the radar is rotating
 
+  if (m_recorder) {  // As decoded, before anything below changes it
+    GeoPosition pos;
+    GetRadarPosition(&pos);
+    m_recorder->AddSpoke(angle, bearing, m_spoke_runs, range_meters, time_rec, pos, GetHeadingTrue());
+  }
+
   // Recompute 'pixels_per_meter' based on the actual spoke length and range in meters.
   if (range_meters == 0) {
     LOG_INFO(wxT("Error ProcessRadarSpoke range is zero"));
     return;
   }
 
-  for (i = 0; i < m_main_bang_size.GetValue(); i++) {
-    data[i] = 0;
-  }
+  m_spoke_runs.ClearBelow(wxMax(m_main_bang_size.GetValue(), 0));
   int threshold = m_threshold.GetValue();
   if (threshold > 0) {
     threshold = threshold * (255 - BLOB_HISTORY_MAX) / 100 + BLOB_HISTORY_MAX;
-    for (; i < (int)len; i++) {
-      if (data[i] < threshold) {
-        data[i] = 0;
-      }
-    }
+    m_spoke_runs.RemoveBelow((uint8_t)threshold);
   }
 
   double pixels_per_meter = (len / (double)range_meters) * (1. - (double)m_range_adjustment.GetValue() * 0.001);
@@ -496,6 +558,20 @@ void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint
     }
   }
 
+  // The software clutter filter works on the samples, so everything after it
+  // (history, guard zones, trails and display) only sees what it keeps.
+  int cfar = m_cfar.GetValue();
+  if (cfar > 0 && len > 0) {
+    static const unsigned cfar_scale[] = {0, 20, 28, 40};  // 1.25, 1.75 and 2.5 times the mean, in 1/16ths
+    size_t window = (size_t)wxMax(wxMin(CFAR_WINDOW_METERS * pixels_per_meter, (double)CFAR_WINDOW_MAX), (double)CFAR_WINDOW_MIN);
+    size_t guard = (size_t)wxMax(wxMin(CFAR_GUARD_METERS * pixels_per_meter, (double)CFAR_GUARD_MAX), 1.);
+
+    m_cfar_detector.Configure(window, guard, cfar_scale[wxMin(cfar, (int)ARRAY_SIZE(cfar_scale) - 1)]);
+    m_spoke_runs.GetSamples(data);
+    m_cfar_detector.Apply(data, len);
+    m_spoke_runs.SetSamples(data, len);
+  }
+
   orientation = GetOrientation();
   if ((orientation == ORIENTATION_HEAD_UP || m_previous_orientation == ORIENTATION_HEAD_UP) &&
       (orientation != m_previous_orientation)) {
@@ -514,37 +590,69 @@ void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint
   int stabilized_mode = orientation != ORIENTATION_HEAD_UP;
   uint8_t weakest_normal_blob = m_pi->m_settings.threshold_red;
 
-  uint8_t *hist_data = m_history[bearing].line;
-  m_history[bearing].time = time_rec;
-  memset(hist_data, 0, m_spoke_len_max);
-  GetRadarPosition(&m_history[bearing].pos);
-  for (size_t radius = 0; radius < len; radius++) {
-    if (data[radius] >= weakest_normal_blob) {
-      // and add 1 if above threshold and set the left 2 bits, used for ARPA
-      hist_data[radius] = 192;  // this is C0, 1100 0000
+  // Scan-to-scan correlation drops the returns that do not persist over
+  // revolutions, for each of the consumers that it is selected for.
+  int correlation = m_scan_correlation.GetValue();
+  const SpokeRuns *arpa_runs = &m_spoke_runs;
+  const SpokeRuns *guard_runs = &m_spoke_runs;
+  if (correlation > 0) {
+    if (!m_correlating) {
+      m_correlator->Clear();  // What it has is from before it was switched off
+      m_correlating = true;
     }
-    if (data[radius] == 255) {  // approaching doppler target
-      // and add 1 if above threshold and set the left 2 bits, used for ARPA
-      hist_data[radius] = 0xE0;  // this is  1110 0000, bit 3 indicates this is an approaching target
-      m_doppler_count++;
+    m_correlator->Correlate(angle, bearing, m_spoke_runs, &m_persistent_runs);
+    if (correlation & SCAN_CORRELATION_ARPA) {
+      arpa_runs = &m_persistent_runs;
     }
+    if (correlation & SCAN_CORRELATION_GUARD) {
+      guard_runs = &m_persistent_runs;
+    }
+  } else {
+    m_correlating = false;
   }
 
-  for (size_t z = 0; z < GUARD_ZONES; z++) {
-    if (m_guard_zone[z]->m_alarm_on) {
-      m_guard_zone[z]->ProcessSpoke(angle, data, m_history[bearing].line, len);
-    }
+  GeoPosition hist_pos;
+  GetRadarPosition(&hist_pos);
+  // Set the ARPA bits for returns above threshold and for approaching doppler targets
+  m_doppler_count += m_history->SetLine(bearing, *arpa_runs, weakest_normal_blob, time_rec, hist_pos);
+
+  // Count the returns in all alarmed guard zones in one pass over the spoke
+  m_guard_zone_mask->ProcessSpoke(angle, *guard_runs);
+
+  if (correlation & SCAN_CORRELATION_DISPLAY) {
+    m_spoke_runs = m_persistent_runs;
   }
 
   size_t trail_len = len;
-  if (m_pi->m_settings.show_extreme_range) {
-    data[len - 1] = 255;
+  if (m_pi->m_settings.show_extreme_range && len > 0) {
+    m_spoke_runs.SetLast(255);
     trail_len--;
   }
 
+  // The trails look at every sample, and write the trail colours into the
+  // empty ones. Only then do the runs have to be rebuilt from the samples.
+  bool trails = m_target_trails.GetState() != RCS_OFF;
+  if (trails) {
+    m_spoke_runs.GetSamples(data);
+  }
+
   bool draw_trails_on_overlay = M_SETTINGS.trails_on_overlay;
+  bool panel_image = m_draw_panel.draw && m_draw_panel.draw->UsesPolarImage();
+  bool overlay_image = m_draw_overlay.draw && m_draw_overlay.draw->UsesPolarImage();
+  bool shared = stabilized_mode && draw_trails_on_overlay;
+
+  if (shared != m_polar_image_shared) {
+    // The overlay image was not kept up to date while it was shared
+    m_polar_image[POLAR_IMAGE_OVERLAY]->Clear();
+    m_polar_image_shared = shared;
+  }
+
   if (m_draw_overlay.draw && !draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, data, len, m_history[bearing].pos);
+    if (overlay_image) {
+      m_polar_image[POLAR_IMAGE_OVERLAY]->ProcessRadarSpoke(bearing, m_spoke_runs);
+    } else {
+      m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, m_spoke_runs, hist_pos);
+    }
   }
   m_trails->UpdateTrailPosition();
 
@@ -553,20 +661,32 @@ void RadarInfo::ProcessRadarSpoke(SpokeBearing angle, SpokeBearing bearing, uint
 
   // Relative trails
   m_trails->UpdateRelativeTrails(angle, data, trail_len);
+  if (trails) {
+    m_spoke_runs.SetSamples(data, len);
+  }
 
   if (m_draw_overlay.draw && draw_trails_on_overlay) {
-    m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, data, len, m_history[bearing].pos);
+    if (!overlay_image) {
+      m_draw_overlay.draw->ProcessRadarSpoke(M_SETTINGS.overlay_transparency.GetValue(), bearing, m_spoke_runs, hist_pos);
+    } else if (!shared) {
+      m_polar_image[POLAR_IMAGE_OVERLAY]->ProcessRadarSpoke(bearing, m_spoke_runs);
+    }
   }
 
-  if (m_draw_panel.draw) {
-    m_draw_panel.draw->ProcessRadarSpoke(4, stabilized_mode ? bearing : angle, data, len, m_history[bearing].pos);
+  // When shared the panel image is written once here for both readers
+  if (panel_image || (shared && overlay_image)) {
+    m_polar_image[POLAR_IMAGE_PANEL]->ProcessRadarSpoke(stabilized_mode ? bearing : angle, m_spoke_runs);
+  }
+  if (m_draw_panel.draw && !panel_image) {
+    m_draw_panel.draw->ProcessRadarSpoke(RADAR_PANEL_TRANSPARENCY, stabilized_mode ? bearing : angle, m_spoke_runs, hist_pos);
   }
+  m_pi->m_frame_scheduler->MarkSpoke(m_radar, angle, bearing, m_spokes);
 }
 
 void RadarInfo::SampleCourse(int angle) {
   //  Calculates the moving average of m_hdt and returns this in m_course
   //  This is a bit more complicated then expected, average of 359 and 1 is 180 and that is not what we want
-  if (m_pi->GetHeadingSource() != HEADING_NONE && ((angle & 127) == 0)) {  // sample m_hdt every 128 spokes
+  if (GetHeadingSource() != HEADING_NONE && ((angle & 127) == 0)) {  // sample m_hdt every 128 spokes
     if (m_course_log[m_course_index] > 720.) {                             // keep values within limits
       for (int i = 0; i < COURSE_SAMPLES; i++) {
         m_course_log[i] -= 720;
@@ -577,7 +697,7 @@ void RadarInfo::SampleCourse(int angle) {
         m_course_log[i] += 720;
       }
     }
-    double hdt = m_pi->GetHeadingTrue();
+    double hdt = GetHeadingTrue();
     while (m_course_log[m_course_index] - hdt > 180.) {  // compare with previous value
       hdt += 360.;
     }
@@ -595,43 +715,10 @@ void RadarInfo::SampleCourse(int angle) {
   }
 }
 
-void RadarInfo::UpdateTransmitState() {
-  wxCriticalSectionLocker lock(m_exclusive);
-  time_t now = time(0);
-
-  int state = m_state.GetValue();
-
-  if (state == RADAR_TRANSMIT && TIMED_OUT(now, m_data_timeout)) {
-    m_state.Update(RADAR_STANDBY);
-    LOG_VERBOSE(wxT("%s data lost"), m_name.c_str());
-  }
-  if (state == RADAR_STANDBY && TIMED_OUT(now, m_radar_timeout)) {
-    static wxString empty;
-
-    m_state.Update(RADAR_OFF);
-    LOG_VERBOSE(wxT("%s lost presence"), m_name.c_str());
-    return;
-  }
-
-  if (state != RADAR_OFF && TIMED_OUT(now, m_stayalive_timeout && m_control)) {
-    m_control->RadarStayAlive();
-    m_stayalive_timeout = now + STAYALIVE_TIMEOUT;
-  }
-
-  // If we find we have a radar and the boot flag is still set, turn radar on
-  // Think about interaction with timed_transmit
-  if (m_boot_state.GetValue() == RADAR_TRANSMIT && state == RADAR_STANDBY) {
-    m_boot_state.Update(RADAR_OFF);
-    RequestRadarState(RADAR_TRANSMIT);
-  }
-}
-
 void RadarInfo::RequestRadarState(RadarState state) {
   int oldState = m_state.GetValue();
   if (/*m_pi->IsRadarOnScreen(m_radar) &&*/ oldState != RADAR_OFF && m_control) {        // if radar is visible and detected
     if (oldState != state && !(oldState != RADAR_STANDBY && state == RADAR_TRANSMIT)) {  // and change is wanted
-      time_t now = time(0);
-
       if (state == RADAR_TRANSMIT) {
         m_control->RadarTxOn();
         // Refresh radar immediately so that we generate draw mechanisms
@@ -648,36 +735,92 @@ void RadarInfo::RequestRadarState(RadarState state) {
       } else {
         LOG_INFO(wxT("%s unexpected status request %d"), m_name.c_str(), state);
       }
-      m_stayalive_timeout = now + STAYALIVE_TIMEOUT;
+      m_lifecycle.CommandSent(GetMonotonicMillis());
+      m_pi->ScheduleDeadlines();
     }
   }
 }
 
-void RadarInfo::RenderGuardZone() {
-  int start_bearing = 0, end_bearing = 0;
+/*
+ * Build the fill and outline of a guard zone. Polygon guard zones are filled one
+ * degree at a time with the parts of each ray that fall inside the polygon, and
+ * outlined with the polygon itself.
+ */
+void RadarInfo::BuildGuardZoneGeometry(GuardZone *zone, GLGeometry *geometry) {
+  int start_bearing, end_bearing;
+
+  switch (zone->m_type) {
+    case GZ_POLYGON: {
+      double begin[GUARD_ZONE_MAX_INTERVALS];
+      double end[GUARD_ZONE_MAX_INTERVALS];
+      size_t n = zone->m_polygon.size();
+
+      if (n < 3) {
+        return;
+      }
+      for (int angle = 0; angle < DEGREES_PER_ROTATION; angle++) {
+        size_t intervals = zone->GetPolygonIntervals(angle, begin, end, GUARD_ZONE_MAX_INTERVALS);
+        for (size_t i = 0; i < intervals; i++) {
+          geometry->AddFilledArc(end[i], begin[i], angle, angle);
+        }
+      }
+      for (size_t i = 0; i < n; i++) {
+        const Point &p = zone->m_polygon[i];
+        const Point &q = zone->m_polygon[(i + 1) % n];
+        geometry->AddLine(p.x, p.y, q.x, q.y);
+      }
+      return;
+    }
+
+    case GZ_CIRCLE:
+      start_bearing = 0;
+      end_bearing = 359;
+      break;
+
+    default:
+      start_bearing = zone->m_start_bearing;
+      end_bearing = zone->m_end_bearing;
+      break;
+  }
+  geometry->AddFilledArc(zone->m_outer_range, zone->m_inner_range, start_bearing, end_bearing);
+  geometry->AddOutlineArc(zone->m_outer_range, zone->m_inner_range, start_bearing, end_bearing);
+}
+
+/*
+ * The geometry of the guard zones and no transmit zones only changes when their
+ * settings (or the range) change, so it is cached per GL context in 'di'.
+ */
+void RadarInfo::RenderGuardZone(DrawInfo *di) {
   GLubyte red = 0, green = 200, blue = 0, alpha = 50;
 
+  glLineWidth(1.0);
   for (size_t z = 0; z < GUARD_ZONES; z++) {
-    if (m_guard_zone[z]->m_alarm_on || m_guard_zone[z]->m_arpa_on || m_guard_zone[z]->m_show_time + 5 > time(0)) {
-      if (m_guard_zone[z]->m_type == GZ_CIRCLE) {
-        start_bearing = 0;
-        end_bearing = 359;
-      } else {
-        start_bearing = m_guard_zone[z]->m_start_bearing;
-        end_bearing = m_guard_zone[z]->m_end_bearing;
+    GuardZone *zone = m_guard_zone[z];
+
+    if (zone->m_alarm_on || zone->m_arpa_on || zone->m_show_time + 5 > time(0)) {
+      GLGeometry *geometry = &di->guard_zone[z];
+      const double key[] = {(double)zone->m_version,     (double)zone->m_type,        (double)zone->m_start_bearing,
+                            (double)zone->m_end_bearing, (double)zone->m_inner_range, (double)zone->m_outer_range};
+
+      if (!geometry->IsCurrent(key, ARRAY_SIZE(key))) {
+        BuildGuardZoneGeometry(zone, geometry);
       }
+
       switch (m_pi->m_settings.guard_zone_render_style) {
         case 1:
           glColor4ub((GLubyte)255, (GLubyte)0, (GLubyte)0, (GLubyte)255);
-          DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, true);
+          glEnable(GL_LINE_STIPPLE);
+          glLineStipple(1, 0x000F);
+          geometry->DrawOutline();
+          glDisable(GL_LINE_STIPPLE);
           break;
         case 2:
           glColor4ub(red, green, blue, alpha);
-          DrawOutlineArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing, false);
+          geometry->DrawOutline();
         // fall thru
         default:
           glColor4ub(red, green, blue, alpha);
-          DrawFilledArc(m_guard_zone[z]->m_outer_range, m_guard_zone[z]->m_inner_range, start_bearing, end_bearing);
+          geometry->DrawFilled();
       }
     }
 
@@ -691,19 +834,50 @@ void RadarInfo::RenderGuardZone() {
     range = 4000;
   }
 
+  vector<double> key;
+  key.push_back(range);
   for (size_t z = 0; z < m_no_transmit_zones; z++) {
     if (m_no_transmit_start[z].GetState() != RCS_OFF) {
-      start_bearing = m_no_transmit_start[z].GetValue();
-      end_bearing = m_no_transmit_end[z].GetValue();
-
-      if (start_bearing != end_bearing && start_bearing >= -180 && end_bearing >= -180) {
-        start_bearing = MOD_DEGREES(start_bearing);
-        end_bearing = MOD_DEGREES(end_bearing);
-        glColor4ub(250, 255, 255, alpha);
-        DrawFilledArc(range, 0, start_bearing, end_bearing);
+      key.push_back(m_no_transmit_start[z].GetValue());
+      key.push_back(m_no_transmit_end[z].GetValue());
+    }
+  }
+  if (!di->no_transmit.IsCurrent(&key[0], key.size())) {
+    for (size_t z = 0; z < m_no_transmit_zones; z++) {
+      if (m_no_transmit_start[z].GetState() != RCS_OFF) {
+        int start_bearing = m_no_transmit_start[z].GetValue();
+        int end_bearing = m_no_transmit_end[z].GetValue();
+
+        if (start_bearing != end_bearing && start_bearing >= -180 && end_bearing >= -180) {
+          start_bearing = MOD_DEGREES(start_bearing);
+          end_bearing = MOD_DEGREES(end_bearing);
+          di->no_transmit.AddFilledArc(range, 0, start_bearing, end_bearing);
+        }
       }
     }
   }
+  glColor4ub(250, 255, 255, alpha);
+  di->no_transmit.DrawFilled();
+}
+
+/*
+ * The panel's GL context is about to be destroyed, a new RadarCanvas gets a new one.
+ */
+void RadarInfo::ReleasePanelGeometry(bool context_current) {
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    m_draw_panel.guard_zone[z].Release(context_current);
+  }
+  m_draw_panel.no_transmit.Release(context_current);
+}
+
+/*
+ * The plugin stops drawing in OpenCPN's GL context, called when it is unloaded.
+ */
+void RadarInfo::ReleaseOverlayGeometry(bool context_current) {
+  for (size_t z = 0; z < GUARD_ZONES; z++) {
+    m_draw_overlay.guard_zone[z].Release(context_current);
+  }
+  m_draw_overlay.no_transmit.Release(context_current);
 }
 
 void RadarInfo::SetAutoRangeMeters(int autorange_to_set) {
@@ -733,6 +907,81 @@ void RadarInfo::SetAutoRangeMeters(int autorange_to_set) {
   }
 }
 
+RadarControlItem *RadarInfo::GetControlItem(ControlType controlType) {
+  switch (controlType) {
+    case CT_ACCENT_LIGHT:
+      return &m_accent_light;
+    case CT_ANTENNA_HEIGHT:
+      return &m_antenna_height;
+    case CT_AUTOTTRACKDOPPLER:
+      return &m_autotrack_doppler;
+    case CT_BEARING_ALIGNMENT:
+      return &m_bearing_alignment;
+    case CT_COLOR_GAIN:
+      return &m_color_gain;
+    case CT_DISPLAY_TIMING:
+      return &m_display_timing;
+    case CT_DOPPLER:
+      return &m_doppler;
+    case CT_FTC:
+      return &m_ftc;
+    case CT_GAIN:
+      return &m_gain;
+    case CT_INTERFERENCE_REJECTION:
+      return &m_interference_rejection;
+    case CT_LOCAL_INTERFERENCE_REJECTION:
+      return &m_local_interference_rejection;
+    case CT_MAIN_BANG_SUPPRESSION:
+      return &m_main_bang_suppression;
+    case CT_MODE:
+      return &m_mode;
+    case CT_NOISE_REJECTION:
+      return &m_noise_rejection;
+    case CT_NO_TRANSMIT_START_1:
+    case CT_NO_TRANSMIT_START_2:
+    case CT_NO_TRANSMIT_START_3:
+    case CT_NO_TRANSMIT_START_4:
+      return &m_no_transmit_start[controlType - CT_NO_TRANSMIT_START_1];
+    case CT_NO_TRANSMIT_END_1:
+    case CT_NO_TRANSMIT_END_2:
+    case CT_NO_TRANSMIT_END_3:
+    case CT_NO_TRANSMIT_END_4:
+      return &m_no_transmit_end[controlType - CT_NO_TRANSMIT_END_1];
+    case CT_RAIN:
+      return &m_rain;
+    case CT_RANGE:
+      return &m_range;
+    case CT_SCAN_SPEED:
+      return &m_scan_speed;
+    case CT_SEA:
+      return &m_sea;
+    case CT_SEA_STATE:
+      return &m_sea_state;
+    case CT_SIDE_LOBE_SUPPRESSION:
+      return &m_side_lobe_suppression;
+    case CT_STC:
+      return &m_stc;
+    case CT_STC_CURVE:
+      return &m_stc_curve;
+    case CT_TARGET_BOOST:
+      return &m_target_boost;
+    case CT_TARGET_EXPANSION:
+      return &m_target_expansion;
+    case CT_TARGET_SEPARATION:
+      return &m_target_separation;
+    case CT_TIMED_IDLE:
+      return &m_timed_idle;
+    case CT_TIMED_RUN:
+      return &m_timed_run;
+    case CT_TUNE_COARSE:
+      return &m_tune_coarse;
+    case CT_TUNE_FINE:
+      return &m_tune_fine;
+    default:
+      return 0;
+  }
+}
+
 bool RadarInfo::SetControlValue(ControlType controlType, RadarControlItem &item, RadarControlButton *button) {
   LOG_DIALOG(wxT("%s SetControlValue %s button=%s value=%d state=%d"), m_name.c_str(), ControlTypeNames[controlType].c_str(),
              button->GetLabel().c_str(), item.GetValue(), item.GetState());
@@ -765,6 +1014,16 @@ bool RadarInfo::SetControlValue(ControlType controlType, RadarControlItem &item,
       return true;
     }
 
+    case CT_CFAR: {
+      m_cfar = item;
+      return true;
+    }
+
+    case CT_SCAN_CORRELATION: {
+      m_scan_correlation = item;
+      return true;
+    }
+
     case CT_ANTENNA_FORWARD: {
       m_antenna_forward = item;
       return true;
@@ -815,13 +1074,8 @@ bool RadarInfo::SetControlValue(ControlType controlType, RadarControlItem &item,
     case CT_TIMED_IDLE: {
       if (!m_timed_idle_hardware) {
         m_timed_idle = item;
-        m_idle_standby = 0;
-        m_idle_transmit = 0;
-        if (m_state.GetValue() == RADAR_TRANSMIT) {
-          m_idle_standby = time(0) + 10;
-        } else {
-          m_idle_transmit = time(0) + 10;
-        }
+        m_lifecycle.TimedTransmitChanged(GetMonotonicMillis());
+        m_pi->ScheduleDeadlines();
         m_pi->UpdateAllControlStates(true);
         return true;
       }
@@ -901,7 +1155,12 @@ void RadarInfo::RefreshDisplay() {
   }
 }
 
-void RadarInfo::RenderRadarImage2(DrawInfo *di, double radar_scale, double panel_rotate) {
+/*
+ * Draw the radar image around `center`. Draw methods that use the fixed function matrices get them pushed here,
+ * the others get the same transform computed on the CPU. `clip` holds the x and y scale and offset that the
+ * projection and the panel translation apply to the pixel coordinates.
+ */
+void RadarInfo::RenderRadarImage2(DrawInfo *di, wxPoint center, double radar_scale, double panel_rotate, const double *clip) {
   wxCriticalSectionLocker lock(m_exclusive);
   int drawing_method = m_pi->m_settings.drawing_method;
   int state = m_state.GetValue();
@@ -938,12 +1197,49 @@ void RadarInfo::RenderRadarImage2(DrawInfo *di, double radar_scale, double panel
     }
   }
 
+  bool fixed_function = drawing_method && !di->draw->UsesOwnTransform();
+  if (fixed_function) {
+    glPushMatrix();
+    glTranslated(center.x, center.y, 0);
+    glRotated(panel_rotate, 0.0, 0.0, 1.0);
+    glScaled(radar_scale, radar_scale, 1.);
+  } else if (di->draw->UsesOwnTransform()) {
+    // clip * translate(center) * rotate(panel_rotate) * scale(radar_scale), column-major
+    double c = cos(deg2rad(panel_rotate)) * radar_scale;
+    double s = sin(deg2rad(panel_rotate)) * radar_scale;
+    GLfloat transform[16] = {(GLfloat)(clip[0] * c),
+                             (GLfloat)(clip[1] * s),
+                             0,
+                             0,
+                             (GLfloat)(-clip[0] * s),
+                             (GLfloat)(clip[1] * c),
+                             0,
+                             0,
+                             0,
+                             0,
+                             1,
+                             0,
+                             (GLfloat)(clip[0] * center.x + clip[2]),
+                             (GLfloat)(clip[1] * center.y + clip[3]),
+                             0,
+                             1};
+    di->draw->SetTransform(transform);
+  }
+
   if (di == &m_draw_overlay) {
+    di->draw->SetPolarImage(m_polar_image[m_polar_image_shared ? POLAR_IMAGE_PANEL : POLAR_IMAGE_OVERLAY], POLAR_IMAGE_OVERLAY);
+    di->draw->SetLevel(RadarPolarImage::GetLevelForScale(radar_scale));  // radar_scale is in pixels per sample
     di->draw->DrawRadarOverlayImage(radar_scale, panel_rotate);
   } else {
     double panel_scale = (m_panel_zoom / m_range.GetValue()) / m_pixels_per_meter;  // typical value 0.001
+    di->draw->SetPolarImage(m_polar_image[POLAR_IMAGE_PANEL], POLAR_IMAGE_PANEL);
+    // The panel is drawn in units where 1.0 is half the largest side of the window
+    di->draw->SetLevel(RadarPolarImage::GetLevelForScale(panel_scale * m_radar_radius / m_panel_zoom));
     di->draw->DrawRadarPanelImage(panel_scale, panel_rotate);
   }
+  if (fixed_function) {
+    glPopMatrix();
+  }
 
   if (g_first_render) {
     g_first_render = false;
@@ -956,7 +1252,7 @@ int RadarInfo::GetOrientation() {
   int orientation;
 
   // check for no longer allowed value
-  if (m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (GetHeadingSource() == HEADING_NONE) {
     orientation = ORIENTATION_HEAD_UP;
   } else {
     orientation = m_orientation.GetValue();
@@ -965,7 +1261,7 @@ int RadarInfo::GetOrientation() {
   return orientation;
 }
 
-void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_rotate, bool overlay) {
+void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_rotate, bool overlay, wxSize viewport) {
   bool arpa_on = false;
   if (m_arpa) {
     for (int i = 0; i < GUARD_ZONES; i++) {
@@ -986,6 +1282,7 @@ void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_r
   double panel_rotate = overlay_rotate;
   double guard_rotate = overlay_rotate;
   double arpa_rotate;
+  double clip[4];  // x and y scale, x and y offset from pixels to clip space
 
   // So many combinations here
 
@@ -997,19 +1294,19 @@ void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_r
       case ORIENTATION_STABILIZED_UP:
         panel_rotate -= m_course;  // Panel only needs stabilized heading applied
         arpa_rotate -= m_course;
-        guard_rotate += m_pi->GetHeadingTrue() - m_course;
+        guard_rotate += GetHeadingTrue() - m_course;
         break;
       case ORIENTATION_COG_UP: {
         double cog = m_pi->GetCOG();
         panel_rotate -= cog;  // Panel only needs stabilized heading applied
         arpa_rotate -= cog;
-        guard_rotate += m_pi->GetHeadingTrue() - cog;
+        guard_rotate += GetHeadingTrue() - cog;
       } break;
       case ORIENTATION_NORTH_UP:
-        guard_rotate += m_pi->GetHeadingTrue();
+        guard_rotate += GetHeadingTrue();
         break;
       case ORIENTATION_HEAD_UP:
-        arpa_rotate += -m_pi->GetHeadingTrue();  // Undo the actual heading calculation always done for ARPA
+        arpa_rotate += -GetHeadingTrue();  // Undo the actual heading calculation always done for ARPA
         break;
     }
 
@@ -1018,9 +1315,26 @@ void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_r
     x = (double)(m_off_center.x + m_drag.x) * m_panel_zoom / m_radar_radius;
     y = (double)(m_off_center.y + m_drag.y) * m_panel_zoom / m_radar_radius;
     glTranslated(x, y, 0.);
+
+    // Same as the projection set up by RadarCanvas::Render
+    if (viewport.GetWidth() >= viewport.GetHeight()) {
+      clip[0] = 1.0;
+      clip[1] = -(double)viewport.GetWidth() / viewport.GetHeight();
+    } else {
+      clip[0] = (double)viewport.GetHeight() / viewport.GetWidth();
+      clip[1] = -1.0;
+    }
+    clip[2] = clip[0] * x;
+    clip[3] = clip[1] * y;
   } else {
-    guard_rotate += m_pi->GetHeadingTrue();
+    guard_rotate += GetHeadingTrue();
     arpa_rotate = overlay_rotate - OPENGL_ROTATION;
+
+    // OpenCPN draws the chart in pixels with y pointing down
+    clip[0] = 2.0 / viewport.GetWidth();
+    clip[1] = -2.0 / viewport.GetHeight();
+    clip[2] = -1.0;
+    clip[3] = 1.0;
   }
 
   wxLongLong now = wxGetUTCTimeMillis();
@@ -1030,22 +1344,13 @@ void RadarInfo::RenderRadarImage1(wxPoint center, double scale, double overlay_r
     glTranslated(center.x, center.y, 0);
     glRotated(guard_rotate, 0.0, 0.0, 1.0);
     glScaled(scale, scale, 1.);
-    RenderGuardZone();
+    RenderGuardZone(overlay ? &m_draw_overlay : &m_draw_panel);
     glPopMatrix();
   }
 
   if (m_pixels_per_meter != 0.) {
     double radar_scale = scale / m_pixels_per_meter;
-    if (m_pi->m_settings.drawing_method) {  // for shader
-      glPushMatrix();
-      glTranslated(center.x, center.y, 0);
-      glRotated(panel_rotate, 0.0, 0.0, 1.0);
-      glScaled(radar_scale, radar_scale, 1.);
-    }
-    RenderRadarImage2(overlay ? &m_draw_overlay : &m_draw_panel, radar_scale, panel_rotate);
-    if (m_pi->m_settings.drawing_method) {
-      glPopMatrix();
-    }
+    RenderRadarImage2(overlay ? &m_draw_overlay : &m_draw_panel, center, radar_scale, panel_rotate, clip);
   }
 
   if (arpa_on) {
@@ -1209,7 +1514,7 @@ wxString RadarInfo::GetCanvasTextBottomLeft() {
       distance = local_distance(radar_pos, m_mouse_pos);
       bearing = local_bearing(radar_pos, m_mouse_pos);
       if (GetOrientation() != ORIENTATION_NORTH_UP) {
-        bearing -= m_pi->GetHeadingTrue();
+        bearing -= GetHeadingTrue();
       }
     }
 
@@ -1372,13 +1677,13 @@ void RadarInfo::SetMouseVrmEbl(double vrm, double ebl) {
       m_mouse_ebl[ORIENTATION_NORTH_UP] = ebl + m_course;
       m_mouse_ebl[ORIENTATION_COG_UP] = ebl + m_course - cog;
       m_mouse_ebl[ORIENTATION_STABILIZED_UP] = ebl;
-      bearing = ebl + m_pi->GetHeadingTrue();
+      bearing = ebl + GetHeadingTrue();
       break;
     case ORIENTATION_COG_UP:
       m_mouse_ebl[ORIENTATION_NORTH_UP] = ebl + cog;
       m_mouse_ebl[ORIENTATION_STABILIZED_UP] = ebl + cog - m_course;
       m_mouse_ebl[ORIENTATION_COG_UP] = ebl;
-      bearing = ebl + m_pi->GetHeadingTrue();
+      bearing = ebl + GetHeadingTrue();
       break;
   }
   static double R = 6378.1e3 / 1852.;  // Radius of the Earth in nm
@@ -1586,78 +1891,85 @@ wxString RadarInfo::GetRadarStateText() {
   return o;
 }
 
-/**
- * See how TimedTransmit is doing.
- *
- * If the ON timer is running and has run out, start the radar and start an OFF timer.
- * If the OFF timer is running and has run out, stop the radar and start an ON timer.
+/*
+ * RadarLifecycleHost: m_lifecycle decides when, these do it.
  */
-void RadarInfo::CheckTimedTransmit() {
-  if (m_timed_idle.GetState() == RCS_OFF) {
-    if (!m_timed_idle_hardware) {
-      m_idle_transmit = 0;
-      m_idle_standby = 0;
-      m_next_state_change.Update(0);
-    }
-    return;  // User does not want timed idle
+LifecycleState RadarInfo::GetLifecycleState() {
+  switch (m_state.GetValue()) {
+    case RADAR_OFF:
+      return LS_OFF;
+    case RADAR_STANDBY:
+      return LS_STANDBY;
+    case RADAR_TRANSMIT:
+      return LS_TRANSMIT;
   }
+  return LS_BUSY;
+}
 
-  if (m_timed_idle_hardware) {
-    // Send a reset of the countdown if ARPA targets are found
-    if ((m_control && m_arpa && m_arpa->GetTargetCount() > 0) || m_pi->m_guard_bogey_seen) {
-      // Send another 'enable timed transmit' followed by a transmit command..
-      // The idea is that this enables transmit but does reset the countdown timer
-      // in the radar.
-      // TODO: This is just a guess as to whether it works.
-      SetControlValue(CT_TIMED_RUN, m_timed_run, 0);
-      SetControlValue(CT_TIMED_IDLE, m_timed_idle, 0);
-      m_control->RadarTxOn();
-    }
+void RadarInfo::OnDataLost() {
+  wxCriticalSectionLocker lock(m_exclusive);
 
-    return;  // hardware versions do not need the rest of the code
-  }
+  m_state.Update(RADAR_STANDBY);
+  LOG_VERBOSE(wxT("%s data lost"), m_name.c_str());
+}
 
-  RadarState state = (RadarState)m_state.GetValue();
-  if (state == RADAR_OFF) {
-    return;  // Timers are just stuck at existing value if radar is off.
+void RadarInfo::OnPresenceLost() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_state.Update(RADAR_OFF);
+  LOG_VERBOSE(wxT("%s lost presence"), m_name.c_str());
+}
+
+void RadarInfo::SendStayAlive() {
+  if (m_control) {
+    m_control->RadarStayAlive();
   }
+}
 
-  // If there are (M)ARPA targets being tracked or zone alarm we should not go to standbye, targets would be lost
-  if (m_arpa->GetTargetCount() > 0 || m_pi->m_guard_bogey_seen) {
-    return;
+void RadarInfo::RequestTransmit(bool transmit) { RequestRadarState(transmit ? RADAR_TRANSMIT : RADAR_STANDBY); }
+
+// The boot flag asks to turn the radar on as soon as it is seen in standby
+bool RadarInfo::IsBootTransmitPending() { return m_boot_state.GetValue() == RADAR_TRANSMIT; }
+
+void RadarInfo::ClearBootTransmit() { m_boot_state.Update(RADAR_OFF); }
+
+TimedTransmitMode RadarInfo::GetTimedTransmitMode() {
+  if (m_timed_idle_hardware) {
+    return m_timed_idle.GetState() == RCS_OFF ? TTM_OFF : TTM_HARDWARE;
   }
+  return m_timed_idle.GetState() == RCS_OFF ? TTM_OFF : TTM_SOFTWARE;
+}
 
-  time_t now = time(0);
-  int time_to_go;
+int RadarInfo::GetTimedRunSeconds() { return m_timed_run.GetValue() * SECONDS_PER_TIMED_RUN_SETTING; }
 
-  if (m_idle_standby > 0) {
-    if (TIMED_OUT(now, m_idle_standby) && state == RADAR_TRANSMIT) {
-      RequestRadarState(RADAR_STANDBY);
-      time_to_go = m_timed_idle.GetValue() * SECONDS_PER_TIMED_IDLE_SETTING;
-      m_idle_transmit = now + time_to_go;
-      m_idle_standby = 0;
-    } else {
-      time_to_go = m_idle_standby - now;
-    }
-  } else if (m_idle_transmit > 0) {
-    if (TIMED_OUT(now, m_idle_transmit) && state == RADAR_STANDBY) {
-      RequestRadarState(RADAR_TRANSMIT);
-      time_to_go = m_timed_run.GetValue() * SECONDS_PER_TIMED_RUN_SETTING;
-      m_idle_standby = now + time_to_go;
-      m_idle_transmit = 0;
-    } else {
-      time_to_go = m_idle_transmit - now;
-    }
-  } else {
-    time_to_go = 0;
+int RadarInfo::GetTimedIdleSeconds() { return m_timed_idle.GetValue() * SECONDS_PER_TIMED_IDLE_SETTING; }
+
+// If there are (M)ARPA targets being tracked or zone alarm we should not go to standby, targets would be lost
+bool RadarInfo::HoldTransmit() { return (m_arpa && m_arpa->GetTargetCount() > 0) || m_pi->m_guard_bogey_seen; }
+
+void RadarInfo::RenewTimedTransmit() {
+  if (m_control && m_timed_idle.GetState() != RCS_OFF) {
+    // Send another 'enable timed transmit' followed by a transmit command..
+    // The idea is that this enables transmit but does reset the countdown timer
+    // in the radar.
+    // TODO: This is just a guess as to whether it works.
+    SetControlValue(CT_TIMED_RUN, m_timed_run, 0);
+    SetControlValue(CT_TIMED_IDLE, m_timed_idle, 0);
+    m_control->RadarTxOn();
   }
-  time_to_go = wxMax(time_to_go, 0);
-  m_next_state_change.Update(time_to_go);
 }
 
+void RadarInfo::SetCountdown(int seconds) { m_next_state_change.Update(seconds); }
+
+void RadarInfo::WakeLifecycle() { m_pi->NotifyLifecycle(); }
+
 bool RadarInfo::GetRadarPosition(GeoPosition *pos) {
   wxCriticalSectionLocker lock(m_exclusive);
 
+  if (m_playback_navigation) {
+    *pos = m_playback_position;
+    return true;
+  }
   if (m_pi->IsBoatPositionValid() && VALID_GEO(m_radar_position.lat) && VALID_GEO(m_radar_position.lon)) {
     *pos = m_radar_position;
     return true;
@@ -1670,6 +1982,10 @@ bool RadarInfo::GetRadarPosition(GeoPosition *pos) {
 bool RadarInfo::GetRadarPosition(ExtendedPosition *radar_pos) {
   wxCriticalSectionLocker lock(m_exclusive);
 
+  if (m_playback_navigation) {
+    radar_pos->pos = m_playback_position;
+    return true;
+  }
   if (m_pi->IsBoatPositionValid() && VALID_GEO(m_radar_position.lat) && VALID_GEO(m_radar_position.lon)) {
     radar_pos->pos = m_radar_position;
     return true;
@@ -1679,6 +1995,67 @@ bool RadarInfo::GetRadarPosition(ExtendedPosition *radar_pos) {
   return false;
 }
 
+/*
+ * Called by the playback thread for every spoke. The recorded position is
+ * that of the radar, the antenna offset has already been applied.
+ */
+void RadarInfo::SetPlaybackNavigation(GeoPosition pos, double heading) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_playback_navigation = true;
+  m_playback_position = pos;
+  m_playback_heading = heading;
+}
+
+void RadarInfo::ClearPlaybackNavigation() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_playback_navigation = false;
+}
+
+void RadarInfo::SetPlaybackClock(wxLongLong start, double speed) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_playback_clock_start = start;
+  m_playback_clock_speed = speed;
+}
+
+void RadarInfo::ClearPlaybackClock() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_playback_clock_start = 0;
+}
+
+wxLongLong RadarInfo::GetRadarTime() {
+  wxLongLong now = wxGetUTCTimeMillis();
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (m_playback_clock_start == 0) {
+    return now;
+  }
+  return m_playback_clock_start + wxLongLong((wxLongLong_t)((now - m_playback_clock_start).GetValue() * m_playback_clock_speed));
+}
+
+double RadarInfo::GetHeadingTrue() {
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+    if (m_playback_navigation) {
+      return m_playback_heading;
+    }
+  }
+  return m_pi->GetHeadingTrue();
+}
+
+HeadingSource RadarInfo::GetHeadingSource() {
+  {
+    wxCriticalSectionLocker lock(m_exclusive);
+    if (m_playback_navigation) {
+      return HEADING_PLAYBACK;
+    }
+  }
+  return m_pi->GetHeadingSource();
+}
+
 bool RadarInfo::HaveRadarSerialNo(size_t r) {
   wxCriticalSectionLocker lock(m_exclusive);
   return !m_radar_location_info.serialNr.IsNull();
@@ -1691,12 +2068,18 @@ RadarLocationInfo RadarInfo::GetRadarLocationInfo() {
 
 void RadarInfo::SetRadarLocationInfo(const RadarLocationInfo &info) {
   wxCriticalSectionLocker lock(m_exclusive);
+  if (!(m_radar_location_info == info)) {
+    m_discovery_changed = true;
+  }
   m_radar_location_info = info;
   LOG_VERBOSE(wxT("Set radar location info to %s"), info.to_string());
 }
 
 void RadarInfo::SetRadarInterfaceAddress(NetworkAddress &ifaddr, NetworkAddress &addr) {
   wxCriticalSectionLocker lock(m_exclusive);
+  if (!(m_radar_interface_address == ifaddr) || !(m_radar_address == addr)) {
+    m_discovery_changed = true;
+  }
   m_radar_interface_address = ifaddr;
   m_radar_address = addr;
 };
@@ -1711,4 +2094,13 @@ NetworkAddress RadarInfo::GetRadarInterfaceAddress() {
   return m_radar_interface_address;
 }
 
+// Returns whether the radar was found somewhere else since the last call
+bool RadarInfo::TakeDiscoveryChanged() {
+  wxCriticalSectionLocker lock(m_exclusive);
+  bool changed = m_discovery_changed;
+
+  m_discovery_changed = false;
+  return changed;
+}
+
 PLUGIN_END_NAMESPACE
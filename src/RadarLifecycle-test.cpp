@@ -0,0 +1,351 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Runs the DeadlineWheel and the RadarLifecycle state machine on a fake
+ * clock against a fake radar: data and presence loss at their exact
+ * deadlines, no work while data keeps coming in, 'transmit at boot' and
+ * software and hardware timed transmit. Build it against the plugin headers and
+ * wxWidgets, like Kalman-test.cpp, e.g.
+ *
+ *   c++ -O2 -Iinclude `wx-config --cxxflags` -o RadarLifecycle-test \
+ *     src/RadarLifecycle-test.cpp src/RadarLifecycle.cpp `wx-config --libs`
+ */
+
+#include "RadarLifecycle.h"
+
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+// A radar that does what it is told at once
+class FakeRadar : public RadarLifecycleHost {
+public:
+  FakeRadar() {
+    state = LS_OFF;
+    boot = false;
+    mode = TTM_OFF;
+    run = 60;
+    idle = 120;
+    hold = false;
+    countdown = 0;
+    woken = false;
+    data_lost = presence_lost = stayalive = transmit = standby = renewed = wakes = 0;
+  }
+
+  LifecycleState GetLifecycleState() { return state; }
+  void OnDataLost() {
+    state = LS_STANDBY;
+    data_lost++;
+  }
+  void OnPresenceLost() {
+    state = LS_OFF;
+    presence_lost++;
+  }
+  void SendStayAlive() { stayalive++; }
+  void RequestTransmit(bool on) {
+    state = on ? LS_TRANSMIT : LS_STANDBY;
+    (on ? transmit : standby)++;
+  }
+  bool IsBootTransmitPending() { return boot; }
+  void ClearBootTransmit() { boot = false; }
+  TimedTransmitMode GetTimedTransmitMode() { return mode; }
+  int GetTimedRunSeconds() { return run; }
+  int GetTimedIdleSeconds() { return idle; }
+  bool HoldTransmit() { return hold; }
+  void RenewTimedTransmit() { renewed++; }
+  void SetCountdown(int seconds) { countdown = seconds; }
+  void WakeLifecycle() {
+    woken = true;
+    wakes++;
+  }
+
+  LifecycleState state;
+  bool boot;
+  TimedTransmitMode mode;
+  int run;
+  int idle;
+  bool hold;
+  int countdown;
+  bool woken;
+  int data_lost, presence_lost, stayalive, transmit, standby, renewed, wakes;
+};
+
+// One radar on a wheel, and the clock that drives them
+struct Rig {
+  Rig() : wheel(2 * LT_TIMERS), lifecycle(&radar, &wheel, LT_TIMERS) {
+    now = 0;
+    fired = 0;
+  }
+
+  // Move the clock to 'until', handling the wake up and firing every timer at its deadline
+  void RunUntil(wxLongLong until) {
+    for (;;) {
+      if (radar.woken) {
+        radar.woken = false;
+        lifecycle.Wake(now);
+      }
+      wxLongLong next;
+      if (!wheel.GetNextDeadline(&next) || next > until) {
+        break;
+      }
+      now = wxMax(now, next);
+      int id;
+      while ((id = wheel.Expire(now)) >= 0) {
+        fired++;
+        lifecycle.OnTimer((LifecycleTimer)(id - LT_TIMERS), now);
+      }
+    }
+    now = until;
+  }
+
+  // Packets every 'step' ms until 'until': spokes while transmitting, otherwise status reports
+  void Feed(wxLongLong until, int step = 100) {
+    while (now < until) {
+      if (radar.state == LS_TRANSMIT) {
+        lifecycle.DataReceived(now);
+      } else {
+        lifecycle.ReportReceived(now);
+      }
+      RunUntil(wxMin(now + step, until));
+    }
+  }
+
+  FakeRadar radar;
+  DeadlineWheel wheel;
+  RadarLifecycle lifecycle;
+  wxLongLong now;
+  int fired;
+};
+
+static int Expect(const char *what, long actual, long expected) {
+  if (actual != expected) {
+    cout << "ERROR: " << what << " is " << actual << ", expected " << expected << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+static int TestWheel() {
+  const int timers = 200;
+  DeadlineWheel wheel(timers);
+  wxLongLong deadline[timers];
+  int ret = 0;
+
+  srand(1);
+  for (int id = 0; id < timers; id++) {
+    deadline[id] = rand() % 20000;  // Three turns of the wheel
+    wheel.Arm(id, deadline[id]);
+  }
+  for (int id = 0; id < timers; id += 7) {
+    wheel.Cancel(id);
+    deadline[id] = -1;
+  }
+
+  wxLongLong now = 0;
+  int expired = 0;
+  wxLongLong next;
+  while (wheel.GetNextDeadline(&next)) {
+    wxLongLong earliest = -1;
+    for (int id = 0; id < timers; id++) {
+      if (deadline[id] >= 0 && (earliest < 0 || deadline[id] < earliest)) {
+        earliest = deadline[id];
+      }
+    }
+    if (next != earliest) {
+      cout << "ERROR: next deadline " << next << ", expected " << earliest << "\n";
+      return 1;
+    }
+    now = next;
+    int id;
+    while ((id = wheel.Expire(now)) >= 0) {
+      if (deadline[id] != now) {
+        cout << "ERROR: timer " << id << " for " << deadline[id] << " expired at " << now << "\n";
+        ret = 1;
+      }
+      deadline[id] = -1;
+      expired++;
+    }
+  }
+  ret |= Expect("expired timers", expired, timers - (timers + 6) / 7);
+
+  // A deadline in the past expires at once, even after a long time without looking
+  wheel.Arm(3, now - 5000);
+  wheel.Arm(4, now + 100000);
+  ret |= Expect("late timer", wheel.Expire(now + 1), 3);
+  ret |= Expect("early timer", wheel.Expire(now + 99999), -1);
+  ret |= Expect("far timer", wheel.Expire(now + 100000), 4);
+  return ret;
+}
+
+static int TestDataLoss() {
+  Rig rig;
+  int ret = 0;
+
+  rig.radar.state = LS_TRANSMIT;
+  rig.lifecycle.DataReceived(0);
+  rig.RunUntil(4999);
+  ret |= Expect("data lost before deadline", rig.radar.data_lost, 0);
+  rig.RunUntil(5000);
+  ret |= Expect("data lost at deadline", rig.radar.data_lost, 1);
+  ret |= Expect("state after data loss", rig.radar.state, LS_STANDBY);
+  rig.RunUntil(9999);
+  ret |= Expect("presence lost before deadline", rig.radar.presence_lost, 0);
+  rig.RunUntil(10000);
+  ret |= Expect("presence lost at deadline", rig.radar.presence_lost, 1);
+  ret |= Expect("state after presence loss", rig.radar.state, LS_OFF);
+
+  // Nothing more happens until the radar is back
+  int fired = rig.fired;
+  rig.RunUntil(600000);
+  ret |= Expect("timers while gone", rig.fired - fired, 0);
+
+  rig.radar.state = LS_TRANSMIT;
+  rig.Feed(610000);
+  ret |= Expect("wake ups", rig.radar.wakes, 2);
+  rig.RunUntil(615000);
+  ret |= Expect("data lost again", rig.radar.data_lost, 2);
+  return ret;
+}
+
+static int TestSteadyData() {
+  Rig rig;
+  int ret = 0;
+
+  rig.radar.state = LS_TRANSMIT;
+  rig.Feed(60000, 10);
+  ret |= Expect("wake ups", rig.radar.wakes, 1);
+  ret |= Expect("data lost", rig.radar.data_lost, 0);
+  ret |= Expect("stay alive pings", rig.radar.stayalive, 1 + 60000 / LIFECYCLE_STAYALIVE);
+  if (rig.fired > 40) {
+    cout << "ERROR: " << rig.fired << " timers fired for 6000 packets\n";
+    ret = 1;
+  }
+  return ret;
+}
+
+static int TestBoot() {
+  Rig rig;
+  int ret = 0;
+
+  rig.radar.boot = true;
+  rig.Feed(2500);
+  ret |= Expect("transmit while off", rig.radar.transmit, 0);
+  rig.radar.state = LS_STANDBY;
+  rig.Feed(3500);
+  ret |= Expect("transmit at boot", rig.radar.transmit, 1);
+  ret |= Expect("boot pending", rig.radar.boot, false);
+  rig.Feed(10000);
+  ret |= Expect("transmit later", rig.radar.transmit, 1);
+  return ret;
+}
+
+static int TestTimedTransmit() {
+  Rig rig;
+  int ret = 0;
+
+  rig.radar.state = LS_TRANSMIT;
+  rig.Feed(1000);
+  rig.radar.mode = TTM_SOFTWARE;
+  rig.lifecycle.TimedTransmitChanged(rig.now);
+  ret |= Expect("countdown at start", rig.radar.countdown, 10);
+  rig.Feed(6000);
+  ret |= Expect("countdown after 5s", rig.radar.countdown, 5);
+  rig.Feed(10999);
+  ret |= Expect("standby before deadline", rig.radar.standby, 0);
+  rig.Feed(11000);
+  ret |= Expect("standby at deadline", rig.radar.standby, 1);
+  ret |= Expect("countdown in standby", rig.radar.countdown, 120);
+
+  rig.Feed(11000 + 120000);
+  ret |= Expect("transmit after idle", rig.radar.transmit, 1);
+  ret |= Expect("data lost during idle", rig.radar.data_lost, 0);
+
+  // Targets keep it transmitting past the deadline
+  rig.radar.hold = true;
+  rig.Feed(131000 + 60000 + 5000);
+  ret |= Expect("standby with targets", rig.radar.standby, 1);
+  ret |= Expect("countdown with targets", rig.radar.countdown, 1);
+  rig.radar.hold = false;
+  rig.Feed(131000 + 60000 + 6000);
+  ret |= Expect("standby without targets", rig.radar.standby, 2);
+
+  rig.radar.mode = TTM_OFF;
+  rig.lifecycle.TimedTransmitChanged(rig.now);
+  ret |= Expect("countdown when off", rig.radar.countdown, 0);
+  ret |= Expect("running when off", rig.lifecycle.IsTimedTransmitRunning(), false);
+  rig.Feed(1000000);
+  ret |= Expect("transmit when off", rig.radar.transmit, 1);
+  return ret;
+}
+
+static int TestHardwareTimedTransmit() {
+  Rig rig;
+  int ret = 0;
+
+  // In standby there are no targets to hold on to, so only the other timers run
+  rig.radar.state = LS_STANDBY;
+  rig.radar.mode = TTM_HARDWARE;
+  rig.Feed(60000);
+  if (rig.fired > 25) {
+    cout << "ERROR: " << rig.fired << " timers fired in a minute of hardware timed standby\n";
+    ret = 1;
+  }
+
+  // The next stay-alive notices that it transmits, then targets renew the timed transmit every second
+  rig.radar.state = LS_TRANSMIT;
+  rig.radar.hold = true;
+  rig.Feed(70000);
+  ret |= Expect("renewals with targets", rig.radar.renewed, 6);
+
+  rig.radar.state = LS_STANDBY;
+  rig.Feed(100000);
+  ret |= Expect("renewals in standby", rig.radar.renewed, 6);
+  return ret;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestWheel();
+  ret |= TestDataLoss();
+  ret |= TestSteadyData();
+  ret |= TestBoot();
+  ret |= TestTimedTransmit();
+  ret |= TestHardwareTimedTransmit();
+  cout << (ret ? "FAILED\n" : "OK\n");
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
@@ -0,0 +1,418 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarLifecycle.h"
+
+#include <chrono>
+
+PLUGIN_BEGIN_NAMESPACE
+
+DeadlineWheel::DeadlineWheel(int timers) {
+  m_timers = timers;
+  m_timer = new Timer[timers];
+  for (int i = 0; i < timers; i++) {
+    m_timer[i].deadline = 0;
+    m_timer[i].slot = -1;
+  }
+  for (int s = 0; s < DEADLINE_WHEEL_SLOTS; s++) {
+    m_head[s] = -1;
+  }
+  m_tick = 0;
+  m_armed = 0;
+}
+
+DeadlineWheel::~DeadlineWheel() { delete[] m_timer; }
+
+void DeadlineWheel::Arm(int id, wxLongLong deadline) {
+  Cancel(id);
+
+  // A deadline that has already passed goes in the slot that Expire() looks at first
+  wxLongLong tick = deadline / DEADLINE_WHEEL_TICK_MS;
+  Timer &t = m_timer[id];
+  t.deadline = deadline;
+  t.slot = SlotOf(wxMax(tick, m_tick));
+  t.prev = -1;
+  t.next = m_head[t.slot];
+  if (t.next >= 0) {
+    m_timer[t.next].prev = id;
+  }
+  m_head[t.slot] = id;
+  m_armed++;
+}
+
+void DeadlineWheel::Cancel(int id) {
+  Timer &t = m_timer[id];
+  if (t.slot < 0) {
+    return;
+  }
+  if (t.prev >= 0) {
+    m_timer[t.prev].next = t.next;
+  } else {
+    m_head[t.slot] = t.next;
+  }
+  if (t.next >= 0) {
+    m_timer[t.next].prev = t.prev;
+  }
+  t.slot = -1;
+  m_armed--;
+}
+
+int DeadlineWheel::Expire(wxLongLong now) {
+  wxLongLong now_tick = now / DEADLINE_WHEEL_TICK_MS;
+
+  if (now_tick - m_tick >= DEADLINE_WHEEL_SLOTS) {
+    m_tick = now_tick - (DEADLINE_WHEEL_SLOTS - 1);  // A full turn visits every slot once
+  }
+  while (m_armed > 0) {
+    for (int id = m_head[SlotOf(m_tick)]; id >= 0; id = m_timer[id].next) {
+      if (m_timer[id].deadline <= now) {
+        Cancel(id);
+        return id;
+      }
+    }
+    if (m_tick >= now_tick) {
+      break;
+    }
+    m_tick++;
+  }
+  return -1;
+}
+
+bool DeadlineWheel::GetNextDeadline(wxLongLong *deadline) {
+  if (m_armed == 0) {
+    return false;
+  }
+
+  // The first slot that holds a timer for its own turn of the wheel has the earliest deadline
+  for (int i = 0; i < DEADLINE_WHEEL_SLOTS; i++) {
+    wxLongLong end = (m_tick + i + 1) * DEADLINE_WHEEL_TICK_MS;
+    bool found = false;
+    for (int id = m_head[SlotOf(m_tick + i)]; id >= 0; id = m_timer[id].next) {
+      if (m_timer[id].deadline < end && (!found || m_timer[id].deadline < *deadline)) {
+        *deadline = m_timer[id].deadline;
+        found = true;
+      }
+    }
+    if (found) {
+      return true;
+    }
+  }
+
+  // Everything is more than a turn away
+  bool found = false;
+  for (int id = 0; id < m_timers; id++) {
+    if (m_timer[id].slot >= 0 && (!found || m_timer[id].deadline < *deadline)) {
+      *deadline = m_timer[id].deadline;
+      found = true;
+    }
+  }
+  return found;
+}
+
+wxLongLong GetMonotonicMillis() {
+  std::chrono::milliseconds ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  return wxLongLong((wxLongLong_t)ms.count());
+}
+
+RadarLifecycle::RadarLifecycle(RadarLifecycleHost *host, DeadlineWheel *wheel, int first_timer) {
+  m_host = host;
+  m_wheel = wheel;
+  m_first_timer = first_timer;
+  m_data_time = 0;
+  m_report_time = 0;
+  m_detected = false;
+  m_data_armed = false;
+  m_presence_armed = false;
+  m_timed_transmit = TT_NONE;
+  m_timed_deadline = 0;
+}
+
+RadarLifecycle::~RadarLifecycle() {
+  for (int t = 0; t < LT_TIMERS; t++) {
+    Cancel((LifecycleTimer)t);
+  }
+}
+
+void RadarLifecycle::DataReceived(wxLongLong now) {
+  m_data_time = now.GetValue();
+  m_report_time = now.GetValue();
+  if (!m_data_armed || !m_presence_armed) {
+    m_data_armed = true;
+    m_presence_armed = true;
+    m_host->WakeLifecycle();
+  }
+}
+
+void RadarLifecycle::ReportReceived(wxLongLong now) {
+  m_report_time = now.GetValue();
+  if (!m_presence_armed) {
+    m_presence_armed = true;
+    m_host->WakeLifecycle();
+  }
+}
+
+void RadarLifecycle::Detected() {
+  m_detected = true;
+  m_host->WakeLifecycle();
+}
+
+/*
+ * A receive thread has seen a radar whose timers had lapsed, or the radar
+ * opened its transmit socket. Arm whatever timers the radar needs now.
+ */
+void RadarLifecycle::Wake(wxLongLong now) {
+  if (m_presence_armed && !IsArmed(LT_PRESENCE)) {
+    CheckPresence(now);
+    if (IsArmed(LT_PRESENCE)) {
+      // The radar is back
+      if (!IsArmed(LT_STAYALIVE)) {
+        Arm(LT_STAYALIVE, now);
+      }
+      if (!IsArmed(LT_BOOT) && m_host->IsBootTransmitPending()) {
+        Arm(LT_BOOT, now);
+      }
+      if (!IsArmed(LT_TIMED_TRANSMIT)) {
+        Arm(LT_TIMED_TRANSMIT, m_timed_transmit != TT_NONE ? wxMax(m_timed_deadline, now) : now);
+      }
+    }
+  }
+  if (m_data_armed && !IsArmed(LT_DATA)) {
+    CheckData(now);
+  }
+  if (m_detected.exchange(false)) {
+    Arm(LT_STAYALIVE, now);  // Allow immediate restart of any TxOn or TxOff command
+  }
+}
+
+void RadarLifecycle::OnTimer(LifecycleTimer timer, wxLongLong now) {
+  switch (timer) {
+    case LT_DATA:
+      CheckData(now);
+      break;
+
+    case LT_PRESENCE:
+      CheckPresence(now);
+      break;
+
+    case LT_STAYALIVE:
+      if (m_host->GetLifecycleState() != LS_OFF) {
+        m_host->SendStayAlive();
+      }
+      if (m_presence_armed) {
+        Arm(LT_STAYALIVE, now + LIFECYCLE_STAYALIVE);
+        // Hardware timed transmit is only watched while the radar transmits, see whether it does now
+        if (!IsArmed(LT_TIMED_TRANSMIT) && m_host->GetTimedTransmitMode() == TTM_HARDWARE) {
+          CheckTimedTransmit(now);
+        }
+      }
+      break;
+
+    case LT_BOOT:
+      CheckBoot(now);
+      break;
+
+    case LT_TIMED_TRANSMIT:
+      CheckTimedTransmit(now);
+      break;
+
+    case LT_COUNTDOWN:
+      UpdateCountdown(now);
+      break;
+
+    case LT_TIMERS:
+      break;
+  }
+}
+
+void RadarLifecycle::CheckData(wxLongLong now) {
+  // Clear the flag before looking at the time, so that a spoke arriving in
+  // between either shows up here or wakes us up again.
+  m_data_armed = false;
+  wxLongLong deadline = wxLongLong(m_data_time.load()) + LIFECYCLE_DATA_TIMEOUT;
+  if (now < deadline) {
+    m_data_armed = true;
+    Arm(LT_DATA, deadline);
+    return;
+  }
+
+  if (m_host->GetLifecycleState() == LS_TRANSMIT) {
+    m_host->OnDataLost();
+    CheckPresence(now);
+  }
+}
+
+void RadarLifecycle::CheckPresence(wxLongLong now) {
+  m_presence_armed = false;
+  wxLongLong deadline = wxLongLong(m_report_time.load()) + LIFECYCLE_PRESENCE_TIMEOUT;
+  if (now < deadline) {
+    m_presence_armed = true;
+    Arm(LT_PRESENCE, deadline);
+    return;
+  }
+
+  // A transmitting radar is only lost once its data stops as well, CheckData() will call us again.
+  if (m_host->GetLifecycleState() == LS_STANDBY) {
+    m_host->OnPresenceLost();
+
+    // The timed transmit deadline stays, it is honoured as soon as the radar is back.
+    Cancel(LT_STAYALIVE);
+    Cancel(LT_BOOT);
+    Cancel(LT_TIMED_TRANSMIT);
+    Cancel(LT_COUNTDOWN);
+  }
+}
+
+void RadarLifecycle::CheckBoot(wxLongLong now) {
+  if (!m_host->IsBootTransmitPending()) {
+    return;
+  }
+
+  LifecycleState state = m_host->GetLifecycleState();
+  if (state == LS_STANDBY) {
+    m_host->ClearBootTransmit();
+    m_host->RequestTransmit(true);
+  } else if (m_presence_armed) {
+    Arm(LT_BOOT, now + LIFECYCLE_RETRY);  // Still starting up
+  }
+}
+
+void RadarLifecycle::CommandSent(wxLongLong now) { Arm(LT_STAYALIVE, now + LIFECYCLE_STAYALIVE); }
+
+/*
+ * The user switched timed transmit on or off, or changed its times. Like
+ * before, the first change of state is LIFECYCLE_TIMED_TRANSMIT_START
+ * after that.
+ */
+void RadarLifecycle::TimedTransmitChanged(wxLongLong now) {
+  switch (m_host->GetTimedTransmitMode()) {
+    case TTM_OFF:
+      Cancel(LT_TIMED_TRANSMIT);
+      if (m_timed_transmit != TT_NONE) {
+        m_timed_transmit = TT_NONE;
+        Cancel(LT_COUNTDOWN);
+        m_host->SetCountdown(0);
+      }
+      break;
+
+    case TTM_SOFTWARE:
+      m_timed_transmit = m_host->GetLifecycleState() == LS_TRANSMIT ? TT_UNTIL_STANDBY : TT_UNTIL_TRANSMIT;
+      m_timed_deadline = now + LIFECYCLE_TIMED_TRANSMIT_START;
+      Arm(LT_TIMED_TRANSMIT, m_timed_deadline);
+      UpdateCountdown(now);
+      break;
+
+    case TTM_HARDWARE:
+      m_timed_transmit = TT_NONE;
+      Arm(LT_TIMED_TRANSMIT, now);
+      break;
+  }
+}
+
+/*
+ * If the radar has transmitted long enough, send it to standby and start
+ * the idle period; if it has idled long enough, start transmitting and
+ * start the run period. While targets are being tracked or the radar is not
+ * in the expected state the change is put off, and tried again a little
+ * later.
+ */
+void RadarLifecycle::CheckTimedTransmit(wxLongLong now) {
+  TimedTransmitMode mode = m_host->GetTimedTransmitMode();
+  LifecycleState state = m_host->GetLifecycleState();
+
+  if (mode == TTM_OFF) {
+    TimedTransmitChanged(now);
+    return;
+  }
+  if ((mode == TTM_SOFTWARE && m_timed_transmit == TT_NONE) || !m_presence_armed) {
+    return;  // Not started, or frozen until the radar is back, see Wake()
+  }
+  if (mode == TTM_HARDWARE) {
+    // The radar counts down itself, but it must not go to standby with targets. That can only happen while it
+    // transmits; in any other state the stay-alive timer starts watching again later.
+    if (state == LS_TRANSMIT) {
+      if (m_host->HoldTransmit()) {
+        m_host->RenewTimedTransmit();
+      }
+      Arm(LT_TIMED_TRANSMIT, now + LIFECYCLE_RETRY);
+    }
+    return;
+  }
+  if (state == LS_OFF) {
+    Arm(LT_TIMED_TRANSMIT, now + LIFECYCLE_RETRY);  // Seen, but its state is not known yet
+    return;
+  }
+  if (now < m_timed_deadline) {
+    Arm(LT_TIMED_TRANSMIT, m_timed_deadline);
+    UpdateCountdown(now);
+    return;
+  }
+
+  bool hold = m_host->HoldTransmit();
+  if (!hold && m_timed_transmit == TT_UNTIL_STANDBY && state == LS_TRANSMIT) {
+    m_host->RequestTransmit(false);
+    m_timed_transmit = TT_UNTIL_TRANSMIT;
+    m_timed_deadline = now + m_host->GetTimedIdleSeconds() * 1000;
+    Arm(LT_TIMED_TRANSMIT, m_timed_deadline);
+  } else if (!hold && m_timed_transmit == TT_UNTIL_TRANSMIT && state == LS_STANDBY) {
+    m_host->RequestTransmit(true);
+    m_timed_transmit = TT_UNTIL_STANDBY;
+    m_timed_deadline = now + m_host->GetTimedRunSeconds() * 1000;
+    Arm(LT_TIMED_TRANSMIT, m_timed_deadline);
+  } else {
+    Arm(LT_TIMED_TRANSMIT, now + LIFECYCLE_RETRY);
+  }
+  UpdateCountdown(now);
+}
+
+/*
+ * Show the whole seconds left until the next timed transmit change, and arm
+ * LT_COUNTDOWN for the moment that number drops. A change that is put off
+ * shows as one second to go.
+ */
+void RadarLifecycle::UpdateCountdown(wxLongLong now) {
+  if (m_timed_transmit == TT_NONE) {
+    return;
+  }
+
+  wxLongLong left = m_timed_deadline - now;
+  int seconds = 1;
+  if (left > 1000) {
+    seconds = (int)((left + 999) / 1000).GetLo();
+    Arm(LT_COUNTDOWN, m_timed_deadline - (seconds - 1) * 1000);
+  } else {
+    Cancel(LT_COUNTDOWN);
+  }
+  m_host->SetCountdown(seconds);
+}
+
+PLUGIN_END_NAMESPACE
@@ -32,6 +32,7 @@
 #include "RadarMarpa.h"
 
 #include "GuardZone.h"
+#include "PolarHistory.h"
 #include "RadarCanvas.h"
 #include "RadarInfo.h"
 #include "drawutil.h"
@@ -97,9 +98,9 @@ bool RadarArpa::Pix(int ang, int rad, bool doppler) {
   if (rad <= 0 || rad >= (int)m_ri->m_spoke_len_max) {
     return false;
   }
-  int angle = MOD_SPOKES(ang);
-  bool bit0 = (m_ri->m_history[angle].line[rad] & 128) != 0;
-  bool bit2 = (m_ri->m_history[angle].line[rad] & 32) != 0;
+  int pix = m_ri->m_history->Bits(ang, rad);
+  bool bit0 = (pix & HISTORY_BIT(HISTORY_ABOVE_THRESHOLD)) != 0;
+  bool bit2 = (pix & HISTORY_BIT(HISTORY_DOPPLER)) != 0;
   if (!doppler) {
     return (bit0);
   } else {
@@ -111,13 +112,10 @@ bool ArpaTarget::Pix(int ang, int rad) {
   if (rad <= 0 || rad >= (int)m_ri->m_spoke_len_max) {
     return false;
   }
-  int angle = MOD_SPOKES(ang);
-  if (angle >= m_ri->m_spokes || angle < 0) {
-    return false;
-  }
-  bool bit0 = (m_ri->m_history[angle].line[rad] & 128) > 0;
-  bool bit1 = (m_ri->m_history[angle].line[rad] & 64) > 0;
-  bool bit2 = (m_ri->m_history[angle].line[rad] & 32) > 0;
+  int pix = m_ri->m_history->Bits(ang, rad);
+  bool bit0 = (pix & HISTORY_BIT(HISTORY_ABOVE_THRESHOLD)) != 0;
+  bool bit1 = (pix & HISTORY_BIT(HISTORY_UNCLAIMED)) != 0;
+  bool bit2 = (pix & HISTORY_BIT(HISTORY_DOPPLER)) != 0;
 
   if (m_doppler_target > 0 && !bit2) {  // we are looking for doppler targets and this is not doppler
     return false;
@@ -226,9 +224,7 @@ bool ArpaTarget::MultiPix(int ang, int rad) {  // checks if the blob has a conto
     max_angle.angle += m_ri->m_spokes;
   }
   for (int a = min_angle.angle; a <= max_angle.angle; a++) {
-    for (int r = min_r.r; r <= max_r.r; r++) {
-      m_ri->m_history[MOD_SPOKES(a)].line[r] &= 63;
-    }
+    m_ri->m_history->ClearBits(a, min_r.r, max_r.r + 1, HISTORY_BIT(HISTORY_ABOVE_THRESHOLD) | HISTORY_BIT(HISTORY_UNCLAIMED));
   }
   return false;
 }
@@ -331,9 +327,7 @@ bool RadarArpa::MultiPix(int ang, int rad, bool doppler) {
     max_angle.angle += m_ri->m_spokes;
   }
   for (int a = min_angle.angle; a <= max_angle.angle; a++) {
-    for (int r = min_r.r; r <= max_r.r; r++) {
-      m_ri->m_history[MOD_SPOKES(a)].line[r] &= 63;  // 0x3F
-    }
+    m_ri->m_history->ClearBits(a, min_r.r, max_r.r + 1, HISTORY_BIT(HISTORY_ABOVE_THRESHOLD) | HISTORY_BIT(HISTORY_UNCLAIMED));
   }
   return false;
 }
@@ -532,8 +526,8 @@ int ArpaTarget::GetContour(Polar* pol) {
     pol->angle -= m_ri->m_spokes;
   }
   pol->r = (m_max_r.r + m_min_r.r) / 2;
-  pol->time = m_ri->m_history[MOD_SPOKES(pol->angle)].time;
-  m_radar_pos = m_ri->m_history[MOD_SPOKES(pol->angle)].pos;
+  pol->time = m_ri->m_history->GetTime(MOD_SPOKES(pol->angle));
+  m_radar_pos = m_ri->m_history->GetPos(MOD_SPOKES(pol->angle));
 
   double poslat = m_radar_pos.lat;
   double poslon = m_radar_pos.lon;
@@ -773,16 +767,16 @@ void ArpaTarget::RefreshTarget(int dist) {
     return;
   }
   pol = Pos2Polar(m_position, own_pos);
-  wxLongLong time1 = m_ri->m_history[MOD_SPOKES(pol.angle)].time;
+  wxLongLong time1 = m_ri->m_history->GetTime(MOD_SPOKES(pol.angle));
   int margin = SCAN_MARGIN;
   if (m_pass_nr == PASS2) margin += 100;
-  wxLongLong time2 = m_ri->m_history[MOD_SPOKES(pol.angle + margin)].time;
+  wxLongLong time2 = m_ri->m_history->GetTime(MOD_SPOKES(pol.angle + margin));
   // check if target has been refreshed since last time (at least SCAN_MARGIN2 later)
   // and if the beam has passed the target location with SCAN_MARGIN spokes
   // the beam sould have passed our "angle" AND a point SCANMARGIN further
   // always refresh when status == 0
   if ((time1 < (m_refresh + SCAN_MARGIN2) || time2 < time1) && m_status != 0) {
-    wxLongLong now = wxGetUTCTimeMillis();  // millis
+    wxLongLong now = m_ri->GetRadarTime();  // millis, on the clock of the spoke times
     int diff = now.GetLo() - m_refresh.GetLo();
     if (diff > 8000) {
       LOG_ARPA(wxT("target not refreshed, missing spokes, set lost, status= %i, target_id= %i timediff= %i"), m_status, m_target_id,
@@ -856,7 +850,7 @@ void ArpaTarget::RefreshTarget(int dist) {
     if (m_status == ACQUIRE0) {
       // as this is the first measurement, move target to measured position
       ExtendedPosition p_own;
-      p_own.pos = m_ri->m_history[MOD_SPOKES(pol.angle)].pos;  // get the position at receive time
+      p_own.pos = m_ri->m_history->GetPos(MOD_SPOKES(pol.angle));  // get the position at receive time
       m_position = Polar2Pos(pol, p_own);                      // using own ship location from the time of reception
       m_position.dlat_dt = 0.;
       m_position.dlon_dt = 0.;
@@ -1222,7 +1216,7 @@ int RadarArpa::AcquireNewARPATarget(Polar pol, int status, uint8_t doppler) {
   target_pos = target->Polar2Pos(pol, own_pos);
 
   target->m_position = target_pos;  // Expected position
-  target->m_position.time = wxGetUTCTimeMillis();
+  target->m_position.time = m_ri->GetRadarTime();
   target->m_position.dlat_dt = 0.;
   target->m_position.dlon_dt = 0.;
   target->m_position.sd_speed_kn = 0.;
@@ -1245,11 +1239,11 @@ int RadarArpa::AcquireNewARPATarget(Polar pol, int status, uint8_t doppler) {
 void ArpaTarget::ResetPixels() {
   // resets the pixels of the current blob (plus DISTANCE_BETWEEN_TARGETS) so that blob will not be found again in the same sweep
   // We not only reset the blob but all pixels in a radial "square" covering the blob
-  for (int r = wxMax(m_min_r.r - DISTANCE_BETWEEN_TARGETS, 0);
-       r <= wxMin(m_max_r.r + DISTANCE_BETWEEN_TARGETS, (int)m_ri->m_spoke_len_max - 1); r++) {
-    for (int a = m_min_angle.angle - DISTANCE_BETWEEN_TARGETS; a <= m_max_angle.angle + DISTANCE_BETWEEN_TARGETS; a++) {
-      m_ri->m_history[MOD_SPOKES(a)].line[r] = m_ri->m_history[MOD_SPOKES(a)].line[r] & 127;
-    }
+  // Walk row by row so each history line is cleared with whole words.
+  int r_begin = m_min_r.r - DISTANCE_BETWEEN_TARGETS;
+  int r_end = m_max_r.r + DISTANCE_BETWEEN_TARGETS + 1;
+  for (int a = m_min_angle.angle - DISTANCE_BETWEEN_TARGETS; a <= m_max_angle.angle + DISTANCE_BETWEEN_TARGETS; a++) {
+    m_ri->m_history->ClearBits(a, r_begin, r_end, HISTORY_BIT(HISTORY_ABOVE_THRESHOLD));
   }
 }
 
@@ -1276,8 +1270,8 @@ void RadarArpa::SearchDopplerTargets() {
   }
   if (!m_pi->m_settings.show                          // No radar shown
     || !m_ri->GetRadarPosition(&own_pos.pos)        // No position
-    || m_pi->GetHeadingSource() == HEADING_NONE    // No heading
-    || (m_pi->GetHeadingSource() == HEADING_FIX_HDM && m_pi->m_var_source == VARIATION_SOURCE_NONE)) {
+    || m_ri->GetHeadingSource() == HEADING_NONE    // No heading
+    || (m_ri->GetHeadingSource() == HEADING_FIX_HDM && m_pi->m_var_source == VARIATION_SOURCE_NONE)) {
     return;
   }
 
@@ -1294,9 +1288,9 @@ void RadarArpa::SearchDopplerTargets() {
   // loop with +2 increments as target must be larger than 2 pixels in width
   for (int angleIter = start_bearing; angleIter < end_bearing; angleIter += 2) {
     SpokeBearing angle = MOD_SPOKES(angleIter);
-    wxLongLong time1 = m_ri->m_history[angle].time;
+    wxLongLong time1 = m_ri->m_history->GetTime(angle);
     // time2 must be timed later than the pass 2 in refresh, otherwise target may be found multiple times
-    wxLongLong time2 = m_ri->m_history[MOD_SPOKES(angle + 3 * SCAN_MARGIN)].time;
+    wxLongLong time2 = m_ri->m_history->GetTime(MOD_SPOKES(angle + 3 * SCAN_MARGIN));
 
     // check if target has been refreshed since last time
     // and if the beam has passed the target location with SCAN_MARGIN spokes
@@ -1304,7 +1298,9 @@ void RadarArpa::SearchDopplerTargets() {
          time2 >= time1)) {  // the beam sould have passed our "angle" AND a
                              // point SCANMARGIN further set new refresh time
       m_doppler_arpa_update_time[angle] = time1;
-      for (int rrr = (int)range_start; rrr < (int)range_end; rrr++) {
+      // Skip straight to the next doppler sample, most of a spoke is empty
+      for (int rrr = m_ri->m_history->FindNext(angle, range_start, range_end, true); rrr < (int)range_end;
+           rrr = m_ri->m_history->FindNext(angle, rrr + 1, range_end, true)) {
         if (m_ri->m_arpa->GetTargetCount() >= MAX_NUMBER_OF_TARGETS - 1) {
           LOG_INFO(wxT("No more scanning for ARPA targets in loop, maximum number of targets reached"));
           return;
@@ -0,0 +1,144 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarPlayback.h"
+
+#include "RadarInfo.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+// Returns false when we should stop
+bool RadarPlayback::Sleep(wxLongLong millis) {
+  while (millis > 0 && !m_shutdown) {
+    long ms = (long)wxMin(millis.GetValue(), (wxLongLong_t)PLAYBACK_MAX_SLEEP);
+    wxMilliSleep(ms);
+    millis -= ms;
+  }
+  return !m_shutdown;
+}
+
+void *RadarPlayback::Entry(void) {
+  RecordedSpoke spoke;
+  SpokeRuns runs;
+
+  LOG_VERBOSE(wxT("%s playback thread starting"), m_ri->m_name.c_str());
+
+  if (!m_recording.Open(m_filename)) {
+    wxLogError(wxT("radar_pi %s: cannot play recording %s"), m_ri->m_name.c_str(), m_filename.c_str());
+    return 0;
+  }
+  if (m_recording.GetSpokes() != m_ri->m_spokes || m_recording.GetSpokeLen() > m_ri->m_spoke_len_max) {
+    wxLogError(wxT("radar_pi %s: recording %s has %u x %u spokes, radar has %u x %u"), m_ri->m_name.c_str(), m_filename.c_str(),
+               (unsigned)m_recording.GetSpokes(), (unsigned)m_recording.GetSpokeLen(), (unsigned)m_ri->m_spokes,
+               (unsigned)m_ri->m_spoke_len_max);
+    return 0;
+  }
+  LOG_INFO(wxT("%s playing %s, %u revolutions"), m_ri->m_name.c_str(), m_filename.c_str(),
+           (unsigned)m_recording.GetRevolutions());
+
+  double speed = wxMax(M_SETTINGS.playback_speed, 0.1);
+  m_recording.Seek(m_recording.GetStartTime() + wxLongLong((wxLongLong_t)M_SETTINGS.playback_start * MILLISECONDS_PER_SECOND));
+
+  wxLongLong start_wall = 0;
+  int64_t start_recorded = 0;
+
+  while (!m_shutdown) {
+    if (!m_recording.NextSpoke(&spoke, &runs)) {
+      m_recording.SeekRevolution(0);
+      start_wall = 0;
+      if (!m_recording.NextSpoke(&spoke, &runs)) {
+        LOG_INFO(wxT("%s recording %s is empty"), m_ri->m_name.c_str(), m_filename.c_str());
+        break;
+      }
+    }
+
+    // Keep the pace of the recording, scaled by the playback speed
+    wxLongLong now = wxGetUTCTimeMillis();
+    if (start_wall == 0 || spoke.time < start_recorded) {
+      start_wall = now;
+      start_recorded = spoke.time;
+      m_ri->SetPlaybackClock(start_wall, speed);
+    }
+    wxLongLong due = start_wall + wxLongLong((wxLongLong_t)((spoke.time - start_recorded) / speed));
+    if (due > now && !Sleep(due - now)) {
+      break;
+    }
+
+    GeoPosition pos;
+    pos.lat = spoke.lat * 1e-7;
+    pos.lon = spoke.lon * 1e-7;
+    double heading = spoke.heading * 0.01;
+    {
+      wxCriticalSectionLocker lock(m_lock);
+      m_recorded_time = wxLongLong((wxLongLong_t)spoke.time);
+      m_recorded_pos = pos;
+      m_recorded_heading = heading;
+    }
+    if (VALID_GEO(pos.lat) && VALID_GEO(pos.lon) && fabs(pos.lat) <= 90.) {
+      m_ri->SetPlaybackNavigation(pos, heading);
+    } else {
+      m_ri->ClearPlaybackNavigation();  // Recorded without a position
+    }
+
+    m_ri->m_lifecycle.DataReceived();
+    m_ri->m_state.Update(RADAR_TRANSMIT);
+    m_ri->m_statistics.packets++;
+    m_ri->m_statistics.spokes++;
+    if (m_ri->m_range.GetValue() != spoke.range_meters) {
+      m_ri->m_range.Update(spoke.range_meters);
+    }
+    // Stamp the spoke with its recorded time moved onto the wall clock, so that ARPA and the trails see
+    // the recorded intervals and speeds whatever the playback speed; see RadarInfo::GetRadarTime.
+    wxLongLong spoke_time = start_wall + wxLongLong((wxLongLong_t)(spoke.time - start_recorded));
+    m_ri->ProcessRadarSpoke(spoke.angle % m_ri->m_spokes, spoke.bearing % m_ri->m_spokes, runs, spoke.range_meters,
+                            spoke_time);
+  }
+
+  m_ri->ClearPlaybackNavigation();
+  m_ri->ClearPlaybackClock();
+  LOG_VERBOSE(wxT("%s playback thread stopping"), m_ri->m_name.c_str());
+  return 0;
+}
+
+wxString RadarPlayback::GetInfoStatus() {
+  wxCriticalSectionLocker lock(m_lock);
+
+  if (m_recorded_time == 0) {
+    return _("Playback");
+  }
+  wxDateTime when(m_recorded_time);
+  return wxString::Format(_("Playback of %s\n%s UTC, heading %.1f, %.5f %.5f"), m_filename.AfterLast(wxFILE_SEP_PATH).c_str(),
+                          when.ToUTC().FormatISOCombined(' ').c_str(), m_recorded_heading, m_recorded_pos.lat,
+                          m_recorded_pos.lon);
+}
+
+PLUGIN_END_NAMESPACE
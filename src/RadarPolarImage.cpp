@@ -0,0 +1,206 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarPolarImage.h"
+
+#include "RadarInfo.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static uint8_t g_rank_of_colour[BLOB_COLOURS];
+
+RadarPolarImage::RadarPolarImage(RadarInfo *ri, size_t spokes, size_t spoke_len_max) {
+  m_ri = ri;
+  m_spokes = spokes;
+  m_spoke_len_max = spoke_len_max;
+  m_epoch = 0;
+
+  for (int i = 0; i < POLAR_IMAGE_LEVELS; i++) {
+    m_level[i].spokes = wxMax(spokes >> i, 1);
+    m_level[i].spoke_len = wxMax(spoke_len_max >> i, 1);
+    m_level[i].data = (uint8_t *)calloc(m_level[i].spokes, m_level[i].spoke_len);
+    m_level[i].epoch = (uint32_t *)calloc(m_level[i].spokes, sizeof(uint32_t));
+    if (!m_level[i].data || !m_level[i].epoch) {
+      wxLogError(wxT("Out Of Memory, fatal!"));
+      wxAbort();
+    }
+  }
+  for (int i = 0; i < BLOB_COLOURS; i++) {
+    g_rank_of_colour[i] = (uint8_t)PolarImageRank(i);
+  }
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    SetAllChanged(i);
+  }
+}
+
+RadarPolarImage::~RadarPolarImage() {
+  for (int i = 0; i < POLAR_IMAGE_LEVELS; i++) {
+    free(m_level[i].data);
+    free(m_level[i].epoch);
+  }
+}
+
+void RadarPolarImage::Clear() {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  m_epoch++;
+  if (m_epoch == 0) {
+    // A line from 2^32 clears ago would look current, so wipe for real
+    for (int i = 0; i < POLAR_IMAGE_LEVELS; i++) {
+      memset(m_level[i].data, 0, m_level[i].spokes * m_level[i].spoke_len);
+      memset(m_level[i].epoch, 0, m_level[i].spokes * sizeof(uint32_t));
+    }
+  }
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    SetAllChanged(i);
+  }
+}
+
+void RadarPolarImage::SetAllChanged(int reader) {
+  m_start_line[reader] = 0;
+  m_lines[reader] = (int)m_spokes;
+}
+
+void RadarPolarImage::MarkChanged(SpokeBearing angle) {
+  for (int i = 0; i < POLAR_IMAGE_READERS; i++) {
+    if (m_start_line[i] == -1) {
+      m_start_line[i] = angle;  // Note that this only runs once after each upload
+    }
+    if (m_lines[i] < (int)m_spokes) {
+      m_lines[i]++;
+    }
+  }
+}
+
+// Return 'line' of 'level', zeroed first if it was written before the last Clear().
+const uint8_t *RadarPolarImage::CurrentLine(int level, size_t line) {
+  Level &l = m_level[level];
+  uint8_t *d = l.data + line * l.spoke_len;
+
+  if (l.epoch[line] != m_epoch) {
+    memset(d, 0, l.spoke_len);
+    l.epoch[line] = m_epoch;
+  }
+  return d;
+}
+
+// Recompute 'line' of 'level' as the maximum of the 2 x 2 blocks of the level above.
+// When the level above has an odd size the last row or column is folded into the last block.
+void RadarPolarImage::UpdateLevel(int level, size_t line) {
+  const Level &src = m_level[level - 1];
+  Level &dst = m_level[level];
+  size_t first = line * 2;
+  size_t last = (line == dst.spokes - 1) ? src.spokes - 1 : first + 1;
+  uint8_t *d = dst.data + line * dst.spoke_len;
+
+  // First the maximum over the source lines, in the first half of the
+  // destination line's worth of source samples.
+  uint8_t row[SPOKE_LEN_MAX];
+  size_t src_len = wxMin(src.spoke_len, (size_t)SPOKE_LEN_MAX);
+  memcpy(row, CurrentLine(level - 1, first), src_len);
+  for (size_t s = first + 1; s <= last; s++) {
+    const uint8_t *p = CurrentLine(level - 1, s);
+    for (size_t r = 0; r < src_len; r++) {
+      row[r] = wxMax(row[r], p[r]);
+    }
+  }
+
+  for (size_t r = 0; r < dst.spoke_len; r++) {
+    d[r] = wxMax(row[2 * r], row[2 * r + 1]);
+  }
+  if (src_len & 1) {
+    d[dst.spoke_len - 1] = wxMax(d[dst.spoke_len - 1], row[src_len - 1]);
+  }
+  dst.epoch[line] = m_epoch;
+}
+
+void RadarPolarImage::ProcessRadarSpoke(SpokeBearing angle, const SpokeRuns &runs) {
+  const BlobColour *colour_map = m_ri->m_colour_map;
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  uint8_t *d = m_level[0].data + (size_t)angle * m_spoke_len_max;
+  memset(d, 0, m_spoke_len_max);  // rank of BLOB_NONE
+  m_level[0].epoch[angle] = m_epoch;
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    const SpokeRun &run = runs[i];
+    size_t end = wxMin((size_t)run.end, m_spoke_len_max);
+
+    if (run.begin >= end) {
+      break;
+    }
+    memset(d + run.begin, g_rank_of_colour[colour_map[run.value]], end - run.begin);
+  }
+
+  for (int i = 1; i < POLAR_IMAGE_LEVELS; i++) {
+    UpdateLevel(i, wxMin((size_t)angle >> i, m_level[i].spokes - 1));
+  }
+  MarkChanged(angle);
+}
+
+bool RadarPolarImage::GetChangedLines(int reader, int level, int *start_line, int *lines) {
+  if (m_start_line[reader] == -1) {
+    return false;
+  }
+  int start = m_start_line[reader];
+  int n = m_lines[reader];
+  m_start_line[reader] = -1;
+  m_lines[reader] = 0;
+
+  int spokes = (int)m_level[level].spokes;
+  if (n >= (int)m_spokes) {
+    *start_line = 0;
+    *lines = spokes;
+  } else {
+    // Convert the full resolution lines to the lines of this level
+    int first = wxMin(start >> level, spokes - 1);
+    int last = wxMin((int)((start + n - 1) % m_spokes) >> level, spokes - 1);
+    *start_line = first;
+    *lines = (last >= first) ? last - first + 1 : spokes - first + last + 1;
+  }
+
+  for (int i = 0; i < *lines; i++) {
+    CurrentLine(level, (*start_line + i) % spokes);
+  }
+  return true;
+}
+
+int RadarPolarImage::GetLevelForScale(double pixels_per_sample) {
+  int level = 0;
+
+  // Only go down a level while it still has at least one sample per pixel
+  while (level < POLAR_IMAGE_LEVELS - 1 && pixels_per_sample * (2 << level) <= 1.0) {
+    level++;
+  }
+  return level;
+}
+
+PLUGIN_END_NAMESPACE
@@ -0,0 +1,383 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RadarRecorder.h"
+
+#include "RadarInfo.h"
+
+#ifndef __WXMSW__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+PLUGIN_BEGIN_NAMESPACE
+
+static uint8_t *PutVarint(uint8_t *p, size_t value) {
+  while (value >= 0x80) {
+    *p++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *p++ = (uint8_t)value;
+  return p;
+}
+
+// Returns false when the varint does not end before 'end'
+static bool GetVarint(const uint8_t **p, const uint8_t *end, size_t *value) {
+  size_t v = 0;
+
+  for (int shift = 0; *p < end && shift < 28; shift += 7) {
+    uint8_t b = *(*p)++;
+    v |= (size_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      *value = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+RadarRecorder::RadarRecorder(RadarInfo *ri) {
+  m_ri = ri;
+  m_file = 0;
+  m_offset = 0;
+  m_previous_angle = INT_MAX;
+}
+
+RadarRecorder::~RadarRecorder() { Close(); }
+
+bool RadarRecorder::Open(const wxString &filename, size_t spokes, size_t spoke_len_max) {
+  RecordingHeader header;
+
+  Close();
+  m_file = wxFopen(filename, wxT("wb"));
+  if (!m_file) {
+    wxLogError(wxT("radar_pi: cannot create recording %s"), filename.c_str());
+    return false;
+  }
+  setvbuf(m_file, 0, _IOFBF, RECORDING_BUFFER_SIZE);
+
+  CLEAR_STRUCT(header);
+  memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+  header.version = RECORDING_VERSION;
+  header.spokes = (uint32_t)spokes;
+  header.spoke_len_max = (uint32_t)spoke_len_max;
+  if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+    wxLogError(wxT("radar_pi: cannot write recording %s"), filename.c_str());
+    fclose(m_file);
+    m_file = 0;
+    return false;
+  }
+  m_filename = filename;
+  m_offset = sizeof(header);
+  m_previous_angle = INT_MAX;
+  m_index.clear();
+  LOG_INFO(wxT("%s recording to %s"), m_ri->m_name.c_str(), filename.c_str());
+  return true;
+}
+
+void RadarRecorder::AddSpoke(SpokeBearing angle, SpokeBearing bearing, const SpokeRuns &runs, int range_meters, wxLongLong time,
+                             const GeoPosition &pos, double heading) {
+  uint8_t record[RECORDING_MAX_RECORD];
+  uint8_t *p = record + sizeof(RecordedSpoke);
+  RecordedSpoke spoke;
+  size_t end = 0;
+
+  if (!m_file || runs.GetLen() > SPOKE_LEN_MAX) {
+    return;
+  }
+
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    p = PutVarint(p, runs[i].begin - end);
+    p = PutVarint(p, runs[i].end - runs[i].begin - 1);
+    *p++ = runs[i].value;
+    end = runs[i].end;
+  }
+
+  while (heading < 0.) {
+    heading += 360.;
+  }
+  spoke.size = (uint16_t)(p - record);
+  spoke.angle = (uint16_t)angle;
+  spoke.bearing = (uint16_t)bearing;
+  spoke.len = (uint16_t)runs.GetLen();
+  spoke.range_meters = range_meters;
+  spoke.time = time.GetValue();
+  spoke.lat = (int32_t)(pos.lat * 1e7);
+  spoke.lon = (int32_t)(pos.lon * 1e7);
+  spoke.heading = (uint16_t)((int)(heading * 100.) % 36000);
+  spoke.runs = (uint16_t)runs.GetCount();
+  memcpy(record, &spoke, sizeof(spoke));
+
+  if (angle < m_previous_angle) {  // A new revolution starts here
+    RecordingIndex index = {m_offset, spoke.time};
+    m_index.push_back(index);
+  }
+  m_previous_angle = angle;
+
+  if (fwrite(record, spoke.size, 1, m_file) != 1) {
+    LOG_INFO(wxT("%s recording to %s failed, stopped"), m_ri->m_name.c_str(), m_filename.c_str());
+    Close();
+    return;
+  }
+  m_offset += spoke.size;
+}
+
+// Append the index of revolutions and close the file
+void RadarRecorder::Close() {
+  if (!m_file) {
+    return;
+  }
+
+  RecordingTrailer trailer;
+  memcpy(trailer.magic, RECORDING_INDEX_MAGIC, sizeof(trailer.magic));
+  trailer.index_offset = m_offset;
+  trailer.revolutions = m_index.size();
+  if ((m_index.size() && fwrite(&m_index[0], sizeof(RecordingIndex), m_index.size(), m_file) != m_index.size()) ||
+      fwrite(&trailer, sizeof(trailer), 1, m_file) != 1) {
+    LOG_INFO(wxT("%s cannot write index of recording %s"), m_ri->m_name.c_str(), m_filename.c_str());
+  }
+  fclose(m_file);
+  m_file = 0;
+}
+
+RadarRecording::RadarRecording() {
+  CLEAR_STRUCT(m_header);
+  m_data = 0;
+  m_size = 0;
+  m_end = 0;
+  m_offset = 0;
+#ifdef __WXMSW__
+  m_file = INVALID_HANDLE_VALUE;
+  m_mapping = 0;
+#else
+  m_fd = -1;
+#endif
+}
+
+RadarRecording::~RadarRecording() { Close(); }
+
+void RadarRecording::Close() {
+#ifdef __WXMSW__
+  if (m_data) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping) {
+    CloseHandle(m_mapping);
+    m_mapping = 0;
+  }
+  if (m_file != INVALID_HANDLE_VALUE) {
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (m_data) {
+    munmap((void *)m_data, m_size);
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+    m_fd = -1;
+  }
+#endif
+  m_data = 0;
+  m_size = 0;
+  m_end = 0;
+  m_offset = 0;
+  m_index.clear();
+}
+
+bool RadarRecording::Open(const wxString &filename) {
+  Close();
+
+#ifdef __WXMSW__
+  m_file = CreateFileW(filename.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, 0);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size) || size.QuadPart < (LONGLONG)sizeof(RecordingHeader)) {
+    Close();
+    return false;
+  }
+  m_size = (size_t)size.QuadPart;
+  m_mapping = CreateFileMapping(m_file, 0, PAGE_READONLY, 0, 0, 0);
+  if (m_mapping) {
+    m_data = (const uint8_t *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+#else
+  struct stat st;
+
+  m_fd = open(filename.fn_str(), O_RDONLY);
+  if (m_fd < 0) {
+    return false;
+  }
+  if (fstat(m_fd, &st) < 0 || st.st_size < (off_t)sizeof(RecordingHeader)) {
+    Close();
+    return false;
+  }
+  m_size = (size_t)st.st_size;
+  void *data = mmap(0, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data != MAP_FAILED) {
+    m_data = (const uint8_t *)data;
+    madvise(data, m_size, MADV_SEQUENTIAL);
+  }
+#endif
+  if (!m_data) {
+    Close();
+    return false;
+  }
+
+  memcpy(&m_header, m_data, sizeof(m_header));
+  if (memcmp(m_header.magic, RECORDING_MAGIC, sizeof(m_header.magic)) || m_header.version != RECORDING_VERSION ||
+      m_header.spoke_len_max > SPOKE_LEN_MAX) {
+    Close();
+    return false;
+  }
+  if (!ReadIndex()) {
+    BuildIndex();
+  }
+  m_offset = sizeof(RecordingHeader);
+  return true;
+}
+
+bool RadarRecording::ReadIndex() {
+  RecordingTrailer trailer;
+
+  if (m_size < sizeof(RecordingHeader) + sizeof(trailer)) {
+    return false;
+  }
+  memcpy(&trailer, m_data + m_size - sizeof(trailer), sizeof(trailer));
+  if (memcmp(trailer.magic, RECORDING_INDEX_MAGIC, sizeof(trailer.magic)) || trailer.index_offset < sizeof(RecordingHeader) ||
+      trailer.index_offset > m_size - sizeof(trailer) ||
+      trailer.revolutions != (m_size - sizeof(trailer) - trailer.index_offset) / sizeof(RecordingIndex)) {
+    return false;
+  }
+  m_end = (size_t)trailer.index_offset;
+  m_index.resize((size_t)trailer.revolutions);
+  if (trailer.revolutions) {
+    memcpy(&m_index[0], m_data + m_end, m_index.size() * sizeof(RecordingIndex));
+  }
+  return true;
+}
+
+// The recording was not closed, so find the revolutions and the last complete spoke
+void RadarRecording::BuildIndex() {
+  RecordedSpoke spoke;
+  size_t offset = sizeof(RecordingHeader);
+  int previous_angle = INT_MAX;
+
+  m_end = m_size;
+  m_index.clear();
+  while (offset + sizeof(spoke) <= m_size) {
+    memcpy(&spoke, m_data + offset, sizeof(spoke));
+    if (spoke.size < sizeof(spoke) || offset + spoke.size > m_size) {
+      break;
+    }
+    if (spoke.angle < previous_angle) {
+      RecordingIndex index = {offset, spoke.time};
+      m_index.push_back(index);
+    }
+    previous_angle = spoke.angle;
+    offset += spoke.size;
+  }
+  m_end = offset;
+  LOG_INFO(wxT("radar_pi: recording without index, found %u revolutions"), (unsigned)m_index.size());
+}
+
+wxLongLong RadarRecording::GetStartTime() { return m_index.empty() ? wxLongLong(0) : wxLongLong(m_index[0].time); }
+
+void RadarRecording::SeekRevolution(size_t revolution) {
+  if (revolution < m_index.size()) {
+    m_offset = (size_t)m_index[revolution].offset;
+  }
+}
+
+void RadarRecording::Seek(wxLongLong time) {
+  size_t lo = 0;
+  size_t hi = m_index.size();
+
+  // Find the last revolution that starts at or before 'time'
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (m_index[mid].time <= time.GetValue()) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  SeekRevolution(lo > 0 ? lo - 1 : 0);
+}
+
+// Returns the offset of the next spoke, or 0 when the record is invalid
+size_t RadarRecording::DecodeSpoke(size_t offset, RecordedSpoke *spoke, SpokeRuns *runs) {
+  if (offset + sizeof(RecordedSpoke) > m_end) {
+    return 0;
+  }
+  memcpy(spoke, m_data + offset, sizeof(RecordedSpoke));
+  if (spoke->size < sizeof(RecordedSpoke) || offset + spoke->size > m_end || spoke->len > m_header.spoke_len_max) {
+    return 0;
+  }
+
+  const uint8_t *p = m_data + offset + sizeof(RecordedSpoke);
+  const uint8_t *end = m_data + offset + spoke->size;
+  size_t r = 0;
+
+  runs->Clear(spoke->len);
+  for (size_t i = 0; i < spoke->runs; i++) {
+    size_t gap, length;
+
+    if (!GetVarint(&p, end, &gap) || !GetVarint(&p, end, &length) || p >= end) {
+      return 0;
+    }
+    runs->Add(r + gap, length + 1, *p++);
+    r += gap + length + 1;
+  }
+  return offset + spoke->size;
+}
+
+bool RadarRecording::NextSpoke(RecordedSpoke *spoke, SpokeRuns *runs) {
+  if (!m_data || m_offset >= m_end) {
+    return false;
+  }
+  size_t next = DecodeSpoke(m_offset, spoke, runs);
+  if (!next) {
+    LOG_INFO(wxT("radar_pi: invalid spoke in recording at offset %u"), (unsigned)m_offset);
+    m_offset = m_end;
+    return false;
+  }
+  m_offset = next;
+  return true;
+}
+
+PLUGIN_END_NAMESPACE
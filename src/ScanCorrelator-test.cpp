@@ -0,0 +1,179 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Feeds the ScanCorrelator made up revolutions with a single echo and
+ * checks the N-of-M rule: echoes that are seen often enough pass, the
+ * ones that are not or that came too long ago do not, a one sample jitter
+ * is allowed also across the boundary of the 64-bit words, and a bearing
+ * that is written twice in one revolution counts once. Build it against
+ * the plugin headers and wxWidgets, like Kalman-test.cpp, e.g.
+ *
+ *   c++ -O2 -Iinclude `wx-config --cxxflags` -o ScanCorrelator-test \
+ *     src/ScanCorrelator-test.cpp src/ScanCorrelator.cpp src/spokeutil.cpp `wx-config --libs`
+ */
+
+#include "ScanCorrelator.h"
+
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define SPOKES (16)
+#define LEN (200)
+#define REVOLUTIONS (4)
+#define HITS (3)
+#define ECHO_BEARING (5)
+#define NONE (-1)
+
+static int Expect(const char *what, long actual, long expected) {
+  if (actual != expected) {
+    cout << "ERROR: " << what << " is " << actual << ", expected " << expected << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Run one revolution with an echo at 'sample' on ECHO_BEARING, or none. When
+ * 'turn' is set the boat turns while the radar passes ECHO_BEARING, so the next
+ * spoke is written to ECHO_BEARING as well (with the same echo).
+ * Return whether the echo passed the last time ECHO_BEARING was written.
+ */
+static long Revolution(ScanCorrelator &correlator, long sample, bool turn = false) {
+  SpokeRuns runs;
+  SpokeRuns persistent;
+  long passed = 0;
+
+  for (SpokeBearing angle = 0; angle < SPOKES; angle++) {
+    SpokeBearing bearing = angle;
+
+    if (turn && angle == ECHO_BEARING + 1) {
+      bearing = ECHO_BEARING;
+    }
+    runs.Clear(LEN);
+    if (bearing == ECHO_BEARING && sample != NONE) {
+      runs.Add((size_t)sample, 1, 200);
+    }
+    correlator.Correlate(angle, bearing, runs, &persistent);
+    if (bearing == ECHO_BEARING && sample != NONE) {
+      passed = persistent.CountAbove((size_t)sample, (size_t)sample + 1, 1);
+    }
+  }
+  return passed;
+}
+
+static int TestHits() {
+  ScanCorrelator correlator(SPOKES, LEN, REVOLUTIONS, HITS);
+  int ret = 0;
+
+  ret |= Expect("first revolution", Revolution(correlator, 100), 0);
+  ret |= Expect("second revolution", Revolution(correlator, 100), 0);
+  ret |= Expect("third revolution", Revolution(correlator, 100), 1);
+  ret |= Expect("after a miss", Revolution(correlator, NONE), 0);
+  ret |= Expect("two of the three earlier", Revolution(correlator, 100), 1);
+  ret |= Expect("one of the three earlier", Revolution(correlator, 150), 0);
+
+  // Three of the last four, but the first one was longer ago
+  correlator.Clear();
+  ret |= Expect("after clear", Revolution(correlator, 100), 0);
+  Revolution(correlator, 100);
+  Revolution(correlator, NONE);
+  Revolution(correlator, NONE);
+  ret |= Expect("three of five", Revolution(correlator, 100), 0);
+  return ret;
+}
+
+static int TestJitter() {
+  ScanCorrelator correlator(SPOKES, LEN, REVOLUTIONS, HITS);
+  int ret = 0;
+
+  Revolution(correlator, 100);
+  Revolution(correlator, 101);
+  ret |= Expect("one sample jitter", Revolution(correlator, 100), 1);
+  ret |= Expect("one sample jitter back", Revolution(correlator, 99), 1);
+
+  correlator.Clear();
+  Revolution(correlator, 100);
+  Revolution(correlator, 102);
+  ret |= Expect("two sample drift", Revolution(correlator, 104), 0);
+
+  // Across the boundary of the first and second word
+  correlator.Clear();
+  Revolution(correlator, 63);
+  Revolution(correlator, 64);
+  ret |= Expect("jitter down across a word", Revolution(correlator, 63), 1);
+  correlator.Clear();
+  Revolution(correlator, 64);
+  Revolution(correlator, 63);
+  ret |= Expect("jitter up across a word", Revolution(correlator, 64), 1);
+  correlator.Clear();
+  Revolution(correlator, 62);
+  Revolution(correlator, 65);
+  ret |= Expect("no match across a word", Revolution(correlator, 64), 0);
+  correlator.Clear();
+  Revolution(correlator, 127);
+  Revolution(correlator, 128);
+  ret |= Expect("jitter across the second word", Revolution(correlator, 128), 1);
+  return ret;
+}
+
+static int TestTurning() {
+  ScanCorrelator correlator(SPOKES, LEN, REVOLUTIONS, HITS);
+  int ret = 0;
+
+  // Clutter seen in two revolutions, the first of which wrote the bearing twice
+  ret |= Expect("written twice", Revolution(correlator, 100, true), 0);
+  ret |= Expect("two revolutions with a turn", Revolution(correlator, 100), 0);
+  ret |= Expect("three revolutions with a turn", Revolution(correlator, 100), 1);
+
+  // Both writes in one revolution count as that revolution
+  correlator.Clear();
+  Revolution(correlator, 100);
+  Revolution(correlator, 100);
+  ret |= Expect("turn in the third revolution", Revolution(correlator, 100, true), 1);
+  return ret;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestHits();
+  ret |= TestJitter();
+  ret |= TestTurning();
+  cout << (ret ? "FAILED\n" : "OK\n");
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
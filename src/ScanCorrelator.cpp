@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "ScanCorrelator.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+ScanCorrelator::ScanCorrelator(size_t spokes, size_t spoke_len_max, int revolutions, int hits) {
+  revolutions = wxMax(wxMin(revolutions, SCAN_CORRELATOR_REVOLUTIONS_MAX), 1);
+  hits = wxMax(wxMin(hits, revolutions), 1);
+
+  m_spokes = (int)spokes;
+  m_spoke_len_max = spoke_len_max;
+  m_words = (spoke_len_max + HISTORY_WORD_BITS - 1) / HISTORY_WORD_BITS;
+  m_planes = revolutions - 1;
+  m_hits = hits - 1;
+  m_data = (uint64_t *)calloc(sizeof(uint64_t), spokes * wxMax(m_planes, 1) * m_words);
+  m_oldest = (uint8_t *)calloc(sizeof(uint8_t), spokes);
+  m_epoch = 1;  // and every spoke was written in epoch 0, so reads as empty
+  m_spoke_epoch = (uint32_t *)calloc(sizeof(uint32_t), spokes);
+  m_last_angle = 0;
+  m_revolution = 0;
+  m_spoke_revolution = (uint32_t *)calloc(sizeof(uint32_t), spokes);
+  m_current.resize(m_words);
+  m_persistent.resize(m_words);
+
+  if (!m_data || !m_oldest || !m_spoke_epoch || !m_spoke_revolution) {
+    wxLogError(wxT("Out Of Memory, fatal!"));
+    wxAbort();
+  }
+}
+
+ScanCorrelator::~ScanCorrelator() {
+  free(m_data);
+  free(m_oldest);
+  free(m_spoke_epoch);
+  free(m_spoke_revolution);
+}
+
+void ScanCorrelator::Clear() {
+  m_epoch++;
+  if (m_epoch == 0) {
+    memset(m_spoke_epoch, 0, m_spokes * sizeof(uint32_t));
+    m_epoch = 1;
+  }
+}
+
+void ScanCorrelator::Correlate(SpokeBearing angle, SpokeBearing bearing, const SpokeRuns &runs, SpokeRuns *persistent) {
+  uint64_t *current = &m_current[0];
+  uint64_t *pass = &m_persistent[0];
+
+  if (angle < m_last_angle) {
+    m_revolution++;
+  }
+  m_last_angle = angle;
+
+  memset(current, 0, m_words * sizeof(uint64_t));
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    size_t end = wxMin((size_t)runs[i].end, m_spoke_len_max);
+
+    if (runs[i].begin >= end) {
+      break;
+    }
+    HistorySetBits(current, runs[i].begin, end);
+  }
+
+  if (m_spoke_epoch[bearing] != m_epoch) {
+    memset(Plane(bearing, 0), 0, m_planes * m_words * sizeof(uint64_t));
+    m_oldest[bearing] = 0;
+    m_spoke_epoch[bearing] = m_epoch;
+    m_spoke_revolution[bearing] = m_revolution - 1;
+  }
+
+  // The plane written last. When that was in this revolution (the boat turned
+  // back onto this bearing) it is not an earlier revolution, so it is skipped.
+  int latest = m_planes > 0 ? (m_oldest[bearing] + m_planes - 1) % m_planes : 0;
+  bool again = m_planes > 0 && m_spoke_revolution[bearing] == m_revolution;
+  m_spoke_revolution[bearing] = m_revolution;
+
+  // A bit-sliced count: bit b of seen[k] is set when sample b had a return
+  // in at least k of the earlier revolutions, for k up to m_hits.
+  for (size_t w = 0; w < m_words; w++) {
+    uint64_t seen[SCAN_CORRELATOR_REVOLUTIONS_MAX];
+
+    seen[0] = ~(uint64_t)0;
+    for (int k = 1; k <= m_hits; k++) {
+      seen[k] = 0;
+    }
+    for (int p = 0, n = 0; p < m_planes && current[w]; p++) {
+      if (again && p == latest) {
+        continue;
+      }
+      const uint64_t *plane = Plane(bearing, p);
+      uint64_t here = plane[w];
+      uint64_t wide = here | (here << 1) | (here >> 1);
+
+      if (w > 0) {
+        wide |= plane[w - 1] >> (HISTORY_WORD_BITS - 1);
+      }
+      if (w + 1 < m_words) {
+        wide |= plane[w + 1] << (HISTORY_WORD_BITS - 1);
+      }
+      n++;
+      for (int k = wxMin(n, m_hits); k > 0; k--) {
+        seen[k] |= seen[k - 1] & wide;
+      }
+    }
+    pass[w] = current[w] & seen[m_hits];
+  }
+
+  // This revolution replaces the oldest one, or adds to what it already has
+  if (again) {
+    uint64_t *plane = Plane(bearing, latest);
+    for (size_t w = 0; w < m_words; w++) {
+      plane[w] |= current[w];
+    }
+  } else if (m_planes > 0) {
+    memcpy(Plane(bearing, m_oldest[bearing]), current, m_words * sizeof(uint64_t));
+    m_oldest[bearing] = (uint8_t)((m_oldest[bearing] + 1) % m_planes);
+  }
+
+  // Split the runs where samples did not pass
+  persistent->Clear(runs.GetLen());
+  for (size_t i = 0; i < runs.GetCount(); i++) {
+    const SpokeRun &run = runs[i];
+    size_t end = wxMin((size_t)run.end, m_spoke_len_max);
+    size_t begin = run.begin;
+
+    while (begin < end) {
+      while (begin < end && !((pass[begin / HISTORY_WORD_BITS] >> (begin % HISTORY_WORD_BITS)) & 1)) {
+        begin++;
+      }
+      size_t r = begin;
+      while (r < end && ((pass[r / HISTORY_WORD_BITS] >> (r % HISTORY_WORD_BITS)) & 1)) {
+        r++;
+      }
+      persistent->Add(begin, r - begin, run.value);
+      begin = r;
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
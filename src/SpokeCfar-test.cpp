@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Checks the SpokeCfar clutter filter on made up spokes: where its guard
+ * gap and windows begin and end on both sides of a sample, the ends of the
+ * spoke, a target in open water and in sea clutter, and the edge of a
+ * clutter patch. Build it against the plugin headers and wxWidgets, like
+ * Kalman-test.cpp, e.g.
+ *
+ *   c++ -O2 -Iinclude `wx-config --cxxflags` -o SpokeCfar-test \
+ *     src/SpokeCfar-test.cpp src/spokeutil.cpp `wx-config --libs`
+ */
+
+#include "spokeutil.h"
+
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define LEN (256)
+#define WINDOW (8)
+#define GUARD (2)
+#define SCALE (32)  // Twice the mean
+
+// Return the number of samples in data[0..LEN> that are >= threshold
+static long CountAbove(const uint8_t *data, uint8_t threshold) {
+  SpokeRuns runs;
+
+  runs.SetSamples(data, LEN);
+  return (long)runs.CountAbove(0, LEN, threshold);
+}
+
+static int Expect(const char *what, long actual, long expected) {
+  if (actual != expected) {
+    cout << "ERROR: " << what << " is " << actual << ", expected " << expected << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+// Return what is left of a weak target at 'target' with a strong echo 'distance' samples away
+static int Neighbour(size_t target, long distance) {
+  SpokeCfar cfar;
+  uint8_t data[LEN];
+
+  cfar.Configure(WINDOW, GUARD, SCALE);
+  memset(data, 0, sizeof(data));
+  data[target] = 20;
+  data[target + distance] = 100;  // Raises the threshold to 100 * 2 / WINDOW = 25 when in a window
+  cfar.Apply(data, LEN);
+  return data[target];
+}
+
+static int TestWindowEdges() {
+  int ret = 0;
+
+  // The samples right next to the target are in the guard gap
+  ret |= Expect("echo at the guard after", Neighbour(100, GUARD), 20);
+  ret |= Expect("echo at the guard before", Neighbour(100, -GUARD), 20);
+  // The first samples beyond the gap are in the windows
+  ret |= Expect("echo at the window start after", Neighbour(100, GUARD + 1), 0);
+  ret |= Expect("echo at the window start before", Neighbour(100, -(GUARD + 1)), 0);
+  // As are the last ones
+  ret |= Expect("echo at the window end after", Neighbour(100, GUARD + WINDOW), 0);
+  ret |= Expect("echo at the window end before", Neighbour(100, -(GUARD + WINDOW)), 0);
+  // And the ones beyond are not
+  ret |= Expect("echo beyond the window after", Neighbour(100, GUARD + WINDOW + 1), 20);
+  ret |= Expect("echo beyond the window before", Neighbour(100, -(GUARD + WINDOW + 1)), 20);
+
+  // At the ends of the spoke only one window exists
+  ret |= Expect("first sample, echo in the window", Neighbour(0, GUARD + 1), 0);
+  ret |= Expect("last sample, echo in the window", Neighbour(LEN - 1, -(GUARD + 1)), 0);
+  ret |= Expect("first sample, echo beyond the window", Neighbour(0, GUARD + WINDOW + 1), 20);
+  ret |= Expect("last sample, echo beyond the window", Neighbour(LEN - 1, -(GUARD + WINDOW + 1)), 20);
+  return ret;
+}
+
+static int TestTargets() {
+  SpokeCfar cfar;
+  uint8_t data[LEN];
+  int ret = 0;
+
+  cfar.Configure(WINDOW, GUARD, SCALE);
+
+  // Open water: the threshold is zero, so even a weak target stays
+  memset(data, 0, sizeof(data));
+  data[100] = 10;
+  data[180] = 200;
+  cfar.Apply(data, LEN);
+  ret |= Expect("weak target in open water", data[100], 10);
+  ret |= Expect("strong target in open water", data[180], 200);
+
+  // Sea clutter of 60 on [50..150> gives a threshold of 120 inside it
+  memset(data, 0, sizeof(data));
+  memset(data + 50, 60, 100);
+  data[80] = 100;
+  data[120] = 200;
+  cfar.Apply(data, LEN);
+  ret |= Expect("clutter left", CountAbove(data, 1), 1);
+  ret |= Expect("weak target in clutter", data[80], 0);
+  ret |= Expect("strong target in clutter", data[120], 200);
+
+  // The edges of a clutter patch see open water on one side only, the greater mean removes them
+  memset(data, 0, sizeof(data));
+  memset(data + 50, 60, 100);
+  cfar.Apply(data, LEN);
+  ret |= Expect("clutter patch start", data[50], 0);
+  ret |= Expect("clutter patch end", data[149], 0);
+
+  // A spoke shorter than both windows is left alone
+  memset(data, 60, sizeof(data));
+  cfar.Apply(data, 2 * (GUARD + WINDOW));
+  ret |= Expect("short spoke", CountAbove(data, 60), LEN);
+  return ret;
+}
+
+int main() {
+  int ret = 0;
+
+  ret |= TestWindowEdges();
+  ret |= TestTargets();
+  cout << (ret ? "FAILED\n" : "OK\n");
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
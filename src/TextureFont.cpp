@@ -25,14 +25,32 @@
 
 #include "TextureFont.h"
 
+#include <map>
+
 PLUGIN_BEGIN_NAMESPACE
 
-void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
-  /* avoid rebuilding if the parameters are the same */
-  if (font == m_font && blur == m_blur) return;
+static wxString GetGlyphText(int i) {
+  if (i == DEGREE_GLYPH) {
+    return wxString::Format(_T("%c"), 0x00B0);  //_T("°");
+  }
+  return wxString::Format(_T("%c"), i);
+}
 
-  m_font = font;
-  m_blur = blur;
+static std::map<wxString, TextureFontAtlas *> atlases;
+
+/*
+ * Return the atlas for 'key', drawing the glyphs the first time a font is seen.
+ * Atlases are kept until the plugin is unloaded (see FreeAtlases); only a handful
+ * of fonts are ever used, and a font that changes back (DPI or setting toggled) is free.
+ */
+TextureFontAtlas *TextureFont::GetAtlas(const wxString &key, wxFont &font, bool blur) {
+  std::map<wxString, TextureFontAtlas *>::iterator it = atlases.find(key);
+  if (it != atlases.end()) {
+    return it->second;
+  }
+
+  TextureFontAtlas *atlas = new TextureFontAtlas;
+  TexGlyphInfo *tgi = atlas->tgi;
 
   wxBitmap bmp(256, 256);
   wxMemoryDC dc(bmp);
@@ -42,18 +60,14 @@ void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
   int maxglyphw = 0, maxglyphh = 0;
   for (int i = MIN_GLYPH; i < MAX_GLYPH; i++) {
     wxCoord gw, gh;
-    wxString text;
-    if (i == DEGREE_GLYPH)
-      text = wxString::Format(_T("%c"), 0x00B0);  //_T("°");
-    else
-      text = wxString::Format(_T("%c"), i);
+    wxString text = GetGlyphText(i);
     wxCoord descent, exlead;
     dc.GetTextExtent(text, &gw, &gh, &descent, &exlead, &font);  // measure the text
 
-    m_tgi[i].width = gw;
-    m_tgi[i].height = gh;
+    tgi[i].width = gw;
+    tgi[i].height = gh;
 
-    m_tgi[i].advance = gw;
+    tgi[i].advance = gw;
 
     maxglyphw = wxMax(gw, maxglyphw);
     maxglyphh = wxMax(gh, maxglyphh);
@@ -70,12 +84,12 @@ void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
   wxASSERT(w < 2048 && h < 2048);
 
   /* make power of 2 */
-  for (tex_w = 1; tex_w < w; tex_w *= 2)
+  for (atlas->tex_w = 1; atlas->tex_w < w; atlas->tex_w *= 2)
     ;
-  for (tex_h = 1; tex_h < h; tex_h *= 2)
+  for (atlas->tex_h = 1; atlas->tex_h < h; atlas->tex_h *= 2)
     ;
 
-  wxBitmap tbmp(tex_w, tex_h);
+  wxBitmap tbmp(atlas->tex_w, atlas->tex_h);
   dc.SelectObject(tbmp);
 
   /* fill bitmap with black */
@@ -92,21 +106,59 @@ void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
       row++;
     }
 
-    m_tgi[i].x = col * maxglyphw;
-    m_tgi[i].y = row * maxglyphh;
-
-    wxString text;
-    if (i == DEGREE_GLYPH)
-      text = wxString::Format(_T("%c"), 0x00B0);  //_T("°");
-    else
-      text = wxString::Format(_T("%c"), i);
+    tgi[i].x = col * maxglyphw;
+    tgi[i].y = row * maxglyphh;
 
-    dc.DrawText(text, m_tgi[i].x, m_tgi[i].y);
+    dc.DrawText(GetGlyphText(i), tgi[i].x, tgi[i].y);
     col++;
   }
 
   wxImage image = tbmp.ConvertToImage();
 
+  if (blur) image = image.Blur(1);
+
+  unsigned char *imgdata = image.GetData();
+  size_t texels = atlas->tex_w * atlas->tex_h;
+  atlas->alpha = (unsigned char *)calloc(texels, 1);
+  if (!atlas->alpha) {
+    wxLogError(wxT("Out Of Memory, fatal!"));
+    wxAbort();
+  }
+  if (imgdata) {
+    for (size_t j = 0; j < texels; j++) atlas->alpha[j] = imgdata[3 * j];
+  }
+
+  atlases[key] = atlas;
+  return atlas;
+}
+
+/*
+ * Called from DeInit after all canvases are gone, as the fonts point into the atlases.
+ */
+void TextureFont::FreeAtlases() {
+  for (std::map<wxString, TextureFontAtlas *>::iterator it = atlases.begin(); it != atlases.end(); it++) {
+    free(it->second->alpha);
+    delete it->second;
+  }
+  atlases.clear();
+}
+
+void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
+  /* avoid rebuilding if the parameters are the same */
+  wxString key = wxString::Format(wxT("%s/%d/%d/%d/%d/%d/%d"), font.GetFaceName().c_str(), (int)font.GetFamily(),
+                                  font.GetPointSize(), (int)font.GetWeight(), (int)font.GetStyle(), (int)font.GetUnderlined(),
+                                  (int)blur);
+  if (m_texobj && key == m_key && luminance == m_luminance) return;
+
+  m_font = font;
+  m_key = key;
+  m_blur = blur;
+  m_luminance = luminance;
+  m_atlas = GetAtlas(key, font, blur);
+  m_tgi = m_atlas->tgi;
+  tex_w = m_atlas->tex_w;
+  tex_h = m_atlas->tex_h;
+
   GLuint format, internalformat;
   int stride;
 
@@ -120,14 +172,11 @@ void TextureFont::Build(wxFont &font, bool blur, bool luminance) {
 
   internalformat = format;
 
-  if (m_blur) image = image.Blur(1);
-
-  unsigned char *imgdata = image.GetData();
   unsigned char *teximage = (unsigned char *)malloc(stride * tex_w * tex_h);
 
-  if (teximage && imgdata) {
+  if (teximage) {
     for (int j = 0; j < tex_w * tex_h; j++)
-      for (int k = 0; k < stride; k++) teximage[j * stride + k] = imgdata[3 * j];
+      for (int k = 0; k < stride; k++) teximage[j * stride + k] = m_atlas->alpha[j];
   }
   if (m_texobj) Delete();
 
@@ -152,6 +201,12 @@ void TextureFont::Delete() {
 void TextureFont::GetTextExtent(const wxString &string, int *width, int *height) {
   int w0 = 0, w1 = 0, h = 0;
 
+  if (!m_atlas) {
+    if (width) *width = 0;
+    if (height) *height = 0;
+    return;
+  }
+
   for (unsigned int i = 0; i < string.size(); i++) {
     wchar_t c = string[i];
     if (c == '\n') {
@@ -174,7 +229,7 @@ void TextureFont::GetTextExtent(const wxString &string, int *width, int *height)
       continue;
     }
 
-    TexGlyphInfo &tgisi = m_tgi[c];
+    const TexGlyphInfo &tgisi = m_tgi[c];
 
     w0 += tgisi.advance;
     if (h < tgisi.height) h = tgisi.height;
@@ -183,96 +238,90 @@ void TextureFont::GetTextExtent(const wxString &string, int *width, int *height)
   if (height) *height = h;
 }
 
-void TextureFont::RenderGlyph(wchar_t c) {
-  /* degree symbol */
-  if (c == 0x00B0)
-    c = DEGREE_GLYPH;
-  else if (c < MIN_GLYPH || c >= MAX_GLYPH) {
-    // outside font, render with draw pixels (slow)
-    wxMemoryDC dc;
-    dc.SetFont(m_font);
-    wxCoord gw, gh;
-    dc.GetTextExtent(c, &gw, &gh);  // measure the text
-    int w, h;
-    for (w = 1; w < gw; w *= 2)
-      ;
-    for (h = 1; h < gh; h *= 2)
-      ;
-    wxBitmap bmp(w, h);
-    dc.SelectObject(bmp);
-    dc.SetBackground(wxBrush(wxColour(0, 0, 0)));
-    dc.Clear();
-    /* draw the text white */
-    dc.SetTextForeground(wxColour(255, 255, 255));
-    dc.DrawText(c, 0, 0);
-    wxImage image = bmp.ConvertToImage();
-    if (m_blur) {
-      image = image.Blur(1);
-    }
-    unsigned char *imgdata = image.GetData();
-    if (!imgdata) {
-      return;
-    }
-    char *data = new char[w * h * 2];
-    if (!data) {
-      return;
-    }
-
-    for (int i = 0; i < w * h; i++) {
-      data[2 * i + 0] = imgdata[3 * i];  // Luminance
-      data[2 * i + 1] = imgdata[3 * i];  // Alpha
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, w, h, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, data);
-    float u = (float)gw / w, v = (float)gh / h;
-    glBegin(GL_QUADS);
-    glTexCoord2f(0, 0);
-    glVertex2i(0, 0);
-    glTexCoord2f(u, 0);
-    glVertex2i(gw, 0);
-    glTexCoord2f(u, v);
-    glVertex2i(gw, gh);
-    glTexCoord2f(0, v);
-    glVertex2i(0, gh);
-    glEnd();
-
-    glBindTexture(GL_TEXTURE_2D, m_texobj);
-    delete[] data;
-
-    glTranslatef(gw, 0.0, 0.0);
-    return;
+// Render a glyph that is not in the atlas at the current origin, return its advance
+float TextureFont::RenderGlyph(wchar_t c) {
+  // outside font, render with draw pixels (slow)
+  wxMemoryDC dc;
+  dc.SetFont(m_font);
+  wxCoord gw, gh;
+  dc.GetTextExtent(c, &gw, &gh);  // measure the text
+  int w, h;
+  for (w = 1; w < gw; w *= 2)
+    ;
+  for (h = 1; h < gh; h *= 2)
+    ;
+  wxBitmap bmp(w, h);
+  dc.SelectObject(bmp);
+  dc.SetBackground(wxBrush(wxColour(0, 0, 0)));
+  dc.Clear();
+  /* draw the text white */
+  dc.SetTextForeground(wxColour(255, 255, 255));
+  dc.DrawText(c, 0, 0);
+  wxImage image = bmp.ConvertToImage();
+  if (m_blur) {
+    image = image.Blur(1);
+  }
+  unsigned char *imgdata = image.GetData();
+  if (!imgdata) {
+    return gw;
+  }
+  char *data = new char[w * h * 2];
+  if (!data) {
+    return gw;
   }
 
-  TexGlyphInfo &tgic = m_tgi[c];
-
-  int x = tgic.x, y = tgic.y;
-  float w = tgic.width, h = tgic.height;
-  float tx1 = (float)x / tex_w;
-  float tx2 = (float)(x + w) / tex_w;
-  float ty1 = (float)y / tex_h;
-  float ty2 = (float)(y + h) / tex_h;
+  for (int i = 0; i < w * h; i++) {
+    data[2 * i + 0] = imgdata[3 * i];  // Luminance
+    data[2 * i + 1] = imgdata[3 * i];  // Alpha
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, w, h, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, data);
+  float u = (float)gw / w, v = (float)gh / h;
   glBegin(GL_QUADS);
-
-  glTexCoord2f(tx1, ty1);
+  glTexCoord2f(0, 0);
   glVertex2i(0, 0);
-  glTexCoord2f(tx2, ty1);
-  glVertex2i(w, 0);
-  glTexCoord2f(tx2, ty2);
-  glVertex2i(w, h);
-  glTexCoord2f(tx1, ty2);
-  glVertex2i(0, h);
-
+  glTexCoord2f(u, 0);
+  glVertex2i(gw, 0);
+  glTexCoord2f(u, v);
+  glVertex2i(gw, gh);
+  glTexCoord2f(0, v);
+  glVertex2i(0, gh);
   glEnd();
-  glTranslatef(tgic.advance, 0.0, 0.0);
+
+  glBindTexture(GL_TEXTURE_2D, m_texobj);
+  delete[] data;
+
+  return gw;
 }
 
+void TextureFont::FlushQuads() {
+  if (m_quads.empty()) {
+    return;
+  }
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), &m_quads[0]);
+  glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), &m_quads[2]);
+  glDrawArrays(GL_QUADS, 0, (GLsizei)(m_quads.size() / 4));
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  m_quads.clear();
+}
+
+/*
+ * All glyphs of the string that are in the atlas are collected into one quad array
+ * and drawn with a single call. Glyphs outside the atlas are rare and drawn one by one.
+ */
 void TextureFont::RenderString(const wxString &string, int x, int y) {
+  if (!m_atlas) {
+    return;
+  }
+
   glPushMatrix();
   glTranslatef(x, y, 0);
 
@@ -281,21 +330,45 @@ void TextureFont::RenderString(const wxString &string, int x, int y) {
   glBindTexture(GL_TEXTURE_2D, m_texobj);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glPushMatrix();
+
+  float pen_x = 0, pen_y = 0;
 
   for (unsigned int i = 0; i < string.size(); i++) {
-    wchar_t x = string[i];
+    wchar_t c = string[i];
 
-    if (x == '\n') {
-      glPopMatrix();
-      glTranslatef(0, m_tgi[(int)'A'].height, 0);
+    if (c == '\n') {
+      pen_x = 0;
+      pen_y += m_tgi[(int)'A'].height;
+      continue;
+    }
+    if (c == 0x00B0) {
+      c = DEGREE_GLYPH;
+    } else if (c < MIN_GLYPH || c >= MAX_GLYPH) {
+      FlushQuads();
       glPushMatrix();
+      glTranslatef(pen_x, pen_y, 0);
+      pen_x += RenderGlyph(c);
+      glPopMatrix();
       continue;
     }
-    RenderGlyph(x);
+
+    const TexGlyphInfo &tgic = m_tgi[c];
+
+    float w = tgic.width, h = tgic.height;
+    float tx1 = (float)tgic.x / tex_w;
+    float tx2 = (float)(tgic.x + w) / tex_w;
+    float ty1 = (float)tgic.y / tex_h;
+    float ty2 = (float)(tgic.y + h) / tex_h;
+
+    const float quad[] = {tx1, ty1, pen_x,     pen_y,      //
+                          tx2, ty1, pen_x + w, pen_y,      //
+                          tx2, ty2, pen_x + w, pen_y + h,  //
+                          tx1, ty2, pen_x,     pen_y + h};
+    m_quads.insert(m_quads.end(), quad, quad + ARRAY_SIZE(quad));
+    pen_x += tgic.advance;
   }
+  FlushQuads();
 
-  glPopMatrix();
   glPopAttrib();
   glPopMatrix();
 }
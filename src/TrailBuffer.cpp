@@ -82,9 +82,10 @@ void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t l
     uint8_t weak_target = M_SETTINGS.threshold_blue;
     uint8_t strong_target = M_SETTINGS.threshold_red;
     size_t radius = 0;
+    SpokeDirection direction = m_ri->m_polar_lookup->GetDirection(bearing);
 
     for (; radius < len - 1; radius++) {  //  len - 1 : no trails on range circle
-      PointInt point = m_ri->m_polar_lookup->GetPointInt(bearing, radius);
+      PointInt point = PolarToCartesianLookup::GetPointInt(direction, radius);
 
       point.x += m_trail_size / 2 + m_offset.lat;
       point.y += m_trail_size / 2 + m_offset.lon;
@@ -109,7 +110,7 @@ void TrailBuffer::UpdateTrueTrails(SpokeBearing bearing, uint8_t *data, size_t l
     // This will only be called when the current spoke length is smaller than the max.
     // we need to update the trail 'age' for those points.
     for (; radius < m_ri->m_spoke_len_max; radius++) {
-      PointInt point = m_ri->m_polar_lookup->GetPointInt(bearing, radius);
+      PointInt point = PolarToCartesianLookup::GetPointInt(direction, radius);
 
       point.x += m_trail_size / 2 + m_offset.lat;
       point.y += m_trail_size / 2 + m_offset.lon;
@@ -256,7 +257,7 @@ void TrailBuffer::UpdateTrailPosition() {
     ZoomTrails(zoom_factor);
   }
 
-  if (!m_ri->GetRadarPosition(&radar) || m_ri->m_pi->GetHeadingSource() == HEADING_NONE) {
+  if (!m_ri->GetRadarPosition(&radar) || m_ri->GetHeadingSource() == HEADING_NONE) {
     return;
   }
 
@@ -32,10 +32,11 @@
 #include "drawutil.h"
 
 #include "radar_pi.h"
+#include "shaderutil.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
-static void draw_blob_gl(double ca, double sa, double radius, double arc_width, double blob_heigth) {
+static void add_blob(vector<float> &v, double ca, double sa, double radius, double arc_width, double blob_heigth) {
   const double blob_start = 0.0;
   const double blob_end = blob_heigth;
 
@@ -47,27 +48,20 @@ static void draw_blob_gl(double ca, double sa, double radius, double arc_width,
   double arc_width_start2 = (radius + blob_start) * arc_width;
   double arc_width_end2 = (radius + blob_end) * arc_width;
 
-  double xa = xm1 + arc_width_start2 * sa;
-  double ya = ym1 - arc_width_start2 * ca;
+  float xa = xm1 + arc_width_start2 * sa;
+  float ya = ym1 - arc_width_start2 * ca;
 
-  double xb = xm2 + arc_width_end2 * sa;
-  double yb = ym2 - arc_width_end2 * ca;
+  float xb = xm2 + arc_width_end2 * sa;
+  float yb = ym2 - arc_width_end2 * ca;
 
-  double xc = xm1 - arc_width_start2 * sa;
-  double yc = ym1 + arc_width_start2 * ca;
+  float xc = xm1 - arc_width_start2 * sa;
+  float yc = ym1 + arc_width_start2 * ca;
 
-  double xd = xm2 - arc_width_end2 * sa;
-  double yd = ym2 + arc_width_end2 * ca;
+  float xd = xm2 - arc_width_end2 * sa;
+  float yd = ym2 + arc_width_end2 * ca;
 
-  glBegin(GL_TRIANGLES);
-  glVertex2d(xa, ya);
-  glVertex2d(xb, yb);
-  glVertex2d(xc, yc);
-
-  glVertex2d(xb, yb);
-  glVertex2d(xc, yc);
-  glVertex2d(xd, yd);
-  glEnd();
+  const float triangles[] = {xa, ya, xb, yb, xc, yc, xb, yb, xc, yc, xd, yd};
+  v.insert(v.end(), triangles, triangles + ARRAY_SIZE(triangles));
 }
 
 void DrawArc(float cx, float cy, float r, float start_angle, float arc_angle, int num_segments) {
@@ -95,52 +89,6 @@ void DrawArc(float cx, float cy, float r, float start_angle, float arc_angle, in
   glEnd();
 }
 
-void DrawOutlineArc(double r1, double r2, double a1, double a2, bool stippled) {
-  if (a1 > a2) {
-    a2 += 360.0;
-  }
-  int segments = (a2 - a1) * 4;
-  bool circle = (a1 == 0.0 && a2 == 360.0);
-
-  if (!circle) {
-    a1 -= 0.5;
-    a2 += 0.5;
-  }
-  a1 = deg2rad(a1);
-  a2 = deg2rad(a2);
-
-  if (stippled) {
-    glEnable(GL_LINE_STIPPLE);
-    glLineStipple(1, 0x000F);
-    glLineWidth(1.0);
-  } else {
-    glLineWidth(1.0);
-  }
-
-  DrawArc(0.0, 0.0, r1, a1, a2 - a1, segments);
-  DrawArc(0.0, 0.0, r2, a1, a2 - a1, segments);
-
-  if (!circle) {
-    glBegin(GL_LINES);
-    glVertex2f(r1 * cosf(a1), r1 * sinf(a1));
-    glVertex2f(r2 * cosf(a1), r2 * sinf(a1));
-    glVertex2f(r1 * cosf(a2), r1 * sinf(a2));
-    glVertex2f(r2 * cosf(a2), r2 * sinf(a2));
-    glEnd();
-  }
-}
-
-void DrawFilledArc(double r1, double r2, double a1, double a2) {
-  if (a1 > a2) {
-    a2 += 360.0;
-  }
-
-  for (double n = a1; n <= a2; ++n) {
-    double nr = deg2rad(n);
-    draw_blob_gl(cos(nr), sin(nr), r2, deg2rad(0.5), r1 - r2);
-  }
-}
-
 void CheckOpenGLError(const wxString& after) {
   GLenum errLast = GL_NO_ERROR;
 
@@ -162,6 +110,26 @@ void CheckOpenGLError(const wxString& after) {
   }
 }
 
+PolarToCartesianLookup::PolarToCartesianLookup(size_t spokes) {
+  m_spokes = spokes;
+  m_octant = (spokes % 8 == 0) ? spokes / 8 : 0;
+
+  size_t entries = m_octant ? m_octant + 1 : m_spokes;
+  m_direction = (SpokeDirection *)malloc(sizeof(SpokeDirection) * entries);
+  if (!m_direction) {
+    wxLogError(wxT("Out Of Memory, fatal!"));
+    wxAbort();
+  }
+
+  for (size_t arc = 0; arc < entries; arc++) {
+    double angle = (double)arc * PI * 2 / m_spokes;
+    m_direction[arc].cosine = (int32_t)round(cos(angle) * POLAR_LOOKUP_ONE);
+    m_direction[arc].sine = (int32_t)round(sin(angle) * POLAR_LOOKUP_ONE);
+  }
+}
+
+PolarToCartesianLookup::~PolarToCartesianLookup() { free(m_direction); }
+
 //
 //  Draws rounded rectangle.
 //
@@ -236,4 +204,163 @@ void DrawRoundRect(float x, float y, float width, float height, float radius) {
   glEnd();
 }  // DrawRoundRect
 
+GLGeometry::GLGeometry() {
+  m_vbo = 0;
+  m_uploaded = false;
+  m_buffers_supported = -1;
+}
+
+// No GL context need be current here, so the VBO is left to Release().
+GLGeometry::~GLGeometry() {}
+
+/*
+ * Whether the current GL context has buffer objects, either as OpenGL 1.5 or
+ * as the ARB extension. Another context on another display may differ.
+ */
+static bool BuffersSupportedInContext() {
+  if (!GenBuffers) {
+    ShadersSupported();  // Loads the buffer object functions as well
+  }
+  if (!GenBuffers || !DeleteBuffers || !BindBuffer || !BufferData) {
+    return false;
+  }
+  const char *version = (const char *)glGetString(GL_VERSION);
+  int major = 0, minor = 0;
+  if (version && sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 1 || minor >= 5)) {
+    return true;
+  }
+  const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+  return extensions && strstr(extensions, "GL_ARB_vertex_buffer_object");
+}
+
+bool GLGeometry::IsCurrent(const double *key, size_t n) {
+  if (m_key.size() == n && std::equal(key, key + n, m_key.begin())) {
+    return true;
+  }
+  m_key.assign(key, key + n);
+  m_fill.clear();
+  m_lines.clear();
+  m_uploaded = false;
+  return false;
+}
+
+void GLGeometry::AddFilledArc(double r1, double r2, double a1, double a2) {
+  if (a1 > a2) {
+    a2 += 360.0;
+  }
+
+  for (double n = a1; n <= a2; ++n) {
+    double nr = deg2rad(n);
+    add_blob(m_fill, cos(nr), sin(nr), r2, deg2rad(0.5), r1 - r2);
+  }
+  m_uploaded = false;
+}
+
+void GLGeometry::AddOutlineArc(double r1, double r2, double a1, double a2) {
+  if (a1 > a2) {
+    a2 += 360.0;
+  }
+  int segments = (a2 - a1) * 4;
+  bool circle = (a1 == 0.0 && a2 == 360.0);
+
+  if (!circle) {
+    a1 -= 0.5;
+    a2 += 0.5;
+  }
+  a1 = deg2rad(a1);
+  a2 = deg2rad(a2);
+
+  AddArc(0.0, 0.0, r1, a1, a2 - a1, segments);
+  AddArc(0.0, 0.0, r2, a1, a2 - a1, segments);
+
+  if (!circle) {
+    AddLine(r1 * cosf(a1), r1 * sinf(a1), r2 * cosf(a1), r2 * sinf(a1));
+    AddLine(r1 * cosf(a2), r1 * sinf(a2), r2 * cosf(a2), r2 * sinf(a2));
+  }
+}
+
+// Same incremental rotation as DrawArc, but stored as separate line segments
+void GLGeometry::AddArc(float cx, float cy, float r, float start_angle, float arc_angle, int num_segments) {
+  float theta = arc_angle / float(num_segments - 1);
+
+  float tangential_factor = tanf(theta);
+  float radial_factor = cosf(theta);
+
+  float x = r * cosf(start_angle);
+  float y = r * sinf(start_angle);
+
+  for (int ii = 0; ii < num_segments - 1; ii++) {
+    float tx = -y;
+    float ty = x;
+    float nx = (x + tx * tangential_factor) * radial_factor;
+    float ny = (y + ty * tangential_factor) * radial_factor;
+
+    AddLine(x + cx, y + cy, nx + cx, ny + cy);
+    x = nx;
+    y = ny;
+  }
+}
+
+void GLGeometry::AddLine(float x1, float y1, float x2, float y2) {
+  const float line[] = {x1, y1, x2, y2};
+  m_lines.insert(m_lines.end(), line, line + ARRAY_SIZE(line));
+  m_uploaded = false;
+}
+
+void GLGeometry::Upload() {
+  if (m_buffers_supported < 0) {
+    m_buffers_supported = BuffersSupportedInContext();
+  }
+  if (!m_buffers_supported) {
+    return;  // Draw from client memory
+  }
+  if (!m_vbo) {
+    GenBuffers(1, &m_vbo);
+  }
+  // One buffer: the triangles followed by the lines
+  vector<float> all(m_fill);
+  all.insert(all.end(), m_lines.begin(), m_lines.end());
+  BindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  BufferData(GL_ARRAY_BUFFER, all.size() * sizeof(float), all.size() ? &all[0] : 0, GL_STATIC_DRAW);
+  BindBuffer(GL_ARRAY_BUFFER, 0);
+  m_uploaded = true;
+}
+
+void GLGeometry::DrawArrays(GLenum mode, size_t first, size_t count) {
+  if (!count) {
+    return;
+  }
+  if (!m_uploaded) {
+    Upload();
+  }
+  glEnableClientState(GL_VERTEX_ARRAY);
+  if (m_uploaded) {
+    BindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glVertexPointer(2, GL_FLOAT, 0, 0);
+    glDrawArrays(mode, (GLint)first, (GLsizei)count);
+    BindBuffer(GL_ARRAY_BUFFER, 0);
+  } else {
+    const vector<float> &v = (mode == GL_TRIANGLES) ? m_fill : m_lines;
+    glVertexPointer(2, GL_FLOAT, 0, &v[0]);
+    glDrawArrays(mode, 0, (GLsizei)count);
+  }
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void GLGeometry::Release(bool context_current) {
+  if (m_vbo && context_current && DeleteBuffers) {
+    DeleteBuffers(1, &m_vbo);
+  }
+  m_vbo = 0;
+  m_buffers_supported = -1;  // The next context may differ
+  m_key.clear();
+  m_fill.clear();
+  m_lines.clear();
+  m_uploaded = false;
+}
+
+void GLGeometry::DrawFilled() { DrawArrays(GL_TRIANGLES, 0, m_fill.size() / 2); }
+
+void GLGeometry::DrawOutline() { DrawArrays(GL_LINES, m_fill.size() / 2, m_lines.size() / 2); }
+
 PLUGIN_END_NAMESPACE
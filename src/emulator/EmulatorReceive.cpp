@@ -45,39 +45,73 @@ PLUGIN_BEGIN_NAMESPACE
  * The rest of the plugin uses a (slightly) abstract definition of the radar.
  */
 
-#define MILLIS_PER_SELECT 250
-#define SECONDS_SELECT(x) ((x)*MILLISECONDS_PER_SECOND / MILLIS_PER_SELECT)
+#define MILLIS_PER_SELECT 10
+
+void EmulatorReceive::LoadScene(void) {
+  if (M_SETTINGS.emulator_scene.IsEmpty() || !m_scene.Load(M_SETTINGS.emulator_scene)) {
+    m_scene.LoadDefault();
+  }
+  m_scene.SetGeometry(m_ri->m_spokes, m_ri->m_spoke_len_max);
+  LOG_INFO(wxT("%s emulating %u spokes of %u samples at %g RPM"), m_ri->m_name.c_str(), (unsigned)m_scene.m_spokes,
+           (unsigned)m_scene.m_spoke_len, m_scene.m_rpm);
+}
 
 /*
- * Called once a second. Emulate a radar return that is
- * at the current desired auto_range.
- * Speed is 24 images per minute, e.g. 1/2.5 of a full
- * image.
+ * Where the radar is in scene coordinates. This is the same position the rest of
+ * the plugin uses, so ARPA and the overlay agree with the picture. Without a
+ * position fix the scene's own ship is used.
  */
+ScenePoint EmulatorReceive::GetOwnPosition(double seconds) {
+  GeoPosition pos;
 
-void EmulatorReceive::EmulateFakeBuffer(void) {
-  time_t now = time(0);
-  uint8_t data[EMULATOR_MAX_SPOKE_LEN];
+  if (!m_ri->GetRadarPosition(&pos)) {
+    return m_scene.GetOwnShipPosition(seconds);
+  }
+  if (!m_origin_set) {
+    m_origin = pos;
+    m_origin_set = true;
+  }
 
-  wxCriticalSectionLocker lock(m_ri->m_exclusive);
+  ScenePoint p;
+  p.x = (pos.lon - m_origin.lon) * 60. * METERS_PER_NM * cos(deg2rad(m_origin.lat));
+  p.y = (pos.lat - m_origin.lat) * 60. * METERS_PER_NM;
+  return p;
+}
 
-  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
+/*
+ * Called every MILLIS_PER_SELECT. Generates all the spokes that the scene's
+ * rotation speed says are due since transmit started, so the spoke rate does not
+ * depend on how often we are called. When we fall more than a rotation behind the
+ * missed spokes are skipped.
+ */
+void EmulatorReceive::EmulateSpokes(void) {
+  wxLongLong now_millis = wxGetUTCTimeMillis();
+  uint8_t data[EMULATOR_MAX_SPOKE_LEN];
+
+  if (m_scene.m_own_ship) {
+    m_pi->SetEmulatorHeading(m_scene.m_own_heading);  // only if nothing better is available
+  }
+  double hdt = m_pi->GetHeadingTrue();
 
   int state = m_ri->m_state.GetValue();
+  ScenePoint pos = GetOwnPosition((now_millis - m_scene_start).ToDouble() / MILLISECONDS_PER_SECOND);
+
+  wxCriticalSectionLocker lock(m_ri->m_exclusive);
+
+  m_ri->m_lifecycle.ReportReceived();
 
   if (state != RADAR_TRANSMIT) {
     if (state == RADAR_OFF) {
       m_ri->m_state.Update(RADAR_STANDBY);
     }
+    m_start = now_millis;
+    m_spokes_done = 0;
     return;
   }
 
   m_ri->m_statistics.packets++;
-  m_ri->m_data_timeout = now + WATCHDOG_TIMEOUT;
+  m_ri->m_lifecycle.DataReceived();
 
-  m_next_rotation = (m_next_rotation + 1) % EMULATOR_SPOKES;
-
-  int scanlines_in_packet = EMULATOR_SPOKES * 24 / 60 * MILLIS_PER_SELECT / MILLISECONDS_PER_SECOND;
   int range_meters = m_ri->m_range.GetValue();
 
   const int *ranges;
@@ -92,51 +126,27 @@ void EmulatorReceive::EmulateFakeBuffer(void) {
     m_ri->m_range.Update(range_meters);
   }
 
-  int spots = 0;
+  double spokes_per_milli = m_scene.m_spokes * m_scene.m_rpm / 60. / MILLISECONDS_PER_SECOND;
+  uint64_t due = (uint64_t)((now_millis - m_start).ToDouble() * spokes_per_milli);
 
-  for (int scanline = 0; scanline < scanlines_in_packet; scanline++) {
-    int angle = m_next_spoke;
-    m_next_spoke = MOD_SPOKES(m_next_spoke + 1);
-    m_ri->m_statistics.spokes++;
+  if (due > m_spokes_done + m_scene.m_spokes) {
+    LOG_VERBOSE(wxT("%s emulator skipping %u spokes"), m_ri->m_name.c_str(), (unsigned)(due - m_spokes_done - m_scene.m_spokes));
+    m_spokes_done = due - m_scene.m_spokes;
+  }
 
-    if (range_meters == ranges[count - 1]) {
-      // New pattern suited for arpa / guard zone detection
-      CLEAR_STRUCT(data);
-      if (scanline < 8) {
-        for (size_t range = 384; range < 410; range++) {
-          data[range] = 255;
-          spots++;
-        }
-      }
-    } else {
-      // The blotchy pattern
-      // Invent a pattern. Outermost ring, then a square pattern
-      for (size_t range = 0; range < sizeof(data); range++) {
-        size_t bit = range >> 7;
-        // use bit 'bit' of angle_raw
-        uint8_t colour;
-        if (range > sizeof(data) - 10) {
-          colour = ((angle + m_next_rotation) % EMULATOR_SPOKES) <= 8 ? 255 : 0;
-        } else if (range > sizeof(data) - 20) {
-          colour = (angle * 256 / EMULATOR_SPOKES);
-        } else {
-          colour = (((angle + m_next_rotation) >> 5) & (2 << bit)) > 0 ? (range / 2) : 0;
-        }
-        data[range] = colour;
-        if (colour >= M_SETTINGS.threshold_blue) {
-          spots++;
-        }
-      }
-    }
+  int hdt_spokes = SCALE_DEGREES_TO_SPOKES(hdt);
 
-    int hdt = SCALE_DEGREES_TO_SPOKES(m_pi->GetHeadingTrue());
-    int bearing = MOD_SPOKES(angle + hdt);
+  for (; m_spokes_done < due; m_spokes_done++) {
+    size_t spoke = (size_t)(m_spokes_done % m_scene.m_spokes);
+    int angle = (int)(spoke * m_ri->m_spokes / m_scene.m_spokes);
+    int bearing = MOD_SPOKES(angle + hdt_spokes);
+    wxLongLong time_rec = m_start + (wxLongLong_t)(m_spokes_done / spokes_per_milli);
 
-    wxLongLong time_rec = wxGetUTCTimeMillis();
-    m_ri->ProcessRadarSpoke(angle, bearing, data, sizeof(data), range_meters, time_rec);
+    m_ri->m_statistics.spokes++;
+    m_scene.Render(data, m_scene.m_spoke_len, bearing * (double)DEGREES_PER_ROTATION / m_ri->m_spokes, pos, range_meters,
+                   (time_rec - m_scene_start).ToDouble() / MILLISECONDS_PER_SECOND);
+    m_ri->ProcessRadarSpoke(angle, bearing, data, m_scene.m_spoke_len, range_meters, time_rec);
   }
-
-  LOG_VERBOSE(wxT("emulating %d spokes at range %d with %d spots"), scanlines_in_packet, range_meters, spots);
 }
 
 /*
@@ -151,7 +161,10 @@ void *EmulatorReceive::Entry(void) {
 
   LOG_VERBOSE(wxT("EmulatorReceive thread %s starting"), m_ri->m_name.c_str());
 
+  LoadScene();
   m_ri->DetectedRadar(fake, fake);
+  m_scene_start = wxGetUTCTimeMillis();
+  m_start = m_scene_start;
 
   while (!m_shutdown) {
     struct timeval tv;
@@ -183,7 +196,7 @@ void *EmulatorReceive::Entry(void) {
       }
     }
 
-    EmulateFakeBuffer();
+    EmulateSpokes();
 
   }  // endless loop until thread destroy
 
@@ -207,6 +220,9 @@ void EmulatorReceive::Shutdown() {
   LOG_INFO(wxT("%s receive thread will take long time to stop"), m_ri->m_name.c_str());
 }
 
-wxString EmulatorReceive::GetInfoStatus() { return _("OK"); }
+wxString EmulatorReceive::GetInfoStatus() {
+  return wxString::Format(_("Scene %s, %u x %u at %g RPM"), m_scene.m_name.c_str(), (unsigned)m_scene.m_spokes,
+                          (unsigned)m_scene.m_spoke_len, m_scene.m_rpm);
+}
 
 PLUGIN_END_NAMESPACE
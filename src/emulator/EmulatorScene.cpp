@@ -0,0 +1,318 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "EmulatorScene.h"
+
+#include <wx/ffile.h>
+#include <wx/tokenzr.h>
+
+PLUGIN_BEGIN_NAMESPACE
+
+static const wxChar *default_scene =
+    wxT("# Used when no EmulatorScene is configured\n")
+    wxT("sea 700 120\n")
+    wxT("rain 60 3500 700 90 250 8\n")
+    wxT("coast 300 280:2600 305:1900 330:2400 345:4200 320:7000 275:6000\n")
+    wxT("target 10 1500 270 12 30\n")
+    wxT("target 95 900 10 6 15 200\n")
+    wxT("target 200 2500 45 20 40\n")
+    wxT("target 160 4200 300 3 80\n")
+    wxT("target 240 600 120 0 10 180\n");
+
+static ScenePoint PolarToPoint(double bearing, double distance) {
+  ScenePoint p;
+
+  p.x = distance * sin(deg2rad(bearing));
+  p.y = distance * cos(deg2rad(bearing));
+  return p;
+}
+
+// Read up to 'max' numbers, returns how many were read or -1 on a bad number
+static int GetNumbers(wxStringTokenizer &tokens, double *v, int max) {
+  int n = 0;
+
+  while (n < max && tokens.HasMoreTokens()) {
+    if (!tokens.GetNextToken().ToCDouble(&v[n])) {
+      return -1;
+    }
+    n++;
+  }
+  return tokens.HasMoreTokens() ? -1 : n;
+}
+
+EmulatorScene::EmulatorScene() {
+  m_spoke_len = 0;
+  m_spokes = 0;
+  Clear();
+}
+
+void EmulatorScene::Clear() {
+  m_name = wxT("");
+  m_rpm = SCENE_DEFAULT_RPM;
+  m_beam = SCENE_DEFAULT_BEAM;
+  m_own_ship = false;
+  m_own_heading = 0.;
+  m_own_speed = 0.;
+  m_sea_range = 0.;
+  m_sea_strength = 0;
+  m_random = 0x12345678;
+  m_targets.clear();
+  m_rain.clear();
+  m_coast.clear();
+}
+
+bool EmulatorScene::Load(const wxString &filename) {
+  wxFFile file(filename, wxT("r"));
+  wxString text;
+
+  if (!file.IsOpened() || !file.ReadAll(&text)) {
+    wxLogError(wxT("radar_pi: cannot read emulator scene %s"), filename.c_str());
+    return false;
+  }
+  return Parse(text, wxFileName(filename).GetName());
+}
+
+void EmulatorScene::LoadDefault() { Parse(default_scene, _("built in")); }
+
+bool EmulatorScene::Parse(const wxString &text, const wxString &name) {
+  wxStringTokenizer lines(text, wxT("\r\n"), wxTOKEN_STRTOK);
+  bool ok = true;
+  int line_no = 0;
+
+  Clear();
+  m_name = name;
+  while (lines.HasMoreTokens()) {
+    wxString line = lines.GetNextToken().BeforeFirst('#').Trim().Trim(false);
+
+    line_no++;
+    if (!line.IsEmpty() && !ParseLine(line)) {
+      LOG_INFO(wxT("radar_pi: emulator scene %s ignoring line %d '%s'"), name.c_str(), line_no, line.c_str());
+      ok = false;
+    }
+  }
+  LOG_INFO(wxT("radar_pi: emulator scene %s with %u targets, %u rain cells, %u coasts"), name.c_str(),
+           (unsigned)m_targets.size(), (unsigned)m_rain.size(), (unsigned)m_coast.size());
+  return ok;
+}
+
+bool EmulatorScene::ParseLine(const wxString &line) {
+  wxStringTokenizer tokens(line, wxT(" \t"), wxTOKEN_STRTOK);
+  wxString keyword = tokens.GetNextToken();
+  double v[6];
+  int n;
+
+  if (keyword == wxT("coast")) {
+    SceneCoast coast;
+
+    if (!tokens.GetNextToken().ToCDouble(&coast.depth) || coast.depth <= 0.) {
+      return false;
+    }
+    while (tokens.HasMoreTokens()) {
+      wxString token = tokens.GetNextToken();
+      double bearing, distance;
+
+      if (!token.BeforeFirst(':').ToCDouble(&bearing) || !token.AfterFirst(':').ToCDouble(&distance) || distance < 0.) {
+        return false;
+      }
+      coast.polygon.push_back(PolarToPoint(bearing, distance));
+    }
+    if (coast.polygon.size() < 3) {
+      return false;
+    }
+    m_coast.push_back(coast);
+    return true;
+  }
+
+  n = GetNumbers(tokens, v, ARRAY_SIZE(v));
+  if (keyword == wxT("spokes") && n == 1 && v[0] >= 1.) {
+    m_spokes = (size_t)v[0];
+  } else if (keyword == wxT("spoke_len") && n == 1 && v[0] >= 1.) {
+    m_spoke_len = (size_t)v[0];
+  } else if (keyword == wxT("rpm") && n == 1 && v[0] > 0. && v[0] <= SCENE_MAX_RPM) {
+    m_rpm = v[0];
+  } else if (keyword == wxT("beam") && n == 1 && v[0] > 0. && v[0] < 90.) {
+    m_beam = v[0];
+  } else if (keyword == wxT("seed") && n == 1) {
+    m_random = (uint32_t)v[0] | 1;
+  } else if (keyword == wxT("ownship") && n == 2) {
+    m_own_ship = true;
+    m_own_heading = v[0];
+    m_own_speed = SCENE_KNOTS_TO_MPS(v[1]);
+  } else if (keyword == wxT("sea") && n == 2) {
+    m_sea_range = v[0];
+    m_sea_strength = (uint8_t)wxMax(0., wxMin(v[1], 255.));
+  } else if (keyword == wxT("target") && n >= 4) {
+    SceneTarget target;
+
+    target.start = PolarToPoint(v[0], v[1]);
+    target.velocity = PolarToPoint(v[2], SCENE_KNOTS_TO_MPS(v[3]));
+    target.size = n >= 5 ? v[4] : SCENE_DEFAULT_TARGET_SIZE;
+    target.strength = n >= 6 ? (uint8_t)wxMax(0., wxMin(v[5], 255.)) : 255;
+    m_targets.push_back(target);
+  } else if (keyword == wxT("rain") && (n == 4 || n == 6)) {
+    SceneRain rain;
+
+    rain.start = PolarToPoint(v[0], v[1]);
+    rain.velocity = n == 6 ? PolarToPoint(v[4], SCENE_KNOTS_TO_MPS(v[5])) : PolarToPoint(0., 0.);
+    rain.radius = v[2];
+    rain.strength = (uint8_t)wxMax(1., wxMin(v[3], 255.));
+    m_rain.push_back(rain);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void EmulatorScene::SetGeometry(size_t spokes, size_t spoke_len) {
+  if (m_spokes == 0 || m_spokes > spokes) {
+    m_spokes = spokes;
+  }
+  if (m_spoke_len == 0 || m_spoke_len > spoke_len) {
+    m_spoke_len = spoke_len;
+  }
+}
+
+ScenePoint EmulatorScene::GetOwnShipPosition(double seconds) { return PolarToPoint(m_own_heading, m_own_speed * seconds); }
+
+// xorshift32, good enough for clutter and much cheaper than rand()
+uint32_t EmulatorScene::Random() {
+  m_random ^= m_random << 13;
+  m_random ^= m_random >> 17;
+  m_random ^= m_random << 5;
+  return m_random;
+}
+
+void EmulatorScene::Render(uint8_t *data, size_t len, double bearing, ScenePoint pos, double range, double seconds) {
+  double ux = sin(deg2rad(bearing));
+  double uy = cos(deg2rad(bearing));
+  double samples_per_meter = len / range;
+  double beam = tan(deg2rad(m_beam / 2.));
+
+  memset(data, 0, len);
+
+  // Sea clutter, strong and dense close by and fading out towards m_sea_range
+  if (m_sea_strength > 0) {
+    size_t end = wxMin(len, (size_t)(m_sea_range * samples_per_meter));
+
+    for (size_t i = 0; i < end; i++) {
+      uint32_t fade = (uint32_t)(256 - i * 256 / end);
+      uint32_t r = Random();
+
+      if ((r & 0xff) < fade / 2) {
+        data[i] = (uint8_t)((m_sea_strength * fade >> 8) * ((r >> 8) & 0xff) >> 8);
+      }
+    }
+  }
+
+  // Rain: noisy returns where the spoke passes through the cell
+  for (size_t c = 0; c < m_rain.size(); c++) {
+    const SceneRain &rain = m_rain[c];
+    double dx = rain.start.x + rain.velocity.x * seconds - pos.x;
+    double dy = rain.start.y + rain.velocity.y * seconds - pos.y;
+    double along = dx * ux + dy * uy;
+    double across = dx * uy - dy * ux;
+
+    if (fabs(across) >= rain.radius) {
+      continue;
+    }
+    double half = sqrt(rain.radius * rain.radius - across * across);
+    int begin = wxMax(0, (int)((along - half) * samples_per_meter));
+    int end = wxMin((int)len, (int)((along + half) * samples_per_meter));
+
+    for (int i = begin; i < end; i++) {
+      uint8_t v = (uint8_t)(Random() % rain.strength);
+      if (v > data[i]) {
+        data[i] = v;
+      }
+    }
+  }
+
+  // Targets, widened by the beam like real echoes
+  for (size_t t = 0; t < m_targets.size(); t++) {
+    const SceneTarget &target = m_targets[t];
+    double dx = target.start.x + target.velocity.x * seconds - pos.x;
+    double dy = target.start.y + target.velocity.y * seconds - pos.y;
+    double along = dx * ux + dy * uy;
+    double across = dx * uy - dy * ux;
+
+    if (along <= 0. || fabs(across) > target.size / 2. + along * beam) {
+      continue;
+    }
+    int begin = wxMax(0, (int)((along - target.size / 2.) * samples_per_meter));
+    int end = wxMin((int)len, (int)((along + target.size / 2.) * samples_per_meter) + 1);
+
+    for (int i = begin; i < end; i++) {
+      data[i] = wxMax(data[i], target.strength);
+    }
+  }
+
+  // Coast: the nearest edge crossing returns land echoes, behind it is shadow
+  double nearest = range;
+  const SceneCoast *nearest_coast = 0;
+  for (size_t c = 0; c < m_coast.size(); c++) {
+    const vector<ScenePoint> &polygon = m_coast[c].polygon;
+
+    for (size_t i = 0; i < polygon.size(); i++) {
+      const ScenePoint &a = polygon[i];
+      const ScenePoint &b = polygon[(i + 1) % polygon.size()];
+      double ex = b.x - a.x;
+      double ey = b.y - a.y;
+      double denominator = ux * ey - uy * ex;
+
+      if (fabs(denominator) < 1e-9) {
+        continue;
+      }
+      double ax = a.x - pos.x;
+      double ay = a.y - pos.y;
+      double s = (ax * ey - ay * ex) / denominator;  // distance along the spoke
+      double f = (ax * uy - ay * ux) / denominator;  // fraction along the edge
+
+      if (s > 0. && s < nearest && f >= 0. && f <= 1.) {
+        nearest = s;
+        nearest_coast = &m_coast[c];
+      }
+    }
+  }
+  if (nearest_coast) {
+    size_t begin = (size_t)(nearest * samples_per_meter);
+    size_t end = wxMin(len, (size_t)((nearest + nearest_coast->depth) * samples_per_meter) + 1);
+
+    for (size_t i = begin; i < end; i++) {
+      data[i] = (uint8_t)(192 + (Random() & 63));
+    }
+    if (end < len) {
+      memset(data + end, 0, len - end);
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
@@ -119,18 +119,7 @@ bool GarminHDControl::Init(radar_pi *pi, RadarInfo *ri, NetworkAddress &ifadr, N
 }
 
 void GarminHDControl::logBinaryData(const wxString &what, const void *data, int size) {
-  wxString explain;
-  const uint8_t *d = (const uint8_t *)data;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("") + m_name + wxT(" ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), d[i]);
-  }
-  LOG_TRANSMIT(explain);
+  m_pi->logBinaryData(m_name + wxT(" ") + what, (const uint8_t *)data, size);
 }
 
 bool GarminHDControl::TransmitCmd(const void *msg, int size) {
@@ -210,6 +199,7 @@ bool GarminHDControl::SetControlValue(ControlType controlType, RadarControlItem
     case CT_ANTENNA_STARBOARD:
     case CT_AUTOTTRACKDOPPLER:
     case CT_CENTER_VIEW:
+    case CT_CFAR:
     case CT_COLOR_GAIN:
     case CT_MAIN_BANG_SIZE:
     case CT_MAX:
@@ -220,6 +210,7 @@ bool GarminHDControl::SetControlValue(ControlType controlType, RadarControlItem
     case CT_RANGE:
     case CT_RANGE_ADJUSTMENT:
     case CT_REFRESHRATE:
+    case CT_SCAN_CORRELATION:
     case CT_TARGET_ON_PPI:
     case CT_TARGET_TRAILS:
     case CT_THRESHOLD:
@@ -32,6 +32,8 @@
 
 #include "GarminHDReceive.h"
 
+#include "GarminHDUnpack.h"
+
 PLUGIN_BEGIN_NAMESPACE
 
 /*
@@ -83,10 +85,6 @@ struct radar_line {
 void GarminHDReceive::ProcessFrame(radar_line *packet) {
   // log_line.time_rec = wxGetUTCTimeMillis();
   wxLongLong time_rec = wxGetUTCTimeMillis();
-  time_t now = (time_t)(time_rec.GetValue() / MILLISECONDS_PER_SECOND);
-  uint8_t line[GARMIN_HD_MAX_SPOKE_LEN];
-  int i;
-  uint8_t *p, *s;
 
   if (packet->scan_length * 2 > GARMIN_HD_MAX_SPOKE_LEN) {
     LOG_INFO(wxT("%s truncating data, %d longer than expected max length %d"), packet->scan_length * 8, GARMIN_HD_MAX_SPOKE_LEN);
@@ -105,17 +103,15 @@ void GarminHDReceive::ProcessFrame(radar_line *packet) {
   }
 
   m_ri->m_state.Update(RADAR_TRANSMIT);
-  m_ri->m_range.Update(packet->range_meters + 1);
-  m_ri->m_gain.Update(packet->gain_level[0], packet->gain_level[1] ? RCS_AUTO_1 : RCS_MANUAL);
-  m_ri->m_rain.Update(packet->sea_clutter[0], packet->sea_clutter[1] ? RCS_AUTO_1 : RCS_MANUAL);
-  m_ri->m_rain.Update(packet->rain_clutter[0]);
-  m_ri->m_bearing_alignment.Update(packet->dome_offset);
-  m_ri->m_ftc.Update(packet->FTC_mode);
-  m_ri->m_interference_rejection.Update(packet->crosstalk_onoff);
-  m_ri->m_scan_speed.Update(packet->dome_speed);
-
-  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
-  m_ri->m_data_timeout = now + DATA_TIMEOUT;
+  m_ri->m_control_journal.Set(CT_RANGE, packet->range_meters + 1);
+  m_ri->m_control_journal.Set(CT_GAIN, packet->gain_level[0], packet->gain_level[1] ? RCS_AUTO_1 : RCS_MANUAL);
+  m_ri->m_control_journal.Set(CT_RAIN, packet->rain_clutter[0]);
+  m_ri->m_control_journal.Set(CT_BEARING_ALIGNMENT, packet->dome_offset);
+  m_ri->m_control_journal.Set(CT_FTC, packet->FTC_mode);
+  m_ri->m_control_journal.Set(CT_INTERFERENCE_REJECTION, packet->crosstalk_onoff);
+  m_ri->m_control_journal.Set(CT_SCAN_SPEED, packet->dome_speed);
+
+  m_ri->m_lifecycle.DataReceived();
 
   if (m_first_receive) {
     m_first_receive = false;
@@ -124,18 +120,9 @@ void GarminHDReceive::ProcessFrame(radar_line *packet) {
   }
   wxCriticalSectionLocker lock(m_ri->m_exclusive);
 
+  // The packet holds four spokes of scan_length / 4 bytes each
   for (int j = 0; j < 4; j++) {
-    s = &packet->line_data[packet->scan_length / 4 * j];
-    for (p = line, i = 0; i < packet->scan_length / 4; i++, s++) {
-      *p++ = (*s & 0x01) > 0 ? 255 : 0;
-      *p++ = (*s & 0x02) > 0 ? 255 : 0;
-      *p++ = (*s & 0x04) > 0 ? 255 : 0;
-      *p++ = (*s & 0x08) > 0 ? 255 : 0;
-      *p++ = (*s & 0x10) > 0 ? 255 : 0;
-      *p++ = (*s & 0x20) > 0 ? 255 : 0;
-      *p++ = (*s & 0x40) > 0 ? 255 : 0;
-      *p++ = (*s & 0x80) > 0 ? 255 : 0;
-    }
+    GarminHDUnpackSpoke(&packet->line_data[packet->scan_length / 4 * j], packet->scan_length / 4, &m_runs);
 
     m_next_spoke = (spoke + 1) % GARMIN_HD_SPOKES;
 
@@ -148,7 +135,7 @@ void GarminHDReceive::ProcessFrame(radar_line *packet) {
     SpokeBearing a = MOD_SPOKES(angle_raw);
     SpokeBearing b = MOD_SPOKES(bearing_raw);
 
-    m_ri->ProcessRadarSpoke(a, b, line, p - line, packet->display_meters, time_rec);
+    m_ri->ProcessRadarSpoke(a, b, m_runs, packet->display_meters, time_rec);
 
     angle_raw++;
     spoke++;
@@ -176,8 +163,8 @@ bool GarminHDReceive::IsValidGarminAddress(struct ifaddrs *nif) {
   return false;
 }
 
-SOCKET GarminHDReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
+bool GarminHDReceive::PickNextEthernetCard() {
+  bool joined = false;
   m_interface_addr = NetworkAddress();
 
   // Pick the next ethernet card
@@ -206,30 +193,29 @@ SOCKET GarminHDReceive::PickNextEthernetCard() {
     m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
     m_interface_addr.port = 0;
 
-    socket = GetNewReportSocket();
+    joined = JoinReportGroup();
   } else {
     wxString s;
     s << _("No interface found") << wxT("\n");
     s << _("Interface must match") << wxT(" 172.16/12");
     SetInfoStatus(s);
 
-    socket = GetNewReportSocket();
+    joined = JoinReportGroup();
   }
 
-  return socket;
+  return joined;
 }
 
-SOCKET GarminHDReceive::GetNewReportSocket() {
-  SOCKET socket;
+bool GarminHDReceive::JoinReportGroup() {
   wxString error;
 
   if (m_interface_addr.addr.s_addr == 0) {
-    return INVALID_SOCKET;
+    return false;
   }
 
   error = wxT("");
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_report_addr, error);
-  if (socket != INVALID_SOCKET) {
+  bool joined = m_multicast.Join(m_interface_addr, m_report_addr, error);
+  if (joined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = m_report_addr.FormatNetworkAddressPort();
 
@@ -242,7 +228,7 @@ SOCKET GarminHDReceive::GetNewReportSocket() {
     SetInfoStatus(error);
     wxLogError(wxT("Unable to listen to socket: %s"), error.c_str());
   }
-  return socket;
+  return joined;
 }
 
 /*
@@ -259,26 +245,26 @@ void *GarminHDReceive::Entry(void) {
     sockaddr_in ipv4;
   } rx_addr;
   socklen_t rx_len;
+  MulticastSource source;
 
   uint8_t data[sizeof(radar_line)];
   m_interface_array = 0;
   m_interface = 0;
   m_no_spoke_timeout = 0;
-  struct sockaddr_in radarFoundAddr;
-  sockaddr_in *radar_addr = 0;
+  bool detected = false;
 
-  SOCKET reportSocket = INVALID_SOCKET;
+  bool report_joined = false;
 
   LOG_VERBOSE(wxT("GarminHDReceive thread %s starting"), m_ri->m_name.c_str());
 
   if (m_interface_addr.addr.s_addr == 0) {
-    reportSocket = GetNewReportSocket();
+    report_joined = JoinReportGroup();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
+    if (!report_joined) {
+      report_joined = PickNextEthernetCard();
+      if (report_joined) {
         no_data_timeout = 0;
         m_no_spoke_timeout = 0;
       }
@@ -294,9 +280,10 @@ void *GarminHDReceive::Entry(void) {
       FD_SET(m_receive_socket, &fdin);
       maxFd = MAX(m_receive_socket, maxFd);
     }
-    if (reportSocket != INVALID_SOCKET) {
-      FD_SET(reportSocket, &fdin);
-      maxFd = MAX(reportSocket, maxFd);
+    SOCKET wakeSocket = m_multicast.GetWakeSocket();
+    if (wakeSocket != INVALID_SOCKET) {
+      FD_SET(wakeSocket, &fdin);
+      maxFd = MAX(wakeSocket, maxFd);
     }
 
     r = select(maxFd + 1, &fdin, 0, 0, &tv);
@@ -311,36 +298,34 @@ void *GarminHDReceive::Entry(void) {
         }
       }
 
-      if (reportSocket != INVALID_SOCKET && FD_ISSET(reportSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          NetworkAddress radar_address;
-          radar_address.addr = rx_addr.ipv4.sin_addr;
-          radar_address.port = rx_addr.ipv4.sin_port;
-
-          if (ProcessReport(data, (size_t)r)) {
-            if (!radar_addr) {
-              wxCriticalSectionLocker lock(m_lock);
-              m_ri->DetectedRadar(m_interface_addr, radar_address);  // enables transmit data
-
-              // the dataSocket is opened in the next loop
-
-              radarFoundAddr = rx_addr.ipv4;
-              radar_addr = &radarFoundAddr;
-              m_addr = radar_address.FormatNetworkAddress();
-
-              if (m_ri->m_state.GetValue() == RADAR_OFF) {
-                LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), m_addr.c_str());
-                m_ri->m_state.Update(RADAR_STANDBY);
+      if (wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &fdin)) {
+        while ((r = m_multicast.Receive(data, sizeof(data), &source)) >= 0) {
+          if (!report_joined || !(source.group == m_report_addr)) {
+            continue;
+          }
+          if (r > 0) {
+            bool is_report = ProcessReport(data, (size_t)r);
+            m_ri->m_control_journal.Commit();
+            if (is_report) {
+              if (!detected) {
+                wxCriticalSectionLocker lock(m_lock);
+                m_ri->DetectedRadar(m_interface_addr, source.from);  // enables transmit data
+
+                detected = true;
+                m_addr = source.from.FormatNetworkAddress();
+
+                if (m_ri->m_state.GetValue() == RADAR_OFF) {
+                  LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), m_addr.c_str());
+                  m_ri->m_state.Update(RADAR_STANDBY);
+                }
               }
+              no_data_timeout = SECONDS_SELECT(-15);
             }
-            no_data_timeout = SECONDS_SELECT(-15);
+          } else {
+            wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
+            m_multicast.Leave(m_report_addr);
+            report_joined = false;
           }
-        } else {
-          wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
         }
       }
 
@@ -348,12 +333,12 @@ void *GarminHDReceive::Entry(void) {
 
       if (no_data_timeout >= SECONDS_SELECT(2)) {
         no_data_timeout = 0;
-        if (reportSocket != INVALID_SOCKET) {
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
+        if (report_joined) {
+          m_multicast.Leave(m_report_addr);
+          report_joined = false;
           m_ri->m_state.Update(RADAR_OFF);
           m_interface_addr = NetworkAddress();
-          radar_addr = 0;
+          detected = false;
         }
       } else {
         no_data_timeout++;
@@ -369,9 +354,7 @@ void *GarminHDReceive::Entry(void) {
 
   }  // endless loop until thread destroy
 
-  if (reportSocket != INVALID_SOCKET) {
-    closesocket(reportSocket);
-  }
+  m_multicast.LeaveAll();
   if (m_send_socket != INVALID_SOCKET) {
     closesocket(m_send_socket);
     m_send_socket = INVALID_SOCKET;
@@ -455,7 +438,6 @@ bool GarminHDReceive::UpdateScannerStatus(int status) {
     m_radar_status = status;
 
     wxString stat;
-    time_t now = time(0);
 
     switch (m_radar_status) {
       case 1:
@@ -470,7 +452,7 @@ bool GarminHDReceive::UpdateScannerStatus(int status) {
         break;
       case 5:
         m_ri->m_state.Update(RADAR_SPINNING_UP);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         LOG_VERBOSE(wxT("%s reports status SPINNING UP"), m_ri->m_name.c_str());
         stat = _("Spinning up");
         break;
@@ -492,9 +474,8 @@ bool GarminHDReceive::UpdateScannerStatus(int status) {
 bool GarminHDReceive::ProcessReport(const uint8_t *report, size_t len) {
   LOG_BINARY_REPORTS(wxString::Format(wxT("%s report"), m_ri->m_name.c_str()), report, len);
 
-  time_t now = time(0);
 
-  m_ri->resetTimeout(now);
+  m_ri->m_lifecycle.ReportReceived();
 
   if (len >= 12 /*sizeof(rad_response_pkt)*/) {  //  sizeof(rad_response_pkt)) {
     rad_response_pkt *packet = (rad_response_pkt *)report;
@@ -521,7 +502,7 @@ bool GarminHDReceive::ProcessReport(const uint8_t *report, size_t len) {
 
       case 0x2a7: {
         LOG_VERBOSE(wxT("0x02a7: range %d"), packet->range_meters + 1);  // Range in meters
-        m_ri->m_range.Update(packet->range_meters + 1);
+        m_ri->m_control_journal.Set(CT_RANGE, packet->range_meters + 1);
 
         LOG_VERBOSE(wxT("0x02a7: gain %d"), packet->gain_level);  // Gain
         m_gain = packet->gain_level;
@@ -543,12 +524,12 @@ bool GarminHDReceive::ProcessReport(const uint8_t *report, size_t len) {
           }
         }
         LOG_VERBOSE(wxT("%s m_gain.Update(%d, %d)"), m_ri->m_name.c_str(), m_gain, (int)state);
-        m_ri->m_gain.Update(m_gain, state);
+        m_ri->m_control_journal.Set(CT_GAIN, m_gain, state);
 
         // Sea Clutter level
         LOG_VERBOSE(wxT("0x02a7: sea clutter %d"), packet->sea_clutter_level);
         m_sea_clutter = packet->sea_clutter_level;
-        m_ri->m_sea.Update(m_sea_clutter, m_sea_mode);
+        m_ri->m_control_journal.Set(CT_SEA, m_sea_clutter, m_sea_mode);
 
         // Sea Clutter On/Off
         LOG_VERBOSE(wxT("0x02a7: sea mode %d"), packet->sea_clutter_mode);
@@ -573,25 +554,25 @@ bool GarminHDReceive::ProcessReport(const uint8_t *report, size_t len) {
         // Rain clutter level
         LOG_VERBOSE(wxT("0x02a7: rain clutter %d"), packet->rain_clutter_level);
         m_rain_clutter = packet->rain_clutter_level;
-        m_ri->m_rain.Update(m_rain_clutter, m_rain_mode);
+        m_ri->m_control_journal.Set(CT_RAIN, m_rain_clutter, m_rain_mode);
 
         // Dome offset, called bearing alignment here
         LOG_VERBOSE(wxT("0x02a7: bearing alignment %d"), (int32_t)packet->dome_offset);
-        m_ri->m_bearing_alignment.Update((int32_t)packet->dome_offset);
+        m_ri->m_control_journal.Set(CT_BEARING_ALIGNMENT, (int32_t)packet->dome_offset);
 
         // FTC mode
         LOG_VERBOSE(wxT("0x02a7: FTC %d"), packet->FTC_mode);
-        m_ri->m_ftc.Update(packet->FTC_mode);
+        m_ri->m_control_journal.Set(CT_FTC, packet->FTC_mode);
 
         // Crosstalk reject, I guess this is the same as interference rejection?
         LOG_VERBOSE(wxT("0x02a7: crosstalk/interference rejection %d"), packet->crosstalk_onoff);
-        m_ri->m_interference_rejection.Update(packet->crosstalk_onoff);
+        m_ri->m_control_journal.Set(CT_INTERFERENCE_REJECTION, packet->crosstalk_onoff);
 
         // Timed transmit status should go here
 
         // Dome Speed
         LOG_VERBOSE(wxT("0x02a7: scan speed %d"), packet->dome_speed);
-        m_ri->m_scan_speed.Update(packet->dome_speed);
+        m_ri->m_control_journal.Set(CT_SCAN_SPEED, packet->dome_speed);
 
         return true;
       }
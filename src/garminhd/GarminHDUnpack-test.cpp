@@ -0,0 +1,178 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Checks GarminHDUnpackSpoke() against the bit at a time expansion it
+ * replaced: every byte value at every position of a spoke, every 16 bit
+ * pattern across the boundary of two 64 bit words, and spoke lengths that
+ * are not a multiple of 8 bytes. Then compares the speed of both. Build it
+ * against the plugin headers and wxWidgets, like Kalman-test.cpp, e.g.
+ *
+ *   c++ -O2 -Iinclude -Iinclude/garminhd `wx-config --cxxflags` -o GarminHDUnpack-test \
+ *     src/garminhd/GarminHDUnpack-test.cpp src/garminhd/GarminHDUnpack.cpp src/spokeutil.cpp `wx-config --libs`
+ */
+
+#include "GarminHDUnpack.h"
+
+#include <chrono>
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#define TEST_BYTES (252)  // One spoke of the longest HD range
+
+// The expansion as it was in GarminHDReceive::ProcessFrame
+static void ReferenceExpand(const uint8_t *s, size_t bytes, uint8_t *p) {
+  for (size_t i = 0; i < bytes; i++, s++) {
+    *p++ = (*s & 0x01) > 0 ? 255 : 0;
+    *p++ = (*s & 0x02) > 0 ? 255 : 0;
+    *p++ = (*s & 0x04) > 0 ? 255 : 0;
+    *p++ = (*s & 0x08) > 0 ? 255 : 0;
+    *p++ = (*s & 0x10) > 0 ? 255 : 0;
+    *p++ = (*s & 0x20) > 0 ? 255 : 0;
+    *p++ = (*s & 0x40) > 0 ? 255 : 0;
+    *p++ = (*s & 0x80) > 0 ? 255 : 0;
+  }
+}
+
+static int Check(const char *name, const uint8_t *src, size_t bytes) {
+  uint8_t expected[TEST_BYTES * 8];
+  uint8_t actual[TEST_BYTES * 8];
+  SpokeRuns runs;
+
+  ReferenceExpand(src, bytes, expected);
+  GarminHDUnpackSpoke(src, bytes, &runs);
+  if (runs.GetLen() != bytes * 8) {
+    cout << "ERROR: " << name << ": length " << runs.GetLen() << ", expected " << bytes * 8 << "\n";
+    return 1;
+  }
+  runs.GetSamples(actual);
+  for (size_t i = 0; i < bytes * 8; i++) {
+    if (actual[i] != expected[i]) {
+      cout << "ERROR: " << name << ": sample " << i << " is " << (int)actual[i] << ", expected " << (int)expected[i] << "\n";
+      return 1;
+    }
+  }
+  for (size_t i = 1; i < runs.GetCount(); i++) {
+    if (runs[i].begin <= runs[i - 1].end) {
+      cout << "ERROR: " << name << ": runs " << i - 1 << " and " << i << " touch\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main() {
+  int ret = 0;
+  uint8_t spoke[TEST_BYTES];
+
+  // Every byte value at every position, on an empty and on a full spoke
+  for (int fill = 0; fill <= 0xff && !ret; fill += 0xff) {
+    for (size_t pos = 0; pos < 24 && !ret; pos++) {
+      for (int v = 0; v < 256 && !ret; v++) {
+        memset(spoke, fill, sizeof(spoke));
+        spoke[pos] = (uint8_t)v;
+        ret |= Check("byte", spoke, 24);
+      }
+    }
+  }
+
+  // Every pattern of the last byte of one word and the first of the next
+  memset(spoke, 0, sizeof(spoke));
+  for (int v = 0; v < 65536 && !ret; v++) {
+    spoke[7] = (uint8_t)v;
+    spoke[8] = (uint8_t)(v >> 8);
+    ret |= Check("word boundary", spoke, 16);
+  }
+
+  // Lengths that end in the middle of a word
+  uint32_t seed = 1;
+  for (size_t bytes = 1; bytes <= TEST_BYTES && !ret; bytes++) {
+    for (size_t i = 0; i < bytes; i++) {
+      seed = seed * 1103515245 + 12345;
+      spoke[i] = (uint8_t)(seed >> 16);
+    }
+    ret |= Check("length", spoke, bytes);
+  }
+  if (ret) {
+    return ret;
+  }
+
+  // A spoke as seen at sea: mostly empty, clutter near the boat, a few targets
+  vector<uint8_t> spokes(720 * TEST_BYTES, 0);
+  for (size_t s = 0; s < 720; s++) {
+    uint8_t *p = &spokes[s * TEST_BYTES];
+    for (size_t i = 0; i < 30; i++) {
+      seed = seed * 1103515245 + 12345;
+      p[i] = (uint8_t)(seed >> 16);
+    }
+    seed = seed * 1103515245 + 12345;
+    memset(p + 40 + (seed >> 16) % 180, 0xff, 6);
+  }
+
+  SpokeRuns runs;
+  uint8_t line[TEST_BYTES * 8];
+  size_t total = 0;
+  const int revolutions = 200;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < revolutions; rev++) {
+    for (size_t s = 0; s < 720; s++) {
+      ReferenceExpand(&spokes[s * TEST_BYTES], TEST_BYTES, line);
+      runs.SetSamples(line, sizeof(line));
+      total += runs.GetCount();
+    }
+  }
+  std::chrono::duration<double> old_time = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < revolutions; rev++) {
+    for (size_t s = 0; s < 720; s++) {
+      GarminHDUnpackSpoke(&spokes[s * TEST_BYTES], TEST_BYTES, &runs);
+      total -= runs.GetCount();
+    }
+  }
+  std::chrono::duration<double> new_time = std::chrono::steady_clock::now() - start;
+
+  if (total != 0) {
+    cout << "ERROR: different number of runs\n";
+    ret = 1;
+  }
+  double spokes_done = revolutions * 720.;
+  cout << "Expand bits and find runs: " << old_time.count() / spokes_done * 1e9 << " ns per spoke\n";
+  cout << "Unpack runs from words:    " << new_time.count() / spokes_done * 1e9 << " ns per spoke\n";
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
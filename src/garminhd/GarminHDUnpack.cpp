@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "GarminHDUnpack.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static inline int FirstSet64(uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(w);
+#else
+  int n = 0;
+  while (!(w & 1)) {
+    w >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+// Samples [8 * i..8 * i + 64> as bits, the first sample in bit 0.
+static inline uint64_t LoadBits(const uint8_t *src, size_t i, size_t bytes) {
+  uint64_t w = 0;
+
+  if (i + sizeof(w) <= bytes) {
+    memcpy(&w, src + i, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+  }
+  for (size_t k = 0; i + k < bytes; k++) {
+    w |= (uint64_t)src[i + k] << (8 * k);
+  }
+  return w;
+}
+
+void GarminHDUnpackSpoke(const uint8_t *src, size_t bytes, SpokeRuns *runs) {
+  runs->Clear(bytes * 8);
+
+  for (size_t i = 0; i < bytes; i += sizeof(uint64_t)) {
+    uint64_t w = LoadBits(src, i, bytes);
+    size_t base = i * 8;
+
+    while (w) {
+      int begin = FirstSet64(w);
+      uint64_t rest = ~(w >> begin);  // zero bits shifted in end the run
+      int end = rest ? begin + FirstSet64(rest) : 64;
+
+      // A run that reaches the next word is extended by Add() there
+      runs->Add(base + begin, end - begin, 255);
+      if (end == 64) {
+        break;
+      }
+      w &= ~(uint64_t)0 << end;
+    }
+  }
+}
+
+PLUGIN_END_NAMESPACE
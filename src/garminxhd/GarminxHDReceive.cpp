@@ -77,14 +77,12 @@ struct radar_line {
 void GarminxHDReceive::ProcessFrame(const uint8_t *data, size_t len) {
   // log_line.time_rec = wxGetUTCTimeMillis();
   wxLongLong time_rec = wxGetUTCTimeMillis();
-  time_t now = (time_t)(time_rec.GetValue() / MILLISECONDS_PER_SECOND);
 
   radar_line *packet = (radar_line *)data;
 
   wxCriticalSectionLocker lock(m_ri->m_exclusive);
 
-  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
-  m_ri->m_data_timeout = now + DATA_TIMEOUT;
+  m_ri->m_lifecycle.DataReceived();
   m_ri->m_state.Update(RADAR_TRANSMIT);
 
   const size_t packet_header_length = sizeof(radar_line) - GARMIN_XHD_MAX_SPOKE_LEN;
@@ -124,7 +122,7 @@ void GarminxHDReceive::ProcessFrame(const uint8_t *data, size_t len) {
   SpokeBearing a = MOD_SPOKES(angle_raw);
   SpokeBearing b = MOD_SPOKES(bearing_raw);
 
-  m_ri->m_range.Update(packet->range_meters);
+  m_ri->m_control_journal.Set(CT_RANGE, packet->range_meters);
   m_ri->ProcessRadarSpoke(a, b, packet->line_data, len, packet->display_meters, time_rec);
 }
 
@@ -149,8 +147,8 @@ bool GarminxHDReceive::IsValidGarminAddress(struct ifaddrs *nif) {
   return false;
 }
 
-SOCKET GarminxHDReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
+bool GarminxHDReceive::PickNextEthernetCard() {
+  bool joined = false;
   m_interface_addr = NetworkAddress();
 
   // Pick the next ethernet card
@@ -179,30 +177,29 @@ SOCKET GarminxHDReceive::PickNextEthernetCard() {
     m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
     m_interface_addr.port = 0;
 
-    socket = GetNewReportSocket();
+    joined = JoinReportGroup();
   } else {
     wxString s;
     s << _("No interface found") << wxT("\n");
     s << _("Interface must match") << wxT(" 172.16/12");
     SetInfoStatus(s);
 
-    socket = GetNewReportSocket();
+    joined = JoinReportGroup();
   }
 
-  return socket;
+  return joined;
 }
 
-SOCKET GarminxHDReceive::GetNewReportSocket() {
-  SOCKET socket;
+bool GarminxHDReceive::JoinReportGroup() {
   wxString error;
 
   if (m_interface_addr.addr.s_addr == 0) {
-    return INVALID_SOCKET;
+    return false;
   }
 
   error = wxT("");
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_report_addr, error);
-  if (socket != INVALID_SOCKET) {
+  bool joined = m_multicast.Join(m_interface_addr, m_report_addr, error);
+  if (joined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = m_report_addr.FormatNetworkAddressPort();
 
@@ -215,20 +212,19 @@ SOCKET GarminxHDReceive::GetNewReportSocket() {
     SetInfoStatus(error);
     wxLogError(wxT("Unable to listen to socket: %s"), error.c_str());
   }
-  return socket;
+  return joined;
 }
 
-SOCKET GarminxHDReceive::GetNewDataSocket() {
-  SOCKET socket;
+bool GarminxHDReceive::JoinDataGroup() {
   wxString error;
 
   if (m_interface_addr.addr.s_addr == 0) {
-    return INVALID_SOCKET;
+    return false;
   }
 
   error.Printf(wxT("%s data: "), m_ri->m_name.c_str());
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_data_addr, error);
-  if (socket != INVALID_SOCKET) {
+  bool joined = m_multicast.Join(m_interface_addr, m_data_addr, error);
+  if (joined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = m_data_addr.FormatNetworkAddressPort();
 
@@ -237,7 +233,7 @@ SOCKET GarminxHDReceive::GetNewDataSocket() {
     SetInfoStatus(error);
     wxLogError(wxT("Unable to listen to socket: %s"), error.c_str());
   }
-  return socket;
+  return joined;
 }
 
 /*
@@ -255,43 +251,43 @@ void *GarminxHDReceive::Entry(void) {
     sockaddr_in ipv4;
   } rx_addr;
   socklen_t rx_len;
+  MulticastSource source;
 
   uint8_t data[sizeof(radar_line)];
   m_interface_array = 0;
   m_interface = 0;
-  struct sockaddr_in radarFoundAddr;
-  sockaddr_in *radar_addr = 0;
+  bool detected = false;
 
-  SOCKET dataSocket = INVALID_SOCKET;
-  SOCKET reportSocket = INVALID_SOCKET;
+  bool data_joined = false;
+  bool report_joined = false;
 
   LOG_VERBOSE(wxT("GarminxHDReceive thread %s starting"), m_ri->m_name.c_str());
 
   if (m_interface_addr.addr.s_addr == 0) {
-    reportSocket = GetNewReportSocket();
+    report_joined = JoinReportGroup();
   }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
+    if (!report_joined) {
+      report_joined = PickNextEthernetCard();
+      if (report_joined) {
         no_data_timeout = 0;
         no_spoke_timeout = 0;
       }
     }
-    if (radar_addr) {
+    if (detected) {
       // If we have detected a radar antenna at this address start opening more sockets.
       // We do this later for 2 reasons:
       // - Resource consumption
       // - Timing. If we start processing radar data before the rest of the system
       //           is initialized then we get ordering/race condition issues.
-      if (dataSocket == INVALID_SOCKET) {
-        dataSocket = GetNewDataSocket();
+      if (!data_joined) {
+        data_joined = JoinDataGroup();
       }
     } else {
-      if (dataSocket != INVALID_SOCKET) {
-        closesocket(dataSocket);
-        dataSocket = INVALID_SOCKET;
+      if (data_joined) {
+        m_multicast.Leave(m_data_addr);
+        data_joined = false;
       }
     }
 
@@ -305,13 +301,10 @@ void *GarminxHDReceive::Entry(void) {
       FD_SET(m_receive_socket, &fdin);
       maxFd = MAX(m_receive_socket, maxFd);
     }
-    if (reportSocket != INVALID_SOCKET) {
-      FD_SET(reportSocket, &fdin);
-      maxFd = MAX(reportSocket, maxFd);
-    }
-    if (dataSocket != INVALID_SOCKET) {
-      FD_SET(dataSocket, &fdin);
-      maxFd = MAX(dataSocket, maxFd);
+    SOCKET wakeSocket = m_multicast.GetWakeSocket();
+    if (wakeSocket != INVALID_SOCKET) {
+      FD_SET(wakeSocket, &fdin);
+      maxFd = MAX(wakeSocket, maxFd);
     }
 
     r = select(maxFd + 1, &fdin, 0, 0, &tv);
@@ -326,50 +319,47 @@ void *GarminxHDReceive::Entry(void) {
         }
       }
 
-      if (dataSocket != INVALID_SOCKET && FD_ISSET(dataSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          ProcessFrame(data, (size_t)r);
-          no_data_timeout = -15;
-          no_spoke_timeout = -5;
-        } else {
-          closesocket(dataSocket);
-          dataSocket = INVALID_SOCKET;
-          wxLogError(wxT("%s illegal frame"), m_ri->m_name.c_str());
-        }
-      }
-
-      if (reportSocket != INVALID_SOCKET && FD_ISSET(reportSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          NetworkAddress radar_address;
-          radar_address.addr = rx_addr.ipv4.sin_addr;
-          radar_address.port = rx_addr.ipv4.sin_port;
-
-          if (ProcessReport(data, (size_t)r)) {
-            if (!radar_addr) {
-              wxCriticalSectionLocker lock(m_lock);
-              m_ri->DetectedRadar(m_interface_addr, radar_address);  // enables transmit data
-
-              // the dataSocket is opened in the next loop
-
-              radarFoundAddr = rx_addr.ipv4;
-              radar_addr = &radarFoundAddr;
-              m_addr = radar_address.FormatNetworkAddress();
-
-              if (m_ri->m_state.GetValue() == RADAR_OFF) {
-                LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), m_addr.c_str());
-                m_ri->m_state.Update(RADAR_STANDBY);
+      if (wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &fdin)) {
+        // Frames and reports, in the order the dispatcher queued them
+        while ((r = m_multicast.Receive(data, sizeof(data), &source)) >= 0) {
+          if (data_joined && source.group == m_data_addr) {
+            if (r > 0) {
+              ProcessFrame(data, (size_t)r);
+              m_ri->m_control_journal.Commit();
+              no_data_timeout = -15;
+              no_spoke_timeout = -5;
+            } else {
+              m_multicast.Leave(m_data_addr);
+              data_joined = false;
+              wxLogError(wxT("%s illegal frame"), m_ri->m_name.c_str());
+            }
+          } else if (report_joined && source.group == m_report_addr) {
+            if (r > 0) {
+              bool is_report = ProcessReport(data, (size_t)r);
+              m_ri->m_control_journal.Commit();
+              if (is_report) {
+                if (!detected) {
+                  wxCriticalSectionLocker lock(m_lock);
+                  m_ri->DetectedRadar(m_interface_addr, source.from);  // enables transmit data
+
+                  // the data group is joined in the next loop
+
+                  detected = true;
+                  m_addr = source.from.FormatNetworkAddress();
+
+                  if (m_ri->m_state.GetValue() == RADAR_OFF) {
+                    LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), m_addr.c_str());
+                    m_ri->m_state.Update(RADAR_STANDBY);
+                  }
+                }
+                no_data_timeout = SECONDS_SELECT(-15);
               }
+            } else {
+              wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
+              m_multicast.Leave(m_report_addr);
+              report_joined = false;
             }
-            no_data_timeout = SECONDS_SELECT(-15);
           }
-        } else {
-          wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
         }
       }
 
@@ -377,12 +367,12 @@ void *GarminxHDReceive::Entry(void) {
 
       if (no_data_timeout >= SECONDS_SELECT(2)) {
         no_data_timeout = 0;
-        if (reportSocket != INVALID_SOCKET) {
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
+        if (report_joined) {
+          m_multicast.Leave(m_report_addr);
+          report_joined = false;
           m_ri->m_state.Update(RADAR_OFF);
           m_interface_addr = NetworkAddress();
-          radar_addr = 0;
+          detected = false;
         }
       } else {
         no_data_timeout++;
@@ -396,22 +386,17 @@ void *GarminxHDReceive::Entry(void) {
       }
     }
 
-    if (reportSocket == INVALID_SOCKET) {
-      // If we closed the reportSocket then close the command and data socket
-      if (dataSocket != INVALID_SOCKET) {
-        closesocket(dataSocket);
-        dataSocket = INVALID_SOCKET;
+    if (!report_joined) {
+      // If we left the report group then leave the data group too
+      if (data_joined) {
+        m_multicast.Leave(m_data_addr);
+        data_joined = false;
       }
     }
 
   }  // endless loop until thread destroy
 
-  if (dataSocket != INVALID_SOCKET) {
-    closesocket(dataSocket);
-  }
-  if (reportSocket != INVALID_SOCKET) {
-    closesocket(reportSocket);
-  }
+  m_multicast.LeaveAll();
   if (m_send_socket != INVALID_SOCKET) {
     closesocket(m_send_socket);
     m_send_socket = INVALID_SOCKET;
@@ -492,7 +477,6 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
     m_radar_status = status;
 
     wxString stat;
-    time_t now = time(0);
 
     switch (m_radar_status) {
       case 2:
@@ -507,7 +491,7 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
         break;
       case 4:
         m_ri->m_state.Update(RADAR_SPINNING_UP);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         LOG_VERBOSE(wxT("%s reports status SPINNING UP"), m_ri->m_name.c_str());
         stat = _("Spinning up");
         break;
@@ -518,7 +502,7 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
         break;
       case 6:
         m_ri->m_state.Update(RADAR_STOPPING);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         LOG_VERBOSE(wxT("%s reports status STOPPING"), m_ri->m_name.c_str());
         stat = _("Stopping");
         break;
@@ -546,9 +530,8 @@ bool GarminxHDReceive::UpdateScannerStatus(int status) {
 bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
   LOG_BINARY_REPORTS(wxString::Format(wxT("%s report"), m_ri->m_name.c_str()), report, len);
 
-  time_t now = time(0);
 
-  m_ri->resetTimeout(now);
+  m_ri->m_lifecycle.ReportReceived();
 
   if (len >= sizeof(rad_ctl_pkt_9)) {  //  sizeof(rad_respond_pkt_9)) {
     rad_ctl_pkt_9 *packet9 = (rad_ctl_pkt_9 *)report;
@@ -559,7 +542,7 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
     switch (packet_type) {
       case 0x0916:  // Dome Speed
         LOG_VERBOSE(wxT("Garmin xHD 0x0916: scan speed %d"), packet9->parm1);
-        m_ri->m_scan_speed.Update(packet9->parm1 >> 1);
+        m_ri->m_control_journal.Set(CT_SCAN_SPEED, packet9->parm1 >> 1);
         return true;
 
       case 0x0919:  // Standby/Transmit
@@ -571,7 +554,7 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
 
       case 0x091e:  // Range
         LOG_VERBOSE(wxT("Garmin xHD 0x091e: range %d"), packet12->parm1);
-        m_ri->m_range.Update(packet12->parm1);  // Range in meters
+        m_ri->m_control_journal.Set(CT_RANGE, packet12->parm1);  // Range in meters
         return true;
 
         //
@@ -609,18 +592,18 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
           }
         }
         LOG_VERBOSE(wxT("%s m_gain.Update(%d, %d)"), m_ri->m_name.c_str(), m_gain, (int)state);
-        m_ri->m_gain.Update(m_gain, state);
+        m_ri->m_control_journal.Set(CT_GAIN, m_gain, state);
         return true;
       }
 
       case 0x0930:  // Dome offset, called bearing alignment here
         LOG_VERBOSE(wxT("Garmin xHD 0x0930: bearing alignment %d"), (int32_t)packet12->parm1 / 32);
-        m_ri->m_bearing_alignment.Update((int32_t)packet12->parm1 / 32);
+        m_ri->m_control_journal.Set(CT_BEARING_ALIGNMENT, (int32_t)packet12->parm1 / 32);
         return true;
 
       case 0x0932:  // Crosstalk reject, I guess this is the same as interference rejection?
         LOG_VERBOSE(wxT("Garmin xHD 0x0932: crosstalk/interference rejection %d"), packet9->parm1);
-        m_ri->m_interference_rejection.Update(packet9->parm1);
+        m_ri->m_control_journal.Set(CT_INTERFERENCE_REJECTION, packet9->parm1);
         return true;
 
       case 0x0933:  // Rain clutter mode
@@ -641,7 +624,7 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
         // Rain clutter level
         LOG_VERBOSE(wxT("Garmin xHD 0x0934: rain clutter %d"), packet10->parm1);
         m_rain_clutter = packet10->parm1 / 100;
-        m_ri->m_rain.Update(m_rain_clutter, m_rain_mode);
+        m_ri->m_control_journal.Set(CT_RAIN, m_rain_clutter, m_rain_mode);
         return true;
       }
 
@@ -674,7 +657,7 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
         // Sea Clutter level
         LOG_VERBOSE(wxT("Garmin xHD 0x093a: sea clutter %d"), packet10->parm1);
         m_sea_clutter = packet10->parm1 / 100;
-        m_ri->m_sea.Update(m_sea_clutter, m_sea_mode);
+        m_ri->m_control_journal.Set(CT_SEA, m_sea_clutter, m_sea_mode);
         return true;
       }
 
@@ -683,7 +666,7 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
         LOG_VERBOSE(wxT("Garmin xHD 0x093a: sea clutter auto %d"), packet9->parm1);
         if (m_sea_mode >= RCS_AUTO_1) {
           m_sea_mode = (RadarControlState)(RCS_AUTO_1 + packet9->parm1);
-          m_ri->m_sea.Update(m_sea_clutter, m_sea_mode);
+          m_ri->m_control_journal.Set(CT_SEA, m_sea_clutter, m_sea_mode);
         }
         return true;
       }
@@ -694,8 +677,8 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
         // parm1 = 0 = Zone off, in that case we want AUTO_RANGE - 1 = 'Off'.
         // parm1 = 1 = Zone on, in that case we will receive 0x0940+0x0941.
         if (!m_no_transmit_zone_mode) {
-          m_ri->m_no_transmit_start[0].Update(0, RCS_OFF);
-          m_ri->m_no_transmit_end[0].Update(0, RCS_OFF);
+          m_ri->m_control_journal.Set(CT_NO_TRANSMIT_START_1, 0, RCS_OFF);
+          m_ri->m_control_journal.Set(CT_NO_TRANSMIT_END_1, 0, RCS_OFF);
         }
         m_ri->m_no_transmit_zones = 1;
         return true;
@@ -703,14 +686,14 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
       case 0x0940: {
         LOG_VERBOSE(wxT("Garmin xHD 0x0940: no transmit zone start %d"), (int32_t)packet12->parm1 / 32);
         if (m_no_transmit_zone_mode) {
-          m_ri->m_no_transmit_start[0].Update((int32_t)packet12->parm1 / 32, RCS_MANUAL);
+          m_ri->m_control_journal.Set(CT_NO_TRANSMIT_START_1, (int32_t)packet12->parm1 / 32, RCS_MANUAL);
         }
         return true;
       }
       case 0x0941: {
         LOG_VERBOSE(wxT("Garmin xHD 0x0941: no transmit zone end %d"), (int32_t)packet12->parm1 / 32);
         if (m_no_transmit_zone_mode) {
-          m_ri->m_no_transmit_end[0].Update((int32_t)packet12->parm1 / 32, RCS_MANUAL);
+          m_ri->m_control_journal.Set(CT_NO_TRANSMIT_END_1, (int32_t)packet12->parm1 / 32, RCS_MANUAL);
         }
         return true;
       }
@@ -734,14 +717,14 @@ bool GarminxHDReceive::ProcessReport(const uint8_t *report, size_t len) {
 
       case 0x0943: {
         LOG_VERBOSE(wxT("Garmin xHD 0x0943: timed idle time %d s"), (int32_t)packet10->parm1);
-        m_ri->m_timed_idle.Update(packet10->parm1 / 60, m_timed_idle_mode);
+        m_ri->m_control_journal.Set(CT_TIMED_IDLE, packet10->parm1 / 60, m_timed_idle_mode);
 
         return true;
       }
 
       case 0x0944: {
         LOG_VERBOSE(wxT("Garmin xHD 0x0944: timed run time %d s"), (int32_t)packet10->parm1);
-        m_ri->m_timed_run.Update(packet10->parm1 / 60);
+        m_ri->m_control_journal.Set(CT_TIMED_RUN, packet10->parm1 / 60);
         return true;
       }
 
@@ -80,17 +80,7 @@ bool NavicoControl::Init(radar_pi *pi, RadarInfo *ri, NetworkAddress &ifadr, Net
 }
 
 void NavicoControl::logBinaryData(const wxString &what, const uint8_t *data, int size) {
-  wxString explain;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("") + m_name.c_str() + wxT(" ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), data[i]);
-  }
-  LOG_TRANSMIT(explain);
+  m_pi->logBinaryData(m_name + wxT(" ") + what, data, size);
 }
 
 bool NavicoControl::TransmitCmd(const NetworkAddress &send_address, const uint8_t *msg, int size) {
@@ -170,6 +160,7 @@ bool NavicoControl::SetControlValue(ControlType controlType, RadarControlItem &i
     case CT_ANTENNA_STARBOARD:
     case CT_AUTOTTRACKDOPPLER:
     case CT_CENTER_VIEW:
+    case CT_CFAR:
     case CT_COLOR_GAIN:
     case CT_DISPLAY_TIMING:
     case CT_FTC:
@@ -182,6 +173,7 @@ bool NavicoControl::SetControlValue(ControlType controlType, RadarControlItem &i
     case CT_RANGE:
     case CT_RANGE_ADJUSTMENT:
     case CT_REFRESHRATE:
+    case CT_SCAN_CORRELATION:
     case CT_STC:
     case CT_STC_CURVE:
     case CT_TARGET_ON_PPI:
@@ -42,74 +42,20 @@ PLUGIN_BEGIN_NAMESPACE
 static const NetworkAddress reportNavicoCommon(236, 6, 7, 5, 6878);
 
 #define SECONDS_PER_SELECT (1)
-#define PERIOD_UNTIL_CARD_REFRESH (60)
 #define PERIOD_UNTIL_WAKE_RADAR (30)
 
-void NavicoLocate::CleanupCards() {
-  if (m_interface_addr) {
-    delete[] m_interface_addr;
-    m_interface_addr = 0;
-  }
-  if (m_socket) {
-    for (size_t i = 0; i < m_interface_count; i++) {
-      if (m_socket[i] != INVALID_SOCKET) {
-        closesocket(m_socket[i]);
-      }
-    }
-    delete[] m_socket;
-    m_socket = 0;
-  }
-  m_interface_count = 0;
-  ClearErrors();
-}
-
-void NavicoLocate::UpdateEthernetCards() {
-  struct ifaddrs *addr_list;
-  struct ifaddrs *addr;
-  size_t i = 0;
-  wxString error;
-
-  CleanupCards();
-
-  if (!getifaddrs(&addr_list)) {
-    // Count the # of active IPv4 cards
-    for (addr = addr_list; addr; addr = addr->ifa_next) {
-      if (VALID_IPV4_ADDRESS(addr)) {
-        m_interface_count++;
-      }
-    }
-    LOG_VERBOSE(wxT("Found %d ethernet cards"), m_interface_count);
-
-    // If there are any fill packed array (m_socket, m_interface_addr) with them.
-    if (m_interface_count > 0) {
-      m_socket = new SOCKET[m_interface_count];
-      m_interface_addr = new NetworkAddress[m_interface_count];
-
-      for (addr = addr_list; addr; addr = addr->ifa_next) {
-        if (VALID_IPV4_ADDRESS(addr)) {
-          struct sockaddr_in *sa = (struct sockaddr_in *)addr->ifa_addr;
-          m_interface_addr[i].addr = sa->sin_addr;
-          m_interface_addr[i].port = 0;
-          error = wxString::Format(wxT("Cannot scan interface %s: "), m_interface_addr[i].FormatNetworkAddress());
-          m_socket[i] = startUDPMulticastReceiveSocket(m_interface_addr[i], reportNavicoCommon, error);
-          if (m_socket[i] == INVALID_SOCKET) {
-            wxLogError(error);
-            AddError(error);
-          } else {
-            LOG_VERBOSE(wxT("Scanning interface %s for radars on socket %d"), m_interface_addr[i].FormatNetworkAddress(),
-                        m_socket[i]);
-          }
-          i++;
-        }
-      }
-    }
+// Returns true when the ethernet cards changed.
+bool NavicoLocate::UpdateEthernetCards() {
+  wxString errors;
 
-    freeifaddrs(addr_list);
-  } else {
-    wxLogError(wxT("No ethernet cards found"));
+  if (!m_groups.Update(&errors)) {
+    return false;
   }
 
-  WakeRadar();
+  // All sockets that failed before were retried, so this replaces all earlier errors
+  wxCriticalSectionLocker lock(m_exclusive);
+  m_errors = errors;
+  return true;
 }
 
 /*
@@ -120,13 +66,8 @@ void NavicoLocate::UpdateEthernetCards() {
  */
 void *NavicoLocate::Entry(void) {
   int r = 0;
-  int rescan_network_cards = 0;
   int wake_timeout = 0;
-  union {
-    sockaddr_storage addr;
-    sockaddr_in ipv4;
-  } rx_addr;
-  socklen_t rx_len;
+  MulticastSource source;
 
   uint8_t data[1500];
 
@@ -134,7 +75,9 @@ void *NavicoLocate::Entry(void) {
 
   m_is_shutdown = false;
 
+  m_groups.AddGroup(reportNavicoCommon);
   UpdateEthernetCards();
+  WakeRadar();
 
   while (!m_shutdown) {
     struct timeval tv = {1, 0};
@@ -142,41 +85,28 @@ void *NavicoLocate::Entry(void) {
     FD_ZERO(&fdin);
 
     int maxFd = INVALID_SOCKET;
-    for (size_t i = 0; i < m_interface_count; i++) {
-      if (m_socket[i] != INVALID_SOCKET) {
-        FD_SET(m_socket[i], &fdin);
-        maxFd = MAX(m_socket[i], maxFd);
-        LOG_RECEIVE(wxT("reading from socket %d"), m_socket[i]);
-      }
+    SOCKET sock = m_groups.GetWakeSocket();
+    if (sock != INVALID_SOCKET) {
+      FD_SET(sock, &fdin);
+      maxFd = MAX(sock, maxFd);
     }
 
     r = select(maxFd + 1, &fdin, 0, 0, &tv);
     if (r == -1 && errno != 0) {
+      m_groups.Close();  // Join all of them again
       UpdateEthernetCards();
-      rescan_network_cards = 0;
     }
     if (r > 0) {
-      for (size_t i = 0; i < m_interface_count; i++) {
-        if (m_socket[i] != INVALID_SOCKET && FD_ISSET(m_socket[i], &fdin)) {
-          rx_len = sizeof(rx_addr);
-          r = recvfrom(m_socket[i], (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-          LOG_RECEIVE(wxT("read %d bytes from socket %d"), r, m_socket[i]);
-          if (r > 2) {  // we are not interested in 2 byte messages
-            NetworkAddress radar_address;
-            radar_address.addr = rx_addr.ipv4.sin_addr;
-            radar_address.port = rx_addr.ipv4.sin_port;
-
-            if (ProcessReport(radar_address, m_interface_addr[i], data, (size_t)r)) {
-              rescan_network_cards = -PERIOD_UNTIL_CARD_REFRESH;  // Give double time until we rescan
-              wake_timeout = -PERIOD_UNTIL_WAKE_RADAR;
-            }
+      while ((r = m_groups.Receive(data, sizeof(data), &source)) >= 0) {
+        LOG_RECEIVE(wxT("read %d bytes from %s"), r, source.interface_address.FormatNetworkAddress());
+        if (r > 2) {  // we are not interested in 2 byte messages
+          if (ProcessReport(source.from, source.interface_address, data, (size_t)r)) {
+            wake_timeout = -PERIOD_UNTIL_WAKE_RADAR;
           }
         }
       }
     } else {  // no data received -> select timeout
-      if (++rescan_network_cards >= PERIOD_UNTIL_CARD_REFRESH) {
-        UpdateEthernetCards();
-        rescan_network_cards = 0;
+      if (UpdateEthernetCards()) {
         wake_timeout = PERIOD_UNTIL_WAKE_RADAR - 2;  // Wake radar soon, but not immediately
       }
 
@@ -188,7 +118,7 @@ void *NavicoLocate::Entry(void) {
 
   }  // endless loop until thread destroy
 
-  CleanupCards();
+  m_groups.Close();
 
   LOG_VERBOSE(wxT("thread stopping"));
   m_is_shutdown = true;
@@ -371,18 +301,19 @@ void NavicoLocate::WakeRadar() {
 
   int one = 1;
 
-  for (size_t i = 0; i < m_interface_count; i++) {
+  for (size_t i = 0; i < m_groups.GetCount(); i++) {  // Only one group, so once per card
+    const NetworkAddress &interface_addr = m_groups.GetInterface(i);
     SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    struct sockaddr_in s = m_interface_addr[i].GetSockAddrIn();
+    struct sockaddr_in s = interface_addr.GetSockAddrIn();
 
     if (sock != INVALID_SOCKET) {
       if (!setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one)) &&
           !::bind(sock, (struct sockaddr *)&s, sizeof(s)) &&
           sendto(sock, (const char *)WAKE_COMMAND, sizeof WAKE_COMMAND, 0, (struct sockaddr *)&send_addr, sizeof(send_addr)) ==
               sizeof WAKE_COMMAND) {
-        LOG_VERBOSE(wxT("Sent wake command to radar on %s"), m_interface_addr[i].FormatNetworkAddress());
+        LOG_VERBOSE(wxT("Sent wake command to radar on %s"), interface_addr.FormatNetworkAddress());
       } else {
-        wxLogError(wxT("Failed to send wake command to radars on %s"), m_interface_addr[i].FormatNetworkAddress());
+        wxLogError(wxT("Failed to send wake command to radars on %s"), interface_addr.FormatNetworkAddress());
       }
       closesocket(sock);
     }
@@ -521,17 +452,6 @@ void NavicoLocate::FoundNavicoLocationInfo(const NetworkAddress &addr, const Net
   LOG_INFO(wxT("Failed to allocate info from NavicoLocate to a radar"));
 }
 
-void NavicoLocate::ClearErrors(void) {
-  wxCriticalSectionLocker lock(m_exclusive);
-  m_errors.Clear();
-}
-
-void NavicoLocate::AddError(wxString &error) {
-  wxCriticalSectionLocker lock(m_exclusive);
-  m_errors << wxT("\n");
-  m_errors << error;
-}
-
 void NavicoLocate::AppendErrors(wxString &error) {
   wxCriticalSectionLocker lock(m_exclusive);
   error << m_errors;
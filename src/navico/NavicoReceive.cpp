@@ -69,8 +69,8 @@ PLUGIN_BEGIN_NAMESPACE
 // Without this the Doppler function doesn't work
 static const NetworkAddress haloInfoAddress(239, 238, 55, 73, 7527);
 
-SOCKET g_HaloInfoSocket = INVALID_SOCKET;  // Only _one_ radar is able to create this socket at a time.
-wxCriticalSection g_HaloInfoSocketLock;
+bool g_HaloInfoJoined = false;  // Only _one_ radar is able to receive and send this info at a time.
+wxCriticalSection g_HaloInfoLock;
 
 #pragma pack(push, 1)
 
@@ -270,8 +270,6 @@ void NavicoReceive::InitializeLookupData() {
 // from the radar up to the range indicated in the packet.
 //
 void NavicoReceive::ProcessFrame(const uint8_t *data, size_t len) {
-  time_t now = time(0);
-
   // log_line.time_rec = wxGetUTCTimeMillis();
   wxLongLong time_rec = wxGetUTCTimeMillis();
 
@@ -279,8 +277,7 @@ void NavicoReceive::ProcessFrame(const uint8_t *data, size_t len) {
 
   wxCriticalSectionLocker lock(m_ri->m_exclusive);
 
-  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
-  m_ri->m_data_timeout = now + DATA_TIMEOUT;
+  m_ri->m_lifecycle.DataReceived();
   m_ri->m_state.Update(RADAR_TRANSMIT);
 
   m_ri->m_statistics.packets++;
@@ -430,8 +427,7 @@ void NavicoReceive::ProcessFrame(const uint8_t *data, size_t len) {
   }
 }
 
-SOCKET NavicoReceive::PickNextEthernetCard() {
-  SOCKET socket = INVALID_SOCKET;
+bool NavicoReceive::PickNextEthernetCard() {
   m_interface_addr = NetworkAddress();
 
   // Pick the next ethernet card
@@ -460,12 +456,10 @@ SOCKET NavicoReceive::PickNextEthernetCard() {
     m_interface_addr.addr = ((struct sockaddr_in *)m_interface->ifa_addr)->sin_addr;
     m_interface_addr.port = 0;
   }
-  socket = GetNewReportSocket();
-  return socket;
+  return JoinReportGroup();
 }
 
-SOCKET NavicoReceive::GetNewReportSocket() {
-  SOCKET socket;
+bool NavicoReceive::JoinReportGroup() {
   wxString error = wxT(" ");
   wxString s = wxT(" ");
   RadarLocationInfo current_info = m_ri->GetRadarLocationInfo();
@@ -480,12 +474,12 @@ SOCKET NavicoReceive::GetNewReportSocket() {
   if (m_interface_addr.IsNull()) {
     LOG_RECEIVE(wxT("%s no interface address to listen on"), m_ri->m_name.c_str());
     wxMilliSleep(200);  // don't make the log too large
-    return INVALID_SOCKET;
+    return false;
   }
   if (m_info.report_addr.IsNull()) {
     LOG_RECEIVE(wxT("%s no report address to listen on"), m_ri->m_name.c_str());
     wxMilliSleep(200);
-    return INVALID_SOCKET;
+    return false;
   }
 
   if (RadarOrder[m_ri->m_radar_type] >= RO_PRIMARY) {
@@ -494,9 +488,9 @@ SOCKET NavicoReceive::GetNewReportSocket() {
     }
   }
 
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_info.report_addr, error);
+  bool joined = m_multicast.Join(m_interface_addr, m_info.report_addr, error);
 
-  if (socket != INVALID_SOCKET) {
+  if (joined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = m_info.report_addr.FormatNetworkAddressPort();
 
@@ -509,20 +503,19 @@ SOCKET NavicoReceive::GetNewReportSocket() {
     SetInfoStatus(s);
     wxLogError(wxT("%s Unable to listen to socket: %s"), m_ri->m_name.c_str(), error.c_str());
   }
-  return socket;
+  return joined;
 }
 
-SOCKET NavicoReceive::GetNewDataSocket() {
-  SOCKET socket;
+bool NavicoReceive::JoinDataGroup() {
   wxString error;
 
   if (m_interface_addr.addr.s_addr == 0) {
-    return INVALID_SOCKET;
+    return false;
   }
 
   error.Printf(wxT("%s data: "), m_ri->m_name.c_str());
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_info.spoke_data_addr, error);
-  if (socket != INVALID_SOCKET) {
+  bool joined = m_multicast.Join(m_interface_addr, m_info.spoke_data_addr, error);
+  if (joined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = m_info.spoke_data_addr.FormatNetworkAddressPort();
 
@@ -531,36 +524,36 @@ SOCKET NavicoReceive::GetNewDataSocket() {
     SetInfoStatus(error);
     wxLogError(wxT("Unable to listen to socket: %s"), error.c_str());
   }
-  return socket;
+  return joined;
 }
 
 /*
- * Get a socket to the multicast address where MFDs send the HALO the course and time
+ * Join the multicast address where MFDs send the HALO the course and time
  * info that was previously done via the RI-10/11.
  */
-SOCKET NavicoReceive::GetNewInfoSocket() {
+bool NavicoReceive::JoinInfoGroup() {
   wxString error;
 
   // This is only necessary on HALO radars
   if (!IS_HALO) {
     LOG_RECEIVE(wxT("%s no halo info socket needed for radar type"), m_ri->m_name.c_str());
-    return INVALID_SOCKET;
+    return false;
   }
   if (m_interface_addr.addr.s_addr == 0) {
     LOG_RECEIVE(wxT("%s no halo info socket needed when no radar address"), m_ri->m_name.c_str());
-    return INVALID_SOCKET;
+    return false;
   }
 
-  if (g_HaloInfoSocket != INVALID_SOCKET) {
-    // Other thread already has a g_HaloInfoSocket, this thread should NOT use it
-    return INVALID_SOCKET;
-  }
+  wxCriticalSectionLocker lock(g_HaloInfoLock);
 
-  wxCriticalSectionLocker lock(g_HaloInfoSocketLock);
+  if (g_HaloInfoJoined) {
+    // Other thread already receives the info, this thread should NOT use it
+    return false;
+  }
 
   error.Printf(wxT("%s info: "), m_ri->m_name.c_str());
-  g_HaloInfoSocket = startUDPMulticastReceiveSocket(m_interface_addr, haloInfoAddress, error);
-  if (g_HaloInfoSocket != INVALID_SOCKET) {
+  g_HaloInfoJoined = m_multicast.Join(m_interface_addr, haloInfoAddress, error);
+  if (g_HaloInfoJoined) {
     wxString addr = m_interface_addr.FormatNetworkAddress();
     wxString rep_addr = haloInfoAddress.FormatNetworkAddressPort();
 
@@ -569,15 +562,13 @@ SOCKET NavicoReceive::GetNewInfoSocket() {
     SetInfoStatus(error);
     wxLogError(wxT("%s Unable to listen for halo info: %s"), m_ri->m_name.c_str(), error.c_str());
   }
-  return g_HaloInfoSocket;
+  return g_HaloInfoJoined;
 }
 
-void NavicoReceive::ReleaseInfoSocket(void) {
-  wxCriticalSectionLocker lock(g_HaloInfoSocketLock);
-  if (g_HaloInfoSocket != INVALID_SOCKET) {
-    closesocket(g_HaloInfoSocket);
-    g_HaloInfoSocket = INVALID_SOCKET;
-  }
+void NavicoReceive::LeaveInfoGroup(void) {
+  wxCriticalSectionLocker lock(g_HaloInfoLock);
+  m_multicast.Leave(haloInfoAddress);
+  g_HaloInfoJoined = false;
 }
 
 static halo_heading_packet g_heading_msg = {
@@ -663,48 +654,54 @@ void *NavicoReceive::Entry(void) {
     sockaddr_in ipv4;
   } rx_addr;
   socklen_t rx_len;
+  MulticastSource source;
 
   uint8_t data[sizeof(radar_frame_pkt)];
   m_interface_array = 0;
   m_interface = 0;
   NetworkAddress radar_address = NetworkAddress();
 
-  SOCKET dataSocket = INVALID_SOCKET;
-  SOCKET reportSocket = INVALID_SOCKET;
-  SOCKET infoSocket = INVALID_SOCKET;
+  bool data_joined = false;
+  bool report_joined = false;
+  bool info_joined = false;
 
   LOG_VERBOSE(wxT("%s thread starting"), m_ri->m_name.c_str());
-  reportSocket = GetNewReportSocket();  // Start using the same interface_addr as previous time
+  report_joined = JoinReportGroup();  // Start using the same interface_addr as previous time
+  if (!report_joined) {
+    StartDiscoveryCache(false);  // The cached interface is gone
+  }
 
   while (m_receive_socket != INVALID_SOCKET) {
-    if (reportSocket == INVALID_SOCKET) {
-      reportSocket = PickNextEthernetCard();
-      if (reportSocket != INVALID_SOCKET) {
+    if (!report_joined) {
+      report_joined = PickNextEthernetCard();
+      if (report_joined) {
         no_data_timeout = 0;
         no_spoke_timeout = 0;
       }
     }
-    if (!radar_address.IsNull()) {
+    if (!radar_address.IsNull() || (UsingDiscoveryCache() && report_joined)) {
       // If we have detected a radar antenna at this address, start opening more sockets.
       // We do this later for 2 reasons:
       // - Resource consumption
       // - Timing. If we start processing radar data before the rest of the system
       //           is initialized then we get ordering/race condition issues.
-      if (dataSocket == INVALID_SOCKET) {
-        dataSocket = GetNewDataSocket();
+      // The exception is a radar that was seen at the cached addresses last time,
+      // then we listen for its spokes straight away so they show as soon as it transmits.
+      if (!data_joined) {
+        data_joined = JoinDataGroup();
       }
-      if (infoSocket == INVALID_SOCKET) {
-        // One of the two Halo radars will obtain an InfoSocket.
-        infoSocket = GetNewInfoSocket();
+      if (!info_joined) {
+        // One of the two Halo radars will receive the info.
+        info_joined = JoinInfoGroup();
       }
     } else {
-      if (dataSocket != INVALID_SOCKET) {
-        closesocket(dataSocket);
-        dataSocket = INVALID_SOCKET;
+      if (data_joined) {
+        m_multicast.Leave(m_info.spoke_data_addr);
+        data_joined = false;
       }
-      if (infoSocket != INVALID_SOCKET) {
-        ReleaseInfoSocket();
-        infoSocket = INVALID_SOCKET;
+      if (info_joined) {
+        LeaveInfoGroup();
+        info_joined = false;
       }
     }
 
@@ -716,17 +713,10 @@ void *NavicoReceive::Entry(void) {
       FD_SET(m_receive_socket, &fdin);
       maxFd = MAX(m_receive_socket, maxFd);
     }
-    if (reportSocket != INVALID_SOCKET) {
-      FD_SET(reportSocket, &fdin);
-      maxFd = MAX(reportSocket, maxFd);
-    }
-    if (dataSocket != INVALID_SOCKET) {
-      FD_SET(dataSocket, &fdin);
-      maxFd = MAX(dataSocket, maxFd);
-    }
-    if (infoSocket != INVALID_SOCKET) {
-      FD_SET(infoSocket, &fdin);
-      maxFd = MAX(infoSocket, maxFd);
+    SOCKET wakeSocket = m_multicast.GetWakeSocket();
+    if (wakeSocket != INVALID_SOCKET) {
+      FD_SET(wakeSocket, &fdin);
+      maxFd = MAX(wakeSocket, maxFd);
     }
 
     wxLongLong start = wxGetUTCTimeMillis();
@@ -747,84 +737,87 @@ void *NavicoReceive::Entry(void) {
         }
       }
 
-      if (dataSocket != INVALID_SOCKET && FD_ISSET(dataSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(dataSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          ProcessFrame(data, (size_t)r);
-          no_data_timeout = -15;
-          no_spoke_timeout = -5;
-        } else {
-          closesocket(dataSocket);
-          dataSocket = INVALID_SOCKET;
-          wxLogError(wxT("%s illegal frame"), m_ri->m_name.c_str());
-        }
-      }
-
-      if (reportSocket != INVALID_SOCKET && FD_ISSET(reportSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(reportSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          if (ProcessReport(data, (size_t)r)) {
-            if (radar_address.IsNull()) {
-              radar_address.addr = rx_addr.ipv4.sin_addr;
-              radar_address.port = rx_addr.ipv4.sin_port;
-              wxCriticalSectionLocker lock(m_lock);
-              m_ri->DetectedRadar(m_interface_addr, radar_address);  // enables transmit data
-              DetectedRadar(radar_address);
-
-              // the dataSocket is opened in the next loop
-
-              if (m_ri->m_state.GetValue() == RADAR_OFF) {
-                LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), radar_address.FormatNetworkAddress());
-                m_ri->m_state.Update(RADAR_STANDBY);
+      if (wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &fdin)) {
+        // Reports, spokes and halo info, in the order the dispatcher queued them
+        while ((r = m_multicast.Receive(data, sizeof(data), &source)) >= 0) {
+          if (data_joined && source.group == m_info.spoke_data_addr) {
+            if (r > 0) {
+              if (radar_address.IsNull()) {
+                radar_address.addr = source.from.addr;
+                radar_address.port = htons(RadarOrder[m_ri->m_radar_type]);
+                LOG_INFO(wxT("%s spokes received from %s"), m_ri->m_name.c_str(), radar_address.FormatNetworkAddress());
+                wxCriticalSectionLocker lock(m_lock);
+                DetectedRadar(radar_address);
               }
+              ProcessFrame(data, (size_t)r);
+              no_data_timeout = -15;
+              no_spoke_timeout = -5;
+            } else {
+              m_multicast.Leave(m_info.spoke_data_addr);
+              data_joined = false;
+              wxLogError(wxT("%s illegal frame"), m_ri->m_name.c_str());
             }
-            no_data_timeout = SECONDS_SELECT(-15);
-          }
-        } else {
-          wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
-        }
-      }
-
-      if (infoSocket != INVALID_SOCKET && FD_ISSET(infoSocket, &fdin)) {
-        rx_len = sizeof(rx_addr);
-        r = recvfrom(infoSocket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-        if (r > 0) {
-          NetworkAddress mfd_address;
-          mfd_address.addr = rx_addr.ipv4.sin_addr;
-          mfd_address.port = 0;
-          if (m_interface_addr == mfd_address) {
-            LOG_RECEIVE(wxT("%s active mfd detected at %s but that is us"), m_ri->m_name.c_str(),
-                        mfd_address.FormatNetworkAddress());
-          } else {
-            LOG_RECEIVE(wxT("%s active mfd detected at %s"), m_ri->m_name.c_str(), mfd_address.FormatNetworkAddress());
-            m_halo_received_info = wxGetUTCTimeMillis();
-          }
-          IF_LOG_AT(LOGLEVEL_RECEIVE, m_pi->logBinaryData(m_ri->m_name, data, r));
-
-          halo_heading_packet *msg = (halo_heading_packet *)data;
-
-          if (msg->u02[0] == 0x12 && msg->u02[1] == 0xf1) {
-            double heading = (double)msg->heading * 360.0 / ((double)0xf800);  // assume that this is a true heading ?
-            if (m_pi->m_heading_source <= HEADING_FIX_COG || m_pi->m_heading_source >= HEADING_RADAR_HDM) {
-              LOG_RECEIVE(wxT("Received and set radar_heading from network %f"), heading);
-              m_pi->SetRadarHeading(heading, true);  // only set HEADING_RADAR_HDT if nothing better is available
+          } else if (report_joined && source.group == m_info.report_addr) {
+            if (r > 0) {
+              bool is_report = ProcessReport(data, (size_t)r);
+              m_ri->m_control_journal.Commit();
+              if (is_report) {
+                if (radar_address.IsNull()) {
+                  radar_address = source.from;
+                  wxCriticalSectionLocker lock(m_lock);
+                  m_ri->DetectedRadar(m_interface_addr, radar_address);  // enables transmit data
+                  DetectedRadar(radar_address);
+
+                  // the data group is joined in the next loop
+
+                  if (m_ri->m_state.GetValue() == RADAR_OFF) {
+                    LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), radar_address.FormatNetworkAddress());
+                    m_ri->m_state.Update(RADAR_STANDBY);
+                  }
+                }
+                no_data_timeout = SECONDS_SELECT(-15);
+              }
+            } else {
+              wxLogError(wxT("%s illegal report"), m_ri->m_name.c_str());
+              m_multicast.Leave(m_info.report_addr);
+              report_joined = false;
+            }
+          } else if (info_joined && source.group == haloInfoAddress) {
+            if (r > 0) {
+              NetworkAddress mfd_address;
+              mfd_address.addr = source.from.addr;
+              mfd_address.port = 0;
+              if (m_interface_addr == mfd_address) {
+                LOG_RECEIVE(wxT("%s active mfd detected at %s but that is us"), m_ri->m_name.c_str(),
+                            mfd_address.FormatNetworkAddress());
+              } else {
+                LOG_RECEIVE(wxT("%s active mfd detected at %s"), m_ri->m_name.c_str(), mfd_address.FormatNetworkAddress());
+                m_halo_received_info = wxGetUTCTimeMillis();
+              }
+              IF_LOG_AT(LOGLEVEL_RECEIVE, m_pi->logBinaryData(m_ri->m_name, data, r));
+
+              halo_heading_packet *msg = (halo_heading_packet *)data;
+
+              if (msg->u02[0] == 0x12 && msg->u02[1] == 0xf1) {
+                double heading = (double)msg->heading * 360.0 / ((double)0xf800);  // assume that this is a true heading ?
+                if (m_pi->m_heading_source <= HEADING_FIX_COG || m_pi->m_heading_source >= HEADING_RADAR_HDM) {
+                  LOG_RECEIVE(wxT("Received and set radar_heading from network %f"), heading);
+                  m_pi->SetRadarHeading(heading, true);  // only set HEADING_RADAR_HDT if nothing better is available
+                }
+
+                LOG_RECEIVE(wxT("msg.counter = %u"), msg->counter);
+                LOG_RECEIVE(wxT("msg.epoch   = %lld"), msg->epoch);
+                LOG_RECEIVE(wxT("msg.heading = %u -> %f"), msg->heading, heading);
+                LOG_RECEIVE(wxT("msg.u05a    = %x"), msg->u05a);
+                LOG_RECEIVE(wxT("msg.u05b    = %x"), msg->u05b);
+              } else {
+                halo_mystery_packet *msg2 = (halo_mystery_packet *)data;
+                LOG_RECEIVE(wxT("msg.counter = %u"), msg2->counter);
+                LOG_RECEIVE(wxT("msg.epoch   = %lld"), msg2->epoch);
+                LOG_RECEIVE(wxT("msg.mystery1 = %u"), msg2->mystery1);
+                LOG_RECEIVE(wxT("msg.mystery2 = %u"), msg2->mystery2);
+              }
             }
-
-            LOG_RECEIVE(wxT("msg.counter = %u"), msg->counter);
-            LOG_RECEIVE(wxT("msg.epoch   = %lld"), msg->epoch);
-            LOG_RECEIVE(wxT("msg.heading = %u -> %f"), msg->heading, heading);
-            LOG_RECEIVE(wxT("msg.u05a    = %x"), msg->u05a);
-            LOG_RECEIVE(wxT("msg.u05b    = %x"), msg->u05b);
-          } else {
-            halo_mystery_packet *msg2 = (halo_mystery_packet *)data;
-            LOG_RECEIVE(wxT("msg.counter = %u"), msg2->counter);
-            LOG_RECEIVE(wxT("msg.epoch   = %lld"), msg2->epoch);
-            LOG_RECEIVE(wxT("msg.mystery1 = %u"), msg2->mystery1);
-            LOG_RECEIVE(wxT("msg.mystery2 = %u"), msg2->mystery2);
           }
         }
       }
@@ -832,9 +825,9 @@ void *NavicoReceive::Entry(void) {
     } else {  // no data received -> select timeout
       if (no_data_timeout >= SECONDS_SELECT(2)) {
         no_data_timeout = 0;
-        if (reportSocket != INVALID_SOCKET) {
-          closesocket(reportSocket);
-          reportSocket = INVALID_SOCKET;
+        if (report_joined && !(radar_address.IsNull() && UsingDiscoveryCache())) {
+          m_multicast.Leave(m_info.report_addr);
+          report_joined = false;
           m_ri->m_state.Update(RADAR_OFF);
           m_interface_addr = NetworkAddress();
           radar_address = NetworkAddress();
@@ -852,9 +845,9 @@ void *NavicoReceive::Entry(void) {
     }
 
     if (m_pi->m_heading_source > HEADING_FIX_COG && m_pi->m_heading_source < HEADING_RADAR_HDM) {
-      LOG_TRANSMIT(wxT("%s infoSocket=%d received=%lld sent=%lld\n"), m_ri->m_name.c_str(), infoSocket, now - m_halo_received_info,
+      LOG_TRANSMIT(wxT("%s info=%d received=%lld sent=%lld\n"), m_ri->m_name.c_str(), info_joined, now - m_halo_received_info,
                    now - m_halo_sent_heading);
-      if (infoSocket != INVALID_SOCKET && m_halo_received_info + 10000 < now) {
+      if (info_joined && m_halo_received_info + 10000 < now) {
         if (m_halo_sent_heading + 100 < now) {
           SendHeadingPacket();
           m_halo_sent_heading = now;
@@ -868,33 +861,28 @@ void *NavicoReceive::Entry(void) {
 
     if (!(m_info == m_ri->GetRadarLocationInfo())) {
       // Navicolocate modified the RadarInfo in settings
-      closesocket(reportSocket);
-      reportSocket = INVALID_SOCKET;
+      m_multicast.Leave(m_info.report_addr);
+      report_joined = false;
     };
 
-    if (reportSocket == INVALID_SOCKET) {
-      // If we closed the reportSocket then close the command and data socket
-      if (dataSocket != INVALID_SOCKET) {
-        closesocket(dataSocket);
-        dataSocket = INVALID_SOCKET;
+    if (!report_joined) {
+      // If we left the report group then leave the data and info groups
+      if (data_joined) {
+        m_multicast.Leave(m_info.spoke_data_addr);
+        data_joined = false;
       }
-      if (infoSocket != INVALID_SOCKET) {
-        ReleaseInfoSocket();
-        infoSocket = INVALID_SOCKET;
+      if (info_joined) {
+        LeaveInfoGroup();
+        info_joined = false;
       }
     }
 
   }  // endless loop until thread destroy
 
-  if (dataSocket != INVALID_SOCKET) {
-    closesocket(dataSocket);
-  }
-  if (infoSocket != INVALID_SOCKET) {
-    ReleaseInfoSocket();
-  }
-  if (reportSocket != INVALID_SOCKET) {
-    closesocket(reportSocket);
+  if (info_joined) {
+    LeaveInfoGroup();
   }
+  m_multicast.LeaveAll();
   if (m_send_socket != INVALID_SOCKET) {
     closesocket(m_send_socket);
     m_send_socket = INVALID_SOCKET;
@@ -1118,9 +1106,7 @@ static void AppendChar16String(wxString &dest, uint16_t *src) {
 }
 
 bool NavicoReceive::ProcessReport(const uint8_t *report, size_t len) {
-  time_t now = time(0);
-
-  m_ri->resetTimeout(now);
+  m_ri->m_lifecycle.ReportReceived();
 
   LOG_BINARY_REPORTS(wxString::Format(wxT("%s report"), m_ri->m_name.c_str()), report, len);
 
@@ -1171,18 +1157,18 @@ bool NavicoReceive::ProcessReport(const uint8_t *report, size_t len) {
         RadarControlState state;
 
         state = (s->field8 > 0) ? RCS_AUTO_1 : RCS_MANUAL;
-        m_ri->m_gain.Update(s->gain * 100 / 255, state);
+        m_ri->m_control_journal.Set(CT_GAIN, s->gain * 100 / 255, state);
 
-        m_ri->m_rain.Update(s->rain * 100 / 255);
+        m_ri->m_control_journal.Set(CT_RAIN, s->rain * 100 / 255);
 
-        state = (RadarControlState)(RCS_MANUAL + s->sea_auto);
-        m_ri->m_sea.Update(s->sea * 100 / 255, state);
+        m_sea_reported = (RadarControlState)(RCS_MANUAL + s->sea_auto);
+        m_ri->m_control_journal.Set(CT_SEA, s->sea * 100 / 255, m_sea_reported);
 
-        m_ri->m_mode.Update(s->mode);
-        m_ri->m_target_boost.Update(s->target_boost);
-        m_ri->m_interference_rejection.Update(s->interference_rejection);
-        m_ri->m_target_expansion.Update(s->target_expansion);
-        m_ri->m_range.Update(s->range / 10);
+        m_ri->m_control_journal.Set(CT_MODE, s->mode);
+        m_ri->m_control_journal.Set(CT_TARGET_BOOST, s->target_boost);
+        m_ri->m_control_journal.Set(CT_INTERFERENCE_REJECTION, s->interference_rejection);
+        m_ri->m_control_journal.Set(CT_TARGET_EXPANSION, s->target_expansion);
+        m_ri->m_control_journal.Set(CT_RANGE, s->range / 10);
 
         LOG_RECEIVE(wxT("%s state range=%u gain=%u sea=%u rain=%u if_rejection=%u tgt_boost=%u tgt_expansion=%u"),
                     m_ri->m_name.c_str(), s->range, s->gain, s->sea, s->rain, s->interference_rejection, s->target_boost,
@@ -1249,13 +1235,13 @@ bool NavicoReceive::ProcessReport(const uint8_t *report, size_t len) {
 
         // bearing alignment
         int ba = (int)data->bearing_alignment / 10;
-        m_ri->m_bearing_alignment.Update(MOD_DEGREES_180(ba));
+        m_ri->m_control_journal.Set(CT_BEARING_ALIGNMENT, MOD_DEGREES_180(ba));
 
         // antenna height
-        m_ri->m_antenna_height.Update(data->antenna_height / 1000);
+        m_ri->m_control_journal.Set(CT_ANTENNA_HEIGHT, data->antenna_height / 1000);
 
         // accent light
-        m_ri->m_accent_light.Update(data->accent_light);
+        m_ri->m_control_journal.Set(CT_ACCENT_LIGHT, data->accent_light);
 
         LOG_RECEIVE(wxT("%s bearing_alignment=%f antenna_height=%umm accent_light=%u"), m_ri->m_name.c_str(),
                     (int)data->bearing_alignment / 10.0, data->antenna_height, data->accent_light);
@@ -1281,10 +1267,11 @@ bool NavicoReceive::ProcessReport(const uint8_t *report, size_t len) {
         for (int i = 0; i <= 3; i++) {
           LOG_INFO(wxT("%s radar blanking sector %u: enabled=%u start=%u end=%u\n"), m_ri->m_name.c_str(), i + 1,
                    data->blanking[i].enabled, data->blanking[i].start_angle, data->blanking[i].end_angle);
-          m_ri->m_no_transmit_start[i].Update(MOD_DEGREES_180(SCALE_DECIDEGREES_TO_DEGREES(data->blanking[i].start_angle)),
-                                              data->blanking[i].enabled ? RCS_MANUAL : RCS_OFF);
-          m_ri->m_no_transmit_end[i].Update(MOD_DEGREES_180(SCALE_DECIDEGREES_TO_DEGREES(data->blanking[i].end_angle)),
-                                            data->blanking[i].enabled ? RCS_MANUAL : RCS_OFF);
+          RadarControlState state = data->blanking[i].enabled ? RCS_MANUAL : RCS_OFF;
+          m_ri->m_control_journal.Set((ControlType)(CT_NO_TRANSMIT_START_1 + i),
+                                      MOD_DEGREES_180(SCALE_DECIDEGREES_TO_DEGREES(data->blanking[i].start_angle)), state);
+          m_ri->m_control_journal.Set((ControlType)(CT_NO_TRANSMIT_END_1 + i),
+                                      MOD_DEGREES_180(SCALE_DECIDEGREES_TO_DEGREES(data->blanking[i].end_angle)), state);
         }
         m_ri->m_no_transmit_zones = 4;
         LOG_BINARY_RECEIVE(wxT("received sector blanking message"), report, len);
@@ -1323,18 +1310,19 @@ bool NavicoReceive::ProcessReport(const uint8_t *report, size_t len) {
                     s08->sls_auto, s08->side_lobe_suppression);
 
         if (IS_HALO) {
-          m_ri->m_sea_state.Update(s08->sea_state);
-          if (m_ri->m_sea.GetState() == RCS_MANUAL) {
-            m_ri->m_sea.Update(s08->sea_clutter);
+          m_ri->m_control_journal.Set(CT_SEA_STATE, s08->sea_state);
+          // The mode comes from the radar's own 02C4 report, m_sea lags behind the journal
+          if (m_sea_reported == RCS_MANUAL) {
+            m_ri->m_control_journal.Set(CT_SEA, s08->sea_clutter);
           } else {
-            m_ri->m_sea.Update(s08->auto_sea_clutter, RCS_AUTO_1);
+            m_ri->m_control_journal.Set(CT_SEA, s08->auto_sea_clutter, RCS_AUTO_1);
           }
         }
-        m_ri->m_scan_speed.Update(s08->scan_speed);
-        m_ri->m_noise_rejection.Update(s08->noise_rejection);
-        m_ri->m_target_separation.Update(s08->target_sep);
-        m_ri->m_side_lobe_suppression.Update(s08->side_lobe_suppression * 100 / 255, s08->sls_auto ? RCS_AUTO_1 : RCS_MANUAL);
-        m_ri->m_local_interference_rejection.Update(s08->local_interference_rejection);
+        m_ri->m_control_journal.Set(CT_SCAN_SPEED, s08->scan_speed);
+        m_ri->m_control_journal.Set(CT_NOISE_REJECTION, s08->noise_rejection);
+        m_ri->m_control_journal.Set(CT_TARGET_SEPARATION, s08->target_sep);
+        m_ri->m_control_journal.Set(CT_SIDE_LOBE_SUPPRESSION, s08->side_lobe_suppression * 100 / 255, s08->sls_auto ? RCS_AUTO_1 : RCS_MANUAL);
+        m_ri->m_control_journal.Set(CT_LOCAL_INTERFERENCE_REJECTION, s08->local_interference_rejection);
 
         break;
       }
@@ -34,13 +34,16 @@
 
 #include "radar_pi.h"
 
+#include "FrameScheduler.h"
 #include "GuardZone.h"
 #include "GuardZoneBogey.h"
 #include "Kalman.h"
 #include "MessageBox.h"
 #include "OptionsDialog.h"
+#include "PacketTrace.h"
 #include "RadarMarpa.h"
 #include "SelectDialog.h"
+#include "TextureFont.h"
 #include "icons.h"
 #include "navico/NavicoLocate.h"
 #include "nmea0183.h"
@@ -118,11 +121,18 @@ static double radar_distance(GeoPosition pos1, GeoPosition pos2, char unit) {
 
 enum { TIMER_ID = 51 };
 enum { UPDATE_TIMER_ID = 52 };
+enum { DEADLINE_TIMER_ID = 53 };
+
+wxDEFINE_EVENT(EVT_RADAR_GUARD_ZONE_TRIPPED, wxCommandEvent);
+wxDEFINE_EVENT(EVT_RADAR_LIFECYCLE_WAKE, wxCommandEvent);
 
 #define UPDATE_INTERVAL 500
 BEGIN_EVENT_TABLE(radar_pi, wxEvtHandler)
 EVT_TIMER(TIMER_ID, radar_pi::OnTimerNotify)
 EVT_TIMER(UPDATE_TIMER_ID, radar_pi::TimedUpdate)
+EVT_TIMER(DEADLINE_TIMER_ID, radar_pi::OnDeadlineTimer)
+EVT_COMMAND(wxID_ANY, EVT_RADAR_GUARD_ZONE_TRIPPED, radar_pi::OnGuardZoneTripped)
+EVT_COMMAND(wxID_ANY, EVT_RADAR_LIFECYCLE_WAKE, radar_pi::OnLifecycleWake)
 END_EVENT_TABLE()
 
 //---------------------------------------------------------------------------------------------------------
@@ -131,7 +141,8 @@ END_EVENT_TABLE()
 //
 //---------------------------------------------------------------------------------------------------------
 
-radar_pi::radar_pi(void *ppimgr) : opencpn_plugin_116(ppimgr), m_raymarine_locator(0) {
+radar_pi::radar_pi(void *ppimgr)
+    : opencpn_plugin_116(ppimgr), m_raymarine_locator(0), m_deadlines(RADARS * LT_TIMERS), m_network_interfaces(this) {
   m_boot_time = wxGetUTCTimeMillis();
   m_initialized = false;
   m_predicted_position_initialised = false;
@@ -148,7 +159,12 @@ radar_pi::radar_pi(void *ppimgr) : opencpn_plugin_116(ppimgr), m_raymarine_locat
   m_opencpn_gl_context_broken = false;
 
   m_timer = 0;
+  m_frame_period = 0;
+  m_frame_scheduler = 0;
+  m_trace = 0;
+  m_multicast_dispatcher = 0;
   m_update_timer = 0;
+  m_deadline_timer = 0;
   for (int r = 0; r < RADARS; r++) {
     m_context_menu_control_id[r] = -1;
   }
@@ -220,6 +236,8 @@ int radar_pi::Init(void) {
   m_opengl_mode_changed = false;
   m_notify_radar_window_viz = false;
   m_notify_control_dialog = false;
+  m_notify_guard_zone_tripped = false;
+  m_notify_lifecycle = false;
 
   m_render_busy = false;
   m_bogey_dialog = 0;
@@ -259,6 +277,8 @@ int radar_pi::Init(void) {
 
   m_navico_locator = 0;
   m_raymarine_locator = 0;
+  m_frame_scheduler = new FrameScheduler();
+  m_trace = 0;
 
   // Create objects before config, so config can set data in it
   // This does not start any threads or generate any UI.
@@ -291,6 +311,16 @@ int radar_pi::Init(void) {
     LOG_RECEIVE(wxT("RECEIVE  log is enabled"));
     LOG_GUARD(wxT("GUARD    log is enabled"));
     LOG_ARPA(wxT("ARPA     log is enabled"));
+    if (m_settings.verbose != 0) {
+      wxString trace_file = *GetpPrivateApplicationDataLocation() + wxFileName::GetPathSeparator() +
+                            wxDateTime::Now().Format(wxT("radar_pi-%Y%m%d-%H%M%S.")) + TRACE_EXTENSION;
+      m_trace = new PacketTrace(this, trace_file);
+      if (m_trace->Run() != wxTHREAD_NO_ERROR) {
+        wxLogError(wxT("unable to start packet trace thread"));
+        delete m_trace;
+        m_trace = 0;
+      }
+    }
   } else {
     wxLogError(wxT("configuration file values initialisation failed"));
     return 0;  // give up
@@ -304,6 +334,15 @@ int radar_pi::Init(void) {
                                   _("Radar plugin with support for multiple radars"), NULL, RADAR_TOOL_POSITION, 0, this);
 
   // CacheSetToolbarToolBitmaps(BM_ID_RED, BM_ID_BLANK);
+
+  // Before any locator or receive thread wants to join a multicast group
+  m_multicast_dispatcher = new MulticastDispatcher(this);
+  if (m_multicast_dispatcher->Run() != wxTHREAD_NO_ERROR) {
+    wxLogError(wxT("unable to start multicast dispatcher thread"));
+    delete m_multicast_dispatcher;
+    m_multicast_dispatcher = 0;
+  }
+
   // Now that the settings are made we can initialize the RadarInfos
   for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
     m_radar[r]->Init();
@@ -360,6 +399,8 @@ int radar_pi::Init(void) {
   m_timer = new wxTimer(this, TIMER_ID);
   m_update_timer = new wxTimer(this, UPDATE_TIMER_ID);
   m_update_timer->Start(UPDATE_INTERVAL);
+  m_deadline_timer = new wxTimer(this, DEADLINE_TIMER_ID);
+  ScheduleDeadlines();
 
   return PLUGIN_OPTIONS;
 }
@@ -424,6 +465,11 @@ bool radar_pi::DeInit(void) {
     delete m_update_timer;
     m_update_timer = 0;
   }
+  if (m_deadline_timer) {
+    m_deadline_timer->Stop();
+    delete m_deadline_timer;
+    m_deadline_timer = 0;
+  }
 
   StopRadarLocators();
 
@@ -436,6 +482,13 @@ bool radar_pi::DeInit(void) {
 
   StopRadarLocators();
 
+  if (m_trace) {
+    m_trace->Shutdown();
+    m_trace->Wait();
+    delete m_trace;
+    m_trace = 0;
+  }
+
   if (m_bogey_dialog) {
     delete m_bogey_dialog;  // This will also save its current pos in m_settings
     m_bogey_dialog = 0;
@@ -449,6 +502,13 @@ bool radar_pi::DeInit(void) {
   RemoveCanvasContextMenuItem(m_context_menu_delete_all_radar_targets);
   LOG_INFO(wxT("radar_pi Context menus removed"));
 
+  // Free the GL objects the overlays made in OpenCPN's context, which outlives the plugin.
+  // The radar windows free theirs when their canvas is destroyed, below.
+  bool chart_context_current = SetChartOpenGLContextCurrent();
+  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+    m_radar[r]->ReleaseOverlayGeometry(chart_context_current);
+  }
+
   // Delete the RadarInfo objects. This will call their destructor and delete all data.
   // To guard against recursive entry for redraw set the global radar_count to zero.
   size_t radar_count = M_SETTINGS.radar_count;
@@ -458,6 +518,17 @@ bool radar_pi::DeInit(void) {
   }
   M_SETTINGS.radar_count = 0;
 
+  // All its subscribers are gone now
+  if (m_multicast_dispatcher) {
+    m_multicast_dispatcher->Shutdown();
+    m_multicast_dispatcher->Wait();
+    delete m_multicast_dispatcher;
+    m_multicast_dispatcher = 0;
+  }
+
+  // The canvases went with their radars, so nothing uses the glyph atlases anymore.
+  TextureFont::FreeAtlases();
+
   if (m_pMessageBox) {
     delete m_pMessageBox;
     m_pMessageBox = 0;
@@ -468,6 +539,11 @@ bool radar_pi::DeInit(void) {
     m_GPS_filter = 0;
   }
 
+  if (m_frame_scheduler) {
+    delete m_frame_scheduler;
+    m_frame_scheduler = 0;
+  }
+
   // No need to delete wxWindow stuff, wxWidgets does this for us.
   LOG_VERBOSE(wxT("DeInit of plugin done"));
   return true;
@@ -611,6 +687,77 @@ void radar_pi::NotifyRadarWindowViz() { m_notify_radar_window_viz = true; }
 //
 void radar_pi::NotifyControlDialog() { m_notify_control_dialog = true; }
 
+// Called from a receive thread as soon as a guard zone has seen enough hits in the
+// current sweep. Instead of waiting for the sweep to end and the next TimedUpdate,
+// wake the main thread right away. At most one event is queued at a time.
+void radar_pi::NotifyGuardZoneTripped() {
+  if (!m_notify_guard_zone_tripped) {
+    m_notify_guard_zone_tripped = true;
+    wxQueueEvent(this, new wxCommandEvent(EVT_RADAR_GUARD_ZONE_TRIPPED));
+  }
+}
+
+void radar_pi::OnGuardZoneTripped(wxCommandEvent &event) {
+  m_notify_guard_zone_tripped = false;
+  if (m_initialized && m_settings.show) {
+    LOG_GUARD(wxT("Guard zone tripped, checking bogeys now"));
+    CheckGuardZoneBogeys();
+  }
+}
+
+// Called from a receive thread when a radar shows up whose lifecycle timers had lapsed,
+// see RadarLifecycle. At most one event is queued at a time.
+void radar_pi::NotifyLifecycle() {
+  if (!m_notify_lifecycle) {
+    m_notify_lifecycle = true;
+    wxQueueEvent(this, new wxCommandEvent(EVT_RADAR_LIFECYCLE_WAKE));
+  }
+}
+
+void radar_pi::OnLifecycleWake(wxCommandEvent &event) {
+  m_notify_lifecycle = false;
+  if (m_initialized) {
+    wxLongLong now = GetMonotonicMillis();
+    for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+      if (m_radar[r]) {
+        m_radar[r]->m_lifecycle.Wake(now);
+      }
+    }
+    ScheduleDeadlines();
+  }
+}
+
+void radar_pi::OnDeadlineTimer(wxTimerEvent &event) {
+  if (!m_initialized) {
+    return;
+  }
+
+  wxLongLong now = GetMonotonicMillis();
+  int id;
+  while ((id = m_deadlines.Expire(now)) >= 0) {
+    RadarInfo *ri = m_radar[id / LT_TIMERS];
+    if (ri) {
+      ri->m_lifecycle.OnTimer((LifecycleTimer)(id % LT_TIMERS), now);
+    }
+  }
+  ScheduleDeadlines();
+}
+
+// (Re)start the deadline timer for the earliest deadline in the wheel
+void radar_pi::ScheduleDeadlines() {
+  if (!m_deadline_timer) {
+    return;
+  }
+
+  wxLongLong deadline;
+  if (m_deadlines.GetNextDeadline(&deadline)) {
+    long wait = (deadline - GetMonotonicMillis()).ToLong();
+    m_deadline_timer->Start(wxMax(wait, 1L), wxTIMER_ONE_SHOT);
+  } else {
+    m_deadline_timer->Stop();
+  }
+}
+
 void radar_pi::SetRadarWindowViz(bool reparent) {
   for (size_t r = 0; r < m_settings.radar_count; r++) {
     bool showThisRadar = m_settings.show && m_settings.show_radar[r];
@@ -619,7 +766,6 @@ void radar_pi::SetRadarWindowViz(bool reparent) {
     m_radar[r]->ShowRadarWindow(showThisRadar);
 
     m_radar[r]->ShowControlDialog(showThisControl, reparent);
-    m_radar[r]->UpdateTransmitState();
   }
 }
 
@@ -849,12 +995,13 @@ void radar_pi::CheckGuardZoneBogeys(void) {
 
       for (size_t z = 0; z < GUARD_ZONES; z++) {
         int bogeys = m_radar[r]->m_guard_zone[z]->GetBogeyCount();
-        if (bogeys > m_settings.guard_zone_threshold) {
+        bool alarm = bogeys > m_settings.guard_zone_threshold || m_radar[r]->m_guard_zone[z]->IsTripped();
+        if (alarm) {
           bogeys_found = true;
           bogeys_found_this_radar = true;
         }
         text << _(" Zone") << wxT(" ") << z + 1 << wxT(": ");
-        if (bogeys > m_settings.guard_zone_threshold) {
+        if (alarm) {
           text << bogeys;
         } else if (bogeys >= 0) {
           text << wxT("(");
@@ -930,6 +1077,17 @@ void radar_pi::SetRadarHeading(double heading, bool isTrue) {
   }
 }
 
+// Only used while there is no real heading, and never passed to OpenCPN
+void radar_pi::SetEmulatorHeading(double heading) {
+  wxCriticalSectionLocker lock(m_exclusive);
+
+  if (m_heading_source <= HEADING_EMULATOR) {
+    m_heading_source = HEADING_EMULATOR;
+    m_hdt = heading;
+    m_hdt_timeout = time(0) + HEADING_TIMEOUT;
+  }
+}
+
 void radar_pi::UpdateHeadingPositionState() {
   {
     wxCriticalSectionLocker lock(m_exclusive);
@@ -945,7 +1103,9 @@ void radar_pi::UpdateHeadingPositionState() {
 
     switch (m_heading_source) {
       case HEADING_NONE:
+      case HEADING_PLAYBACK:
         break;
+      case HEADING_EMULATOR:
       case HEADING_FIX_COG:
       case HEADING_FIX_HDT:
       case HEADING_NMEA_HDT:
@@ -979,81 +1139,92 @@ void radar_pi::UpdateHeadingPositionState() {
 
 /**
  * This is called whenever OpenCPN is drawing the chart, about halfway through its
- * process, e.g. as the last part of RenderGLOverlay(), and by the timer.
+ * process, e.g. as the last part of RenderGLOverlay().
+ *
+ * Keeps the frame timer running at the period for the refresh rate setting:
+ * 1 = 1000 ms, 2 = 500 ms, 3 = 250 ms, 4 = 125 ms, 5 = 62 ms.
  *
  * This happens on the main (GUI) thread.
  */
 void radar_pi::ScheduleWindowRefresh() {
-  int drawTime = 0;
-  int millis = 0;
-  int renderPPI[RADARS];
-  int render_overlay[MAX_CHART_CANVAS];
-  int doppler_count = 0;
-
-  CLEAR_STRUCT(renderPPI);
-  CLEAR_STRUCT(render_overlay);
-
-  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-    m_radar[r]->RefreshDisplay();
-    drawTime += (renderPPI[r] = m_radar[r]->GetDrawTime());
-    doppler_count += m_radar[r]->GetDopplerCount();
-  }
+  int refreshrate = wxMax(1, m_settings.refreshrate.GetValue());
+  int period = 1000 >> (refreshrate - 1);
 
-  int max_canvas = GetCanvasCount();
-  for (int r = 0; r < max_canvas; r++) {
-    drawTime += (render_overlay[r] = m_draw_time_overlay_ms[r]);
-  }
-
-  int refreshrate = m_settings.refreshrate.GetValue();
-  if (refreshrate > 1 && drawTime < 500) {
-    // 1 = 1 per s, 1000ms between draws, no additional refreshes
-    // 2 = 2 per s,  500ms
-    // 3 = 4 per s,  250ms
-    // 4 = 8 per s,  125ms
-    // 5 = 16 per s,  64ms
-    millis = (1000 - drawTime) / (1 << (refreshrate - 1)) + drawTime;
-
-    LOG_VERBOSE(wxT("rendering took %i ms, PPI0=%i ms, PPI1=%i, Overlay0=%i, Overlay1=%i, doppler=%d next render in %i ms"),
-                drawTime, renderPPI[0], renderPPI[1], render_overlay[0], render_overlay[1], doppler_count, millis);
-
-    m_timer->StartOnce(millis);
-
-  } else {
-    LOG_VERBOSE(wxT("rendering took %i ms, PPI0=%i ms, PPI1=%i, Overlay0=%i, Overlay1=%i, doppler=%d no next extra render"),
-                drawTime, renderPPI[0], renderPPI[1], render_overlay[0], render_overlay[1], doppler_count);
+  if (period != m_frame_period || !m_timer->IsRunning()) {
+    LOG_VERBOSE(wxT("frame timer period %d ms"), period);
+    m_frame_period = period;
+    m_timer->Start(period);
   }
 }
 
+/**
+ * Ask for a repaint of each radar window and chart overlay that shows radar data
+ * that has changed since it was last painted.
+ *
+ * The interval between repaints is the refresh rate, stretched so that drawing
+ * takes no more than FRAME_BUDGET_PERCENT of the GUI thread. A radar window is
+ * also repainted every FRAME_IDLE_MILLIS so its texts stay current. A chart
+ * canvas is only repainted by us when the refresh rate is above 1; OpenCPN
+ * repaints it often enough for the slowest rate.
+ */
 void radar_pi::OnTimerNotify(wxTimerEvent &event) {
   if (!EnsureRadarSelectionComplete(false)) {
     return;
   }
 
   if (m_settings.show) {  // Is radar enabled?
-    bool ppi_visible = false;
+    int draw_time = 0;
+    int max_canvas = CANVAS_COUNT;
 
     for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-      if (m_settings.show_radar[r]) {
-        ppi_visible = true;
+      draw_time += m_radar[r]->GetDrawTime();
+    }
+    for (int c = 0; c < max_canvas; c++) {
+      if (m_chart_overlay[c] >= 0) {
+        draw_time += m_draw_time_overlay_ms[c];
       }
     }
-    // always refresh canvas0 if radar window is visible
-    // and refresh canvas with overlay
-    for (int r = 0; r < CANVAS_COUNT; r++) {
-      wxWindow *canvas = GetCanvasByIndex(r);
-      if (m_chart_overlay[r] >= 0 || (r == 0 && ppi_visible)) {
-        if (canvas) {
-          canvas->Refresh(false);
-        } else {
-          LOG_INFO(wxT("**error canvas NOT OK, r=%i"), r);
+    int interval = wxMax(m_frame_period, draw_time * 100 / FRAME_BUDGET_PERCENT);
+
+    for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+      if (m_settings.show_radar[r] && m_radar[r]->IsPaneShown() &&
+          m_frame_scheduler->IsDue(r, FRAME_TARGET_PPI, interval, true)) {
+        m_frame_scheduler->Requested(r, FRAME_TARGET_PPI);
+        m_radar[r]->RefreshDisplay();
+      }
+    }
+
+    if (m_settings.refreshrate.GetValue() > 1) {
+      for (int c = 0; c < max_canvas; c++) {
+        int r = m_chart_overlay[c];
+        if (r >= 0 && m_frame_scheduler->IsDue(r, FRAME_TARGET_CANVAS(c), interval, false)) {
+          wxWindow *canvas = GetCanvasByIndex(c);
+          if (canvas) {
+            m_frame_scheduler->Requested(r, FRAME_TARGET_CANVAS(c));
+            canvas->Refresh(false);
+          } else {
+            LOG_INFO(wxT("**error canvas NOT OK, c=%i"), c);
+          }
         }
       }
     }
+    LOG_VERBOSE(wxT("frame timer: drawing took %d ms, interval %d ms"), draw_time, interval);
+  }
+}
+
+// Move the control values that the receive threads reported to the controls
+void radar_pi::ApplyControlJournals() {
+  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
+    if (m_radar[r]) {
+      m_radar[r]->m_control_journal.Apply(m_radar[r]);
+    }
   }
 }
 
 // Called between 1 and 10 times per second by RenderGLOverlay call
 void radar_pi::TimedControlUpdate() {
+  ApplyControlJournals();
+
   wxLongLong now = wxGetUTCTimeMillis();
   if (!m_notify_control_dialog && !TIMED_OUT(now, m_notify_time_ms + 500)) {
     return;  // Don't run this more often than 2 times per second
@@ -1128,8 +1299,12 @@ void radar_pi::TimedControlUpdate() {
     case HEADING_FIX_HDM:
     case HEADING_NMEA_HDM:
     case HEADING_RADAR_HDM:
+    case HEADING_PLAYBACK:
       info = wxT(" ");
       break;
+    case HEADING_EMULATOR:
+      info = _("Emulator");
+      break;
     case HEADING_FIX_COG:
       info = _("COG");
       break;
@@ -1147,6 +1322,8 @@ void radar_pi::TimedControlUpdate() {
   m_pMessageBox->SetTrueHeadingInfo(info);
   switch (m_heading_source) {
     case HEADING_NONE:
+    case HEADING_EMULATOR:
+    case HEADING_PLAYBACK:
     case HEADING_FIX_COG:
     case HEADING_FIX_HDT:
     case HEADING_NMEA_HDT:
@@ -1188,6 +1365,9 @@ void radar_pi::TimedUpdate(wxTimerEvent &event) {
   nmea = wxT("$GPRMC,123519,A,5326.038,N,00611.000,E,022.4,,230394,,W,*41<0x0D><0x0A>");
   PushNMEABuffer(nmea);*/
 
+  SaveDiscoveryCache();
+  ApplyControlJournals();  // in case nothing is being drawn
+
   // update own ship position to best estimate
   ExtendedPosition intermediate_pos;
   if (m_predicted_position_initialised) {
@@ -1245,7 +1425,6 @@ void radar_pi::TimedUpdate(wxTimerEvent &event) {
                                       // Conditions for ARPA not fulfilled, delete all targets
         m_radar[r]->m_arpa->RadarLost();
       }
-      m_radar[r]->UpdateTransmitState();
     }
   }
   if (any_data_seen && m_settings.show) {
@@ -1274,10 +1453,6 @@ void radar_pi::UpdateState(void) {
     m_toolbar_button = g_toolbarIconColor[state];
   }
   CacheSetToolbarToolBitmaps();
-
-  for (size_t r = 0; r < M_SETTINGS.radar_count; r++) {
-    m_radar[r]->CheckTimedTransmit();
-  }
 }
 
 void radar_pi::SetOpenGLMode(OpenGLMode mode) {
@@ -1291,6 +1466,30 @@ void radar_pi::SetOpenGLMode(OpenGLMode mode) {
 
 wxGLContext *radar_pi::GetChartOpenGLContext() { return m_opencpn_gl_context; }
 
+/*
+ * Make OpenCPN's context current on the GL canvas of one of its chart canvases,
+ * so that the GL objects we created in it can be freed outside a render call.
+ */
+bool radar_pi::SetChartOpenGLContextCurrent() {
+  if (!m_opencpn_gl_context) {
+    return false;
+  }
+  for (int i = 0; i < GetCanvasCount(); i++) {
+    wxWindow *canvas = GetCanvasByIndex(i);
+    if (!canvas) {
+      continue;
+    }
+    wxWindowList &children = canvas->GetChildren();
+    for (wxWindowList::iterator it = children.begin(); it != children.end(); it++) {
+      wxGLCanvas *gl = wxDynamicCast(*it, wxGLCanvas);
+      if (gl && gl->SetCurrent(*m_opencpn_gl_context)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
 //**************************************************************************************************
 // Radar Image Graphic Display Processes
 //**************************************************************************************************
@@ -1414,7 +1613,13 @@ bool radar_pi::RenderGLOverlayMultiCanvas(wxGLContext *pcontext, PlugIn_ViewPort
     double rotation = MOD_DEGREES_FLOAT(rad2deg(vp->rotation + vp->skew * m_settings.skew_factor));
     LOG_DIALOG(wxT("RenderRadarOverlay lat=%g lon=%g v_scale_ppm=%g vp_rotation=%g skew=%g scale=%f rot=%g"), vp->clat, vp->clon,
                vp->view_scale_ppm, vp->rotation, vp->skew, v_scale_ppm, rotation);
-    m_radar[current_overlay_radar]->RenderRadarImage1(boat_center, v_scale_ppm, rotation, true);
+    m_radar[current_overlay_radar]->RenderRadarImage1(boat_center, v_scale_ppm, rotation, true,
+                                                       wxSize(vp->pix_width, vp->pix_height));
+
+    double radius = m_radar[current_overlay_radar]->m_range.GetValue() * v_scale_ppm;
+    uint64_t visible = FrameScheduler::GetVisibleSectors(boat_center, radius, rotation, vp->pix_width, vp->pix_height);
+    m_frame_scheduler->SetVisibleSectors(current_overlay_radar, FRAME_TARGET_CANVAS(canvasIndex), visible);
+    m_frame_scheduler->Presented(current_overlay_radar, FRAME_TARGET_CANVAS(canvasIndex));
   }
 
   m_draw_time_overlay_ms[canvasIndex] = (wxGetUTCTimeMillis() - now).GetLo();
@@ -1481,6 +1686,7 @@ bool radar_pi::LoadConfig(void) {
       ri->m_radar_address.port = htons(RadarOrder[ri->m_radar_type]);
       pConf->Read(wxString::Format(wxT("Radar%dLocationInfo"), r), &s, " ");
       ri->SetRadarLocationInfo(RadarLocationInfo(s));
+      ri->TakeDiscoveryChanged();  // Just loaded, nothing to save
 
       pConf->Read(wxString::Format(wxT("Radar%dRange"), r), &v, 2000);
       ri->m_range.Update(v);
@@ -1498,6 +1704,10 @@ bool radar_pi::LoadConfig(void) {
       ri->m_autotrack_doppler.Update(v);
       pConf->Read(wxString::Format(wxT("Radar%dThreshold"), r), &v, 0);
       ri->m_threshold.Update(v);
+      pConf->Read(wxString::Format(wxT("Radar%dClutterFilter"), r), &v, 0);
+      ri->m_cfar.Update(v);
+      pConf->Read(wxString::Format(wxT("Radar%dScanCorrelation"), r), &v, 0);
+      ri->m_scan_correlation.Update(v);
 
       pConf->Read(wxString::Format(wxT("Radar%dTrailsState"), r), &state, RCS_OFF);
       pConf->Read(wxString::Format(wxT("Radar%dTrails"), r), &v, 0);
@@ -1529,6 +1739,7 @@ bool radar_pi::LoadConfig(void) {
       pConf->Read(wxString::Format(wxT("Radar%dControlShow"), r), &m_settings.show_radar_control[n], false);
       pConf->Read(wxString::Format(wxT("Radar%dTargetShow"), r), &v, true);
       ri->m_target_on_ppi.Update(v);
+      pConf->Read(wxString::Format(wxT("Radar%dPlaybackFile"), r), &m_settings.playback_file[n], wxT(""));
 
       pConf->Read(wxString::Format(wxT("Radar%dControlPosX"), r), &x, wxDefaultPosition.x);
       pConf->Read(wxString::Format(wxT("Radar%dControlPosY"), r), &y, wxDefaultPosition.y);
@@ -1542,6 +1753,12 @@ bool radar_pi::LoadConfig(void) {
         pConf->Read(wxString::Format(wxT("Radar%dZone%dType"), r, i), &v, 0);
         pConf->Read(wxString::Format(wxT("Radar%dZone%dAlarmOn"), r, i), &ri->m_guard_zone[i]->m_alarm_on, 0);
         pConf->Read(wxString::Format(wxT("Radar%dZone%dArpaOn"), r, i), &ri->m_guard_zone[i]->m_arpa_on, 0);
+        pConf->Read(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), &s, wxT(""));
+        size_t skipped = ri->m_guard_zone[i]->SetPolygon(s);
+        if (skipped > 0) {
+          LOG_INFO(wxT("radar_pi: Radar%dZone%dPolygon: ignored %u invalid vertices or vertices beyond the first %d"), r, i,
+                   (unsigned)skipped, GUARD_ZONE_MAX_VERTICES);
+        }
         ri->m_guard_zone[i]->SetType((GuardZoneType)v);
       }
       pConf->Read(wxT("AlarmPosX"), &x, 25);
@@ -1575,20 +1792,26 @@ bool radar_pi::LoadConfig(void) {
     m_settings.doppler_receding_colour = wxColour(s);
     pConf->Read(wxT("DeveloperMode"), &m_settings.developer_mode, false);
     pConf->Read(wxT("DrawingMethod"), &m_settings.drawing_method, 0);
+    pConf->Read(wxT("EmulatorScene"), &m_settings.emulator_scene, wxT(""));
     pConf->Read(wxT("GuardZoneDebugInc"), &m_settings.guard_zone_debug_inc, 0);
     pConf->Read(wxT("GuardZoneOnOverlay"), &m_settings.guard_zone_on_overlay, true);
     pConf->Read(wxT("OverlayStandby"), &m_settings.overlay_on_standby, true);
     pConf->Read(wxT("GuardZoneTimeout"), &m_settings.guard_zone_timeout, 30);
     pConf->Read(wxT("GuardZonesRenderStyle"), &m_settings.guard_zone_render_style, 0);
     pConf->Read(wxT("GuardZonesThreshold"), &m_settings.guard_zone_threshold, 5L);
+    pConf->Read(wxT("GuardZoneTripCount"), &m_settings.guard_zone_trip_count, 0);
     pConf->Read(wxT("IgnoreRadarHeading"), &m_settings.ignore_radar_heading, 0);
     pConf->Read(wxT("ShowExtremeRange"), &m_settings.show_extreme_range, false);
     pConf->Read(wxT("MenuAutoHide"), &m_settings.menu_auto_hide, 0);
     pConf->Read(wxT("PassHeadingToOCPN"), &m_settings.pass_heading_to_opencpn, false);
+    pConf->Read(wxT("PlaybackSpeed"), &m_settings.playback_speed, 1.0);
+    pConf->Read(wxT("PlaybackStart"), &m_settings.playback_start, 0);
+    pConf->Read(wxT("RecordDirectory"), &m_settings.record_directory, wxT(""));
     pConf->Read(wxT("Refreshrate"), &v, 3);
     m_settings.refreshrate.Update(v);
     pConf->Read(wxT("ReverseZoom"), &m_settings.reverse_zoom, false);
     pConf->Read(wxT("ScanMaxAge"), &m_settings.max_age, 6);
+    pConf->Read(wxT("ShaderTiming"), &m_settings.shader_timing, false);
     pConf->Read(wxT("Show"), &m_settings.show, true);
     pConf->Read(wxT("SkewFactor"), &m_settings.skew_factor, 1);
     pConf->Read(wxT("ThresholdBlue"), &m_settings.threshold_blue, 32);
@@ -1612,6 +1835,33 @@ bool radar_pi::LoadConfig(void) {
   return false;
 }
 
+/*
+ * Write where each radar was found as soon as that changes, instead of only when the
+ * plugin stops. This way the receive threads can listen on the right interface and
+ * multicast groups straight away on the next start, even after a power failure.
+ */
+void radar_pi::SaveDiscoveryCache() {
+  wxFileConfig *pConf = m_pconfig;
+  bool changed = false;
+
+  if (!pConf) {
+    return;
+  }
+  for (int r = 0; r < (int)m_settings.radar_count; r++) {
+    if (m_radar[r] && m_radar[r]->TakeDiscoveryChanged()) {
+      pConf->SetPath(wxT("/Plugins/Radar"));
+      pConf->Write(wxString::Format(wxT("Radar%dLocationInfo"), r), m_radar[r]->GetRadarLocationInfo().to_string());
+      pConf->Write(wxString::Format(wxT("Radar%dAddress"), r), m_radar[r]->GetRadarAddress().FormatNetworkAddress());
+      pConf->Write(wxString::Format(wxT("Radar%dInterface"), r), m_radar[r]->GetRadarInterfaceAddress().FormatNetworkAddress());
+      LOG_VERBOSE(wxT("%s saved discovery %s"), m_radar[r]->m_name.c_str(), m_radar[r]->GetRadarLocationInfo().to_string());
+      changed = true;
+    }
+  }
+  if (changed) {
+    pConf->Flush();
+  }
+}
+
 bool radar_pi::SaveConfig(void) {
   wxFileConfig *pConf = m_pconfig;
   if (pConf) {
@@ -1623,6 +1873,7 @@ bool radar_pi::SaveConfig(void) {
     pConf->Write(wxT("AlertAudioFile"), m_settings.alert_audio_file);
     pConf->Write(wxT("DeveloperMode"), m_settings.developer_mode);
     pConf->Write(wxT("DrawingMethod"), m_settings.drawing_method);
+    pConf->Write(wxT("EmulatorScene"), m_settings.emulator_scene);
     pConf->Write(wxT("EnableCOGHeading"), m_settings.enable_cog_heading);
     pConf->Write(wxT("GuardZoneDebugInc"), m_settings.guard_zone_debug_inc);
     pConf->Write(wxT("GuardZoneOnOverlay"), m_settings.guard_zone_on_overlay);
@@ -1630,14 +1881,19 @@ bool radar_pi::SaveConfig(void) {
     pConf->Write(wxT("GuardZoneTimeout"), m_settings.guard_zone_timeout);
     pConf->Write(wxT("GuardZonesRenderStyle"), m_settings.guard_zone_render_style);
     pConf->Write(wxT("GuardZonesThreshold"), m_settings.guard_zone_threshold);
+    pConf->Write(wxT("GuardZoneTripCount"), m_settings.guard_zone_trip_count);
     pConf->Write(wxT("IgnoreRadarHeading"), m_settings.ignore_radar_heading);
     pConf->Write(wxT("ShowExtremeRange"), m_settings.show_extreme_range);
     pConf->Write(wxT("MenuAutoHide"), m_settings.menu_auto_hide);
     pConf->Write(wxT("PassHeadingToOCPN"), m_settings.pass_heading_to_opencpn);
+    pConf->Write(wxT("PlaybackSpeed"), m_settings.playback_speed);
+    pConf->Write(wxT("PlaybackStart"), m_settings.playback_start);
+    pConf->Write(wxT("RecordDirectory"), m_settings.record_directory);
     pConf->Write(wxT("RangeUnits"), (int)m_settings.range_units);
     pConf->Write(wxT("Refreshrate"), m_settings.refreshrate.GetValue());
     pConf->Write(wxT("ReverseZoom"), m_settings.reverse_zoom);
     pConf->Write(wxT("ScanMaxAge"), m_settings.max_age);
+    pConf->Write(wxT("ShaderTiming"), m_settings.shader_timing);
     pConf->Write(wxT("Show"), m_settings.show);
     pConf->Write(wxT("SkewFactor"), m_settings.skew_factor);
     pConf->Write(wxT("ThresholdBlue"), m_settings.threshold_blue);
@@ -1673,7 +1929,10 @@ bool radar_pi::SaveConfig(void) {
       pConf->Write(wxString::Format(wxT("Radar%dWindowDock"), r), m_settings.dock_radar[r]);
       pConf->Write(wxString::Format(wxT("Radar%dControlShow"), r), m_settings.show_radar_control[r]);
       pConf->Write(wxString::Format(wxT("Radar%dTargetShow"), r), m_radar[r]->m_target_on_ppi.GetValue());
+      pConf->Write(wxString::Format(wxT("Radar%dPlaybackFile"), r), m_settings.playback_file[r]);
       pConf->Write(wxString::Format(wxT("Radar%dThreshold"), r), m_radar[r]->m_threshold.GetValue());
+      pConf->Write(wxString::Format(wxT("Radar%dClutterFilter"), r), m_radar[r]->m_cfar.GetValue());
+      pConf->Write(wxString::Format(wxT("Radar%dScanCorrelation"), r), m_radar[r]->m_scan_correlation.GetValue());
       pConf->Write(wxString::Format(wxT("Radar%dTrailsState"), r), (int)m_radar[r]->m_target_trails.GetState());
       pConf->Write(wxString::Format(wxT("Radar%dTrails"), r), m_radar[r]->m_target_trails.GetValue());
       pConf->Write(wxString::Format(wxT("Radar%dTrueTrailsMotion"), r), m_radar[r]->m_trails_motion.GetValue());
@@ -1702,6 +1961,7 @@ bool radar_pi::SaveConfig(void) {
         pConf->Write(wxString::Format(wxT("Radar%dZone%dType"), r, i), (int)m_radar[r]->m_guard_zone[i]->m_type);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dAlarmOn"), r, i), m_radar[r]->m_guard_zone[i]->m_alarm_on);
         pConf->Write(wxString::Format(wxT("Radar%dZone%dArpaOn"), r, i), m_radar[r]->m_guard_zone[i]->m_arpa_on);
+        pConf->Write(wxString::Format(wxT("Radar%dZone%dPolygon"), r, i), m_radar[r]->m_guard_zone[i]->GetPolygonString());
       }
     }
 
@@ -2093,22 +2353,14 @@ bool radar_pi::MouseEventHook(wxMouseEvent &event) {
   return false;
 }
 
+/*
+ * Binary data is not formatted here but copied to the packet trace, which is
+ * written to a pcap file by its own thread. Use PacketTrace-dump to view it.
+ */
 void radar_pi::logBinaryData(const wxString &what, const uint8_t *data, int size) {
-  wxString explain;
-  int i = 0;
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    if (i % 16 == 0) {
-      explain += wxString::Format(wxT(" \n %3d    "), i);
-    } else if (i % 8 == 0) {
-      explain += wxString::Format(wxT("  "), i);
-    }
-    explain += wxString::Format(wxT(" %02X"), data[i]);
-  }
-  LOG_INFO(explain);
+  if (m_trace) {
+    m_trace->Add(what, data, size);
+  }
 }
 
 bool radar_pi::IsRadarOnScreen(int radar) {
@@ -77,17 +77,7 @@ bool RME120Control::Init(radar_pi *pi, RadarInfo *ri, NetworkAddress &ifadr, Net
 }
 
 void RME120Control::logBinaryData(const wxString &what, const uint8_t *data, int size) {
-  wxString explain;
-  int i = 0;
-
-  explain.Alloc(size * 3 + 50);
-  explain += wxT("") + m_name.c_str() + wxT(" ");
-  explain += what;
-  explain += wxString::Format(wxT(" %d bytes: "), size);
-  for (i = 0; i < size; i++) {
-    explain += wxString::Format(wxT(" %02X"), data[i]);
-  }
-  LOG_TRANSMIT(explain);
+  m_pi->logBinaryData(m_name + wxT(" ") + what, data, size);
 }
 
 bool RME120Control::TransmitCmd(const uint8_t *msg, int size) {
@@ -186,6 +176,7 @@ bool RME120Control::SetControlValue(ControlType controlType, RadarControlItem &i
     case CT_ANTENNA_STARBOARD:
     case CT_AUTOTTRACKDOPPLER:
     case CT_CENTER_VIEW:
+    case CT_CFAR:
     case CT_COLOR_GAIN:
     case CT_DOPPLER:
     case CT_LOCAL_INTERFERENCE_REJECTION:
@@ -207,6 +198,7 @@ bool RME120Control::SetControlValue(ControlType controlType, RadarControlItem &i
     case CT_RANGE:
     case CT_RANGE_ADJUSTMENT:
     case CT_REFRESHRATE:
+    case CT_SCAN_CORRELATION:
     case CT_SCAN_SPEED:
     case CT_SEA_STATE:
     case CT_SIDE_LOBE_SUPPRESSION:
@@ -162,6 +162,7 @@ bool RMQuantumControl::SetControlValue(ControlType controlType, RadarControlItem
     case CT_ANTENNA_STARBOARD:
     case CT_AUTOTTRACKDOPPLER:
     case CT_CENTER_VIEW:
+    case CT_CFAR:
     case CT_DISPLAY_TIMING:
     case CT_DOPPLER:
     case CT_FTC:
@@ -184,6 +185,7 @@ bool RMQuantumControl::SetControlValue(ControlType controlType, RadarControlItem
     case CT_RANGE:
     case CT_RANGE_ADJUSTMENT:
     case CT_REFRESHRATE:
+    case CT_SCAN_CORRELATION:
     case CT_SCAN_SPEED:
     case CT_SIDE_LOBE_SUPPRESSION:
     case CT_SEA_STATE:
@@ -0,0 +1,304 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+/*
+ * Checks RaymarineDecodeEncoded() and RaymarineDecodeRaw() against the byte
+ * at a time decoders they replaced, on E120 and Quantum scan packets from the
+ * captures in example/ (see RaymarineDecode-test.inc), on hand built spokes
+ * in the formats of the E120, HD and Quantum radars (there is no HD capture)
+ * and on random streams, and reports the decode throughput. Build it against
+ * the plugin headers and wxWidgets, like Kalman-test.cpp, for instance
+ *
+ *   c++ -O2 -Iinclude -Iinclude/raymarine `wx-config --cxxflags` -o RaymarineDecode-test \
+ *     src/raymarine/RaymarineDecode-test.cpp src/raymarine/RaymarineDecode.cpp src/spokeutil.cpp `wx-config --libs`
+ */
+
+#include "RaymarineDecode.h"
+
+#include <chrono>
+#include <iostream>
+
+PLUGIN_BEGIN_NAMESPACE
+
+#include "RaymarineDecode-test.inc"
+
+#define TEST_SPOKE_LEN_MAX (1024)
+
+// The decoders as they were in RaymarineReceive, writing samples.
+static void ReferenceDecode(const uint8_t *src, unsigned int encoded_len, unsigned int total_len, bool nibbles,
+                            uint8_t *out, unsigned int len) {
+  // The E120 loop does not stop at the end of the spoke, so room for 255 bytes per byte
+  vector<uint8_t> buf(2 * 255 * total_len + 2 * len + 2);
+  unsigned int iS = 0;
+  unsigned int iD = 0;
+
+  if (!nibbles) {
+    while (iS < encoded_len && iD < len) {
+      if (src[iS] != RAYMARINE_ESCAPE) {
+        buf[iD++] = src[iS++];
+      } else {
+        if (iS + 3 > encoded_len) {
+          break;
+        }
+        for (unsigned int i = 0; i < src[iS + 1]; i++) {
+          buf[iD++] = src[iS + 2];
+        }
+        iS += 3;
+      }
+    }
+    while (iS < total_len && iD < len) {
+      buf[iD++] = src[iS++];
+    }
+  } else {
+    while (iS < encoded_len) {
+      if (src[iS] != RAYMARINE_ESCAPE) {
+        buf[iD++] = ((src[iS] & 0x0f) << 4) + 0x0f;
+        buf[iD++] = (src[iS] & 0xf0) + 0x0f;
+        iS++;
+      } else {
+        for (unsigned int i = 0; i < src[iS + 1]; i++) {
+          buf[iD++] = ((src[iS + 2] & 0x0f) << 4) + 0x0f;
+          buf[iD++] = (src[iS + 2] & 0xf0) + 0x0f;
+        }
+        iS += 3;
+      }
+    }
+    if (iD != len) {
+      while (iS < total_len && iD <= len) {
+        buf[iD++] = (src[iS] & 0x0f) << 4;
+        buf[iD++] = src[iS] & 0xf0;
+        iS++;
+      }
+    }
+  }
+  memcpy(out, &buf[0], len);
+}
+
+static void Decode(const uint8_t *src, unsigned int encoded_len, unsigned int total_len, bool nibbles, SpokeRuns *runs,
+                   unsigned int len) {
+  unsigned int sample = 0;
+
+  runs->Clear(len);
+  unsigned int used = RaymarineDecodeEncoded(src, encoded_len, nibbles, runs, &sample);
+  RaymarineDecodeRaw(src + used, total_len - used, nibbles, runs, &sample);
+}
+
+static int Check(const char *name, const uint8_t *src, unsigned int encoded_len, unsigned int total_len, bool nibbles,
+                 unsigned int len) {
+  uint8_t expected[TEST_SPOKE_LEN_MAX];
+  uint8_t actual[TEST_SPOKE_LEN_MAX];
+  SpokeRuns runs;
+
+  ReferenceDecode(src, encoded_len, total_len, nibbles, expected, len);
+  Decode(src, encoded_len, total_len, nibbles, &runs, len);
+  runs.GetSamples(actual);
+  for (unsigned int i = 0; i < len; i++) {
+    if (actual[i] != expected[i]) {
+      cout << "ERROR: " << name << ": sample " << i << " is " << (int)actual[i] << ", expected " << (int)expected[i] << "\n";
+      return 1;
+    }
+  }
+  for (size_t i = 1; i < runs.GetCount(); i++) {
+    if (runs[i].begin == runs[i - 1].end && runs[i].value == runs[i - 1].value) {
+      cout << "ERROR: " << name << ": runs " << i - 1 << " and " << i << " not merged\n";
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static uint32_t Get32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static uint16_t Get16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+/*
+ * Walk the spokes of a captured scan packet as RaymarineReceive does and check
+ * each of them. Return the number of spokes in 'spokes'.
+ */
+static int CheckPacket(const CapturedPacket &packet, int *spokes) {
+  const uint8_t *data = packet.data;
+  unsigned int len = (unsigned int)packet.len;
+  int ret = 0;
+
+  *spokes = 0;
+  if (Get32(data) == 0x00280003) {  // Quantum, one spoke after a 20 byte header
+    unsigned int returns_per_line = wxMin((unsigned int)Get16(data + 8), 252u);
+    unsigned int data_len = wxMin((unsigned int)Get16(data + 18), len - 20);
+
+    *spokes = 1;
+    return Check(packet.name, data + 20, data_len, data_len, false, returns_per_line);
+  }
+
+  // E120 and HD: a 32 byte header, then per spoke a 40 byte header, an optional one and the data
+  unsigned int offset = 32;
+  while (offset + 40 + 12 <= len && Get32(data + offset) == 0x00000001 && Get32(data + offset + 4) == 0x00000028) {
+    bool hd = Get32(data + offset + 12) == 3;
+    offset += 40;
+    if (Get32(data + offset) == 0x00000002) {
+      offset += Get32(data + offset + 4);
+    }
+    uint32_t length = Get32(data + offset + 4);
+    uint32_t data_len = Get32(data + offset + 8);
+    if ((Get32(data + offset) & 0x7fffffff) != 0x00000003 || length < data_len + 8) {
+      cout << "ERROR: " << packet.name << ": bad spoke header at " << offset << "\n";
+      return 1;
+    }
+    unsigned int avail = len - offset - 12;
+    ret |= Check(packet.name, data + offset + 12, wxMin(data_len, avail), wxMin(length - 8, avail), !hd, hd ? 1024 : 512);
+    (*spokes)++;
+    offset += length;
+  }
+  return ret;
+}
+
+// Append 'count' copies of 'value', escaped as the radar does.
+static void Put(vector<uint8_t> *v, unsigned int count, uint8_t value) {
+  while (count > 0) {
+    if (count >= 4 || value == RAYMARINE_ESCAPE) {
+      unsigned int n = wxMin(count, 255u);
+      v->push_back(RAYMARINE_ESCAPE);
+      v->push_back((uint8_t)n);
+      v->push_back(value);
+      count -= n;
+    } else {
+      v->push_back(value);
+      count--;
+    }
+  }
+}
+
+static uint32_t g_seed = 12345;
+
+static uint32_t Random() {
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// A spoke like those seen on the water: main bang, sea clutter, a few targets.
+static void MakeSpoke(vector<uint8_t> *v, unsigned int len, bool nibbles) {
+  unsigned int r = 0;
+  unsigned int per_byte = nibbles ? 2 : 1;
+
+  v->clear();
+  Put(v, 8 / per_byte, nibbles ? 0xff : 0xfe);  // main bang
+  r += 8;
+  while (r + 40 < len) {
+    unsigned int n = 1 + Random() % 12;
+    if (r < len / 4) {  // clutter: mixed literals
+      for (unsigned int i = 0; i < n; i++) {
+        v->push_back((uint8_t)(Random() % 4 == 0 ? RAYMARINE_ESCAPE + 1 : Random() & 0x3f));
+      }
+    } else if (Random() % 8 == 0) {  // target
+      Put(v, n, (uint8_t)(0xc0 + Random() % 0x40));
+    } else {  // open water
+      Put(v, 4 * n, 0);
+    }
+    r += n * per_byte * 4;
+  }
+}
+
+int main() {
+  int ret = 0;
+
+  int captured_spokes = 0;
+  for (size_t i = 0; i < ARRAY_SIZE(captured_packets); i++) {
+    int spokes;
+    ret |= CheckPacket(captured_packets[i], &spokes);
+    if (spokes == 0) {
+      cout << "ERROR: " << captured_packets[i].name << ": no spokes found\n";
+      ret = 1;
+    }
+    captured_spokes += spokes;
+  }
+  cout << "Checked " << captured_spokes << " spokes from " << ARRAY_SIZE(captured_packets) << " captured packets\n";
+
+  // HD: escapes, literals that change on every byte, an escape of 0x5c itself
+  static const uint8_t hd[] = {0x5c, 0x08, 0xfe, 0x10, 0x11, 0x11, 0x12, 0x5c, 0x01, 0x5c,
+                               0x5c, 0x00, 0x33, 0x5c, 0x20, 0x00, 0xc8, 0xc8, 0x5c, 0x04,
+                               0xc8, 0x40, 0x5c, 0xff, 0x00, 0x22, 0x23};
+  ret |= Check("HD", hd, sizeof(hd) - 2, sizeof(hd), false, 1024);
+  // An escape cut off at the end of the encoded part continues as raw bytes
+  ret |= Check("HD cut off", hd, 9, sizeof(hd), false, 1024);
+  // Spoke full halfway a run
+  ret |= Check("HD full", hd, sizeof(hd), sizeof(hd), false, 20);
+
+  // Quantum: 252 samples, all encoded
+  static const uint8_t quantum[] = {0x5c, 0x06, 0x80, 0x01, 0x02, 0x5c, 0x40, 0x00, 0x5c,
+                                    0x03, 0xf0, 0xf0, 0xf0, 0xf1, 0x5c, 0xff, 0x00};
+  ret |= Check("Quantum", quantum, sizeof(quantum), sizeof(quantum), false, 252);
+
+  // E120: two nibbles per byte, equal and different nibbles, raw tail
+  static const uint8_t e120[] = {0xff, 0xff, 0x5c, 0x10, 0x00, 0x21, 0x21, 0x5c, 0x03,
+                                 0x44, 0x5c, 0x05, 0x98, 0x00, 0x7f, 0x7f, 0x11, 0x88};
+  ret |= Check("E120", e120, sizeof(e120) - 4, sizeof(e120), true, 512);
+  ret |= Check("E120 full", e120, sizeof(e120), sizeof(e120), true, 21);
+
+  vector<uint8_t> spoke;
+  for (int i = 0; i < 2000 && !ret; i++) {
+    bool nibbles = i % 2;
+    unsigned int len = nibbles ? 512 : (i % 4 == 0 ? 252 : 1024);
+    MakeSpoke(&spoke, len, nibbles);
+    unsigned int encoded = (unsigned int)spoke.size();
+    for (unsigned int t = 0; t < 16; t++) {
+      spoke.push_back((uint8_t)Random());
+    }
+    ret |= Check("random", spoke.data(), encoded, (unsigned int)spoke.size(), nibbles, len);
+  }
+
+  // Throughput on a revolution of typical HD spokes
+  vector<vector<uint8_t> > spokes(2048);
+  size_t bytes = 0;
+  for (size_t i = 0; i < spokes.size(); i++) {
+    MakeSpoke(&spokes[i], 1024, false);
+    bytes += spokes[i].size();
+  }
+  SpokeRuns runs;
+  size_t total_runs = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int rev = 0; rev < 100; rev++) {
+    for (size_t i = 0; i < spokes.size(); i++) {
+      Decode(spokes[i].data(), (unsigned int)spokes[i].size(), (unsigned int)spokes[i].size(), false, &runs, 1024);
+      total_runs += runs.GetCount();
+    }
+  }
+  std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+  cout << "Decoded " << 100 * spokes.size() << " spokes (" << total_runs / (100 * spokes.size()) << " runs each) at "
+       << 100 * spokes.size() / d.count() / 1000. << "k spokes/s, " << 100 * bytes / d.count() / 1e6 << " MB/s\n";
+
+  return ret;
+}
+
+PLUGIN_END_NAMESPACE
+
+int main() { return RadarPlugin::main(); }
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "RaymarineDecode.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+static inline unsigned int FirstSet(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (unsigned int)__builtin_ctz(mask);
+#else
+  unsigned int n = 0;
+  while (!(mask & 1)) {
+    mask >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+// Return the index of the first byte in src[i..len> that equals 'value',
+// or len if there is none.
+static unsigned int FindByte(const uint8_t *src, unsigned int i, unsigned int len, uint8_t value) {
+#if defined(SPOKE_SIMD_SSE2)
+  const __m128i v = _mm_set1_epi8((char)value);
+
+  for (; i + 16 <= len; i += 16) {
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(src + i)), v));
+    if (mask) {
+      return i + FirstSet(mask);
+    }
+  }
+#elif defined(SPOKE_SIMD_NEON)
+  const uint8x16_t v = vdupq_n_u8(value);
+
+  for (; i + 16 <= len; i += 16) {
+    uint64x2_t eq = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(src + i), v));
+    if (vgetq_lane_u64(eq, 0) | vgetq_lane_u64(eq, 1)) {
+      break;  // The loop below finds it within these 16 bytes
+    }
+  }
+#endif
+  while (i < len && src[i] != value) {
+    i++;
+  }
+  return i;
+}
+
+// Return the index of the first byte in src[i..len> that differs from
+// src[i], i < len.
+static unsigned int FindChange(const uint8_t *src, unsigned int i, unsigned int len) {
+  const uint8_t value = src[i];
+
+#if defined(SPOKE_SIMD_SSE2)
+  const __m128i v = _mm_set1_epi8((char)value);
+
+  for (; i + 16 <= len; i += 16) {
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(src + i)), v));
+    if (mask != 0xffff) {
+      return i + FirstSet(~mask);
+    }
+  }
+#elif defined(SPOKE_SIMD_NEON)
+  const uint8x16_t v = vdupq_n_u8(value);
+
+  for (; i + 16 <= len; i += 16) {
+    uint64x2_t eq = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(src + i), v));
+    if ((vgetq_lane_u64(eq, 0) & vgetq_lane_u64(eq, 1)) != ~(uint64_t)0) {
+      break;
+    }
+  }
+#endif
+  while (i < len && src[i] == value) {
+    i++;
+  }
+  return i;
+}
+
+// Append 'count' bytes of value 'b' at *sample. E120 bytes are two samples,
+// scaled from 4 to 8 bits and raised by 'low_bits'.
+static inline void AddBytes(SpokeRuns *runs, unsigned int *sample, unsigned int count, uint8_t b, bool nibbles,
+                            uint8_t low_bits) {
+  if (!nibbles) {
+    runs->Add(*sample, count, b);
+    *sample += count;
+    return;
+  }
+  uint8_t lo = (uint8_t)(((b & 0x0f) << 4) + low_bits);
+  uint8_t hi = (uint8_t)((b & 0xf0) + low_bits);
+  if (lo == hi) {
+    runs->Add(*sample, 2 * count, lo);
+    *sample += 2 * count;
+    return;
+  }
+  for (unsigned int n = 0; n < count && *sample < runs->GetLen(); n++) {
+    runs->Add(*sample, 1, lo);
+    runs->Add(*sample + 1, 1, hi);
+    *sample += 2;
+  }
+}
+
+// Append the bytes src[begin..end>, none of them an escape, as runs of equal bytes.
+static unsigned int AddLiterals(const uint8_t *src, unsigned int begin, unsigned int end, bool nibbles, uint8_t low_bits,
+                                SpokeRuns *runs, unsigned int *sample) {
+  unsigned int i = begin;
+
+  while (i < end && *sample < runs->GetLen()) {
+    unsigned int next = FindChange(src, i, end);
+    unsigned int room = (unsigned int)runs->GetLen() - *sample;
+    unsigned int count = wxMin(next - i, nibbles ? (room + 1) / 2 : room);
+
+    AddBytes(runs, sample, count, src[i], nibbles, low_bits);
+    i += count;
+  }
+  return i;
+}
+
+unsigned int RaymarineDecodeEncoded(const uint8_t *src, unsigned int len, bool nibbles, SpokeRuns *runs,
+                                    unsigned int *sample) {
+  // The E120 sets the low bits of the samples in this part, so that a zero
+  // nibble still shows as the weakest return.
+  const uint8_t low_bits = nibbles ? 0x0f : 0;
+  unsigned int i = 0;
+
+  while (i < len && *sample < runs->GetLen()) {
+    unsigned int escape = FindByte(src, i, len, RAYMARINE_ESCAPE);
+
+    i = AddLiterals(src, i, escape, nibbles, low_bits, runs, sample);
+    if (i < escape || escape == len) {
+      break;  // Spoke full, or no more escapes
+    }
+    if (i + 3 > len) {
+      break;  // Escape cut off at the end
+    }
+    AddBytes(runs, sample, src[i + 1], src[i + 2], nibbles, low_bits);
+    i += 3;
+  }
+  return i;
+}
+
+unsigned int RaymarineDecodeRaw(const uint8_t *src, unsigned int len, bool nibbles, SpokeRuns *runs, unsigned int *sample) {
+  return AddLiterals(src, 0, len, nibbles, 0, runs, sample);
+}
+
+PLUGIN_END_NAMESPACE
@@ -40,80 +40,6 @@
 
 PLUGIN_BEGIN_NAMESPACE
 
-//
-// Raymarine E120 radars and compatible report their addresses here, (including the version?) #.
-//
-static const NetworkAddress reportRaymarineCommon(224, 0, 0, 1, 5800);
-static const NetworkAddress reportRaymarineQuantumWiFi(232, 1, 1, 1, 5800);
-
-#define SECONDS_PER_SELECT (1)
-#define PERIOD_UNTIL_CARD_REFRESH (60)
-#define PERIOD_UNTIL_WAKE_RADAR (30)
-
-void RaymarineLocate::CleanupCards() {
-  if (m_interface_addr) {
-    delete[] m_interface_addr;
-    m_interface_addr = 0;
-  }
-  if (m_socket) {
-    for (size_t i = 0; i < m_interface_count; i++) {
-      if (m_socket[i] != INVALID_SOCKET) {
-        closesocket(m_socket[i]);
-      }
-    }
-    delete[] m_socket;
-    m_socket = 0;
-  }
-  m_interface_count = 0;
-}
-
-void RaymarineLocate::UpdateEthernetCards() {
-  struct ifaddrs *addr_list;
-  struct ifaddrs *addr;
-  size_t i = 0;
-  wxString error;
-
-  CleanupCards();
-
-  if (!getifaddrs(&addr_list)) {
-    // Count the # of active IPv4 cards
-    for (addr = addr_list; addr; addr = addr->ifa_next) {
-      if (VALID_IPV4_ADDRESS(addr)) {
-        m_interface_count++;
-      }
-    }
-
-    // If there are any fill packed array (m_socket, m_interface_addr) with them.
-    if (m_interface_count > 0) {
-      m_socket = new SOCKET[m_interface_count * 2];
-      m_interface_addr = new NetworkAddress[m_interface_count * 2];
-
-      for (addr = addr_list; addr; addr = addr->ifa_next) {
-        if (VALID_IPV4_ADDRESS(addr)) {
-          struct sockaddr_in *sa = (struct sockaddr_in *)addr->ifa_addr;
-          m_interface_addr[i].addr = sa->sin_addr;
-          m_interface_addr[i].port = 0;
-          wxLogError(wxT("Attempting to start receive socket on  %s"), reportRaymarineCommon.to_string());
-          m_socket[i] = startUDPMulticastReceiveSocket(m_interface_addr[i], reportRaymarineCommon, error);
-          LOG_VERBOSE(wxT("RaymarineLocate scanning interface %s for radars"), m_interface_addr[i].FormatNetworkAddress());
-          i++;
-
-          m_interface_addr[i].addr = sa->sin_addr;
-          m_interface_addr[i].port = 0;
-          wxLogError(wxT("Attempting to start receive socket on  %s"), reportRaymarineQuantumWiFi.to_string());
-          m_socket[i] = startUDPMulticastReceiveSocket(m_interface_addr[i], reportRaymarineQuantumWiFi, error);
-          LOG_VERBOSE(wxT("RaymarineLocate scanning interface %s for radars"), m_interface_addr[i].FormatNetworkAddress());
-          i++;
-        }
-      }
-    }
-
-    freeifaddrs(addr_list);
-  }
-
-  // WakeRadar(); not  known for Raymarine
-}
-
 /*
  * Entry
  *
@@ -122,14 +48,8 @@ void RaymarineLocate::UpdateEthernetCards() {
  */
 void *RaymarineLocate::Entry(void) {
   int r = 0;
-  int rescan_network_cards = 0;
   bool success = false;
-
-  union {
-    sockaddr_storage addr;
-    sockaddr_in ipv4;
-  } rx_addr;
-  socklen_t rx_len;
+  MulticastSource source;
 
 #define MAX_DATA 500
   uint8_t data[MAX_DATA];
@@ -138,7 +58,7 @@ void *RaymarineLocate::Entry(void) {
 
   m_is_shutdown = false;
 
-  UpdateEthernetCards();
+  m_groups.Update();
 
   while (!success && !m_shutdown) {  // will run until the Raymarine radar location info has been found or shutdown
     // after that we stop the Raymarine locate, saves load and prevents that the serial nr gets overwritten
@@ -147,45 +67,32 @@ void *RaymarineLocate::Entry(void) {
     FD_ZERO(&fdin);
 
     int maxFd = INVALID_SOCKET;
-    for (size_t i = 0; i < m_interface_count * 2; i++) {
-      if (m_socket[i] != INVALID_SOCKET) {
-        FD_SET(m_socket[i], &fdin);
-        maxFd = MAX(m_socket[i], maxFd);
-      }
+    SOCKET sock = m_groups.GetWakeSocket();
+    if (sock != INVALID_SOCKET) {
+      FD_SET(sock, &fdin);
+      maxFd = MAX(sock, maxFd);
     }
 
     r = select(maxFd + 1, &fdin, 0, 0, &tv);
     if (r == -1 && errno != 0) {
-      UpdateEthernetCards();
-      rescan_network_cards = 0;
+      m_groups.Close();  // Join all of them again
+      m_groups.Update();
     }
     if (r > 0) {
-      for (size_t i = 0; i < m_interface_count * 2; i++) {
-        if (m_socket[i] != INVALID_SOCKET && FD_ISSET(m_socket[i], &fdin)) {
-          rx_len = sizeof(rx_addr);
-          r = recvfrom(m_socket[i], (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
-          if (r > 2) {  // we are not interested in 2 byte messages
-            if (r > MAX_DATA) wxLogError(wxT("Buffer overflow on reading Raymarine Locate"));
-            NetworkAddress radar_address;
-            radar_address.addr = rx_addr.ipv4.sin_addr;
-            radar_address.port = rx_addr.ipv4.sin_port;
-            if (ProcessReport(radar_address, m_interface_addr[i], data, (size_t)r)) {
-              rescan_network_cards = -PERIOD_UNTIL_CARD_REFRESH;  // Give double time until we rescan
-              success = true;
-            }
+      while (!success && (r = m_groups.Receive(data, sizeof(data), &source)) >= 0) {
+        if (r > 2) {  // we are not interested in 2 byte messages
+          if (ProcessReport(source.from, source.interface_address, data, (size_t)r)) {
+            success = true;
           }
         }
       }
     } else {  // no data received -> select timeout
-      if (++rescan_network_cards >= PERIOD_UNTIL_CARD_REFRESH) {
-        UpdateEthernetCards();
-        rescan_network_cards = 0;
-      }
+      m_groups.Update();  // Only does something when the interfaces changed
     }
 
   }  // endless loop until thread destroy
 
-  CleanupCards();
+  m_groups.Close();
   m_is_shutdown = true;
   if (success) {
     LOG_INFO(wxT("Raymarine locate stopped after success"));
@@ -38,6 +38,7 @@
 
 #include "MessageBox.h"
 #include "RME120Control.h"
+#include "RaymarineDecode.h"
 
 PLUGIN_BEGIN_NAMESPACE
 
@@ -107,6 +108,7 @@ SOCKET RaymarineReceive::PickNextEthernetCard() {
       int one = 1;
       setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one));
     }
+    m_comm_multicast = false;
   } else {
     socket = GetNewReportSocket();
     LOG_INFO(wxT("%s Creating multicast socket for radar at IP %s [%s] - %d"), m_ri->m_name,
@@ -148,7 +150,12 @@ SOCKET RaymarineReceive::GetNewReportSocket() {
     }
   }
 
-  socket = startUDPMulticastReceiveSocket(m_interface_addr, m_info.report_addr, error);
+  socket = INVALID_SOCKET;
+  if (m_multicast.Join(m_interface_addr, m_info.report_addr, error)) {
+    // Commands go out from the report socket, but only the dispatcher reads it
+    socket = m_multicast.GetSocket(m_info.report_addr);
+    m_comm_multicast = true;
+  }
   wxString addr = m_interface_addr.FormatNetworkAddress();
   wxString rep_addr = m_info.report_addr.FormatNetworkAddressPort();
   if (socket != INVALID_SOCKET) {
@@ -165,6 +172,32 @@ SOCKET RaymarineReceive::GetNewReportSocket() {
   return socket;
 }
 
+void RaymarineReceive::CloseCommSocket() {
+  if (m_comm_multicast) {
+    m_multicast.LeaveAll();  // The dispatcher closes the socket
+  } else if (m_comm_socket != INVALID_SOCKET) {
+    closesocket(m_comm_socket);
+  }
+  m_comm_socket = INVALID_SOCKET;
+  m_comm_multicast = false;
+}
+
+void RaymarineReceive::ReceivedFromRadar(const uint8_t *data, size_t len, const NetworkAddress &radar_address, bool *detected) {
+  ProcessFrame(data, len);
+  if (!*detected) {
+    wxCriticalSectionLocker lock(m_lock);
+    m_ri->DetectedRadar(m_interface_addr,
+                        radar_address);  // enables transmit data, if radar multicast address is also known
+    UpdateSendCommand();
+    *detected = true;
+
+    if (m_ri->m_state.GetValue() == RADAR_OFF) {
+      LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), radar_address.FormatNetworkAddress());
+      m_ri->m_state.Update(RADAR_STANDBY);
+    }
+  }
+}
+
 /*
  * Entry
  *
@@ -180,12 +213,12 @@ void *RaymarineReceive::Entry(void) {
     sockaddr_in ipv4;
   } rx_addr;
   socklen_t rx_len;
+  MulticastSource source;
 
   uint8_t data[2048];  // largest packet seen so far from a Raymarine is 626
   m_interface_array = 0;
   m_interface = 0;
-  struct sockaddr_in radarFoundAddr;
-  sockaddr_in *radar_addr = 0;
+  bool detected = false;
   time_t last_keepalive = time(0);
 
   LOG_VERBOSE(wxT("RamarineReceive thread %s starting"), m_ri->m_name.c_str());
@@ -194,6 +227,9 @@ void *RaymarineReceive::Entry(void) {
                 m_info.report_addr.FormatNetworkAddressPort());
     m_comm_socket = GetNewReportSocket();  // Start using the same interface_addr as previous time
   }
+  if (m_comm_socket == INVALID_SOCKET) {
+    StartDiscoveryCache(false);  // No cached addresses, or the cached interface is gone
+  }
 
   while (m_receive_socket != INVALID_SOCKET) {
     if (m_comm_socket == INVALID_SOCKET && !m_info.report_addr.IsNull()) {
@@ -202,6 +238,7 @@ void *RaymarineReceive::Entry(void) {
         LOG_INFO(wxT("Entry %s Creating unicast socket for radar at IP %s [%s]"), m_ri->m_name,
                  m_ri->m_radar_address.FormatNetworkAddressPort(), m_info.to_string());
         m_comm_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        m_comm_multicast = false;
         if (m_comm_socket != INVALID_SOCKET) {
           int one = 1;
           setsockopt(m_comm_socket, SOL_SOCKET, SO_REUSEADDR, (const char *)&one, sizeof(one));
@@ -228,10 +265,15 @@ void *RaymarineReceive::Entry(void) {
       FD_SET(m_receive_socket, &fdin);
       maxFd = MAX(m_receive_socket, maxFd);
     }
-    if (m_comm_socket != INVALID_SOCKET) {
+    if (m_comm_socket != INVALID_SOCKET && !m_comm_multicast) {
       FD_SET(m_comm_socket, &fdin);
       maxFd = MAX(m_comm_socket, maxFd);
     }
+    SOCKET wakeSocket = m_multicast.GetWakeSocket();
+    if (wakeSocket != INVALID_SOCKET) {
+      FD_SET(wakeSocket, &fdin);
+      maxFd = MAX(wakeSocket, maxFd);
+    }
     r = select(maxFd + 1, &fdin, 0, 0, &tv);
     if (r > 0) {
       if (m_receive_socket != INVALID_SOCKET && FD_ISSET(m_receive_socket, &fdin)) {
@@ -243,7 +285,7 @@ void *RaymarineReceive::Entry(void) {
         }
       }
 
-      if (m_comm_socket != INVALID_SOCKET && FD_ISSET(m_comm_socket, &fdin)) {
+      if (m_comm_socket != INVALID_SOCKET && !m_comm_multicast && FD_ISSET(m_comm_socket, &fdin)) {
         rx_len = sizeof(rx_addr);
         r = recvfrom(m_comm_socket, (char *)data, sizeof(data), 0, (struct sockaddr *)&rx_addr, &rx_len);
         if (r > 0) {
@@ -251,22 +293,17 @@ void *RaymarineReceive::Entry(void) {
           radar_address.addr = rx_addr.ipv4.sin_addr;
           radar_address.port = rx_addr.ipv4.sin_port;
 
-          ProcessFrame(data, (size_t)r);
-          if (!radar_addr) {
-            wxCriticalSectionLocker lock(m_lock);
-            m_ri->DetectedRadar(m_interface_addr,
-                                radar_address);  // enables transmit data, if radar multicast address is also known
-            UpdateSendCommand();
-
-            radarFoundAddr = rx_addr.ipv4;
-            radar_addr = &radarFoundAddr;
+          ReceivedFromRadar(data, (size_t)r, radar_address, &detected);
+          no_data_timeout = SECONDS_SELECT(-15);
+        }
+      }
 
-            if (m_ri->m_state.GetValue() == RADAR_OFF) {
-              LOG_INFO(wxT("%s detected at %s"), m_ri->m_name.c_str(), radar_address.FormatNetworkAddress());
-              m_ri->m_state.Update(RADAR_STANDBY);
-            }
+      if (wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &fdin)) {
+        while ((r = m_multicast.Receive(data, sizeof(data), &source)) >= 0) {
+          if (r > 0 && m_comm_multicast && source.group == m_info.report_addr) {
+            ReceivedFromRadar(data, (size_t)r, source.from, &detected);
+            no_data_timeout = SECONDS_SELECT(-15);
           }
-          no_data_timeout = SECONDS_SELECT(-15);
         }
       }
 
@@ -274,12 +311,11 @@ void *RaymarineReceive::Entry(void) {
       LOG_INFO(wxT("%s RaymarineReceive receive timeout %d"), m_ri->m_name.c_str(), no_data_timeout);
       if (no_data_timeout >= SECONDS_SELECT(2)) {
         no_data_timeout = 0;
-        if (m_comm_socket != INVALID_SOCKET) {
+        if (m_comm_socket != INVALID_SOCKET && (detected || !UsingDiscoveryCache())) {
           if (m_ri->m_radar_type != RM_QUANTUM || IS_MULTICAST(m_info.report_addr.addr.s_addr)) {
-            closesocket(m_comm_socket);
-            m_comm_socket = INVALID_SOCKET;
+            CloseCommSocket();
             m_interface_addr = NetworkAddress();
-            radar_addr = 0;
+            detected = false;
           }
           m_ri->m_state.Update(RADAR_OFF);
         }
@@ -300,8 +336,7 @@ void *RaymarineReceive::Entry(void) {
       LOG_INFO(wxT("%s RaymarineReceive updating radar location %s socket %d"), m_ri->m_name.c_str(), m_info.to_string(),
                m_comm_socket);
       if ((m_ri->m_radar_type != RM_QUANTUM || IS_MULTICAST(m_info.report_addr.addr.s_addr)) && m_comm_socket != INVALID_SOCKET) {
-        closesocket(m_comm_socket);
-        m_comm_socket = INVALID_SOCKET;
+        CloseCommSocket();
       } else {
         m_ri->m_control->RadarStayAlive();
         no_data_timeout = 0;
@@ -320,9 +355,7 @@ void *RaymarineReceive::Entry(void) {
 
   LOG_VERBOSE(wxT("%s received stop instruction, stopping"), m_ri->m_name.c_str());
 
-  if (m_comm_socket != INVALID_SOCKET) {
-    closesocket(m_comm_socket);
-  }
+  CloseCommSocket();
   if (m_send_socket != INVALID_SOCKET) {
     closesocket(m_send_socket);
     m_send_socket = INVALID_SOCKET;
@@ -346,7 +379,6 @@ void *RaymarineReceive::Entry(void) {
 }
 
 void RaymarineReceive::ProcessFrame(const UINT8 *data, size_t len) {  // This is the original ProcessFrame from RMradar_pi
-  time_t now = time(0);
   wxString MOD_serial;
   wxString IF_serial;
   wxString s;
@@ -354,8 +386,7 @@ void RaymarineReceive::ProcessFrame(const UINT8 *data, size_t len) {  // This is
   int status;
   wxString stat;
   // LOG_BINARY_RECEIVE(wxT("received frame"), data, len);
-  m_ri->resetTimeout(now);
-  m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
+  m_ri->m_lifecycle.ReportReceived();
   m_ri->m_statistics.packets++;
   if (len >= 4) {
     uint32_t msgId = 0;
@@ -369,15 +400,15 @@ void RaymarineReceive::ProcessFrame(const UINT8 *data, size_t len) {  // This is
         break;
       case 0x00010003:
         ProcessScanData(data, len);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         break;
       case 0x00280003:
         ProcessQuantumScanData(data, len);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         break;
       case 0x00280002:
         ProcessQuantumReport(data, len);
-        m_ri->m_data_timeout = now + DATA_TIMEOUT;
+        m_ri->m_lifecycle.DataReceived();
         break;
       case 0x00280001:  // type and serial for Quantum radar
         LOG_BINARY_RECEIVE(wxT("received frame 0x00280001"), data, len);
@@ -901,7 +932,7 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len) {
     LOG_RECEIVE(wxT("Invalid range"));
     return;
   }
-  m_pi->logBinaryData(wxT("Scandata"), data, len);
+  LOG_BINARY_RECEIVE(wxT("Scandata"), data, len);
   if (len > (int)(sizeof(Header1) + sizeof(Header3))) {
     Header1 *pHeader = (Header1 *)data;
     bool HDtype = false;
@@ -913,15 +944,13 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len) {
       return;
     }
 
-    time_t now = time(0);
-    m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
-    m_ri->m_data_timeout = now + DATA_TIMEOUT;
+    m_ri->m_lifecycle.DataReceived();
     m_ri->m_state.Update(RADAR_TRANSMIT);
 
     if (pHeader->fieldx_4 == 0x400) {
       LOG_RECEIVE(wxT(" different radar type found"));
     }
-    wxLongLong nowMillis = wxGetLocalTimeMillis();
+    wxLongLong nowMillis = wxGetUTCTimeMillis();
     int headerIdx = 0;
     int nextOffset = sizeof(Header1);
 
@@ -960,74 +989,15 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len) {
                     pSData->length, pSData->data_len);
         break;
       }
-      UINT8 unpacked_data[10240], *dataPtr = 0;
-
-      uint8_t *dData = (uint8_t *)unpacked_data;
-      uint8_t *sData = (uint8_t *)data + nextOffset + sizeof(SpokeData);
+      const uint8_t *sData = (const uint8_t *)data + nextOffset + sizeof(SpokeData);
+      unsigned int avail = (unsigned int)wxMax(len - nextOffset - (int)sizeof(SpokeData), 0);
+      unsigned int sample = 0;
 
-      unsigned int iS = 0;
-      unsigned int iD = 0;
       // LOG_BINARY_RECEIVE(wxT("spoke data sData"), sData, pSData->data_len);
-      while (iS < pSData->data_len) {
-        if (HDtype) {
-          if (iD >= 1024) {  // remove trailing zero's
-            break;
-          }
-          if (*sData != 0x5c) {
-            *dData++ = *sData;
-            sData++;
-            iS++;
-            iD++;
-          } else {
-            uint8_t nFill = sData[1];  // number to be filled
-            uint8_t cFill = sData[2];  // data to be filled
-            for (unsigned int i = 0; i < nFill; i++) {
-              *dData++ = cFill;
-            }
-            sData += 3;
-            iS += 3;
-            iD += nFill;
-          }
-        } else {  // not HDtype
-          if (*sData != 0x5c) {
-            *dData++ = (((*sData) & 0x0f) << 4) + 0x0f;
-            *dData++ = ((*sData) & 0xf0) + 0x0f;
-            sData++;
-            iS++;
-            iD += 2;
-          } else {
-            uint8_t nFill = sData[1];
-            uint8_t cFill = sData[2];
-
-            for (unsigned int i = 0; i < nFill; i++) {
-              *dData++ = ((cFill & 0x0f) << 4) + 0x0f;
-              *dData++ = (cFill & 0xf0) + 0x0f;
-            }
-            sData += 3;
-            iS += 3;
-            iD += nFill * 2;
-          }
-        }
-      }
-      if (iD != returns_per_line) {
-        while (iS < pSData->length - 8 && iD <= returns_per_line) {
-          if (HDtype) {
-            *dData++ = *sData;
-            sData++;
-            iS++;
-            iD++;
-          } else {
-            *dData++ = ((*sData) & 0x0f) << 4;
-            *dData++ = (*sData) & 0xf0;
-            sData++;
-            iS++;
-            iD += 2;
-          }
-        }
-      }
-
-      // LOG_BINARY_RECEIVE(wxT("spoke data dData"), unpacked_data, pSData->data_len);
-      dataPtr = unpacked_data;
+      m_runs.Clear(returns_per_line);
+      unsigned int used = RaymarineDecodeEncoded(sData, wxMin(pSData->data_len, avail), !HDtype, &m_runs, &sample);
+      // Any remaining bytes are samples as is
+      RaymarineDecodeRaw(sData + used, wxMin(pSData->length - 8, avail) - used, !HDtype, &m_runs, &sample);
 
       nextOffset += pSData->length;
       m_ri->m_statistics.spokes++;
@@ -1069,10 +1039,10 @@ void RaymarineReceive::ProcessScanData(const UINT8 *data, int len) {
       }
       /*LOG_INFO(wxT("ProcessRadarSpoke a=%i, angle_raw=%i b=%i, bearing_raw=%i, returns_per_line=%i range=%i spokes=%i"), angle,
          angle_raw, bearing, bearing_raw, returns_per_line, m_range_meters, m_ri->m_spokes);*/
-      m_ri->ProcessRadarSpoke(angle, bearing, dataPtr, returns_per_line, m_range_meters, nowMillis);
+      m_ri->ProcessRadarSpoke(angle, bearing, m_runs, m_range_meters, nowMillis);
       // When te HD radar is transmitting in a mode with 1024 spokes, insert additional spokes to fill the image
       if (spokes_1024 && angle + 1 < (int)m_ri->m_spokes && bearing + 1 < (int)m_ri->m_spokes) {
-        m_ri->ProcessRadarSpoke(angle + 1, bearing + 1, dataPtr, returns_per_line, m_range_meters, nowMillis);
+        m_ri->ProcessRadarSpoke(angle + 1, bearing + 1, m_runs, m_range_meters, nowMillis);
       }
     }
   }
@@ -1106,52 +1076,29 @@ void RaymarineReceive::ProcessQuantumScanData(const UINT8 *data, int len) {
     return;
   }
   SQuantumScanDataHeader *qheader = (SQuantumScanDataHeader *)data;
-  m_pi->logBinaryData(wxT("SQuantumScanDataHeader"), data, len);
+  LOG_BINARY_RECEIVE(wxT("SQuantumScanDataHeader"), data, len);
   if (len > (int)(sizeof(SQuantumScanDataHeader))) {
     u_int returns_per_line;
 
-    time_t now = time(0);
-    m_ri->m_radar_timeout = now + WATCHDOG_TIMEOUT;
-    m_ri->m_data_timeout = now + DATA_TIMEOUT;
+    m_ri->m_lifecycle.DataReceived();
     m_ri->m_state.Update(RADAR_TRANSMIT);
 
-    wxLongLong nowMillis = wxGetLocalTimeMillis();
+    wxLongLong nowMillis = wxGetUTCTimeMillis();
     int headerIdx = 0;
     int nextOffset = sizeof(QuantumHeader);
-    UINT8 unpacked_data[1024], *dataPtr = 0;
-
-    uint8_t *dData = (uint8_t *)unpacked_data;
-    uint8_t *sData = (uint8_t *)data + nextOffset;
-
-    unsigned int iS = 0;
-    unsigned int iD = 0;
-    while (iS < qheader->data_len) {
-      if (iD >= 1024) {  // remove trailing zero's
-        break;
-      }
-      if (*sData != 0x5c) {
-        *dData++ = *sData;
-        sData++;
-        iS++;
-        iD++;
-      } else {
-        uint8_t nFill = sData[1];  // number to be filled
-        uint8_t cFill = sData[2];  // data to be filled
-        for (unsigned int i = 0; i < nFill; i++) {
-          *dData++ = cFill;
-        }
-        sData += 3;
-        iS += 3;
-        iD += nFill;
-      }
-    }  // end of while, only one spoke per packet
+    unsigned int samples = 0;
 
     returns_per_line = qheader->scan_len;
     if (returns_per_line > 252) {
       LOG_VERBOSE(wxT("Error returns_per_line too large %i"), returns_per_line);
       returns_per_line = 252;
     }
-    dataPtr = unpacked_data;
+
+    // Only one spoke per packet
+    m_runs.Clear(returns_per_line);
+    RaymarineDecodeEncoded((const uint8_t *)data + nextOffset,
+                           wxMin((unsigned int)qheader->data_len, (unsigned int)(len - nextOffset)), false, &m_runs, &samples);
+
     m_ri->m_statistics.spokes++;
     unsigned int spoke = qheader->azimuth;
     if (m_next_spoke >= 0 && (int)spoke != m_next_spoke) {
@@ -1191,8 +1138,8 @@ void RaymarineReceive::ProcessQuantumScanData(const UINT8 *data, int len) {
       LOG_INFO(wxT("Error range invalid"));
       return;
     }
-    m_ri->ProcessRadarSpoke(angle, bearing, dataPtr, returns_per_line,
-                            m_range_meters * returns_per_line / qheader->returns_per_range / 2, nowMillis);
+    m_ri->ProcessRadarSpoke(angle, bearing, m_runs, m_range_meters * returns_per_line / qheader->returns_per_range / 2,
+                            nowMillis);
   }
 }
 
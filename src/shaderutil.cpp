@@ -64,12 +64,47 @@ GLboolean ShadersSupported(void) {
     if (!u.p) ok = 0;                       \
     name = u.f;                             \
   }
+#define SHADER_OPTIONAL_FUNCTION_LIST(proc, name) \
+  {                                               \
+    union {                                       \
+      proc f;                                     \
+      FunctionPointer p;                          \
+    } u;                                          \
+    u.p = SET_FUNCTION_POINTER("gl" #name);       \
+    name = u.f;                                   \
+  }
 #include "shaderutil.inc"
+#undef SHADER_OPTIONAL_FUNCTION_LIST
 #undef SHADER_FUNCTION_LIST
 
   return ok;
 }
 
+GLboolean TimerQueriesSupported(void) {
+  return GenQueries && DeleteQueries && BeginQuery && EndQuery && GetQueryObjectiv && GetQueryObjectui64v;
+}
+
+GLboolean CoreProfileSupported(bool *es) {
+  const char *version = (const char *)glGetString(GL_VERSION);
+  int major = 0, minor = 0;
+
+  if (!version) {
+    return 0;
+  }
+  *es = strncmp(version, "OpenGL ES ", 10) == 0;
+  if (*es) {
+    version += 10;
+  }
+  if (sscanf(version, "%d.%d", &major, &minor) != 2) {
+    return 0;
+  }
+  if (*es ? major < 3 : (major < 3 || (major == 3 && minor < 3))) {
+    return 0;
+  }
+  return GenVertexArrays && DeleteVertexArrays && BindVertexArray && VertexAttribPointer && EnableVertexAttribArray &&
+         GetUniformBlockIndex && UniformBlockBinding && BindBufferBase && BufferSubData;
+}
+
 bool CompileShaderText(GLuint *shader, GLenum shaderType, const char *text) {
   GLint stat;
 
@@ -0,0 +1,204 @@
+/******************************************************************************
+ *
+ * Project:  OpenCPN
+ * Purpose:  Radar Plugin
+ * Author:   David Register
+ *           Dave Cowell
+ *           Kees Verruijt
+ *           Douwe Fokkema
+ *           Sean D'Epagnier
+ ***************************************************************************
+ *   Copyright (C) 2010 by David S. Register              bdbcat@yahoo.com *
+ *   Copyright (C) 2012-2013 by Dave Cowell                                *
+ *   Copyright (C) 2012-2016 by Kees Verruijt         canboat@verruijt.net *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************
+ */
+
+
+#include "spokeutil.h"
+
+PLUGIN_BEGIN_NAMESPACE
+
+void RemoveBelowEach(uint8_t *data, const uint8_t *threshold, size_t len) {
+  size_t i = 0;
+
+#if defined(SPOKE_SIMD_SSE2)
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i thr = _mm_loadu_si128((const __m128i *)(threshold + i));
+    __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(v, thr), v);  // 0xFF where v >= threshold
+    _mm_storeu_si128((__m128i *)(data + i), _mm_and_si128(v, ge));
+  }
+#elif defined(SPOKE_SIMD_NEON)
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(data + i);
+    vst1q_u8(data + i, vandq_u8(v, vcgeq_u8(v, vld1q_u8(threshold + i))));
+  }
+#endif
+
+  for (; i < len; i++) {
+    if (data[i] < threshold[i]) {
+      data[i] = 0;
+    }
+  }
+}
+
+void SpokeRuns::SetSamples(const uint8_t *data, size_t len) {
+  size_t i = 0;
+
+  Clear(len);
+  while (i < len) {
+    // Skip empty samples eight at a time
+    while (i + sizeof(uint64_t) <= len) {
+      uint64_t word;
+      memcpy(&word, data + i, sizeof(word));
+      if (word) {
+        break;
+      }
+      i += sizeof(word);
+    }
+    while (i < len && !data[i]) {
+      i++;
+    }
+    if (i == len) {
+      break;
+    }
+    size_t begin = i;
+    uint8_t value = data[i];
+    while (++i < len && data[i] == value) {
+    }
+    SpokeRun run = {(uint16_t)begin, (uint16_t)i, value};
+    m_runs.push_back(run);
+  }
+}
+
+void SpokeRuns::GetSamples(uint8_t *data) const {
+  memset(data, 0, m_len);
+  for (size_t i = 0; i < m_runs.size(); i++) {
+    memset(data + m_runs[i].begin, m_runs[i].value, m_runs[i].end - m_runs[i].begin);
+  }
+}
+
+void SpokeRuns::ClearBelow(size_t radius) {
+  size_t n = 0;
+
+  while (n < m_runs.size() && m_runs[n].end <= radius) {
+    n++;
+  }
+  m_runs.erase(m_runs.begin(), m_runs.begin() + n);
+  if (!m_runs.empty() && m_runs[0].begin < radius) {
+    m_runs[0].begin = (uint16_t)radius;
+  }
+}
+
+void SpokeRuns::RemoveBelow(uint8_t threshold) {
+  size_t n = 0;
+
+  for (size_t i = 0; i < m_runs.size(); i++) {
+    if (m_runs[i].value >= threshold) {
+      m_runs[n++] = m_runs[i];
+    }
+  }
+  m_runs.resize(n);
+}
+
+void SpokeRuns::SetLast(uint8_t value) {
+  if (!m_len) {
+    return;
+  }
+  size_t last = m_len - 1;
+  if (!m_runs.empty() && m_runs.back().end > last) {
+    if (m_runs.back().begin == last) {
+      m_runs.pop_back();
+    } else {
+      m_runs.back().end = (uint16_t)last;
+    }
+  }
+  Add(last, 1, value);
+}
+
+size_t SpokeRuns::CountAbove(size_t begin, size_t end, uint8_t threshold) const {
+  size_t count = 0;
+  size_t lo = 0;
+  size_t hi = m_runs.size();
+
+  if (threshold == 0) {  // the empty samples count as well
+    end = wxMin(end, m_len);
+    return end > begin ? end - begin : 0;
+  }
+  // Find the first run that ends after 'begin'
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (m_runs[mid].end <= begin) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  for (size_t i = lo; i < m_runs.size() && m_runs[i].begin < end; i++) {
+    if (m_runs[i].value >= threshold) {
+      count += wxMin((size_t)m_runs[i].end, end) - wxMax((size_t)m_runs[i].begin, begin);
+    }
+  }
+  return count;
+}
+
+void SpokeCfar::Configure(size_t window, size_t guard, unsigned scale) {
+  m_window = wxMax(window, (size_t)1);
+  m_guard = guard;
+  // A window sum times this is at most 255 * scale * 4096, so it fits in 32 bits
+  m_multiplier = (uint32_t)(wxMin(scale, 255u) * 4096 / m_window);
+}
+
+void SpokeCfar::Apply(uint8_t *data, size_t len) {
+  size_t reach = m_guard + m_window;  // From a sample to the far end of its windows
+
+  if (len < 2 * reach + 1) {
+    return;
+  }
+  m_sum.resize(len + 1);
+  m_threshold.resize(len);
+  uint32_t *sum = &m_sum[0];
+  uint8_t *threshold = &m_threshold[0];
+  uint32_t multiplier = m_multiplier;
+
+  sum[0] = 0;
+  for (size_t i = 0; i < len; i++) {
+    sum[i + 1] = sum[i] + data[i];
+  }
+
+  // Each window sum is the difference of two running sums. At both ends of
+  // the spoke only one of the windows lies within it.
+  for (size_t i = 0; i < reach; i++) {
+    uint32_t after = sum[i + reach + 1] - sum[i + m_guard + 1];
+    threshold[i] = (uint8_t)wxMin((after * multiplier) >> 16, 255u);
+  }
+  for (size_t i = reach; i < len - reach; i++) {
+    uint32_t before = sum[i - m_guard] - sum[i - reach];
+    uint32_t after = sum[i + reach + 1] - sum[i + m_guard + 1];
+    threshold[i] = (uint8_t)wxMin((wxMax(before, after) * multiplier) >> 16, 255u);
+  }
+  for (size_t i = len - reach; i < len; i++) {
+    uint32_t before = sum[i - m_guard] - sum[i - reach];
+    threshold[i] = (uint8_t)wxMin((before * multiplier) >> 16, 255u);
+  }
+
+  RemoveBelowEach(data, threshold, len);
+}
+
+PLUGIN_END_NAMESPACE